@@ -44,8 +44,7 @@ void PlayWorld::becameActive()
             enemy = new Enemy2();
         }
         enemy->setCenterPos(KRVector2D(KRRandInt(gKRScreenSize.x-20)+10, KRRandInt(gKRScreenSize.y-20)+10));
-        mEnemies.push_back(enemy);
-        gKRAnime2DMan->addChara2D(enemy);
+        mEnemies.push_back(gKRAnime2DMan->addChara2D(enemy));
     }
     
     // Use label for displaying texts.
@@ -94,23 +93,29 @@ void PlayWorld::updateModel(KRInput* input)
 #endif
 
     // Move Enemies
-    for (std::list<Enemy*>::iterator it = mEnemies.begin(); it != mEnemies.end();) {
+    for (std::list<KRChara2DHandle>::iterator it = mEnemies.begin(); it != mEnemies.end();) {
+        // Get the enemy (NULL if it has already been removed)
+        Enemy* enemy = (Enemy*)gKRAnime2DMan->getChara2D(*it);
+        if (enemy == NULL) {
+            it = mEnemies.erase(it);
+            continue;
+        }
+
         // Do move
-        (*it)->move();
+        enemy->move();
 
         // Hit test
-        KRChara2D* hitPlayer = gKRAnime2DMan->hitChara2D(CharaType::Player, HitType::Attack, *it, HitType::Block);
+        KRChara2D* hitPlayer = gKRAnime2DMan->hitChara2D(CharaType::Player, HitType::Attack, enemy, HitType::Block);
         if (hitPlayer != NULL) {
             // Add Score
             mScore += 10;
-            mScoreLabel->setText(KRFS("Score: %04d", mScore));
+            mScoreLabel->setText(KRStringBuffer<32>("Score: %04d", mScore));
             
             // Explosion
-            gKRAnime2DMan->playChara2DCenter(CharaID::Explosion, 0, (*it)->getCenterPos(), 10);
+            gKRAnime2DMan->playChara2DCenter(CharaID::Explosion, 0, enemy->getCenterPos(), 10);
             gKRAudioMan->playSE(SE_ID::Burn, 1.0);
             
             // Remove an enemy
-            Enemy* enemy = *it;
             it = mEnemies.erase(it);
             gKRAnime2DMan->removeChara2D(enemy);
         } else {
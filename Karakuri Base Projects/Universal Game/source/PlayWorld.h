@@ -18,7 +18,7 @@ class PlayWorld : public KRWorld {
     KRLabel*            mScoreLabel;
 
     Player*             mDraggingPlayer;
-    std::list<Enemy*>   mEnemies;    
+    std::list<KRChara2DHandle>  mEnemies;
 
     int                 mScore;
     
@@ -0,0 +1,325 @@
+/* BroadphaseBenchmark.c
+ * Compares the spatial hash, AABB tree and sort-and-sweep broadphases of the embedded Chipmunk.
+ *
+ * Build and run from this directory:
+ *   cc -std=gnu99 -O2 -I../Karakuri/chipmunk BroadphaseBenchmark.c ../Karakuri/chipmunk/c*.c ../Karakuri/chipmunk/constraints/c*.c -lm -o BroadphaseBenchmark
+ *   ./BroadphaseBenchmark
+ *
+ * Every scene is run once per broadphase with the same shapes and velocities.
+ * The collision callback records each colliding pair and rejects the collision,
+ * so the bodies move the same way in every run, and the pairs found by each
+ * broadphase are checked against the spatial hash at every step.
+ *
+ * Matching pairs are not enough: the order of the pairs is the order of the solver.
+ * The second table settles a 60-row pyramid of boxes with sleeping enabled on every
+ * broadphase. The stack must keep its mean height within PYRAMID_SINK_LIMIT px and
+ * every box must fall asleep.
+ *
+ * Exits with 1 if any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "chipmunk.h"
+
+// Fraction of the world covered by the bounding boxes of the bodies.
+#define DENSITY     0.25
+#define STEP_COUNT  120
+
+// Same sizes and settings as the pyramid scene of SimulatorBenchmark.
+#define PYRAMID_ROWS        60
+#define PYRAMID_BOX_SIZE    20.0
+#define PYRAMID_STEP_COUNT  1200
+#define PYRAMID_SINK_LIMIT  10.0
+
+typedef enum {
+    BroadphaseSpatialHash,
+    BroadphaseAABBTree,
+    BroadphaseSweepAndPrune,
+    BroadphaseCount
+} Broadphase;
+
+static const char *broadphaseNames[BroadphaseCount] = {"hash", "tree", "sweep"};
+
+typedef enum {
+    SizeSmall,      // Radius 4-8 px.
+    SizeLarge,      // Radius 40-80 px.
+    SizeMixed,      // Radius 2-200 px, log-uniform.
+    SizeCount
+} SizeDistribution;
+
+static const char *sizeNames[SizeCount] = {"small", "large", "mixed"};
+
+typedef struct Pair {
+    cpHashValue a, b;
+} Pair;
+
+typedef struct PairList {
+    Pair *arr;
+    int num, max;
+} PairList;
+
+static double
+now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+// Small deterministic generator, so every run gets the same scene.
+static unsigned int randomState;
+
+static double
+randomValue(void)
+{
+    randomState = randomState*1103515245u + 12345u;
+    return ((randomState >> 8) & 0xffffff)/(double)0x1000000;
+}
+
+static int
+recordPair(cpShape *a, cpShape *b, cpContact *contacts, int numContacts, cpFloat normal_coef, void *data)
+{
+    PairList *list = (PairList *)data;
+    if(list->num == list->max){
+        list->max = (list->max ? list->max*2 : 1024);
+        list->arr = (Pair *)realloc(list->arr, list->max*sizeof(Pair));
+    }
+    
+    Pair pair = {(a->id < b->id ? a->id : b->id), (a->id < b->id ? b->id : a->id)};
+    list->arr[list->num++] = pair;
+    
+    return 0;
+}
+
+static int
+comparePairs(const void *p1, const void *p2)
+{
+    const Pair *a = (const Pair *)p1;
+    const Pair *b = (const Pair *)p2;
+    if(a->a != b->a) return (a->a < b->a ? -1 : 1);
+    if(a->b != b->b) return (a->b < b->b ? -1 : 1);
+    return 0;
+}
+
+static cpBB
+shapeBB(cpShape *shape)
+{
+    return shape->bb;
+}
+
+static cpSpace *
+newSpace(Broadphase broadphase, cpSpacePools *pools)
+{
+    cpSpace *space = cpSpaceNew();
+    cpSpaceUsePools(space, pools);
+    
+    // Same settings as KRSimulator2D.
+    if(broadphase == BroadphaseSpatialHash){
+        cpSpaceResizeActiveHash(space, 40.0, 1000);
+        cpSpaceResizeStaticHash(space, 200.0, 1000);
+        cpSpaceHashSetAutoResize((cpSpaceHash *)space->activeShapes, 1);
+    } else {
+        cpSpatialIndexBBFunc bbFunc = (cpSpatialIndexBBFunc)shapeBB;
+        cpSpatialIndex *activeIndex = (broadphase == BroadphaseAABBTree ? (cpSpatialIndex *)cpBBTreeNew(bbFunc) : (cpSpatialIndex *)cpSweep1DNew(bbFunc));
+        cpSpaceUseSpatialIndex(space, (cpSpatialIndex *)cpBBTreeNew(bbFunc), activeIndex);
+    }
+    
+    return space;
+}
+
+static cpSpace *
+createSpace(Broadphase broadphase, SizeDistribution sizes, int count, cpSpacePools *pools, PairList *pairs)
+{
+    cpSpace *space = newSpace(broadphase, pools);
+    
+    cpSpaceSetDefaultCollisionPairFunc(space, recordPair, pairs);
+    
+    randomState = 1234u + sizes*77u + count;
+    
+    // Pick the sizes first, then a world large enough to keep the same density for every scene.
+    double *radii = (double *)malloc(count*sizeof(double));
+    double area = 0.0;
+    for(int i=0; i<count; i++){
+        switch(sizes){
+            case SizeSmall: radii[i] = 4.0 + 4.0*randomValue(); break;
+            case SizeLarge: radii[i] = 40.0 + 40.0*randomValue(); break;
+            default:        radii[i] = 2.0*pow(100.0, randomValue()); break;
+        }
+        area += 4.0*radii[i]*radii[i];
+    }
+    double worldSize = sqrt(area/DENSITY);
+    
+    for(int i=0; i<count; i++){
+        double radius = radii[i];
+        
+        cpBody *body = cpBodyNew(1.0, cpMomentForCircle(1.0, 0.0, radius, cpvzero));
+        body->p = cpv(randomValue()*worldSize, randomValue()*worldSize);
+        body->v = cpv((randomValue() - 0.5)*200.0, (randomValue() - 0.5)*200.0);
+        cpSpaceAddBody(space, body);
+        
+        cpShape *shape = cpCircleShapeNew(body, radius, cpvzero);
+        shape->id = i;
+        cpSpaceAddShape(space, shape);
+    }
+    
+    free(radii);
+    return space;
+}
+
+// Boxes are built like KRShape2DBox, with the ground on a static body as in KRSimulator2D.
+static cpSpace *
+createPyramidSpace(Broadphase broadphase, cpSpacePools *pools, cpBody *staticBody)
+{
+    cpSpace *space = newSpace(broadphase, pools);
+    space->iterations = 20;
+    space->gravity = cpv(0.0, -500.0);
+    space->sleepTimeThreshold = 0.5;
+    
+    cpShape *ground = cpSegmentShapeNew(staticBody, cpv(-1000.0, 0.0), cpv(3000.0, 0.0), 0.0);
+    ground->u = 1.0;
+    cpSpaceAddStaticShape(space, ground);
+    
+    cpFloat half = PYRAMID_BOX_SIZE/2.0;
+    cpVect verts[] = {cpv(-half, -half), cpv(-half, half), cpv(half, half), cpv(half, -half)};
+    
+    for(int row=0; row<PYRAMID_ROWS; row++){
+        for(int i=0; i<PYRAMID_ROWS - row; i++){
+            cpBody *body = cpBodyNew(1.0, cpMomentForPoly(1.0, 4, verts, cpvzero));
+            body->p = cpv((i + row*0.5)*PYRAMID_BOX_SIZE + half, row*PYRAMID_BOX_SIZE + half);
+            cpSpaceAddBody(space, body);
+            
+            cpShape *shape = cpPolyShapeNew(body, 4, verts, cpvzero);
+            shape->e = 0.0;
+            shape->u = 0.8;
+            cpSpaceAddShape(space, shape);
+        }
+    }
+    
+    return space;
+}
+
+// Mean height of the boxes, awake or sleeping.
+static double
+pyramidHeight(cpSpace *space, int *sleepingCount)
+{
+    double sum = 0.0;
+    int count = 0;
+    *sleepingCount = 0;
+    
+    for(int i=0; i<space->bodies->num; i++){
+        sum += ((cpBody *)space->bodies->arr[i])->p.y;
+        count++;
+    }
+    
+    // Sleeping bodies leave the bodies array, but their shapes are kept in sleepingShapes.
+    for(int i=0; i<space->sleepingShapes->num; i++){
+        sum += ((cpShape *)space->sleepingShapes->arr[i])->body->p.y;
+        count++;
+        (*sleepingCount)++;
+    }
+    
+    return sum/count;
+}
+
+// Returns non-zero if the stack sank or did not fall asleep.
+static int
+runPyramid(Broadphase broadphase)
+{
+    cpSpacePools *pools = cpSpacePoolsNew();
+    cpBody *staticBody = cpBodyNew(INFINITY, INFINITY);
+    cpSpace *space = createPyramidSpace(broadphase, pools, staticBody);
+    
+    int sleepingCount;
+    int boxCount = space->bodies->num;
+    double startHeight = pyramidHeight(space, &sleepingCount);
+    
+    double start = now();
+    for(int step=0; step<PYRAMID_STEP_COUNT; step++)
+        cpSpaceStep(space, 1.0/60.0);
+    double total = now() - start;
+    
+    double endHeight = pyramidHeight(space, &sleepingCount);
+    int failed = (startHeight - endHeight > PYRAMID_SINK_LIMIT || sleepingCount != boxCount);
+    
+    printf("%-6s %6d %10.1f %10.1f %8d %10.3f %8s\n", broadphaseNames[broadphase], boxCount,
+           startHeight, endHeight, sleepingCount, total*1000.0/PYRAMID_STEP_COUNT, (failed ? "NO" : "yes"));
+    
+    cpSpaceFreeChildren(space);
+    cpSpaceFree(space);
+    cpBodyFree(staticBody);
+    cpSpacePoolsFree(pools);
+    
+    return failed;
+}
+
+int
+main(int argc, char **argv)
+{
+    cpInitChipmunk();
+    setvbuf(stdout, NULL, _IONBF, 0);
+    
+    int counts[] = {1000, 10000};
+    int mismatchCount = 0;
+    
+    printf("%-6s %6s %-6s %10s %10s %8s\n", "sizes", "count", "phase", "ms/step", "pairs/step", "match");
+    
+    for(int s=0; s<SizeCount; s++){
+        for(int c=0; c<2; c++){
+            PairList reference[STEP_COUNT];
+            memset(reference, 0, sizeof(reference));
+            
+            for(int b=0; b<BroadphaseCount; b++){
+                cpSpacePools *pools = cpSpacePoolsNew();
+                PairList pairs = {NULL, 0, 0};
+                cpSpace *space = createSpace((Broadphase)b, (SizeDistribution)s, counts[c], pools, &pairs);
+                
+                double total = 0.0;
+                long pairTotal = 0;
+                int match = 1;
+                
+                for(int step=0; step<STEP_COUNT; step++){
+                    pairs.num = 0;
+                    
+                    double start = now();
+                    cpSpaceStep(space, 1.0/60.0);
+                    total += now() - start;
+                    
+                    qsort(pairs.arr, pairs.num, sizeof(Pair), comparePairs);
+                    pairTotal += pairs.num;
+                    
+                    if(b == BroadphaseSpatialHash){
+                        reference[step] = pairs;
+                        reference[step].arr = (Pair *)malloc((pairs.num + 1)*sizeof(Pair));
+                        memcpy(reference[step].arr, pairs.arr, pairs.num*sizeof(Pair));
+                    } else if(reference[step].num != pairs.num || memcmp(reference[step].arr, pairs.arr, pairs.num*sizeof(Pair))){
+                        match = 0;
+                    }
+                }
+                
+                if(!match) mismatchCount++;
+                printf("%-6s %6d %-6s %10.3f %10ld %8s\n", sizeNames[s], counts[c], broadphaseNames[b],
+                       total*1000.0/STEP_COUNT, pairTotal/STEP_COUNT, (b == BroadphaseSpatialHash ? "-" : (match ? "yes" : "NO")));
+                
+                cpSpaceFreeChildren(space);
+                cpSpaceFree(space);
+                cpSpacePoolsFree(pools);
+                free(pairs.arr);
+            }
+            
+            for(int step=0; step<STEP_COUNT; step++)
+                free(reference[step].arr);
+        }
+    }
+    
+    printf("\n%-6s %6s %10s %10s %8s %10s %8s\n", "phase", "boxes", "start_y", "end_y", "sleeping", "ms/step", "stable");
+    
+    for(int b=0; b<BroadphaseCount; b++)
+        mismatchCount += runPyramid((Broadphase)b);
+    
+    return (mismatchCount ? 1 : 0);
+}
@@ -0,0 +1,5 @@
+/* AvailabilityMacros.h
+ * Stand-in for the Apple SDK header in the headless Linux build of the benchmarks.
+ */
+
+#define DEPRECATED_ATTRIBUTE
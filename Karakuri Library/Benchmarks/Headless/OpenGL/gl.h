@@ -0,0 +1,15 @@
+/* OpenGL/gl.h
+ * Stand-in for the OpenGL framework header in the headless Linux build of the benchmarks.
+ * The simulator sources only need the GL types that appear in the shared Karakuri headers.
+ */
+
+#pragma once
+
+typedef unsigned int    GLenum;
+typedef unsigned char   GLboolean;
+typedef unsigned char   GLubyte;
+typedef short           GLshort;
+typedef int             GLint;
+typedef int             GLsizei;
+typedef unsigned int    GLuint;
+typedef float           GLfloat;
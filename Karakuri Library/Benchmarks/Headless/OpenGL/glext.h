@@ -0,0 +1,3 @@
+/* OpenGL/glext.h
+ * Stand-in for the OpenGL framework header in the headless Linux build of the benchmarks.
+ */
@@ -0,0 +1,4 @@
+/* TargetConditionals.h
+ * Stand-in for the Apple SDK header in the headless Linux build of the benchmarks.
+ * None of the TARGET_OS_* macros are defined, so the Karakuri headers take the Mac OS X path.
+ */
@@ -0,0 +1,279 @@
+/* PrecisionBenchmark.c
+ * Compares the double and single precision builds of the embedded Chipmunk.
+ *
+ * Build and run from this directory:
+ *   FILES="../Karakuri/chipmunk/c*.c ../Karakuri/chipmunk/constraints/c*.c"
+ *   cc -std=gnu99 -O2 -I../Karakuri/chipmunk PrecisionBenchmark.c $FILES -lm -o PrecisionBenchmark_double
+ *   cc -std=gnu99 -O2 -I../Karakuri/chipmunk -DCP_USE_DOUBLES=0 -DCP_NO_SIMD PrecisionBenchmark.c $FILES -lm -o PrecisionBenchmark_float_scalar
+ *   cc -std=gnu99 -O2 -I../Karakuri/chipmunk -DCP_USE_DOUBLES=0 PrecisionBenchmark.c $FILES -lm -o PrecisionBenchmark_float
+ *   ./PrecisionBenchmark_double --write double.txt
+ *   ./PrecisionBenchmark_float_scalar --compare double.txt
+ *   ./PrecisionBenchmark_float --compare double.txt
+ *
+ * Each build runs the same scene: a pyramid of boxes resting on the ground and
+ * random convex polygons falling into a bin next to it. It prints the time per
+ * step, the time of one poly-poly collision test (findMSA() and findVerts()),
+ * how far the pyramid boxes sank or slid from where they were stacked, and the
+ * mean penetration of the contacts at the end. With --compare, the final body
+ * positions are compared with the ones written by another build. The falling
+ * polygons are chaotic, so their distance from the double build only shows how
+ * soon the builds part ways; the pyramid should stay close.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "chipmunk.h"
+
+#define PYRAMID_BASE        30
+#define BOX_SIZE            20.0
+#define POLY_COUNT          600
+#define STEP_COUNT          600
+#define COLLIDE_PAIR_COUNT  4096
+#define COLLIDE_REPEAT      200
+
+static double
+now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+// Same random numbers in every build.
+static unsigned int randomSeed = 12345;
+
+static double
+frand(void)
+{
+    randomSeed = randomSeed*1103515245 + 12345;
+    return ((randomSeed >> 8) & 0xffff)/65536.0;
+}
+
+// Random convex polygon with 5 to 8 vertices, in clockwise order.
+static int
+randomPoly(cpVect *verts, double radius)
+{
+    int num = 5 + (int)(frand()*4);
+    for(int i=0; i<num; i++){
+        double angle = -2.0*M_PI*(i + 0.3*frand())/num;
+        double r = radius*(0.8 + 0.2*frand());
+        verts[i] = cpv(r*cos(angle), r*sin(angle));
+    }
+    return num;
+}
+
+static cpShape *
+addPoly(cpSpace *space, cpVect pos, int num, cpVect *verts)
+{
+    cpBody *body = cpBodyNew(1.0, cpMomentForPoly(1.0, num, verts, cpvzero));
+    body->p = pos;
+    cpSpaceAddBody(space, body);
+
+    cpShape *shape = cpPolyShapeNew(body, num, verts, cpvzero);
+    shape->e = 0.0;
+    shape->u = 0.8;
+    return cpSpaceAddShape(space, shape);
+}
+
+static void
+addWall(cpSpace *space, cpBody *staticBody, cpVect a, cpVect b)
+{
+    cpShape *wall = cpSegmentShapeNew(staticBody, a, b, 0.0);
+    wall->u = 1.0;
+    cpSpaceAddStaticShape(space, wall);
+}
+
+typedef struct Scene {
+    cpSpace *space;
+    cpBody *staticBody;
+    cpBody **bodies;
+    cpVect *start;
+    int pyramidCount, bodyCount;
+} Scene;
+
+static void
+createScene(Scene *scene)
+{
+    cpSpace *space = scene->space = cpSpaceNew();
+    space->iterations = 10;
+    space->gravity = cpv(0.0, -500.0);
+    cpSpaceResizeActiveHash(space, 30.0, 4000);
+
+    cpBody *staticBody = scene->staticBody = cpBodyNew(INFINITY, INFINITY);
+    addWall(space, staticBody, cpv(-1000.0, 0.0), cpv(2000.0, 0.0));
+    addWall(space, staticBody, cpv(800.0, 0.0), cpv(800.0, 2000.0));
+    addWall(space, staticBody, cpv(1600.0, 0.0), cpv(1600.0, 2000.0));
+
+    scene->bodies = (cpBody **)malloc((PYRAMID_BASE*PYRAMID_BASE + POLY_COUNT)*sizeof(cpBody *));
+    scene->start = (cpVect *)malloc((PYRAMID_BASE*PYRAMID_BASE + POLY_COUNT)*sizeof(cpVect));
+    int count = 0;
+
+    cpFloat h = BOX_SIZE/2.0;
+    cpVect box[] = {cpv(-h, -h), cpv(-h, h), cpv(h, h), cpv(h, -h)};
+    for(int row=0; row<PYRAMID_BASE; row++){
+        for(int i=0; i<PYRAMID_BASE - row; i++){
+            cpVect pos = cpv((i + row*0.5)*BOX_SIZE, (row + 0.5)*BOX_SIZE);
+            scene->start[count] = pos;
+            scene->bodies[count++] = addPoly(space, pos, 4, box)->body;
+        }
+    }
+    scene->pyramidCount = count;
+
+    for(int i=0; i<POLY_COUNT; i++){
+        cpVect verts[8];
+        int num = randomPoly(verts, 8.0 + 8.0*frand());
+        cpVect pos = cpv(820.0 + 760.0*frand(), 50.0 + 1500.0*frand());
+        scene->start[count] = pos;
+        scene->bodies[count++] = addPoly(space, pos, num, verts)->body;
+    }
+    scene->bodyCount = count;
+}
+
+static void
+freeScene(Scene *scene)
+{
+    cpSpaceFreeChildren(scene->space);
+    cpSpaceFree(scene->space);
+    cpBodyFree(scene->staticBody);
+    free(scene->bodies);
+    free(scene->start);
+}
+
+static void
+sumPenetration(cpArbiter *arb, void *data)
+{
+    double *sum = (double *)data;
+    for(int i=0; i<arb->numContacts; i++){
+        sum[0] += fmax(0.0, -arb->contacts[i].dist);
+        sum[1] += 1.0;
+    }
+}
+
+// Time of one cpCollideShapes() call on overlapping random polygons.
+static double
+collideTime(void)
+{
+    cpBody *bodies[2*COLLIDE_PAIR_COUNT];
+    cpShape *shapes[2*COLLIDE_PAIR_COUNT];
+    for(int i=0; i<2*COLLIDE_PAIR_COUNT; i++){
+        cpVect verts[8];
+        int num = randomPoly(verts, 10.0);
+        bodies[i] = cpBodyNew(1.0, 1.0);
+        bodies[i]->p = cpv((i/2)*100.0 + (i & 1)*(8.0 + 8.0*frand()), 8.0*frand());
+        cpBodySetAngle(bodies[i], 2.0*M_PI*frand());
+        shapes[i] = cpPolyShapeNew(bodies[i], num, verts, cpvzero);
+        cpShapeCacheBB(shapes[i]);
+    }
+
+    cpContactBuffer buffer = {NULL, 0, 0, NULL};
+    int contacts = 0;
+    double start = now();
+    for(int r=0; r<COLLIDE_REPEAT; r++){
+        for(int i=0; i<COLLIDE_PAIR_COUNT; i++)
+            contacts += cpCollideShapes(shapes[2*i], shapes[2*i + 1], &buffer);
+    }
+    double time = (now() - start)/(COLLIDE_REPEAT*COLLIDE_PAIR_COUNT);
+    if(contacts == 0) printf("no contacts found\n");
+
+    for(int i=0; i<2*COLLIDE_PAIR_COUNT; i++){
+        cpShapeFree(shapes[i]);
+        cpBodyFree(bodies[i]);
+    }
+    free(buffer.arr);
+
+    return time;
+}
+
+int
+main(int argc, char **argv)
+{
+    const char *writePath = NULL;
+    const char *comparePath = NULL;
+    for(int i=1; i + 1<argc; i+=2){
+        if(!strcmp(argv[i], "--write")) writePath = argv[i + 1];
+        else if(!strcmp(argv[i], "--compare")) comparePath = argv[i + 1];
+    }
+
+    cpInitChipmunk();
+
+#if CP_USE_DOUBLES
+    const char *build = "double";
+#elif CP_USE_SIMD
+    const char *build = "float+simd";
+#else
+    const char *build = "float";
+#endif
+
+    Scene scene;
+    createScene(&scene);
+
+    double total = 0.0;
+    for(int step=0; step<STEP_COUNT; step++){
+        double start = now();
+        cpSpaceStep(scene.space, 1.0/60.0);
+        total += now() - start;
+    }
+
+    // How far the stacked boxes moved while settling.
+    double maxDrift = 0.0, meanDrift = 0.0;
+    for(int i=0; i<scene.pyramidCount; i++){
+        double drift = cpvdist(scene.bodies[i]->p, scene.start[i]);
+        maxDrift = fmax(maxDrift, drift);
+        meanDrift += drift/scene.pyramidCount;
+    }
+
+    double penetration[2] = {0.0, 0.0};
+    cpSpaceEachArbiter(scene.space, sumPenetration, penetration);
+
+    printf("build          %s (cpFloat is %d bytes, cpContact is %d bytes)\n", build, (int)sizeof(cpFloat), (int)sizeof(cpContact));
+    printf("step           %.3f ms\n", total*1000.0/STEP_COUNT);
+    printf("poly collide   %.1f ns\n", collideTime()*1e9);
+    printf("pyramid drift  mean %.4f px, max %.4f px\n", meanDrift, maxDrift);
+    printf("penetration    mean %.4f px over %d contacts\n", penetration[0]/fmax(penetration[1], 1.0), (int)penetration[1]);
+
+    if(writePath){
+        FILE *file = fopen(writePath, "w");
+        if(!file){
+            perror(writePath);
+            return 1;
+        }
+        for(int i=0; i<scene.bodyCount; i++)
+            fprintf(file, "%.17g %.17g\n", (double)scene.bodies[i]->p.x, (double)scene.bodies[i]->p.y);
+        fclose(file);
+    }
+
+    if(comparePath){
+        FILE *file = fopen(comparePath, "r");
+        if(!file){
+            perror(comparePath);
+            return 1;
+        }
+        double pyramidMax = 0.0, pyramidMean = 0.0, polyMax = 0.0, polyMean = 0.0;
+        for(int i=0; i<scene.bodyCount; i++){
+            double x, y;
+            if(fscanf(file, "%lf %lf", &x, &y) != 2){
+                printf("%s has fewer bodies than the scene\n", comparePath);
+                return 1;
+            }
+            double distance = cpvdist(scene.bodies[i]->p, cpv(x, y));
+            if(i < scene.pyramidCount){
+                pyramidMax = fmax(pyramidMax, distance);
+                pyramidMean += distance/scene.pyramidCount;
+            } else {
+                polyMax = fmax(polyMax, distance);
+                polyMean += distance/(scene.bodyCount - scene.pyramidCount);
+            }
+        }
+        fclose(file);
+        printf("vs %s\n", comparePath);
+        printf("  pyramid      mean %.4f px, max %.4f px\n", pyramidMean, pyramidMax);
+        printf("  polygons     mean %.4f px, max %.4f px\n", polyMean, polyMax);
+    }
+
+    freeScene(&scene);
+    return 0;
+}
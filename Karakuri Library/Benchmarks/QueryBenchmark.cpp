@@ -0,0 +1,349 @@
+/* QueryBenchmark.cpp
+ * Headless check of the KRSimulator2D queries against a brute-force search.
+ *
+ * Build and run from this directory (Linux, no Mac OS X frameworks needed):
+ *   make
+ *   ./QueryBenchmark
+ *
+ * Every broadphase gets the same scene: static walls and boxes, and 1,000 moving
+ * circles, boxes and triangles of mixed sizes, stepped for one second so that the
+ * broadphase has reindexed the moving shapes. Then 500 random segments are run
+ * through each query and compared against cpShapeSegmentQuery() and cpBBintersects()
+ * over every shape in the scene:
+ *   raycast        the nearest shape and its fraction (another shape at the same fraction also passes)
+ *   batch          raycast() with all 500 segments at once, checked the same way
+ *   segment        segmentQuery(): every shape exactly once, with its fraction, nearest first
+ *   box            boxQuery() with a random rectangle per segment: the same set of shapes
+ *
+ * Prints one line per broadphase with the query times and the mismatch counts,
+ * and exits with 1 if any query disagrees with the brute-force search.
+ */
+
+#include <Karakuri/KRSimulator2D.h>
+#include <Karakuri/KRGameManager.h>
+#include <Karakuri/KRMemoryAllocator.h>
+#include <Karakuri/chipmunk/chipmunk.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <time.h>
+
+
+#pragma mark -
+#pragma mark Headless Build Support
+
+// KRSimulator2D::step() without arguments asks the game manager for the frame rate.
+// The check always passes the time, so the game manager is never created.
+KRGameManager*  gKRGameMan = NULL;
+
+double KRGameManager::getFrameRate() const
+{
+    return 60.0;
+}
+
+// KRMemoryStats reads the chara slots from the chara allocator, which belongs to KRAnime2DManager.
+KRSizeClassAllocator*   _gKRChara2DAllocator = NULL;
+
+
+#pragma mark -
+#pragma mark Scene
+
+static const int    sShapeCount = 1000;
+static const int    sSegmentCount = 500;
+static const double sWorldSize = 2000.0;
+static const double sFractionTolerance = 1e-9;
+
+// Same layers as the queries of KRSimulator2D.
+static const cpLayers   sAllLayers = (GRABABLE_MASK_BIT | NOT_GRABABLE_MASK);
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Same random numbers on every run.
+static unsigned int sRandomSeed = 12345;
+
+static double frand()
+{
+    sRandomSeed = sRandomSeed * 1103515245 + 12345;
+    return ((sRandomSeed >> 8) & 0xffff) / 65536.0;
+}
+
+// Sizes from 2 to 100, with as many small shapes as large ones on a log scale.
+static double randomSize()
+{
+    return 2.0 * pow(50.0, frand());
+}
+
+template <class T, class Base>
+static void deleteAs(Base* obj)
+{
+    delete static_cast<T*>(obj);
+}
+
+struct Scene {
+    KRSimulator2D*              simulator;
+    std::vector<KRShape2D*>     shapes;
+    std::vector<void (*)(KRShape2D*)>   shapeDeleters;
+
+    Scene(KRSimulator2DBroadphase broadphase)
+    {
+        simulator = new KRSimulator2D(KRVector2D(0.0, 0.0), broadphase);
+    }
+
+    ~Scene()
+    {
+        for (size_t i = 0; i < shapes.size(); i++) {
+            simulator->removeShape(shapes[i]);
+            shapeDeleters[i](shapes[i]);
+        }
+        delete simulator;
+    }
+
+    template <class T>
+    T* addShape(T* shape)
+    {
+        simulator->addShape(shape);
+        shapes.push_back(shape);
+        shapeDeleters.push_back(&deleteAs<T, KRShape2D>);
+        return shape;
+    }
+};
+
+static Scene* createScene(KRSimulator2DBroadphase broadphase)
+{
+    sRandomSeed = 12345;
+    Scene* scene = new Scene(broadphase);
+
+    scene->addShape(new KRShape2DLine(KRVector2D(0.0, 0.0), KRVector2D(sWorldSize, 0.0), true));
+    scene->addShape(new KRShape2DLine(KRVector2D(0.0, sWorldSize), KRVector2D(sWorldSize, sWorldSize), true));
+    scene->addShape(new KRShape2DLine(KRVector2D(0.0, 0.0), KRVector2D(0.0, sWorldSize), true));
+    scene->addShape(new KRShape2DLine(KRVector2D(sWorldSize, 0.0), KRVector2D(sWorldSize, sWorldSize), true));
+
+    for (int i = 0; i < 50; i++) {
+        double width = randomSize();
+        double height = randomSize();
+        scene->addShape(new KRShape2DBox(KRRect2D(frand() * (sWorldSize - width), frand() * (sWorldSize - height), width, height), true));
+    }
+
+    for (int i = 0; i < sShapeCount; i++) {
+        double size = randomSize();
+        KRVector2D pos(size + frand() * (sWorldSize - size * 2), size + frand() * (sWorldSize - size * 2));
+
+        KRShape2D* shape;
+        int type = i % 3;
+        if (type == 0) {
+            shape = scene->addShape(new KRShape2DCircle(pos, size / 2));
+        } else if (type == 1) {
+            shape = scene->addShape(new KRShape2DBox(KRRect2D(pos.x - size / 2, pos.y - size / 2, size, size * (0.5 + frand()))));
+        } else {
+            // Clockwise, as Chipmunk expects.
+            double r = size / 2;
+            KRVector2D verts[3] = { KRVector2D(-r, -r), KRVector2D(0.0, r), KRVector2D(r, -r) };
+            shape = scene->addShape(new KRShape2DPoly(3, verts, pos));
+        }
+        shape->setVelocity(KRVector2D((frand() - 0.5) * 200.0, (frand() - 0.5) * 200.0));
+    }
+
+    for (int i = 0; i < 60; i++) {
+        scene->simulator->step(1.0 / 60.0);
+    }
+    return scene;
+}
+
+
+#pragma mark -
+#pragma mark Brute-Force Search
+
+static bool bruteSegmentQuery(KRShape2D* shape, const KRVector2D& start, const KRVector2D& end, double* fraction)
+{
+    // cpShapeSegmentQuery() only fills in the info on a hit, so it starts empty as in cpSpace.c.
+    cpSegmentQueryInfo info = { NULL, 1.0, cpvzero };
+    if (!cpShapeSegmentQuery((cpShape*)shape->getCPShape(), cpv(start.x, start.y), cpv(end.x, end.y), sAllLayers, 0, &info)) {
+        return false;
+    }
+    *fraction = info.t;
+    return true;
+}
+
+// The nearest fraction of all shapes, or 2.0 if the segment hits nothing.
+static double bruteRaycast(const Scene* scene, const KRVector2D& start, const KRVector2D& end)
+{
+    double nearest = 2.0;
+    for (size_t i = 0; i < scene->shapes.size(); i++) {
+        double fraction;
+        if (bruteSegmentQuery(scene->shapes[i], start, end, &fraction)) {
+            nearest = std::min(nearest, fraction);
+        }
+    }
+    return nearest;
+}
+
+static bool checkRaycastHit(const Scene* scene, const KRVector2D& start, const KRVector2D& end, const KRRaycastHit2D& hit)
+{
+    double nearest = bruteRaycast(scene, start, end);
+    if (hit.shape == NULL) {
+        return (nearest > 1.0);
+    }
+
+    // Any shape at the nearest fraction is a correct answer.
+    double fraction;
+    if (!bruteSegmentQuery(hit.shape, start, end, &fraction)) {
+        return false;
+    }
+    return (fabs(fraction - hit.fraction) <= sFractionTolerance && fabs(fraction - nearest) <= sFractionTolerance);
+}
+
+static bool compareHitsByShape(const KRRaycastHit2D& hit1, const KRRaycastHit2D& hit2)
+{
+    return (hit1.shape < hit2.shape);
+}
+
+static bool checkSegmentQuery(const Scene* scene, const KRVector2D& start, const KRVector2D& end, const std::vector<KRRaycastHit2D>& hits)
+{
+    for (size_t i = 1; i < hits.size(); i++) {
+        if (hits[i].fraction < hits[i - 1].fraction) {
+            return false;
+        }
+    }
+
+    std::vector<KRRaycastHit2D> expected;
+    for (size_t i = 0; i < scene->shapes.size(); i++) {
+        KRRaycastHit2D hit;
+        if (bruteSegmentQuery(scene->shapes[i], start, end, &hit.fraction)) {
+            hit.shape = scene->shapes[i];
+            expected.push_back(hit);
+        }
+    }
+    if (expected.size() != hits.size()) {
+        return false;
+    }
+
+    std::vector<KRRaycastHit2D> sortedHits(hits);
+    std::sort(sortedHits.begin(), sortedHits.end(), compareHitsByShape);
+    std::sort(expected.begin(), expected.end(), compareHitsByShape);
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (sortedHits[i].shape != expected[i].shape || fabs(sortedHits[i].fraction - expected[i].fraction) > sFractionTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool checkBoxQuery(const Scene* scene, const KRRect2D& rect, const std::vector<KRShape2D*>& shapes)
+{
+    cpBB bb = cpBBNew(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+
+    std::vector<KRShape2D*> expected;
+    for (size_t i = 0; i < scene->shapes.size(); i++) {
+        if (cpBBintersects(bb, ((cpShape*)scene->shapes[i]->getCPShape())->bb)) {
+            expected.push_back(scene->shapes[i]);
+        }
+    }
+
+    std::vector<KRShape2D*> sortedShapes(shapes);
+    std::sort(sortedShapes.begin(), sortedShapes.end());
+    std::sort(expected.begin(), expected.end());
+    return (sortedShapes == expected);
+}
+
+
+#pragma mark -
+#pragma mark Main
+
+static int runBroadphase(KRSimulator2DBroadphase broadphase, const char* broadphaseName)
+{
+    Scene* scene = createScene(broadphase);
+
+    // Segments from 10 to 2,000 long, and rectangles from 2 to 100 on a side.
+    sRandomSeed = 777;
+    std::vector<KRVector2D> starts(sSegmentCount);
+    std::vector<KRVector2D> ends(sSegmentCount);
+    std::vector<KRRect2D> rects(sSegmentCount);
+    for (int i = 0; i < sSegmentCount; i++) {
+        double angle = frand() * M_PI * 2;
+        double length = 10.0 * pow(200.0, frand());
+        starts[i] = KRVector2D(frand() * sWorldSize, frand() * sWorldSize);
+        ends[i] = starts[i] + KRVector2D(cos(angle), sin(angle)) * length;
+        double width = randomSize();
+        double height = randomSize();
+        rects[i] = KRRect2D(frand() * sWorldSize, frand() * sWorldSize, width, height);
+    }
+
+    int raycastMismatches = 0;
+    int batchMismatches = 0;
+    int segmentMismatches = 0;
+    int boxMismatches = 0;
+    double raycastTime = 0.0;
+    double batchTime = 0.0;
+    double segmentTime = 0.0;
+    double boxTime = 0.0;
+    int hitCount = 0;
+
+    std::vector<KRRaycastHit2D> batchHits(sSegmentCount);
+    double start = now();
+    scene->simulator->raycast(sSegmentCount, &starts[0], &ends[0], &batchHits[0]);
+    batchTime = now() - start;
+
+    std::vector<KRRaycastHit2D> hits;
+    std::vector<KRShape2D*> shapes;
+    for (int i = 0; i < sSegmentCount; i++) {
+        KRRaycastHit2D hit;
+        start = now();
+        scene->simulator->raycast(starts[i], ends[i], &hit);
+        raycastTime += now() - start;
+        if (!checkRaycastHit(scene, starts[i], ends[i], hit)) {
+            raycastMismatches++;
+        }
+        if (hit.shape != NULL) {
+            hitCount++;
+        }
+
+        if (!checkRaycastHit(scene, starts[i], ends[i], batchHits[i])) {
+            batchMismatches++;
+        }
+
+        start = now();
+        scene->simulator->segmentQuery(starts[i], ends[i], hits);
+        segmentTime += now() - start;
+        if (!checkSegmentQuery(scene, starts[i], ends[i], hits)) {
+            segmentMismatches++;
+        }
+
+        start = now();
+        scene->simulator->boxQuery(rects[i], shapes);
+        boxTime += now() - start;
+        if (!checkBoxQuery(scene, rects[i], shapes)) {
+            boxMismatches++;
+        }
+    }
+
+    int mismatchCount = raycastMismatches + batchMismatches + segmentMismatches + boxMismatches;
+    printf("%-6s %6d %10.3f %10.3f %10.3f %10.3f %4d %4d %4d %4d %6s\n", broadphaseName, hitCount,
+           raycastTime * 1000.0, batchTime * 1000.0, segmentTime * 1000.0, boxTime * 1000.0,
+           raycastMismatches, batchMismatches, segmentMismatches, boxMismatches, (mismatchCount == 0? "ok": "FAIL"));
+
+    delete scene;
+    return mismatchCount;
+}
+
+int main()
+{
+    KRSimulator2D::initSimulatorSystem();
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    printf("%-6s %6s %10s %10s %10s %10s %4s %4s %4s %4s %6s\n", "phase", "hits",
+           "raycast_ms", "batch_ms", "segment_ms", "box_ms", "ray", "bat", "seg", "box", "check");
+
+    int mismatchCount = 0;
+    mismatchCount += runBroadphase(KRSimulator2DBroadphaseSpatialHash, "hash");
+    mismatchCount += runBroadphase(KRSimulator2DBroadphaseAABBTree, "tree");
+    mismatchCount += runBroadphase(KRSimulator2DBroadphaseSweepAndPrune, "sweep");
+
+    return (mismatchCount == 0? 0: 1);
+}
@@ -0,0 +1,258 @@
+/* RollbackBenchmark.cpp
+ * Headless check that KRSimulator2D::restoreState() rolls back bit for bit.
+ *
+ * Build and run from this directory (Linux, no Mac OS X frameworks needed):
+ *   make
+ *   ./RollbackBenchmark
+ *
+ * Every broadphase gets the same scene: a 60-row pyramid of boxes and pivot-joint
+ * chains swinging into its side, 2,000 bodies in all. The scene is stepped for one
+ * second and saved. Then it is stepped for REPLAY_STEP_COUNT steps, and the positions,
+ * angles and velocities of every body are recorded. The state is restored and the same
+ * steps are replayed ROLLBACK_COUNT times, and every replay must match the recording
+ * exactly.
+ *
+ * Prints one line per broadphase with the save and restore times, the snapshot size,
+ * the number of bodies that differ after the replays and the largest position error.
+ * Exits with 1 if any replay differs.
+ */
+
+#include <Karakuri/KRSimulator2D.h>
+#include <Karakuri/KRGameManager.h>
+#include <Karakuri/KRMemoryAllocator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <time.h>
+
+
+#pragma mark -
+#pragma mark Headless Build Support
+
+// KRSimulator2D::step() without arguments asks the game manager for the frame rate.
+// The check always passes the time, so the game manager is never created.
+KRGameManager*  gKRGameMan = NULL;
+
+double KRGameManager::getFrameRate() const
+{
+    return 60.0;
+}
+
+// KRMemoryStats reads the chara slots from the chara allocator, which belongs to KRAnime2DManager.
+KRSizeClassAllocator*   _gKRChara2DAllocator = NULL;
+
+
+#pragma mark -
+#pragma mark Scene
+
+#define WARMUP_STEP_COUNT   60
+#define REPLAY_STEP_COUNT   120
+#define ROLLBACK_COUNT      3
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+template <class T, class Base>
+static void deleteAs(Base* obj)
+{
+    delete static_cast<T*>(obj);
+}
+
+struct Scene {
+    KRSimulator2D*              simulator;
+    std::vector<KRShape2D*>     shapes;
+    std::vector<void (*)(KRShape2D*)>   shapeDeleters;
+    std::vector<KRJoint2D*>     joints;
+    int                         bodyCount;
+
+    Scene(KRSimulator2DBroadphase broadphase)
+        : bodyCount(0)
+    {
+        simulator = new KRSimulator2D(KRVector2D(0.0, -500.0), broadphase);
+    }
+
+    ~Scene()
+    {
+        for (size_t i = 0; i < joints.size(); i++) {
+            simulator->removeJoint(joints[i]);
+            delete static_cast<KRJoint2DPivot*>(joints[i]);
+        }
+        for (size_t i = 0; i < shapes.size(); i++) {
+            simulator->removeShape(shapes[i]);
+            shapeDeleters[i](shapes[i]);
+        }
+        delete simulator;
+    }
+
+    template <class T>
+    KRShape2D* addShape(T* shape)
+    {
+        simulator->addShape(shape);
+        shapes.push_back(shape);
+        shapeDeleters.push_back(&deleteAs<T, KRShape2D>);
+        if (!shape->isStatic()) {
+            bodyCount++;
+        }
+        return shape;
+    }
+
+    void addJoint(KRJoint2DPivot* joint)
+    {
+        simulator->addJoint(joint);
+        joints.push_back(joint);
+    }
+};
+
+static Scene* createScene(KRSimulator2DBroadphase broadphase)
+{
+    static const int    rowCount = 60;
+    static const double boxSize = 20.0;
+    static const int    chainCount = 10;
+    static const int    linkCount = 17;
+    static const double linkSize = 10.0;
+
+    Scene* scene = new Scene(broadphase);
+
+    KRShape2D* ground = scene->addShape(new KRShape2DLine(KRVector2D(-1000.0, 0.0), KRVector2D(3000.0, 0.0), true));
+    ground->setFriction(1.0);
+
+    for (int row = 0; row < rowCount; row++) {
+        for (int i = 0; i < rowCount - row; i++) {
+            KRShape2D* box = scene->addShape(new KRShape2DBox(KRRect2D((i + row * 0.5) * boxSize, row * boxSize, boxSize, boxSize)));
+            box->setElasticity(0.0);
+            box->setFriction(0.8);
+        }
+    }
+
+    // Chains hang from above the right side of the pyramid, tilted away from it, and swing into it.
+    for (int c = 0; c < chainCount; c++) {
+        KRVector2D top(rowCount * boxSize * 0.75 + c * 40.0, 900.0);
+        KRVector2D anchor(0.0, linkSize / 2);
+        KRShape2D* prev = NULL;
+
+        for (int i = 0; i < linkCount; i++) {
+            KRVector2D pos(top.x + (i + 0.5) * linkSize * 0.8, top.y - (i + 0.5) * linkSize * 0.6);
+            KRShape2D* link = scene->addShape(new KRShape2DCircle(pos, linkSize / 2));
+            link->setMass(0.2);
+
+            if (prev) {
+                scene->addJoint(new KRJoint2DPivot(prev, -anchor, link, anchor));
+            } else {
+                scene->addJoint(new KRJoint2DPivot(link, anchor, top));
+            }
+            prev = link;
+        }
+    }
+    return scene;
+}
+
+struct BodyRecord {
+    KRVector2D  pos;
+    KRVector2D  velocity;
+    double      angle;
+    double      angleVelocity;
+};
+
+static void recordBodies(const Scene* scene, std::vector<BodyRecord>& records)
+{
+    records.clear();
+    for (size_t i = 0; i < scene->shapes.size(); i++) {
+        KRShape2D* shape = scene->shapes[i];
+        if (shape->isStatic()) {
+            continue;
+        }
+        BodyRecord record;
+        record.pos = shape->getCenterPos();
+        record.velocity = shape->getVelocity();
+        record.angle = shape->getAngle();
+        record.angleVelocity = shape->getAngleVelocity();
+        records.push_back(record);
+    }
+}
+
+static void replay(Scene* scene)
+{
+    for (int i = 0; i < REPLAY_STEP_COUNT; i++) {
+        scene->simulator->step(1.0 / 60.0);
+    }
+}
+
+
+#pragma mark -
+#pragma mark Main
+
+static int runBroadphase(KRSimulator2DBroadphase broadphase, const char* broadphaseName)
+{
+    Scene* scene = createScene(broadphase);
+    for (int i = 0; i < WARMUP_STEP_COUNT; i++) {
+        scene->simulator->step(1.0 / 60.0);
+    }
+
+    std::vector<unsigned char> buffer;
+    double saveTime = 0.0;
+    for (int i = 0; i < ROLLBACK_COUNT; i++) {
+        double start = now();
+        scene->simulator->saveState(buffer);
+        saveTime += now() - start;
+    }
+
+    std::vector<BodyRecord> expected;
+    replay(scene);
+    recordBodies(scene, expected);
+
+    // Every restore rolls back over REPLAY_STEP_COUNT steps of motion, as a rollback would.
+    std::vector<BodyRecord> actual;
+    double restoreTime = 0.0;
+    double maxRestoreTime = 0.0;
+    int differentCount = 0;
+    double maxError = 0.0;
+    for (int i = 0; i < ROLLBACK_COUNT; i++) {
+        double start = now();
+        scene->simulator->restoreState(buffer);
+        double time = now() - start;
+        restoreTime += time;
+        maxRestoreTime = std::max(maxRestoreTime, time);
+
+        replay(scene);
+        recordBodies(scene, actual);
+        for (size_t j = 0; j < expected.size(); j++) {
+            const BodyRecord& a = expected[j];
+            const BodyRecord& b = actual[j];
+            if (a.pos.x != b.pos.x || a.pos.y != b.pos.y || a.velocity.x != b.velocity.x || a.velocity.y != b.velocity.y ||
+                a.angle != b.angle || a.angleVelocity != b.angleVelocity)
+            {
+                differentCount++;
+                maxError = std::max(maxError, (a.pos - b.pos).length());
+            }
+        }
+    }
+
+    printf("%-6s %6d %8.1f %8.3f %10.3f %10.3f %9d %9.3f %6s\n", broadphaseName, scene->bodyCount, buffer.size() / 1024.0,
+           saveTime * 1000.0 / ROLLBACK_COUNT, restoreTime * 1000.0 / ROLLBACK_COUNT, maxRestoreTime * 1000.0,
+           differentCount, maxError, (differentCount == 0? "ok": "FAIL"));
+
+    delete scene;
+    return differentCount;
+}
+
+int main()
+{
+    KRSimulator2D::initSimulatorSystem();
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    printf("%-6s %6s %8s %8s %10s %10s %9s %9s %6s\n", "phase", "bodies", "kb", "save_ms", "restore_ms", "restore_max",
+           "different", "error_px", "check");
+
+    int differentCount = 0;
+    differentCount += runBroadphase(KRSimulator2DBroadphaseSpatialHash, "hash");
+    differentCount += runBroadphase(KRSimulator2DBroadphaseAABBTree, "tree");
+    differentCount += runBroadphase(KRSimulator2DBroadphaseSweepAndPrune, "sweep");
+
+    return (differentCount == 0? 0: 1);
+}
@@ -0,0 +1,508 @@
+/* SimulatorBenchmark.cpp
+ * Headless benchmark of KRSimulator2D with canned scenes.
+ *
+ * Build and run from this directory (Linux, no Mac OS X frameworks needed):
+ *   make
+ *   ./SimulatorBenchmark
+ *   ./SimulatorBenchmark --scene pyramid --steps 1000 --broadphase tree --threads 4
+ *   ./SimulatorBenchmark --scene settled --broadphase all
+ *
+ * Options:
+ *   --scene pyramid|settled|circles|chains|rotating|all   (default: all)
+ *   --steps N                                             (default: the scene's own count)
+ *   --broadphase hash|tree|sweep|all                      (default: hash)
+ *   --threads N                                           (default: 1, 0 uses every CPU)
+ *
+ * Every scene prints one line of JSON:
+ *   scene, broadphase, threads, shapes, joints, steps
+ *   mean_ms, p50_ms, p99_ms, max_ms      time of one step() call
+ *   pool_allocs_per_step                 mean of getStepAllocCount()
+ *   pool_heap_allocs                     sum of getStepHeapAllocCount()
+ *   heap_allocs_per_step                 malloc() calls per step, all steps
+ *   heap_allocs_steady                   malloc() calls per step, after the first 10% of the steps
+ *   pool_peak_kb                         peak of KRMemoryStats for KRMemoryCategorySimulator
+ *   sleeping_shapes                      getSleepingShapeCount() after the last step
+ *   asleep_step                          step from which every moving shape sleeps to the end, -1 if never
+ *   asleep_mean_ms                       mean time of the steps after asleep_step, -1 if never
+ *
+ * The malloc() calls are counted by wrapping the glibc allocator, so the last
+ * two fields are -1 on other C libraries.
+ */
+
+#include <Karakuri/KRSimulator2D.h>
+#include <Karakuri/KRGameManager.h>
+#include <Karakuri/KRMemoryAllocator.h>
+#include <Karakuri/KRMemoryStats.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <time.h>
+
+
+#pragma mark -
+#pragma mark Headless Build Support
+
+// KRSimulator2D::step() without arguments asks the game manager for the frame rate.
+// The benchmark always passes the time, so the game manager is never created.
+KRGameManager*  gKRGameMan = NULL;
+
+double KRGameManager::getFrameRate() const
+{
+    return 60.0;
+}
+
+// KRMemoryStats reads the chara slots from the chara allocator, which belongs to KRAnime2DManager.
+KRSizeClassAllocator*   _gKRChara2DAllocator = NULL;
+
+
+#pragma mark -
+#pragma mark Heap Allocation Counting
+
+static volatile unsigned long sHeapAllocCount = 0;
+
+#ifdef __GLIBC__
+
+extern "C" {
+
+extern void*    __libc_malloc(size_t size);
+extern void*    __libc_calloc(size_t count, size_t size);
+extern void*    __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+    __sync_fetch_and_add(&sHeapAllocCount, 1);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    __sync_fetch_and_add(&sHeapAllocCount, 1);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    __sync_fetch_and_add(&sHeapAllocCount, 1);
+    return __libc_realloc(ptr, size);
+}
+
+}   // extern "C"
+
+static const bool   sCountsHeapAllocs = true;
+
+#else
+
+static const bool   sCountsHeapAllocs = false;
+
+#endif
+
+
+#pragma mark -
+#pragma mark Scenes
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Same random numbers on every run.
+static unsigned int sRandomSeed = 12345;
+
+static double frand()
+{
+    sRandomSeed = sRandomSeed * 1103515245 + 12345;
+    return ((sRandomSeed >> 8) & 0xffff) / 65536.0;
+}
+
+// The destructors of the base classes are protected, so each shape and joint is
+// deleted through its own class.
+template <class T, class Base>
+static void deleteAs(Base* obj)
+{
+    delete static_cast<T*>(obj);
+}
+
+struct Scene {
+    KRSimulator2D*              simulator;
+    std::vector<KRShape2D*>     shapes;
+    std::vector<void (*)(KRShape2D*)>   shapeDeleters;
+    std::vector<KRJoint2D*>     joints;
+    std::vector<void (*)(KRJoint2D*)>   jointDeleters;
+    int                         stepCount;
+    int                         movingShapeCount;
+    double                      angularVelocity;    // Rotation of the static body per second.
+
+    Scene(KRSimulator2DBroadphase broadphase, int theStepCount)
+        : stepCount(theStepCount), movingShapeCount(0), angularVelocity(0.0)
+    {
+        simulator = new KRSimulator2D(KRVector2D(0.0, -500.0), broadphase);
+    }
+
+    ~Scene()
+    {
+        for (size_t i = 0; i < joints.size(); i++) {
+            simulator->removeJoint(joints[i]);
+            jointDeleters[i](joints[i]);
+        }
+        for (size_t i = 0; i < shapes.size(); i++) {
+            simulator->removeShape(shapes[i]);
+            shapeDeleters[i](shapes[i]);
+        }
+        delete simulator;
+    }
+
+    template <class T>
+    KRShape2D* addShape(T* shape)
+    {
+        simulator->addShape(shape);
+        shapes.push_back(shape);
+        shapeDeleters.push_back(&deleteAs<T, KRShape2D>);
+        if (!shape->isStatic()) {
+            movingShapeCount++;
+        }
+        return shape;
+    }
+
+    template <class T>
+    void addJoint(T* joint)
+    {
+        simulator->addJoint(joint);
+        joints.push_back(joint);
+        jointDeleters.push_back(&deleteAs<T, KRJoint2D>);
+    }
+};
+
+static void addPyramid(Scene* scene)
+{
+    static const int    baseCount = 40;
+    static const double boxSize = 20.0;
+
+    KRShape2D* ground = scene->addShape(new KRShape2DLine(KRVector2D(-1000.0, 0.0), KRVector2D(2000.0, 0.0), true));
+    ground->setFriction(1.0);
+
+    for (int row = 0; row < baseCount; row++) {
+        for (int i = 0; i < baseCount - row; i++) {
+            double x = (i + row * 0.5) * boxSize;
+            double y = row * boxSize;
+            KRShape2D* box = scene->addShape(new KRShape2DBox(KRRect2D(x, y, boxSize, boxSize)));
+            box->setElasticity(0.0);
+            box->setFriction(0.8);
+        }
+    }
+}
+
+// Pyramid of boxes resting on the ground. Measures the solver on a deep stack.
+static Scene* createPyramidScene(KRSimulator2DBroadphase broadphase)
+{
+    Scene* scene = new Scene(broadphase, 600);
+    addPyramid(scene);
+    return scene;
+}
+
+// The same pyramid with sleeping enabled. Once the stack settles and falls asleep,
+// a step should cost next to nothing.
+static Scene* createSettledScene(KRSimulator2DBroadphase broadphase)
+{
+    Scene* scene = new Scene(broadphase, 900);
+    scene->simulator->setSleepTimeThreshold(0.5);
+    addPyramid(scene);
+    return scene;
+}
+
+// 10,000 circles falling into a bin. Measures the broadphase and the contact pools.
+static Scene* createCirclesScene(KRSimulator2DBroadphase broadphase)
+{
+    static const int    columnCount = 100;
+    static const int    rowCount = 100;
+    static const double spacing = 18.0;
+    static const double width = columnCount * spacing;
+
+    Scene* scene = new Scene(broadphase, 300);
+
+    scene->addShape(new KRShape2DLine(KRVector2D(-20.0, 0.0), KRVector2D(width + 20.0, 0.0), true));
+    scene->addShape(new KRShape2DLine(KRVector2D(-20.0, 0.0), KRVector2D(-20.0, 4000.0), true));
+    scene->addShape(new KRShape2DLine(KRVector2D(width + 20.0, 0.0), KRVector2D(width + 20.0, 4000.0), true));
+
+    for (int row = 0; row < rowCount; row++) {
+        for (int i = 0; i < columnCount; i++) {
+            KRVector2D pos((i + 0.5) * spacing + (frand() - 0.5) * 2.0, 40.0 + row * spacing);
+            scene->addShape(new KRShape2DCircle(pos, 4.0 + 4.0 * frand()));
+        }
+    }
+    return scene;
+}
+
+// Long chains hanging from the ceiling and swinging into each other.
+// Half of the chains are linked with pivot joints, the other half with springs.
+static Scene* createChainsScene(KRSimulator2DBroadphase broadphase)
+{
+    static const int    chainCount = 40;
+    static const int    linkCount = 50;
+    static const double linkSize = 10.0;
+    static const double ceiling = 1000.0;
+
+    Scene* scene = new Scene(broadphase, 600);
+
+    for (int c = 0; c < chainCount; c++) {
+        bool useSprings = (c % 2 == 1);
+        KRVector2D top(c * 30.0, ceiling);
+        KRVector2D anchor(0.0, linkSize / 2);
+        KRShape2D* prev = NULL;
+
+        for (int i = 0; i < linkCount; i++) {
+            // Each chain starts tilted, so it swings into its neighbours.
+            double x = top.x + (i + 0.5) * linkSize * 0.6;
+            double y = top.y - (i + 0.5) * linkSize * 0.8;
+            KRShape2D* link = scene->addShape(new KRShape2DCircle(KRVector2D(x, y), linkSize / 2));
+            link->setMass(0.2);
+
+            if (useSprings) {
+                if (prev) {
+                    scene->addJoint(new KRJoint2DSpring(prev, KRVector2D(0.0, 0.0), link, KRVector2D(0.0, 0.0)));
+                } else {
+                    scene->addJoint(new KRJoint2DSpring(link, KRVector2D(0.0, 0.0), top));
+                }
+            } else {
+                if (prev) {
+                    scene->addJoint(new KRJoint2DPivot(prev, -anchor, link, anchor));
+                } else {
+                    scene->addJoint(new KRJoint2DPivot(link, anchor, top));
+                }
+            }
+            prev = link;
+        }
+    }
+    return scene;
+}
+
+// Circles tumbling inside a ring of static lines that turns with setBodyAngle().
+// Every turn of the static body rehashes all the static shapes.
+static Scene* createRotatingScene(KRSimulator2DBroadphase broadphase)
+{
+    static const int    segmentCount = 64;
+    static const double radius = 600.0;
+    static const int    circleCount = 2000;
+
+    Scene* scene = new Scene(broadphase, 600);
+    scene->angularVelocity = 0.5;
+
+    for (int i = 0; i < segmentCount; i++) {
+        double a1 = 2.0 * M_PI * i / segmentCount;
+        double a2 = 2.0 * M_PI * (i + 1) / segmentCount;
+        KRVector2D p1(radius * cos(a1), radius * sin(a1));
+        KRVector2D p2(radius * cos(a2), radius * sin(a2));
+        KRShape2D* wall = scene->addShape(new KRShape2DLine(p1, p2, true));
+        wall->setFriction(1.0);
+
+        // Paddles, so the ring carries the circles around.
+        if (i % 8 == 0) {
+            KRVector2D inner(radius * 0.75 * cos(a1), radius * 0.75 * sin(a1));
+            scene->addShape(new KRShape2DLine(p1, inner, true));
+        }
+    }
+
+    for (int i = 0; i < circleCount; i++) {
+        double angle = 2.0 * M_PI * frand();
+        double r = radius * 0.6 * sqrt(frand());
+        scene->addShape(new KRShape2DCircle(KRVector2D(r * cos(angle), r * sin(angle)), 5.0 + 3.0 * frand()));
+    }
+    return scene;
+}
+
+
+#pragma mark -
+#pragma mark Running
+
+struct SceneInfo {
+    const char* name;
+    Scene*      (*create)(KRSimulator2DBroadphase broadphase);
+};
+
+static const SceneInfo sScenes[] = {
+    { "pyramid",    createPyramidScene },
+    { "settled",    createSettledScene },
+    { "circles",    createCirclesScene },
+    { "chains",     createChainsScene },
+    { "rotating",   createRotatingScene },
+};
+
+static const int sSceneCount = sizeof(sScenes) / sizeof(sScenes[0]);
+
+struct BroadphaseInfo {
+    const char*                 name;
+    KRSimulator2DBroadphase     broadphase;
+};
+
+static const BroadphaseInfo sBroadphases[] = {
+    { "hash",   KRSimulator2DBroadphaseSpatialHash },
+    { "tree",   KRSimulator2DBroadphaseAABBTree },
+    { "sweep",  KRSimulator2DBroadphaseSweepAndPrune },
+};
+
+static const int sBroadphaseCount = sizeof(sBroadphases) / sizeof(sBroadphases[0]);
+
+static double percentile(const std::vector<double>& sortedTimes, double p)
+{
+    size_t index = (size_t)(p * (sortedTimes.size() - 1) + 0.5);
+    return sortedTimes[index];
+}
+
+static void runScene(const SceneInfo& info, int stepCount, KRSimulator2DBroadphase broadphase, const char* broadphaseName, int threadCount)
+{
+    sRandomSeed = 12345;
+    Scene* scene = info.create(broadphase);
+    scene->simulator->setSolverThreadCount(threadCount);
+    if (stepCount <= 0) {
+        stepCount = scene->stepCount;
+    }
+
+    std::vector<double> times;
+    times.reserve(stepCount);
+
+    int warmupCount = stepCount / 10;
+    double poolAllocs = 0.0;
+    unsigned long poolHeapAllocs = 0;
+    unsigned long heapAllocs = 0;
+    unsigned long steadyHeapAllocs = 0;
+    double angle = 0.0;
+    int asleepStep = -1;
+
+    for (int i = 0; i < stepCount; i++) {
+        if (scene->angularVelocity != 0.0) {
+            angle += scene->angularVelocity / 60.0;
+            scene->simulator->setBodyAngle(angle);
+        }
+
+        unsigned long heapAllocsBefore = sHeapAllocCount;
+        double start = now();
+        scene->simulator->step(1.0 / 60.0);
+        times.push_back((now() - start) * 1000.0);
+        unsigned long stepHeapAllocs = sHeapAllocCount - heapAllocsBefore;
+
+        poolAllocs += scene->simulator->getStepAllocCount();
+        poolHeapAllocs += scene->simulator->getStepHeapAllocCount();
+        heapAllocs += stepHeapAllocs;
+        if (i >= warmupCount) {
+            steadyHeapAllocs += stepHeapAllocs;
+        }
+
+        bool isAsleep = (scene->movingShapeCount > 0 && scene->simulator->getSleepingShapeCount() == scene->movingShapeCount);
+        if (!isAsleep) {
+            asleepStep = -1;
+        } else if (asleepStep < 0) {
+            asleepStep = i;
+        }
+    }
+
+    double mean = 0.0;
+    for (int i = 0; i < stepCount; i++) {
+        mean += times[i];
+    }
+    mean /= stepCount;
+
+    double asleepMean = -1.0;
+    if (asleepStep >= 0 && asleepStep + 1 < stepCount) {
+        asleepMean = 0.0;
+        for (int i = asleepStep + 1; i < stepCount; i++) {
+            asleepMean += times[i];
+        }
+        asleepMean /= stepCount - asleepStep - 1;
+    }
+    std::sort(times.begin(), times.end());
+
+    KRMemoryCategoryStats memoryStats = KRMemoryStats::getStats(KRMemoryCategorySimulator);
+
+    double heapAllocsPerStep = -1.0;
+    double steadyHeapAllocsPerStep = -1.0;
+    if (sCountsHeapAllocs) {
+        heapAllocsPerStep = (double)heapAllocs / stepCount;
+        steadyHeapAllocsPerStep = (double)steadyHeapAllocs / (stepCount - warmupCount);
+    }
+
+    printf("{\"scene\": \"%s\", \"broadphase\": \"%s\", \"threads\": %d, \"shapes\": %d, \"joints\": %d, \"steps\": %d, "
+           "\"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f, "
+           "\"pool_allocs_per_step\": %.1f, \"pool_heap_allocs\": %lu, "
+           "\"heap_allocs_per_step\": %.2f, \"heap_allocs_steady\": %.2f, \"pool_peak_kb\": %.1f, "
+           "\"sleeping_shapes\": %d, \"asleep_step\": %d, \"asleep_mean_ms\": %.4f}\n",
+           info.name, broadphaseName, threadCount, (int)scene->shapes.size(), (int)scene->joints.size(), stepCount,
+           mean, percentile(times, 0.5), percentile(times, 0.99), times.back(),
+           poolAllocs / stepCount, poolHeapAllocs,
+           heapAllocsPerStep, steadyHeapAllocsPerStep, memoryStats.peakBytes / 1024.0,
+           scene->simulator->getSleepingShapeCount(), asleepStep, asleepMean);
+    fflush(stdout);
+
+    delete scene;
+    KRMemoryStats::resetPeaks();
+}
+
+static void printUsage()
+{
+    fprintf(stderr, "usage: SimulatorBenchmark [--scene pyramid|settled|circles|chains|rotating|all] [--steps N]\n"
+                    "                          [--broadphase hash|tree|sweep|all] [--threads N]\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::string sceneName = "all";
+    int stepCount = 0;
+    std::string broadphaseName = "hash";
+    int threadCount = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        if (strcmp(argv[i], "--scene") == 0) {
+            sceneName = argv[++i];
+        } else if (strcmp(argv[i], "--steps") == 0) {
+            stepCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--broadphase") == 0) {
+            broadphaseName = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0) {
+            threadCount = atoi(argv[++i]);
+        } else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    bool foundBroadphase = false;
+    bool foundScene = false;
+    for (int i = 0; i < sBroadphaseCount; i++) {
+        if (broadphaseName == "all" || broadphaseName == sBroadphases[i].name) {
+            foundBroadphase = true;
+        }
+    }
+    for (int i = 0; i < sSceneCount; i++) {
+        if (sceneName == "all" || sceneName == sScenes[i].name) {
+            foundScene = true;
+        }
+    }
+    if (!foundBroadphase || !foundScene) {
+        printUsage();
+        return 1;
+    }
+
+    KRSimulator2D::initSimulatorSystem();
+
+    for (int i = 0; i < sBroadphaseCount; i++) {
+        if (broadphaseName != "all" && broadphaseName != sBroadphases[i].name) {
+            continue;
+        }
+        for (int j = 0; j < sSceneCount; j++) {
+            if (sceneName == "all" || sceneName == sScenes[j].name) {
+                runScene(sScenes[j], stepCount, sBroadphases[i].broadphase, sBroadphases[i].name, threadCount);
+            }
+        }
+    }
+
+    return 0;
+}
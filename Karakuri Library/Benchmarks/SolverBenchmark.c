@@ -0,0 +1,217 @@
+/* SolverBenchmark.c
+ * Compares the serial impulse solver of the embedded Chipmunk with the graph-colored multi-threaded solver.
+ *
+ * Build and run from this directory:
+ *   cc -std=gnu99 -O2 -I../Karakuri/chipmunk SolverBenchmark.c ../Karakuri/chipmunk/c*.c ../Karakuri/chipmunk/constraints/c*.c -lm -lpthread -o SolverBenchmark
+ *   ./SolverBenchmark
+ *
+ * The scene (box pyramids and hanging pivot joint chains) is run with the serial
+ * solver and with the colored solver on 1, 2 and 4 threads. The program exits with
+ * a non-zero status when one of these checks fails:
+ *
+ *   - The colored solver gives bit-identical body positions for every thread count.
+ *   - Every pyramid box ends within BOX_TOLERANCE pixels of where the serial solver
+ *     leaves it, and the mean box height within HEIGHT_TOLERANCE pixels.
+ *   - The largest stretch of a chain link over the run is at most STRETCH_RATIO times
+ *     the serial solver's, plus STRETCH_SLACK pixels.
+ *
+ * The colored solver visits the same constraints in a different order, so it is not
+ * expected to match the serial solver exactly. The resting pyramids converge and only
+ * drift by a couple of pixels. The 30-link chains do not converge in 10 iterations:
+ * both solvers leave them stretched by tens of pixels, and the swing diverges by
+ * about a hundred pixels within a few seconds. That is why the chains are compared
+ * by how well the joints are solved rather than by position. "max |dp|" is the
+ * largest distance from the serial solver over all the bodies, for reference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "chipmunk.h"
+
+#define PYRAMID_COUNT   4
+#define PYRAMID_BASE    20
+#define CHAIN_COUNT     10
+#define CHAIN_LENGTH    30
+#define STEP_COUNT      300
+#define LINK_LENGTH     12.0
+
+#define BOX_TOLERANCE       5.0
+#define HEIGHT_TOLERANCE    0.5
+#define STRETCH_RATIO       1.25
+#define STRETCH_SLACK       1.0
+
+typedef struct Run {
+    const char *name;
+    int threadCount;    // 0 for the serial solver.
+} Run;
+
+static const Run runs[] = {
+    {"serial",     0},
+    {"colored/1",  1},
+    {"colored/2",  2},
+    {"colored/4",  4},
+};
+#define RUN_COUNT ((int)(sizeof(runs)/sizeof(runs[0])))
+
+static double
+now(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec*1e-9;
+}
+
+static void
+addBox(cpSpace *space, cpVect pos, cpFloat size)
+{
+    cpFloat h = size/2.0;
+    cpVect verts[] = {cpv(-h, -h), cpv(-h, h), cpv(h, h), cpv(h, -h)};
+
+    cpBody *body = cpBodyNew(1.0, cpMomentForPoly(1.0, 4, verts, cpvzero));
+    body->p = pos;
+    cpSpaceAddBody(space, body);
+
+    cpShape *shape = cpPolyShapeNew(body, 4, verts, cpvzero);
+    shape->e = 0.0;
+    shape->u = 0.8;
+    cpSpaceAddShape(space, shape);
+}
+
+static cpSpace *
+createSpace(cpBody *staticBody)
+{
+    cpSpace *space = cpSpaceNew();
+    space->iterations = 10;
+    space->gravity = cpv(0.0, -500.0);
+    cpSpaceResizeActiveHash(space, 40.0, 1000);
+    cpSpaceResizeStaticHash(space, 200.0, 1000);
+
+    cpShape *ground = cpSegmentShapeNew(staticBody, cpv(-2000.0, 0.0), cpv(2000.0, 0.0), 0.0);
+    ground->u = 1.0;
+    cpSpaceAddStaticShape(space, ground);
+
+    // Pyramids standing on the ground.
+    cpFloat size = 20.0;
+    for(int p=0; p<PYRAMID_COUNT; p++){
+        cpFloat left = -1500.0 + p*(PYRAMID_BASE + 4)*size;
+        for(int row=0; row<PYRAMID_BASE; row++){
+            for(int i=0; i<PYRAMID_BASE - row; i++){
+                addBox(space, cpv(left + (i + row*0.5)*size, (row + 0.5)*size), size);
+            }
+        }
+    }
+
+    // Chains of pivot joints hanging from the static body.
+    for(int c=0; c<CHAIN_COUNT; c++){
+        cpVect anchor = cpv(600.0 + c*80.0, 1200.0);
+        cpBody *prev = staticBody;
+        for(int i=0; i<CHAIN_LENGTH; i++){
+            cpBody *body = cpBodyNew(1.0, cpMomentForCircle(1.0, 0.0, 5.0, cpvzero));
+            body->p = cpvadd(anchor, cpv((i + 1)*LINK_LENGTH, 0.0));
+            cpSpaceAddBody(space, body);
+            cpSpaceAddShape(space, cpCircleShapeNew(body, 5.0, cpvzero));
+
+            cpSpaceAddConstraint(space, cpPivotJointNew(prev, body, cpvadd(anchor, cpv((i + 0.5)*LINK_LENGTH, 0.0))));
+            prev = body;
+        }
+    }
+
+    return space;
+}
+
+// The pyramid boxes are added first, so the chain links follow them in the body array.
+#define BOX_COUNT   (PYRAMID_COUNT*PYRAMID_BASE*(PYRAMID_BASE + 1)/2)
+
+// How far the most stretched link of the chains is from its rest length.
+static double
+maxChainStretch(cpSpace *space)
+{
+    double ret = 0.0;
+    for(int i=BOX_COUNT; i<space->bodies->num; i++){
+        if((i - BOX_COUNT)%CHAIN_LENGTH == 0) continue;
+        cpBody *body = (cpBody *)space->bodies->arr[i];
+        cpBody *prev = (cpBody *)space->bodies->arr[i - 1];
+        ret = fmax(ret, fabs(cpvdist(body->p, prev->p) - LINK_LENGTH));
+    }
+    return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+    cpInitChipmunk();
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    cpVect *positions[RUN_COUNT];
+    double serialStretch = 0.0;
+    int bodyCount = 0;
+    int failed = 0;
+
+    printf("%-10s %10s %8s %14s %10s %10s %10s %8s\n", "solver", "ms/step", "colors", "max |dp| (px)", "box |dp|", "box dy", "stretch", "check");
+
+    for(int r=0; r<RUN_COUNT; r++){
+        // Shape ids decide the hash order, and the order of the arbiters with it.
+        cpResetShapeIdCounter();
+        cpBody *staticBody = cpBodyNew(INFINITY, INFINITY);
+        cpSpace *space = createSpace(staticBody);
+        if(runs[r].threadCount > 0){
+            cpSpaceSetSolverThreads(space, runs[r].threadCount, 1);
+        }
+
+        double total = 0.0;
+        double stretch = 0.0;
+        for(int step=0; step<STEP_COUNT; step++){
+            double start = now();
+            cpSpaceStep(space, 1.0/60.0);
+            total += now() - start;
+            stretch = fmax(stretch, maxChainStretch(space));
+        }
+
+        bodyCount = space->bodies->num;
+        positions[r] = (cpVect *)malloc(bodyCount*sizeof(cpVect));
+        for(int i=0; i<bodyCount; i++){
+            positions[r][i] = ((cpBody *)space->bodies->arr[i])->p;
+        }
+
+        double maxDistance = 0.0;
+        double maxBoxDistance = 0.0;
+        double boxHeightDiff = 0.0;
+        for(int i=0; i<bodyCount; i++){
+            double distance = cpvdist(positions[r][i], positions[0][i]);
+            maxDistance = fmax(maxDistance, distance);
+            if(i < BOX_COUNT){
+                maxBoxDistance = fmax(maxBoxDistance, distance);
+                boxHeightDiff += (positions[r][i].y - positions[0][i].y)/BOX_COUNT;
+            }
+        }
+
+        const char *check = "-";
+        if(r == 0){
+            serialStretch = stretch;
+        } else {
+            int ok = (maxBoxDistance <= BOX_TOLERANCE && fabs(boxHeightDiff) <= HEIGHT_TOLERANCE &&
+                      stretch <= serialStretch*STRETCH_RATIO + STRETCH_SLACK);
+            if(r > 1 && memcmp(positions[r], positions[1], bodyCount*sizeof(cpVect))) ok = 0;
+            if(!ok) failed = 1;
+            check = (ok ? "ok" : "FAILED");
+        }
+
+        int colors = (space->solver ? cpParallelSolverGetColorCount(space->solver) : 0);
+        printf("%-10s %10.3f %8d %14.4f %10.4f %10.4f %10.4f %8s\n", runs[r].name, total*1000.0/STEP_COUNT, colors,
+               maxDistance, maxBoxDistance, boxHeightDiff, stretch, check);
+
+        cpSpaceFreeChildren(space);
+        cpSpaceFree(space);
+        cpBodyFree(staticBody);
+    }
+
+    for(int r=0; r<RUN_COUNT; r++){
+        free(positions[r]);
+    }
+
+    return failed;
+}
@@ -0,0 +1,265 @@
+/* ValueTypesBenchmark.cpp
+ * Memory and time of the Karakuri value types (KRVector2D, KRRect2D, ...) in large arrays.
+ *
+ * Build and run from this directory:
+ *   make ValueTypesBenchmark
+ *   ./ValueTypesBenchmark
+ *
+ * Prints the size of each value type and of arrays shaped like the particles
+ * and the chara hit areas, then the time of:
+ *   particles   one frame of position and velocity updates of 100,000 particles,
+ *               with the state in KRVector2D/double and in KRVector2Df/float
+ *   hit areas   hit tests of 20,000 charas (2 rects each) against 16 rects
+ *   copy        copying the particle array into another vector
+ *   colors      writing the colors of 100,000 sprites (6 vertices each) into a vertex
+ *               array, converting a KRColor per sprite and copying a _KRPackedColor
+ *   textures    looking up the textures of 100,000 sprites by ID (80 textures, half of
+ *               them resource IDs from 1000), in a std::map and in a _KRIDTable
+ */
+
+#include <Karakuri/KarakuriTypes.h>
+#include <Karakuri/KRColor.h>
+#include <Karakuri/KRIDTable.h>
+
+#include <cstdio>
+#include <map>
+#include <vector>
+#include <time.h>
+
+
+// Layout of the particles of _KRParticle2DSystem before they were moved to float.
+struct Particle {
+    KRVector2D  pos;
+    KRVector2D  vel;
+    KRVector2D  scale;
+    double      angle;
+    int         life;
+};
+
+// Same layout as the particles of _KRParticle2DSystem.
+struct ParticleF {
+    KRVector2Df pos;
+    KRVector2Df vel;
+    KRVector2Df scale;
+    float       angle;
+    int         life;
+};
+
+// Same layout as _KRTexture2DDrawData.
+struct Vertex {
+    short           x, y;
+    float           u, v;
+    _KRPackedColor  color;
+};
+
+// Same layout as KRColor (whose constructors live in the Objective-C++ sources).
+struct Color {
+    double  r, g, b, a;
+};
+
+// Same layout as _KRChara2DHitArea.
+struct HitArea {
+    int         group;
+    int         type;
+    KRRect2D    rect;
+};
+
+static const int    sParticleCount = 100000;
+static const int    sCharaCount = 20000;
+static const int    sTargetCount = 16;
+static const int    sTextureCount = 40;     // for each of the file IDs and the resource IDs
+static const int    sFrameCount = 200;
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Same random numbers on every run.
+static unsigned int sRandomSeed = 12345;
+
+static double frand()
+{
+    sRandomSeed = sRandomSeed * 1103515245 + 12345;
+    return ((sRandomSeed >> 8) & 0xffff) / 65536.0;
+}
+
+int main()
+{
+    printf("sizeof(KRVector2D)    %3d bytes\n", (int)sizeof(KRVector2D));
+    printf("sizeof(KRVector2Df)   %3d bytes\n", (int)sizeof(KRVector2Df));
+    printf("sizeof(KRVector2DInt) %3d bytes\n", (int)sizeof(KRVector2DInt));
+    printf("sizeof(KRVector3D)    %3d bytes\n", (int)sizeof(KRVector3D));
+    printf("sizeof(KRRect2D)      %3d bytes\n", (int)sizeof(KRRect2D));
+    printf("sizeof(KRRect2Df)     %3d bytes\n", (int)sizeof(KRRect2Df));
+    printf("sizeof(KRColor)       %3d bytes\n", (int)sizeof(KRColor));
+    printf("sizeof(_KRPackedColor) %2d bytes\n", (int)sizeof(_KRPackedColor));
+    printf("particle              %3d bytes (%.2f MB for %d)\n", (int)sizeof(Particle),
+           sizeof(Particle) * sParticleCount / (1024.0 * 1024.0), sParticleCount);
+    printf("particle (float)      %3d bytes (%.2f MB for %d)\n", (int)sizeof(ParticleF),
+           sizeof(ParticleF) * sParticleCount / (1024.0 * 1024.0), sParticleCount);
+    printf("hit area              %3d bytes (%.2f MB for %d)\n", (int)sizeof(HitArea),
+           sizeof(HitArea) * sCharaCount * 2 / (1024.0 * 1024.0), sCharaCount * 2);
+
+    std::vector<Particle> particles(sParticleCount);
+    for (int i = 0; i < sParticleCount; i++) {
+        particles[i].pos = KRVector2D(frand() * 480.0, frand() * 320.0);
+        particles[i].vel = KRVector2D(frand() * 200.0 - 100.0, frand() * 200.0);
+        particles[i].scale = KRVector2D(1.0, 1.0);
+        particles[i].angle = 0.0;
+        particles[i].life = 60 + (int)(frand() * 60);
+    }
+
+    std::vector<HitArea> hitAreas(sCharaCount * 2);
+    for (int i = 0; i < sCharaCount * 2; i++) {
+        hitAreas[i].group = i % 2;
+        hitAreas[i].type = 0;
+        hitAreas[i].rect = KRRect2D(frand() * 480.0, frand() * 320.0, 8.0 + frand() * 24.0, 8.0 + frand() * 24.0);
+    }
+    std::vector<KRRect2D> targets(sTargetCount);
+    for (int i = 0; i < sTargetCount; i++) {
+        targets[i] = KRRect2D(frand() * 480.0, frand() * 320.0, 16.0, 16.0);
+    }
+
+    KRVector2D gravity(0.0, -300.0);
+    double dt = 1.0 / 60.0;
+
+    double start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        for (int i = 0; i < sParticleCount; i++) {
+            Particle& p = particles[i];
+            p.vel += gravity * dt;
+            p.pos += p.vel * dt;
+            p.scale *= 0.999;
+            p.angle += 0.01;
+            p.life--;
+        }
+    }
+    double particleTime = (now() - start) / sFrameCount;
+
+    std::vector<ParticleF> particlesF(sParticleCount);
+    for (int i = 0; i < sParticleCount; i++) {
+        particlesF[i].pos = KRVector2Df(particles[i].pos);
+        particlesF[i].vel = KRVector2Df(particles[i].vel);
+        particlesF[i].scale = KRVector2Df(1.0f, 1.0f);
+        particlesF[i].angle = 0.0f;
+        particlesF[i].life = particles[i].life;
+    }
+    KRVector2Df gravityF(gravity);
+    float dtF = (float)dt;
+
+    start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        for (int i = 0; i < sParticleCount; i++) {
+            ParticleF& p = particlesF[i];
+            p.vel += gravityF * dtF;
+            p.pos += p.vel * dtF;
+            p.scale *= 0.999f;
+            p.angle += 0.01f;
+            p.life--;
+        }
+    }
+    double particleFTime = (now() - start) / sFrameCount;
+
+    int hitCount = 0;
+    start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        for (int i = 0; i < sCharaCount * 2; i++) {
+            for (int j = 0; j < sTargetCount; j++) {
+                if (hitAreas[i].rect.intersects(targets[j])) {
+                    hitCount++;
+                }
+            }
+        }
+    }
+    double hitTime = (now() - start) / sFrameCount;
+
+    std::vector<Particle> copy;
+    start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        copy = particles;
+    }
+    double copyTime = (now() - start) / sFrameCount;
+
+    std::vector<Color> colors(sParticleCount);
+    std::vector<_KRPackedColor> packedColors(sParticleCount);
+    for (int i = 0; i < sParticleCount; i++) {
+        colors[i].r = frand();
+        colors[i].g = frand();
+        colors[i].b = frand();
+        colors[i].a = frand();
+        packedColors[i].r = _KRPackColorComponent(colors[i].r);
+        packedColors[i].g = _KRPackColorComponent(colors[i].g);
+        packedColors[i].b = _KRPackColorComponent(colors[i].b);
+        packedColors[i].a = _KRPackColorComponent(colors[i].a);
+    }
+    std::vector<Vertex> vertices(sParticleCount * 6);
+
+    start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        for (int i = 0; i < sParticleCount; i++) {
+            const Color& color = colors[i];
+            for (int j = 0; j < 6; j++) {
+                vertices[i * 6 + j].color.r = (unsigned char)(255 * color.r);
+                vertices[i * 6 + j].color.g = (unsigned char)(255 * color.g);
+                vertices[i * 6 + j].color.b = (unsigned char)(255 * color.b);
+                vertices[i * 6 + j].color.a = (unsigned char)(255 * color.a);
+            }
+        }
+    }
+    double colorTime = (now() - start) / sFrameCount;
+
+    start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        for (int i = 0; i < sParticleCount; i++) {
+            for (int j = 0; j < 6; j++) {
+                vertices[i * 6 + j].color = packedColors[i];
+            }
+        }
+    }
+    double packedColorTime = (now() - start) / sFrameCount;
+
+    std::map<int, Color*> textureMap;
+    _KRIDTable<Color*> textureTable;
+    for (int i = 0; i < sTextureCount; i++) {
+        textureMap[i] = &colors[i];
+        textureMap[1000 + i] = &colors[sTextureCount + i];
+        textureTable[i] = &colors[i];
+        textureTable[1000 + i] = &colors[sTextureCount + i];
+    }
+    std::vector<int> spriteTexIDs(sParticleCount);
+    for (int i = 0; i < sParticleCount; i++) {
+        int index = (int)(frand() * sTextureCount);
+        spriteTexIDs[i] = (i % 2 == 0)? index: 1000 + index;
+    }
+
+    long textureSum = 0;
+    start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        for (int i = 0; i < sParticleCount; i++) {
+            textureSum += textureMap[spriteTexIDs[i]] - &colors[0];
+        }
+    }
+    double textureMapTime = (now() - start) / sFrameCount;
+
+    start = now();
+    for (int frame = 0; frame < sFrameCount; frame++) {
+        for (int i = 0; i < sParticleCount; i++) {
+            textureSum -= textureTable.get(spriteTexIDs[i]) - &colors[0];
+        }
+    }
+    double textureTableTime = (now() - start) / sFrameCount;
+
+    printf("particles             %.3f ms/frame\n", particleTime * 1000.0);
+    printf("particles (float)     %.3f ms/frame\n", particleFTime * 1000.0);
+    printf("hit areas             %.3f ms/frame (%d hits)\n", hitTime * 1000.0, hitCount / sFrameCount);
+    printf("copy                  %.3f ms/frame\n", copyTime * 1000.0);
+    printf("colors (KRColor)      %.3f ms/frame\n", colorTime * 1000.0);
+    printf("colors (packed)       %.3f ms/frame\n", packedColorTime * 1000.0);
+    printf("textures (map)        %.3f ms/frame\n", textureMapTime * 1000.0);
+    printf("textures (table)      %.3f ms/frame (%s)\n", textureTableTime * 1000.0, (textureSum == 0)? "same": "different");
+
+    return 0;
+}
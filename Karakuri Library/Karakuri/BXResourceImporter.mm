@@ -383,6 +383,9 @@
     particleSys->setMinV(minV);
     particleSys->setScaleDelta(deltaScale);
     particleSys->setColorDelta(deltaRed, deltaGreen, deltaBlue, deltaAlpha);
+    
+    // ゲーム実行中に計算しなくて済むように、読み込み時点でテーブルを作っておく。
+    particleSys->_bakeLifeTable();
 }
 
 - (void)importPrimitiveResources
@@ -11,12 +11,20 @@
 #include <Karakuri/Karakuri.h>
 
 #include "KRChara2D.h"
+#include "KRParticle2DBudget.h"
 
 
 class _KRParticle2DSystem;
 class KRSimulator2D;
 
 
+// キャラクタのハンドルから、キャラクタを引くための表の1要素。
+struct _KRChara2DSlot {
+    KRChara2D*  chara;
+    unsigned    generation;     // キャラクタが削除されるたびに増やす。0 は使わない。
+};
+
+
 /*!
     @class KRAnime2DManager
     @group Game Graphics
@@ -27,15 +35,27 @@ class KRAnime2DManager : public KRObject {
 
     std::map<int, _KRChara2DSpec*>  mCharaSpecMap;
     std::list<KRChara2D*>           mCharas;
+    std::vector<_KRChara2DSlot>     mCharaSlots;
+    std::vector<unsigned>           mFreeCharaSlotIndices;
     
     std::map<int, _KRParticle2DSystem*> mParticleSystemMap;
     std::map<int, KRSimulator2D*>       mSimulatorMap;
     
     int                             mNextInnerCharaSpecID;
     int                             mNextSimulatorID;
+    
+    double                          mParticleFrameBudget;
+    unsigned                        mMaxParticleCount;
+    KRParticle2DCullMode            mParticleCullMode;
+    double                          mModelUpdateTime;
+    unsigned                        mLiveParticleCount;
+    unsigned                        mRequestedParticleCount;
+    unsigned                        mSuppressedParticleCount;
+    KRParticle2DBudgetStats         mParticleBudgetStats;
+    std::vector<_KRParticle2DSystem*>   mBudgetSystems;     // 負荷管理で毎フレーム優先度順に並べ替える
 
 public:
-	KRAnime2DManager(int maxChara2DCount, size_t maxChara2DSize);
+	KRAnime2DManager(int maxChara2DCount, const std::vector<size_t>& chara2DSizes);
 	virtual ~KRAnime2DManager();
 
 public:
@@ -95,8 +115,9 @@ public:
     /*!
         @method addChara2D
         管理対象のキャラクタを追加します。いったん追加されたキャラクタは、自動的にメモリ管理が行われますので、delete しないようにしてください。
+        <p>追加したキャラクタを指すハンドルがリターンされます。キャラクタをあとから参照する場合には、ポインタの代わりにこのハンドルを保持しておき、getChara2D() 関数でキャラクタを取得することで、削除済みのキャラクタへのアクセスを防ぐことができます。すでに追加されているキャラクタの場合は、そのキャラクタのハンドルがリターンされます。</p>
      */
-    void        addChara2D(KRChara2D* aChara);
+    KRChara2DHandle addChara2D(KRChara2D* aChara);
     
     /*!
         @method getChara2D
@@ -104,6 +125,13 @@ public:
         現在の拡大率が反映された状態で、現在のコマに設定されたテクスチャサイズに基づいて当たり判定が行われます。もっとも手前に表示されているキャラクタが取得されます。
      */
     KRChara2D*  getChara2D(int classType, const KRVector2D& pos) const;
+
+    /*!
+        @method getChara2D
+        @abstract ハンドルが指しているキャラクタを取得します。
+        キャラクタがすでに削除されている場合には NULL がリターンされます。キャラクタの個数によらず、一定の時間で取得できます。
+     */
+    KRChara2D*  getChara2D(const KRChara2DHandle& handle) const;
     
     /*!
         @method hitChara2D
@@ -145,6 +173,13 @@ public:
      */
     void    removeChara2D(KRChara2D* chara);
 
+    /*!
+        @method removeChara2D
+        ハンドルが指しているキャラクタを削除します。キャラクタがすでに削除されている場合には何もしません。
+     */
+    void    removeChara2D(const KRChara2DHandle& handle);
+
+    void    _removeCharas2D(const std::vector<KRChara2D*>& charas);   KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     void    _reorderChara2D(KRChara2D* chara);    KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
 
     
@@ -169,13 +204,111 @@ public:
     
     _KRParticle2DSystem*    _getParticleSystem(int particleID) const;
 
+    /*!
+        @method addParticleAlphaKey
+        @abstract 指定されたパーティクルに、生存期間の割り合い（0.0〜1.0）に対するアルファ値のキーを追加します。
+        キーが1つ以上追加されている場合、アルファ成分はキーの間を線形補間した値になります。
+     */
+    void    addParticleAlphaKey(int particleID, double time, double alpha);
+    
+    /*!
+        @method addParticleColorKey
+        @abstract 指定されたパーティクルに、生存期間の割り合い（0.0〜1.0）に対するカラーのキーを追加します。
+        キーが1つ以上追加されている場合、赤・緑・青の各成分はキーの間を線形補間した値になります。アルファ成分は無視されます。
+     */
+    void    addParticleColorKey(int particleID, double time, const KRColor& color);
+    
+    /*!
+        @method addParticleScaleKey
+        @abstract 指定されたパーティクルに、生存期間の割り合い（0.0〜1.0）に対する拡大率の倍率のキーを追加します。
+     */
+    void    addParticleScaleKey(int particleID, double time, double scale);
+    
     /*!
         @method generateParticle2D
         指定された座標に、新しいパーティクルを生成します。
      */
     void    generateParticle2D(int particleID, const KRVector2D& pos, int zOrder = 0);
     
+    /*!
+        @method prewarmParticle2D
+        @abstract 指定されたパーティクルを、指定された秒数だけ実行した状態にします。
+        フレームを進めることなく計算で求めるので、ワールドの切り替え直後から十分に生成された状態のエフェクトを表示できます。
+     */
+    void    prewarmParticle2D(int particleID, double seconds);
+    
+    /*!
+        @method removeAllParticleCurveKeys
+        @abstract 指定されたパーティクルに追加されたすべての生存期間中のキーを削除し、線形の変化に戻します。
+     */
+    void    removeAllParticleCurveKeys(int particleID);
+    
+    /*!
+        @method setParticleCollision
+        @abstract 指定されたパーティクルと、シミュレータの静的な図形との衝突判定を設定します。
+        パーティクルごとに物理ボディは作成されず、半径 radius の点として静的な図形の空間ハッシュに対してまとめて判定されます。
+        mode に KRParticle2DCollisionModeBounce を指定した場合、bounce が反発係数として使われます。
+     */
+    void    setParticleCollision(int particleID, KRSimulator2D* simulator, KRParticle2DCollisionMode mode, double radius = 0.0, double bounce = 0.5);
+    
     void    _stepParticles();
+    
+
+#pragma mark ---- パーティクルの負荷管理 ----
+
+    /*!
+        @task パーティクルの負荷管理
+     */
+    
+    /*!
+        @method getParticleBudgetStats
+        @abstract パーティクルの負荷管理機構の、直前のフレームにおける判断の結果を取得します。
+        毎フレーム読み出して、デバッグ表示などに利用できます。
+     */
+    const KRParticle2DBudgetStats&  getParticleBudgetStats() const;
+
+    /*!
+        @method getParticleFrameBudget
+        @abstract 1フレームあたりのモデルの更新と描画にかける処理時間の予算（秒）を取得します。
+        予算が自動設定になっている場合には、現在のフレームレートから計算された値がリターンされます。
+     */
+    double  getParticleFrameBudget() const;
+    
+    /*!
+        @method setMaxParticleCount
+        @abstract すべてのパーティクルシステムを合わせた、パーティクルの最大個数を設定します。
+        0 を設定すると、個数の制限は行われません。デフォルトでは 0 に設定されています。
+     */
+    void    setMaxParticleCount(unsigned count);
+    
+    /*!
+        @method setParticleCullMode
+        @abstract 生成率を最低まで下げても処理時間が予算を超える場合に、生成済みのパーティクルをどのように間引くかを設定します。
+        デフォルトでは KRParticle2DCullModeNone に設定されています。
+     */
+    void    setParticleCullMode(KRParticle2DCullMode mode);
+
+    /*!
+        @method setParticleFrameBudget
+        @abstract 1フレームあたりのモデルの更新と描画にかける処理時間の予算（秒）を設定します。
+        <p>処理時間がこの予算を超えると、優先度の低いパーティクルシステムから順に生成率が下げられます。</p>
+        <p>負の値を設定すると、フレームレートから自動的に予算が計算されます（デフォルト）。0 を設定すると、負荷管理は行われません。</p>
+     */
+    void    setParticleFrameBudget(double sec);
+    
+    /*!
+        @method setParticlePriority
+        @abstract パーティクルシステムの優先度を設定します。
+        値が大きいほど優先度が高くなり、負荷が高い場合にも生成率が下げられにくくなります。デフォルトの優先度は 0 です。
+     */
+    void    setParticlePriority(int particleID, int priority);
+    
+    void    _addModelUpdateTime(double time);   KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    int     _requestParticleSpawn(int requestedCount, int scaledCount);  KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    void    _updateParticleBudget(double drawTime); KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+
+private:
+    void    releaseChara2DSlot(KRChara2D* chara);
 
 };
 
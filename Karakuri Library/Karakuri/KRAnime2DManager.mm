@@ -10,20 +10,38 @@
 
 
 KRAnime2DManager*   gKRAnime2DMan = NULL;
-KRMemoryAllocator*  _gKRChara2DAllocator = NULL;
+KRSizeClassAllocator*   _gKRChara2DAllocator = NULL;
+
+
+// パーティクルの負荷管理で使う定数
+static const double _KRParticle2DBudgetAutoRatio        = 0.75;     // 自動設定時に、1フレームの時間のうち予算とする割合
+static const double _KRParticle2DBudgetSmoothing        = 0.25;     // 処理時間の移動平均の重み
+static const double _KRParticle2DBudgetRecoverRatio     = 0.8;      // 予算に対してこの割合を下回ったら生成率を戻す
+static const double _KRParticle2DBudgetCullRatio        = 1.2;      // 予算に対してこの割合を上回ったら間引きを行う
+static const double _KRParticle2DSpawnScaleStep         = 0.1;
+static const double _KRParticle2DMinSpawnScale          = 0.1;
+static const double _KRParticle2DMaxCullRatioPerFrame   = 0.25;     // 1フレームで1つのシステムから削除する最大の割合
 
 
 #pragma mark -
 #pragma mark KRAnime2DManager クラスの実装
 
-KRAnime2DManager::KRAnime2DManager(int maxCharacter2DCount, size_t maxChara2DSize)
+KRAnime2DManager::KRAnime2DManager(int maxCharacter2DCount, const std::vector<size_t>& chara2DSizes)
 {
     gKRAnime2DMan = this;
     
     mNextInnerCharaSpecID = 10000;
     mNextSimulatorID = 10000;
     
-    _gKRChara2DAllocator = new KRMemoryAllocator(maxChara2DSize, maxCharacter2DCount, "kr-chara2d-alloc");
+    mParticleFrameBudget = -1.0;
+    mMaxParticleCount = 0;
+    mParticleCullMode = KRParticle2DCullModeNone;
+    mModelUpdateTime = 0.0;
+    mLiveParticleCount = 0;
+    mRequestedParticleCount = 0;
+    mSuppressedParticleCount = 0;
+    
+    _gKRChara2DAllocator = new KRSizeClassAllocator(chara2DSizes, maxCharacter2DCount, "kr-chara2d-alloc");
 }
 
 KRAnime2DManager::~KRAnime2DManager()
@@ -121,10 +139,10 @@ _KRChara2DSpec* KRAnime2DManager::_getChara2DSpec(int specID)
     return theSpec;
 }
 
-void KRAnime2DManager::addChara2D(KRChara2D* newChara)
+KRChara2DHandle KRAnime2DManager::addChara2D(KRChara2D* newChara)
 {
     if (newChara->_isInList()) {
-        return;
+        return newChara->getHandle();
     }
     
     int zOrder = newChara->getZOrder();
@@ -144,6 +162,25 @@ void KRAnime2DManager::addChara2D(KRChara2D* newChara)
     }
     
     newChara->_setIsInList(true);
+    
+    // 削除されたキャラクタの位置を再利用して、ハンドルの表が増え続けないようにする。
+    unsigned slotIndex;
+    if (!mFreeCharaSlotIndices.empty()) {
+        slotIndex = mFreeCharaSlotIndices.back();
+        mFreeCharaSlotIndices.pop_back();
+    } else {
+        slotIndex = (unsigned)mCharaSlots.size();
+        _KRChara2DSlot newSlot;
+        newSlot.chara = NULL;
+        newSlot.generation = 1;
+        mCharaSlots.push_back(newSlot);
+    }
+    mCharaSlots[slotIndex].chara = newChara;
+    
+    KRChara2DHandle handle(slotIndex, mCharaSlots[slotIndex].generation);
+    newChara->_setHandle(handle);
+    
+    return handle;
 }
 
 KRChara2D* KRAnime2DManager::getChara2D(int classType, const KRVector2D& pos) const
@@ -159,6 +196,18 @@ KRChara2D* KRAnime2DManager::getChara2D(int classType, const KRVector2D& pos) co
     return NULL;
 }
 
+KRChara2D* KRAnime2DManager::getChara2D(const KRChara2DHandle& handle) const
+{
+    if (handle.index >= mCharaSlots.size()) {
+        return NULL;
+    }
+    const _KRChara2DSlot& theSlot = mCharaSlots[handle.index];
+    if (theSlot.generation != handle.generation) {
+        return NULL;
+    }
+    return theSlot.chara;
+}
+
 KRChara2D* KRAnime2DManager::hitChara2D(int classType, int hitType, const KRVector2D& pos) const
 {
     for (std::list<KRChara2D*>::const_iterator it = mCharas.begin(); it != mCharas.end(); it++) {
@@ -212,6 +261,7 @@ void KRAnime2DManager::removeAllCharas()
     for (std::list<KRChara2D*>::iterator it = mCharas.begin(); it != mCharas.end();) {
         KRChara2D* aChara = *it;
         it = mCharas.erase(it);
+        releaseChara2DSlot(aChara);
         delete aChara;
     }
     mCharas.clear();
@@ -224,9 +274,43 @@ void KRAnime2DManager::removeChara2D(KRChara2D* chara)
     }
     
     mCharas.remove(chara);
+    releaseChara2DSlot(chara);
     delete chara;
 }
 
+void KRAnime2DManager::removeChara2D(const KRChara2DHandle& handle)
+{
+    KRChara2D* theChara = getChara2D(handle);
+    if (theChara == NULL) {
+        return;
+    }
+    removeChara2D(theChara);
+}
+
+void KRAnime2DManager::_removeCharas2D(const std::vector<KRChara2D*>& charas)
+{
+    // 削除するキャラクタに印を付けてから、リストを1回たどるだけでまとめて取り除く。
+    int markedCount = 0;
+    for (std::vector<KRChara2D*>::const_iterator it = charas.begin(); it != charas.end(); it++) {
+        if ((*it)->_isInList()) {
+            (*it)->_setIsInList(false);
+            markedCount++;
+        }
+    }
+    
+    for (std::list<KRChara2D*>::iterator it = mCharas.begin(); it != mCharas.end() && markedCount > 0;) {
+        KRChara2D* aChara = *it;
+        if (!aChara->_isInList()) {
+            it = mCharas.erase(it);
+            releaseChara2DSlot(aChara);
+            delete aChara;
+            markedCount--;
+        } else {
+            it++;
+        }
+    }
+}
+
 void KRAnime2DManager::_reorderChara2D(KRChara2D* chara)
 {
     if (!chara->_isInList()) {
@@ -252,6 +336,25 @@ void KRAnime2DManager::_reorderChara2D(KRChara2D* chara)
     }    
 }
 
+// キャラクタの削除前に呼び出して、そのキャラクタを指すハンドルをすべて無効にする。
+void KRAnime2DManager::releaseChara2DSlot(KRChara2D* chara)
+{
+    KRChara2DHandle handle = chara->getHandle();
+    if (handle.isNull()) {
+        return;
+    }
+    
+    _KRChara2DSlot& theSlot = mCharaSlots[handle.index];
+    theSlot.chara = NULL;
+    theSlot.generation++;
+    if (theSlot.generation == 0) {
+        theSlot.generation = 1;
+    }
+    mFreeCharaSlotIndices.push_back(handle.index);
+    
+    chara->_setHandle(KRChara2DHandle());
+}
+
 void KRAnime2DManager::_stepAllCharas()
 {
     for (std::list<KRChara2D*>::iterator it = mCharas.begin(); it != mCharas.end();) {
@@ -259,12 +362,19 @@ void KRAnime2DManager::_stepAllCharas()
         if ((*it)->_isTemporal() && (*it)->isMotionFinished()) {
             KRChara2D* aChara = *it;
             it = mCharas.erase(it);
+            releaseChara2DSlot(aChara);
             delete aChara;
         } else {
             it++;
         }
     }
     
+    // 生成数の制限のために、ステップ実行前の総数を数えておく。
+    mLiveParticleCount = 0;
+    for (std::map<int, _KRParticle2DSystem*>::iterator it = mParticleSystemMap.begin(); it != mParticleSystemMap.end(); it++) {
+        mLiveParticleCount += it->second->getGeneratedParticleCount();
+    }
+    
     for (std::map<int, _KRParticle2DSystem*>::iterator it = mParticleSystemMap.begin(); it != mParticleSystemMap.end(); it++) {
         _KRParticle2DSystem* theParticleSystem = it->second;
         theParticleSystem->step();
@@ -318,10 +428,195 @@ _KRParticle2DSystem* KRAnime2DManager::_getParticleSystem(int particleID) const
     return theParticleSystem;    
 }
 
+void KRAnime2DManager::addParticleAlphaKey(int particleID, double time, double alpha)
+{
+    _getParticleSystem(particleID)->addAlphaKey(time, alpha);
+}
+
+void KRAnime2DManager::addParticleColorKey(int particleID, double time, const KRColor& color)
+{
+    _getParticleSystem(particleID)->addColorKey(time, color);
+}
+
+void KRAnime2DManager::addParticleScaleKey(int particleID, double time, double scale)
+{
+    _getParticleSystem(particleID)->addScaleKey(time, scale);
+}
+
 void KRAnime2DManager::generateParticle2D(int particleID, const KRVector2D& pos, int zOrder)
 {
     return _getParticleSystem(particleID)->addGenerationPoint(pos, zOrder);
 }
 
+void KRAnime2DManager::prewarmParticle2D(int particleID, double seconds)
+{
+    _getParticleSystem(particleID)->prewarm(seconds);
+}
+
+void KRAnime2DManager::removeAllParticleCurveKeys(int particleID)
+{
+    _getParticleSystem(particleID)->removeAllCurveKeys();
+}
+
+void KRAnime2DManager::setParticleCollision(int particleID, KRSimulator2D* simulator, KRParticle2DCollisionMode mode, double radius, double bounce)
+{
+    _getParticleSystem(particleID)->setCollision(simulator, mode, radius, bounce);
+}
+
+
+#pragma mark -
+#pragma mark パーティクルの負荷管理
+
+static bool _KRParticle2DPriorityLess(const _KRParticle2DSystem* sys1, const _KRParticle2DSystem* sys2)
+{
+    return (sys1->getPriority() < sys2->getPriority());
+}
+
+const KRParticle2DBudgetStats& KRAnime2DManager::getParticleBudgetStats() const
+{
+    return mParticleBudgetStats;
+}
+
+double KRAnime2DManager::getParticleFrameBudget() const
+{
+    if (mParticleFrameBudget < 0.0) {
+        return (1.0 / gKRGameMan->getFrameRate()) * _KRParticle2DBudgetAutoRatio;
+    }
+    return mParticleFrameBudget;
+}
 
+void KRAnime2DManager::setMaxParticleCount(unsigned count)
+{
+    mMaxParticleCount = count;
+}
+
+void KRAnime2DManager::setParticleCullMode(KRParticle2DCullMode mode)
+{
+    mParticleCullMode = mode;
+}
+
+void KRAnime2DManager::setParticleFrameBudget(double sec)
+{
+    mParticleFrameBudget = sec;
+    
+    // 負荷管理をやめる場合には、すべての生成率を元に戻しておく。
+    if (sec == 0.0) {
+        for (std::map<int, _KRParticle2DSystem*>::iterator it = mParticleSystemMap.begin(); it != mParticleSystemMap.end(); it++) {
+            it->second->_setSpawnScale(1.0);
+        }
+    }
+}
+
+void KRAnime2DManager::setParticlePriority(int particleID, int priority)
+{
+    _getParticleSystem(particleID)->setPriority(priority);
+}
 
+void KRAnime2DManager::_addModelUpdateTime(double time)
+{
+    mModelUpdateTime += time;
+}
+
+int KRAnime2DManager::_requestParticleSpawn(int requestedCount, int scaledCount)
+{
+    int allowedCount = scaledCount;
+    
+    if (mMaxParticleCount > 0) {
+        int restCount = (mLiveParticleCount < mMaxParticleCount)? (int)(mMaxParticleCount - mLiveParticleCount): 0;
+        if (allowedCount > restCount) {
+            allowedCount = restCount;
+        }
+    }
+    
+    mLiveParticleCount += allowedCount;
+    mRequestedParticleCount += requestedCount;
+    mSuppressedParticleCount += requestedCount - allowedCount;
+    
+    return allowedCount;
+}
+
+void KRAnime2DManager::_updateParticleBudget(double drawTime)
+{
+    KRParticle2DBudgetStats& stats = mParticleBudgetStats;
+    
+    stats.updateTime = mModelUpdateTime;
+    stats.drawTime = drawTime;
+    stats.budget = getParticleFrameBudget();
+    
+    double frameTime = mModelUpdateTime + drawTime;
+    if (stats.smoothedTime == 0.0) {
+        stats.smoothedTime = frameTime;
+    } else {
+        stats.smoothedTime += (frameTime - stats.smoothedTime) * _KRParticle2DBudgetSmoothing;
+    }
+    mModelUpdateTime = 0.0;
+    
+    stats.requestedCount = mRequestedParticleCount;
+    stats.suppressedCount = mSuppressedParticleCount;
+    mRequestedParticleCount = 0;
+    mSuppressedParticleCount = 0;
+    
+    stats.culledCount = 0;
+    
+    std::vector<_KRParticle2DSystem*>& theSystems = mBudgetSystems;
+    theSystems.clear();
+    for (std::map<int, _KRParticle2DSystem*>::iterator it = mParticleSystemMap.begin(); it != mParticleSystemMap.end(); it++) {
+        theSystems.push_back(it->second);
+    }
+    std::stable_sort(theSystems.begin(), theSystems.end(), _KRParticle2DPriorityLess);
+    
+    if (stats.budget > 0.0) {
+        // 予算超過：優先度の低いシステムから順に生成率を下げる。
+        if (stats.smoothedTime > stats.budget) {
+            bool hasThrottled = false;
+            for (std::vector<_KRParticle2DSystem*>::iterator it = theSystems.begin(); it != theSystems.end(); it++) {
+                double theScale = (*it)->_getSpawnScale();
+                if (theScale > _KRParticle2DMinSpawnScale) {
+                    theScale -= _KRParticle2DSpawnScaleStep;
+                    if (theScale < _KRParticle2DMinSpawnScale) {
+                        theScale = _KRParticle2DMinSpawnScale;
+                    }
+                    (*it)->_setSpawnScale(theScale);
+                    hasThrottled = true;
+                    break;
+                }
+            }
+            
+            // 生成率を下げきっても大きく超過している場合には、生成済みのパーティクルを間引く。
+            if (!hasThrottled && mParticleCullMode != KRParticle2DCullModeNone
+                    && stats.smoothedTime > stats.budget * _KRParticle2DBudgetCullRatio)
+            {
+                double overRatio = 1.0 - stats.budget / stats.smoothedTime;
+                if (overRatio > _KRParticle2DMaxCullRatioPerFrame) {
+                    overRatio = _KRParticle2DMaxCullRatioPerFrame;
+                }
+                for (std::vector<_KRParticle2DSystem*>::iterator it = theSystems.begin(); it != theSystems.end(); it++) {
+                    unsigned count = (unsigned)((*it)->getGeneratedParticleCount() * overRatio);
+                    if (count > 0) {
+                        stats.culledCount = (*it)->_cullParticles(count, mParticleCullMode);
+                        break;
+                    }
+                }
+            }
+        }
+        // 予算に余裕がある：優先度の高いシステムから順に生成率を戻す。
+        else if (stats.smoothedTime < stats.budget * _KRParticle2DBudgetRecoverRatio) {
+            for (std::vector<_KRParticle2DSystem*>::reverse_iterator it = theSystems.rbegin(); it != theSystems.rend(); it++) {
+                double theScale = (*it)->_getSpawnScale();
+                if (theScale < 1.0) {
+                    (*it)->_setSpawnScale(theScale + _KRParticle2DSpawnScaleStep);
+                    break;
+                }
+            }
+        }
+    }
+    
+    stats.particleCount = 0;
+    stats.throttledSystemCount = 0;
+    for (std::vector<_KRParticle2DSystem*>::iterator it = theSystems.begin(); it != theSystems.end(); it++) {
+        stats.particleCount += (*it)->getGeneratedParticleCount();
+        if ((*it)->_getSpawnScale() < 1.0) {
+            stats.throttledSystemCount++;
+        }
+    }
+}
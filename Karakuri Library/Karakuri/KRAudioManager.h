@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <Karakuri/KRIDTable.h>
 #include <Karakuri/KRMusic.h>
 #include <Karakuri/KRSound.h>
 
@@ -28,13 +29,14 @@ class KRAudioManager : public KRObject {
     KRMusic*    mCurrentBGM;
     
     std::map<int, std::vector<int> >    mBGM_GroupID_BGMIDList_Map;
-    std::map<int, std::string>          mBGM_BGMID_AudioFileName_Map;
+    _KRIDTable<std::string>             mBGM_BGMID_AudioFileName_Map;
 
     std::map<int, std::vector<int> >    mSE_GroupID_SEIDList_Map;
-    std::map<int, std::string>          mSE_SEID_AudioFileName_Map;
+    _KRIDTable<std::string>             mSE_SEID_AudioFileName_Map;
 
-    std::map<int, KRMusic*>             mBGMMap;
-    std::map<int, KRSound*>             mSEMap;
+    // playSE() は毎フレーム何度も呼ばれるので、IDを添字にした表で持つ。
+    _KRIDTable<KRMusic*>                mBGMMap;
+    _KRIDTable<KRSound*>                mSEMap;
     std::map<int, bool>                 mGroupID_Loaded_Map;
 
 public:
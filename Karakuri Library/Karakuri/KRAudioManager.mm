@@ -67,14 +67,14 @@ int KRAudioManager::_getResourceSizeInGroup(int groupID)
 
     for (std::vector<int>::const_iterator it = theBGMIDList.begin(); it != theBGMIDList.end(); it++) {
         int bgmID = *it;
-        std::string filename = mBGM_BGMID_AudioFileName_Map[bgmID];
+        std::string filename = mBGM_BGMID_AudioFileName_Map.get(bgmID);
         int resourceSize = KRMusic::getResourceSize(filename);
         ret += resourceSize;
     }
     
     for (std::vector<int>::const_iterator it = theSEIDList.begin(); it != theSEIDList.end(); it++) {
         int seID = *it;
-        std::string filename = mSE_SEID_AudioFileName_Map[seID];
+        std::string filename = mSE_SEID_AudioFileName_Map.get(seID);
         int resourceSize = KRSound::getResourceSize(filename);
         ret += resourceSize;
     }
@@ -96,21 +96,21 @@ void KRAudioManager::_loadAudioFilesInGroup(int groupID, KRWorld* loaderWorld, d
 
     for (std::vector<int>::const_iterator it = theBGMIDList.begin(); it != theBGMIDList.end(); it++) {
         int bgmID = *it;
-        std::string filename = mBGM_BGMID_AudioFileName_Map[bgmID];
+        std::string filename = mBGM_BGMID_AudioFileName_Map.get(bgmID);
         int resourceSize = KRMusic::getResourceSize(filename);
         allResourceSize += resourceSize;
     }
 
     for (std::vector<int>::const_iterator it = theSEIDList.begin(); it != theSEIDList.end(); it++) {
         int seID = *it;
-        std::string filename = mSE_SEID_AudioFileName_Map[seID];
+        std::string filename = mSE_SEID_AudioFileName_Map.get(seID);
         int resourceSize = KRSound::getResourceSize(filename);
         allResourceSize += resourceSize;
     }
         
     for (std::vector<int>::const_iterator it = theBGMIDList.begin(); it != theBGMIDList.end(); it++) {
         int bgmID = *it;
-        std::string filename = mBGM_BGMID_AudioFileName_Map[bgmID];
+        std::string filename = mBGM_BGMID_AudioFileName_Map.get(bgmID);
         int resourceSize = KRMusic::getResourceSize(filename);
         double theMinDuration = ((double)resourceSize / allResourceSize) * minDuration;
         
@@ -120,9 +120,10 @@ void KRAudioManager::_loadAudioFilesInGroup(int groupID, KRWorld* loaderWorld, d
         }
 
         NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
-        if (mBGMMap[bgmID] == NULL) {
-            mBGMMap[bgmID] = new KRMusic(filename, true);
-            mBGMMap[bgmID]->_setBGMID(bgmID);
+        if (!mBGMMap.contains(bgmID)) {
+            KRMusic* theMusic = new KRMusic(filename, true);
+            theMusic->_setBGMID(bgmID);
+            mBGMMap[bgmID] = theMusic;
         }
         NSTimeInterval loadTime = [NSDate timeIntervalSinceReferenceDate] - startTime;
 
@@ -143,7 +144,7 @@ void KRAudioManager::_loadAudioFilesInGroup(int groupID, KRWorld* loaderWorld, d
 
     for (std::vector<int>::const_iterator it = theSEIDList.begin(); it != theSEIDList.end(); it++) {
         int seID = *it;
-        std::string filename = mSE_SEID_AudioFileName_Map[seID];
+        std::string filename = mSE_SEID_AudioFileName_Map.get(seID);
         int resourceSize = KRMusic::getResourceSize(filename);
         double theMinDuration = ((double)resourceSize / allResourceSize) * minDuration;
 
@@ -153,7 +154,7 @@ void KRAudioManager::_loadAudioFilesInGroup(int groupID, KRWorld* loaderWorld, d
         }
         
         NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
-        if (mSEMap[seID] == NULL) {
+        if (!mSEMap.contains(seID)) {
             mSEMap[seID] = new KRSound(filename, false);
         }
         NSTimeInterval loadTime = [NSDate timeIntervalSinceReferenceDate] - startTime;
@@ -190,22 +191,24 @@ void KRAudioManager::_unloadAudioFilesInGroup(int groupID)
     std::vector<int>& theBGMIDList = mBGM_GroupID_BGMIDList_Map[groupID];
     for (std::vector<int>::const_iterator it = theBGMIDList.begin(); it != theBGMIDList.end(); it++) {
         int bgmID = *it;
-        if (mBGMMap[bgmID] != NULL) {
-            if (mCurrentBGM == mBGMMap[bgmID]) {
+        KRMusic* theMusic = mBGMMap.get(bgmID);
+        if (theMusic != NULL) {
+            if (mCurrentBGM == theMusic) {
                 mCurrentBGM->stop();
                 mCurrentBGM = NULL;
             }
-            delete mBGMMap[bgmID];
-            mBGMMap[bgmID] = NULL;
+            delete theMusic;
+            mBGMMap.erase(bgmID);
         }
     }
     
     std::vector<int>& theSEIDList = mSE_GroupID_SEIDList_Map[groupID];
     for (std::vector<int>::const_iterator it = theSEIDList.begin(); it != theSEIDList.end(); it++) {
         int seID = *it;
-        if (mSEMap[seID] != NULL) {
-            delete mSEMap[seID];
-            mSEMap[seID] = NULL;
+        KRSound* theSound = mSEMap.get(seID);
+        if (theSound != NULL) {
+            delete theSound;
+            mSEMap.erase(seID);
         }
     }
     
@@ -244,11 +247,8 @@ void KRAudioManager::playBGM(int bgmID, double volume)
         stopBGM();
     }
     
-    // IDからBGMを引っ張ってくる。
-    mCurrentBGM = mBGMMap[bgmID];
-
     // BGMが読み込まれていない場合はエラーを表示
-    if (mCurrentBGM == NULL) {
+    if (!mBGMMap.contains(bgmID)) {
         const char* errorFormat = "BGM with ID %d is not loaded.";
         if (gKRLanguage == KRLanguageJapanese) {
             errorFormat = "ID が %d の BGM は読み込まれていません。";
@@ -256,6 +256,9 @@ void KRAudioManager::playBGM(int bgmID, double volume)
         throw KRRuntimeError(errorFormat, bgmID);
     }    
 
+    // IDからBGMを引っ張ってくる。
+    mCurrentBGM = mBGMMap.get(bgmID);
+
     setBGMVolume(volume);
     mCurrentBGM->play();
 }
@@ -298,11 +301,8 @@ void KRAudioManager::stopBGM()
 
 void KRAudioManager::playSE(int seID, double volume, const KRVector3D& sourcePos)
 {
-    // IDからSEを引っ張ってくる。
-    KRSound* theSound = mSEMap[seID];
-
     // SEが見つからなかったときはエラー
-    if (theSound == NULL) {
+    if (!mSEMap.contains(seID)) {
         const char* errorFormat = "SE with ID %d is not loaded.";
         if (gKRLanguage == KRLanguageJapanese) {
             errorFormat = "ID が %d の SE は読み込まれていません。";
@@ -310,6 +310,9 @@ void KRAudioManager::playSE(int seID, double volume, const KRVector3D& sourcePos
         throw KRRuntimeError(errorFormat, seID);
     }
     
+    // IDからSEを引っ張ってくる。
+    KRSound* theSound = mSEMap.get(seID);
+
     // ボリュームの設定
     theSound->setVolume(volume);
     
@@ -14,7 +14,7 @@
 #include "KRGraphics.h"
 
 
-extern KRMemoryAllocator*   _gKRChara2DAllocator;
+extern KRSizeClassAllocator*   _gKRChara2DAllocator;
 
 
 /*!
@@ -160,6 +160,71 @@ public:
     
 };
 
+/*!
+    @struct KRChara2DHandle
+    @group  Game Graphics
+    @abstract KRAnime2DManager に追加されたキャラクタを指すためのハンドルです。
+    <p>キャラクタのポインタの代わりに保持しておき、KRAnime2DManager の getChara2D() 関数でキャラクタを取得して使います。キャラクタが削除されたあとのハンドルからは NULL が取得されるため、削除済みのキャラクタへのアクセスを確実に検出できます。</p>
+    <p>ハンドルは、管理用の表の位置を表す index と、その位置が再利用されるたびに増える generation で構成されます。generation が 0 のハンドルは、どのキャラクタも指していません。</p>
+ */
+typedef struct KRChara2DHandle {
+
+    /*!
+        @var    index
+        @abstract   キャラクタが格納されている、管理用の表の位置です。
+     */
+    unsigned    index;
+
+    /*!
+        @var    generation
+        @abstract   キャラクタが追加されたときの、管理用の表の位置の世代です。
+     */
+    unsigned    generation;
+
+    /*!
+        @task コンストラクタ
+     */
+
+    /*!
+        @method KRChara2DHandle
+        どのキャラクタも指していないハンドルを作成します。
+     */
+    KRChara2DHandle();
+
+    /*!
+        @method KRChara2DHandle
+        位置と世代を指定してハンドルを作成します。
+     */
+    KRChara2DHandle(unsigned _index, unsigned _generation);
+
+    /*!
+        @task 状態の確認
+     */
+
+    /*!
+        @method isNull
+        このハンドルが、どのキャラクタも指していないかどうかをリターンします。
+        キャラクタが削除されたかどうかは、KRAnime2DManager の getChara2D() 関数で確認してください。
+     */
+    bool    isNull() const;
+
+    /*!
+        @task 演算子のオーバーライド
+     */
+
+    /*!
+        @method operator==
+     */
+    bool    operator==(const KRChara2DHandle& handle) const;
+
+    /*!
+        @method operator!=
+     */
+    bool    operator!=(const KRChara2DHandle& handle) const;
+
+} KRChara2DHandle;
+
+
 /*!
     @class KRChara2D
     @group Game Graphics
@@ -169,7 +234,7 @@ public:
  */
 class KRChara2D : public KRObject {
     
-    KR_DECLARE_USE_ALLOCATOR(_gKRChara2DAllocator)
+    KR_DECLARE_USE_SIZE_CLASS_ALLOCATOR(_gKRChara2DAllocator)
     
 public:
     bool                _mIsHidden;
@@ -188,18 +253,21 @@ private:
     bool                _mIsMotionPaused;
     bool                _mIsTemporal;
     bool                _mIsInList;
+    KRChara2DHandle     _mHandle;
     
-    KRVector2D          _mScale;
+    // 位置と拡大率は、描画とパーティクルの更新のために float で持つ。
+    KRVector2Df         _mScale;
     KRBlendMode         _mBlendMode;
-    KRVector2D          _mPos;
+    KRVector2Df         _mPos;
     KRColor             _mColor;
+    _KRPackedColor      _mPackedColor;      // _mColor を描画用に変換しておいたもの
 
 public:
     /*!
         @-var    _angle
         キャラクタの現在の角度です。
      */
-    double              _angle;
+    float               _angle;
     
 public:
     /*!
@@ -394,6 +462,13 @@ public:
      */
     int     getClassType() const;
     
+    /*!
+        @method getHandle
+        @abstract このキャラクタを指すハンドルを取得します。
+        KRAnime2DManager の addChara2D() 関数で追加される前は、どのキャラクタも指していないハンドルがリターンされます。
+     */
+    KRChara2DHandle getHandle() const;
+
     /*!
         @method hitTest
         @abstract 与えられた点に対して、指定された種類の当たり判定領域との当たり判定を行ないます。
@@ -414,6 +489,55 @@ public:
     void    _draw();    KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     bool    _isInList() const;          KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     void    _setIsInList(bool flag);    KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    void    _setHandle(const KRChara2DHandle& handle);      KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    void    _setPackedColor(const _KRPackedColor& color);   KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    
+    const KRVector2Df&  _getPosf() const;                   KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    void    _setPosf(const KRVector2Df& pos);               KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    void    _setScalef(const KRVector2Df& scale);           KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     
 };
 
+
+inline KRChara2DHandle::KRChara2DHandle()
+    : index(0), generation(0)
+{
+}
+
+inline KRChara2DHandle::KRChara2DHandle(unsigned _index, unsigned _generation)
+    : index(_index), generation(_generation)
+{
+}
+
+inline bool KRChara2DHandle::isNull() const
+{
+    return (generation == 0);
+}
+
+inline bool KRChara2DHandle::operator==(const KRChara2DHandle& handle) const
+{
+    return (index == handle.index && generation == handle.generation);
+}
+
+inline bool KRChara2DHandle::operator!=(const KRChara2DHandle& handle) const
+{
+    return (index != handle.index || generation != handle.generation);
+}
+
+// パーティクルの更新で毎フレーム呼ばれるため、インライン展開できるようにここで定義する。
+
+inline const KRVector2Df& KRChara2D::_getPosf() const
+{
+    return _mPos;
+}
+
+inline void KRChara2D::_setPosf(const KRVector2Df& pos)
+{
+    _mPos = pos;
+}
+
+inline void KRChara2D::_setScalef(const KRVector2Df& scale)
+{
+    _mScale = scale;
+}
+
@@ -297,12 +297,13 @@ KRChara2D::KRChara2D(int classType, int charaID)
     _mZOrder = 0;
     _mIsHidden = false;
 
-    _mPos = KRVector2DZero;
+    _mPos = KRVector2Df(0.0f, 0.0f);
     
-    _angle = 0.0;
+    _angle = 0.0f;
     _mBlendMode = KRBlendModeAlpha;
     _mColor = KRColor(1.0, 1.0, 1.0, 1.0);
-    _mScale = KRVector2DOne;
+    _mPackedColor = _KRPackedColor(_mColor);
+    _mScale = KRVector2Df(1.0f, 1.0f);
     
     _mCurrentMotionID = -1;
     _mIsMotionFinished = true;
@@ -311,6 +312,7 @@ KRChara2D::KRChara2D(int classType, int charaID)
     _mIsTemporal = false;
     
     _mIsInList = false;
+    _mHandle = KRChara2DHandle();
 }
 
 KRChara2D::~KRChara2D()
@@ -345,6 +347,11 @@ _KRChara2DKoma* KRChara2D::_getCurrentKoma() const
     return theMotion->getKoma(_mCurrentKomaIndex);
 }
 
+KRChara2DHandle KRChara2D::getHandle() const
+{
+    return _mHandle;
+}
+
 bool KRChara2D::hitTest(int hitType, const KRVector2D& pos) const
 {
     _KRChara2DMotion* theMotion = _mCharaSpec->getMotion(_mCurrentMotionID);
@@ -363,7 +370,7 @@ bool KRChara2D::hitTest(int hitType, const KRVector2D& pos) const
         if (hitAreas[i].group != hitType) {
             continue;
         }
-        if (hitAreas[i].hitTest(_mPos, _mScale, pos)) {
+        if (hitAreas[i].hitTest(_mPos.toVector2D(), _mScale.toVector2D(), pos)) {
             return true;
         }
     }
@@ -396,12 +403,15 @@ bool KRChara2D::hitTest(int hitType, const KRChara2D* targetChara, int targetHit
     KRVector2D targetOffset = targetChara->getPos();
     KRVector2D targetScale = targetChara->getScale();
 
+    KRVector2D offset = _mPos.toVector2D();
+    KRVector2D scale = _mScale.toVector2D();
+
     _KRChara2DHitArea* hitAreas = theKoma->_getHitAreas();
     for (int i = 0; i < count; i++) {
         if (hitAreas[i].group != hitType) {
             continue;
         }
-        if (hitAreas[i].hitTest(_mPos, _mScale, targetHitAreaCount, targetAreas, targetHitType, targetOffset, targetScale)) {
+        if (hitAreas[i].hitTest(offset, scale, targetHitAreaCount, targetAreas, targetHitType, targetOffset, targetScale)) {
             return true;
         }
     }
@@ -511,8 +521,8 @@ KRVector2D KRChara2D::getCenterPos() const
 void KRChara2D::setCenterPos(const KRVector2D& p)
 {
     KRVector2D size = getSize();
-    _mPos.x = p.x - size.x * _mScale.x / 2;
-    _mPos.y = p.y - size.y * _mScale.y / 2;
+    _mPos.x = (float)(p.x - size.x * _mScale.x / 2);
+    _mPos.y = (float)(p.y - size.y * _mScale.y / 2);
 }
 
 int KRChara2D::getClassType() const
@@ -527,12 +537,12 @@ KRColor KRChara2D::getColor() const
 
 KRVector2D KRChara2D::getPos() const
 {
-    return _mPos;
+    return _mPos.toVector2D();
 }
 
 KRVector2D KRChara2D::getScale() const
 {
-    return _mScale;
+    return _mScale.toVector2D();
 }
 
 KRVector2D KRChara2D::getSize() const
@@ -564,6 +574,7 @@ void KRChara2D::setBlendMode(KRBlendMode blendMode)
 void KRChara2D::setColor(const KRColor& color)
 {
     _mColor = color;
+    _mPackedColor = _KRPackedColor(color);
 }
 
 void KRChara2D::setHidden(bool flag)
@@ -573,12 +584,12 @@ void KRChara2D::setHidden(bool flag)
 
 void KRChara2D::setPos(const KRVector2D& pos)
 {
-    _mPos = pos;
+    _mPos = KRVector2Df(pos);
 }
 
 void KRChara2D::setScale(const KRVector2D& scale)
 {
-    _mScale = scale;
+    _mScale = KRVector2Df(scale);
 }
 
 void KRChara2D::setZOrder(int zOrder)
@@ -646,7 +657,7 @@ void KRChara2D::_draw()
         gKRGraphicsInst->setBlendMode(_mBlendMode);
         
         int texID = _mCharaSpec->getParticleTextureID();
-        gKRTex2DMan->drawAtPointCenterEx(texID, _mPos, _angle, _mScale, _mColor);
+        gKRTex2DMan->_getTexture(texID)->drawAtPointCenterEx(_mPos, KRRect2Df(), _angle, _mScale, _mPackedColor);
     }
     
     // 通常のキャラクタ
@@ -665,8 +676,8 @@ void KRChara2D::_draw()
         gKRGraphicsInst->setBlendMode(_mBlendMode);
         
         int texID = theKoma->getTextureID();
-        KRRect2D atlasRect = theKoma->_getAtlasRect();
-        gKRTex2DMan->drawAtPointEx2(texID, _mPos, atlasRect, 0.0, KRVector2DZero, _mScale, _mColor);
+        KRRect2Df atlasRect(theKoma->_getAtlasRect());
+        gKRTex2DMan->_getTexture(texID)->drawAtPointEx(_mPos, atlasRect, 0.0f, KRVector2Df(), _mScale, _mPackedColor);
     }
 }
 
@@ -680,4 +691,15 @@ void KRChara2D::_setIsInList(bool flag)
     _mIsInList = flag;
 }
 
+void KRChara2D::_setHandle(const KRChara2DHandle& handle)
+{
+    _mHandle = handle;
+}
+
+// パーティクルのように、あらかじめ変換しておいた色を毎フレーム設定する場合に使う。getColor() 関数の値は変わらない。
+void KRChara2D::_setPackedColor(const _KRPackedColor& color)
+{
+    _mPackedColor = color;
+}
+
 
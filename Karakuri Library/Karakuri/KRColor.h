@@ -19,7 +19,7 @@
     @abstract 色を表すためのクラスです。
     利用可能な色の定数の一覧については、<a href="../../../../guide/index.html">開発ガイド</a>の「<a href="../../../../guide/color_chart.html">カラーチャート</a>」を参照してください。
  */
-class KRColor : public KRObject {
+class KRColor {
 public:
     static const KRColor& AliceBlue;
     static const KRColor& AntiqueWhite;
@@ -235,12 +235,6 @@ public:
      */
     KRColor(double r, double g, double b, double a);
     
-    /*!
-        @method KRColor
-        @abstract この色を、与えられた色と同じ色で生成します。
-     */
-    KRColor(const KRColor& color);
-    
 public:
     /*!
         @task 主な操作
@@ -260,12 +254,6 @@ public:
         @task 演算子のオーバーライド
      */
     
-    /*!
-        @method operator=
-        @abstract 与えられた色の情報をこのインスタンスにコピーします。
-     */
-    KRColor&    operator=(const KRColor& color);
-    
     /*!
         @method operator==
         @abstract 与えられた色とこの色が等しいかどうかをリターンします。
@@ -283,7 +271,58 @@ public:
 #pragma mark Debug Support
 
 public:
+    /*!
+        @task デバッグのサポート
+     */
+    
+    /*!
+        @method c_str
+        この色の内容を表すC言語文字列をリターンします。
+     */
+    const char* c_str() const;
+
+    /*!
+        @method to_s
+        この色の内容を表す C++ 文字列をリターンします。
+     */
     std::string to_s() const;
     
 };
 
+
+/*
+    色の各成分を、0.0〜1.0 に丸めてから 0〜255 の8ビットに変換します。
+ */
+inline unsigned char _KRPackColorComponent(double value)
+{
+    if (value <= 0.0) {
+        return 0;
+    }
+    if (value >= 1.0) {
+        return 255;
+    }
+    return (unsigned char)(255 * value);
+}
+
+
+/*
+    @-struct _KRPackedColor
+    描画のために、色の各成分を8ビットずつ RGBA の順番に詰めた値です。
+    頂点配列の色と同じ並びなので、頂点ごとに4バイトをそのままコピーするだけで書き込めます。
+    色の指定には KRColor クラスを使い、この構造体への変換は色が設定されたときに1回だけ行います。
+ */
+struct _KRPackedColor {
+    unsigned char   r;
+    unsigned char   g;
+    unsigned char   b;
+    unsigned char   a;
+    
+    _KRPackedColor() {}
+    
+    explicit _KRPackedColor(const KRColor& color)
+        : r(_KRPackColorComponent(color.r)),
+          g(_KRPackColorComponent(color.g)),
+          b(_KRPackColorComponent(color.b)),
+          a(_KRPackColorComponent(color.a)) {}
+};
+
@@ -186,12 +186,6 @@ KRColor::KRColor(double _r, double _g, double _b, double _a)
     // Do nothing
 }
 
-KRColor::KRColor(const KRColor& color)
-    : r(color.r), g(color.g), b(color.b), a(color.a)
-{
-    // Do nothing
-}
-
 KRColor KRColor::createWithHSBA(double hue, double saturation, double brightness, double alpha)
 {
     KRColor ret;
@@ -335,15 +329,6 @@ void KRColor::setAsClearColor() const
     }
 }
 
-KRColor& KRColor::operator=(const KRColor& color)
-{
-    r = color.r;
-    g = color.g;
-    b = color.b;
-    a = color.a;
-    return *this;
-}
-
 bool KRColor::operator==(const KRColor& color)
 {
     return (r == color.r && g == color.g && b == color.b && a == color.a);
@@ -358,6 +343,11 @@ bool KRColor::operator!=(const KRColor& color)
 #pragma mark -
 #pragma mark Debug Support
 
+const char* KRColor::c_str() const
+{
+    return _KRStoreCString(to_s());
+}
+
 std::string KRColor::to_s() const
 {
     return KRFS("<color>(r=%6.5f, g=%6.5f, b=%6.5f, a=%6.5f)", r, g, b, a);
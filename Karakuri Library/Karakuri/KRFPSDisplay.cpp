@@ -50,7 +50,7 @@ void KRFPSDisplay::drawFPS(double x, double y, double fps)
 {
     gKRGraphicsInst->setBlendMode(KRBlendModeAlpha);
 
-    std::string str = KRFS("%3.1f", fps);
+    KRStringBuffer<16> str("%3.1f", fps);
     
     double width = 0.0;
     if (x > gKRScreenSize.x/2) {
@@ -60,7 +60,7 @@ void KRFPSDisplay::drawFPS(double x, double y, double fps)
     int i;
     
     for (i = 0; i < str.length(); i++) {
-        char c = str[i];
+        char c = str.c_str()[i];
         if (c >= '0' && c <= '9') {
             KRRect2D atlasRect((c - '0') * mNumberSize.x, 0, mNumberSize.x, mNumberSize.y);
             mNumberTex->drawAtPointEx(KRVector2D(x + i * mNumberSize.x + 1 - width, y - 1), atlasRect, 0.0, KRVector2DZero, KRVector2DOne, KRColor::Black);
@@ -78,7 +78,7 @@ void KRFPSDisplay::drawTPF(double x, double y, double tpf)
 {
     gKRGraphicsInst->setBlendMode(KRBlendModeAlpha);
 
-    std::string str = KRFS("%3.1f", tpf);
+    KRStringBuffer<16> str("%3.1f", tpf);
     
     double width = 0.0;
     if (x > gKRScreenSize.x/2) {
@@ -88,7 +88,7 @@ void KRFPSDisplay::drawTPF(double x, double y, double tpf)
     int i;
     
     for (i = 0; i < str.length(); i++) {
-        char c = str[i];
+        char c = str.c_str()[i];
         if (c >= '0' && c <= '9') {
             KRRect2D atlasRect((c - '0') * mNumberSize.x, 0, mNumberSize.x, mNumberSize.y);
             mNumberTex->drawAtPointEx(KRVector2D(x + i * mNumberSize.x + 1 - width, y - 1), atlasRect, 0.0, KRVector2DZero, KRVector2DOne, KRColor::Black);
@@ -106,7 +106,7 @@ void KRFPSDisplay::drawBPF(double x, double y, double bpf)
 {
     gKRGraphicsInst->setBlendMode(KRBlendModeAlpha);
     
-    std::string str = KRFS("%3.1f", bpf);
+    KRStringBuffer<16> str("%3.1f", bpf);
     
     double width = 0.0;
     if (x > gKRScreenSize.x/2) {
@@ -116,7 +116,7 @@ void KRFPSDisplay::drawBPF(double x, double y, double bpf)
     int i;
     
     for (i = 0; i < str.length(); i++) {
-        char c = str[i];
+        char c = str.c_str()[i];
         if (c >= '0' && c <= '9') {
             KRRect2D atlasRect((c - '0') * mNumberSize.x, 0, mNumberSize.x, mNumberSize.y);
             mNumberTex->drawAtPointEx(KRVector2D(x + i * mNumberSize.x + 1 - width, y - 1), atlasRect, 0.0, KRVector2DZero, KRVector2DOne, KRColor::Black);
@@ -134,7 +134,7 @@ void KRFPSDisplay::drawCPF(double x, double y, double cpf)
 {
     gKRGraphicsInst->setBlendMode(KRBlendModeAlpha);
     
-    std::string str = KRFS("%3.1f", cpf);
+    KRStringBuffer<16> str("%3.1f", cpf);
     
     double width = 0.0;
     if (x > gKRScreenSize.x/2) {
@@ -144,7 +144,7 @@ void KRFPSDisplay::drawCPF(double x, double y, double cpf)
     int i;
     
     for (i = 0; i < str.length(); i++) {
-        char c = str[i];
+        char c = str.c_str()[i];
         if (c >= '0' && c <= '9') {
             KRRect2D atlasRect((c - '0') * mNumberSize.x, 0, mNumberSize.x, mNumberSize.y);
             mNumberTex->drawAtPointEx(KRVector2D(x + i * mNumberSize.x + 1 - width, y - 1), atlasRect, 0.0, KRVector2DZero, KRVector2DOne, KRColor::Black);
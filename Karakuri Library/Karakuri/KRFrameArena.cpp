@@ -0,0 +1,170 @@
+/*!
+    @file   KRFrameArena.cpp
+ */
+
+#include "KRFrameArena.h"
+
+#include <cstring>
+
+
+KRFrameArena*   gKRFrameArena = NULL;
+
+
+static const size_t _KRFrameArenaChunkAlignment = 16;
+
+
+static inline size_t _KRFrameArenaAlign(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) & ~(alignment - 1);
+}
+
+
+/*!
+    @method KRFrameArena
+    Constructor
+ */
+KRFrameArena::KRFrameArena(size_t initialSize)
+{
+    gKRFrameArena = this;
+
+    mChunks = NULL;
+    mCurrentPos = NULL;
+    mCurrentEnd = NULL;
+
+    mCapacity = 0;
+    mPrevChunksUsedSize = 0;
+    mPeakSize = 0;
+    mChunkCount = 0;
+
+    addChunk(initialSize);
+}
+
+/*!
+    @method ~KRFrameArena
+    Destructor
+ */
+KRFrameArena::~KRFrameArena()
+{
+    freeAllChunks();
+
+    if (gKRFrameArena == this) {
+        gKRFrameArena = NULL;
+    }
+}
+
+void KRFrameArena::addChunk(size_t minSize)
+{
+    size_t headerSize = _KRFrameArenaAlign(sizeof(_KRFrameArenaChunk), _KRFrameArenaChunkAlignment);
+    size_t size = _KRFrameArenaAlign(std::max(minSize, (size_t)1024), _KRFrameArenaChunkAlignment);
+
+    _KRFrameArenaChunk* theChunk = (_KRFrameArenaChunk*)malloc(headerSize + size);
+    if (theChunk == NULL) {
+        const char* errorFormat = "KRFrameArena: Failed to allocate enough memory (size=%d).";
+        if (gKRLanguage == KRLanguageJapanese) {
+            errorFormat = "KRFrameArena: 十分なメモリを確保できませんでした。 (size=%d)";
+        }
+        throw KRRuntimeError(errorFormat, (int)(headerSize + size));
+    }
+
+    if (mChunks != NULL) {
+        mPrevChunksUsedSize += mCurrentPos - ((char*)mChunks + headerSize);
+    }
+
+    theChunk->size = size;
+    theChunk->next = mChunks;
+    mChunks = theChunk;
+
+    mCurrentPos = (char*)theChunk + headerSize;
+    mCurrentEnd = mCurrentPos + size;
+
+    mCapacity += size;
+    mChunkCount++;
+}
+
+void* KRFrameArena::allocate(size_t size, size_t alignment)
+{
+    char* ptr = (char*)_KRFrameArenaAlign((size_t)mCurrentPos, alignment);
+    if (ptr + size > mCurrentEnd) {
+        // 足りなくなったら、それまでの合計と同じ大きさ以上のチャンクを追加する。
+        addChunk(std::max(size + alignment, mCapacity));
+        ptr = (char*)_KRFrameArenaAlign((size_t)mCurrentPos, alignment);
+    }
+    mCurrentPos = ptr + size;
+
+    size_t usedSize = getUsedSize();
+    if (usedSize > mPeakSize) {
+        mPeakSize = usedSize;
+    }
+
+    return ptr;
+}
+
+void KRFrameArena::freeAllChunks()
+{
+    _KRFrameArenaChunk* theChunk = mChunks;
+    while (theChunk != NULL) {
+        _KRFrameArenaChunk* nextChunk = theChunk->next;
+        free(theChunk);
+        theChunk = nextChunk;
+    }
+
+    mChunks = NULL;
+    mCurrentPos = NULL;
+    mCurrentEnd = NULL;
+
+    mCapacity = 0;
+    mPrevChunksUsedSize = 0;
+    mChunkCount = 0;
+}
+
+void KRFrameArena::release(void* ptr, size_t size)
+{
+    if ((char*)ptr + size == mCurrentPos) {
+        mCurrentPos = (char*)ptr;
+    }
+}
+
+void KRFrameArena::reset()
+{
+    // 複数のチャンクを使ったフレームのあとは、合計サイズの1つのチャンクにまとめ直す。
+    if (mChunkCount > 1) {
+        size_t totalSize = mCapacity;
+        freeAllChunks();
+        addChunk(totalSize);
+    }
+
+    size_t headerSize = _KRFrameArenaAlign(sizeof(_KRFrameArenaChunk), _KRFrameArenaChunkAlignment);
+    mCurrentPos = (char*)mChunks + headerSize;
+    mPrevChunksUsedSize = 0;
+
+#if __DEBUG__
+    // 前のフレームのメモリを使い続けているコードが見つかりやすいように、内容を壊しておく。
+    memset(mCurrentPos, 0xcd, mChunks->size);
+#endif
+}
+
+
+#pragma mark -
+#pragma mark メモリ使用状況の確認
+
+size_t KRFrameArena::getCapacity() const
+{
+    return mCapacity;
+}
+
+int KRFrameArena::getChunkCount() const
+{
+    return mChunkCount;
+}
+
+size_t KRFrameArena::getPeakSize() const
+{
+    return mPeakSize;
+}
+
+size_t KRFrameArena::getUsedSize() const
+{
+    size_t headerSize = _KRFrameArenaAlign(sizeof(_KRFrameArenaChunk), _KRFrameArenaChunkAlignment);
+    return mPrevChunksUsedSize + (mCurrentPos - ((char*)mChunks + headerSize));
+}
+
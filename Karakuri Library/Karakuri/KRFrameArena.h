@@ -0,0 +1,202 @@
+/*!
+    @file   KRFrameArena.h
+
+    1フレームの間だけ使う一時的なメモリを確保するためのアリーナです。
+ */
+
+#pragma once
+
+#include <Karakuri/KarakuriLibrary.h>
+
+#include <cstddef>
+#include <list>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// まとめて確保される領域。この構造体の直後にメモリが並ぶ。
+struct _KRFrameArenaChunk {
+    _KRFrameArenaChunk* next;
+    size_t              size;
+};
+
+
+/*!
+    @class KRFrameArena
+    @group  Game System
+    @abstract <p>1フレームの間だけ使う一時的なメモリを、大きな連続した領域から先頭から順番に切り出して確保するクラスです。</p>
+    <p>確保したメモリを個別に解放する必要はありません。ゲームループが drawView() 関数の呼び出しのあとで reset() 関数を呼び出し、そのフレームで確保されたすべてのメモリをまとめて再利用可能にします。updateModel() 関数や drawView() 関数の中で確保したメモリは、そのフレームの描画が終わるまで使用できます。フレームをまたいで保持してはいけません。</p>
+    <p>領域が足りなくなったときには新しい領域が追加され、次の reset() 関数の呼び出しで、それまでに使用された合計サイズの1つの領域にまとめ直されます。そのため、数フレーム後には malloc() を呼ぶことなくメモリを確保できるようになります。</p>
+    <p>通常は直接使わずに、KRFrameAllocator クラスを STL コンテナのアロケータとして指定して使用します。メインスレッドからのみ使用してください。</p>
+ */
+class KRFrameArena : public KRObject {
+
+    _KRFrameArenaChunk*     mChunks;        // 先頭のチャンクが現在使用中のチャンク
+    char*                   mCurrentPos;
+    char*                   mCurrentEnd;
+
+    size_t      mCapacity;
+    size_t      mPrevChunksUsedSize;        // 現在のチャンクより前のチャンクで使用されたバイト数
+    size_t      mPeakSize;
+    int         mChunkCount;
+
+public:
+    /*!
+        @task コンストラクタ
+     */
+    /*!
+        @method KRFrameArena
+        @abstract 最初に確保する領域のバイト数を指定して、アリーナを生成します。
+     */
+    KRFrameArena(size_t initialSize);
+
+    virtual ~KRFrameArena();
+
+public:
+    /*!
+        @task メモリの確保
+     */
+
+    /*!
+        @method allocate
+        @abstract 指定されたバイト数のメモリを、指定されたアライメントで確保します。
+        アライメントは2のべき乗で指定してください。確保したメモリは、次に reset() 関数が呼ばれるまで有効です。
+     */
+    void*   allocate(size_t size, size_t alignment = 16);
+
+    /*!
+        @method release
+        @abstract 確保したメモリを返却します。
+        最後に確保されたメモリの場合にだけ、その領域が次の確保で再利用されます。それ以外の場合には何もしません。
+     */
+    void    release(void* ptr, size_t size);
+
+    /*!
+        @method reset
+        @abstract このフレームで確保されたすべてのメモリを再利用可能にします。
+        ゲームループから1フレームに1回呼ばれます。ゲームから呼び出す必要はありません。
+     */
+    void    reset();
+
+public:
+    /*!
+        @task メモリ使用状況の確認のための関数
+     */
+
+    /*!
+        @method getCapacity
+        @abstract 確保されている領域の合計バイト数を取得します。
+     */
+    size_t  getCapacity() const;
+
+    /*!
+        @method getChunkCount
+        @abstract 確保されている領域の個数を取得します。
+        reset() 関数の直後は常に 1 になります。
+     */
+    int     getChunkCount() const;
+
+    /*!
+        @method getPeakSize
+        @abstract アリーナが作成されてから、1フレームで使用されたバイト数の最大値を取得します。
+     */
+    size_t  getPeakSize() const;
+
+    /*!
+        @method getUsedSize
+        @abstract このフレームで使用されているバイト数を取得します。
+        アライメントのための余白や、足りなくなって使われずに残った領域の末尾も含みます。
+     */
+    size_t  getUsedSize() const;
+
+private:
+    void    addChunk(size_t minSize);
+    void    freeAllChunks();
+
+};
+
+
+/*!
+    @var gKRFrameArena
+    @group Game System
+    @abstract ゲームループが所有する、1フレームの一時的なメモリのためのアリーナです。
+ */
+extern KRFrameArena*    gKRFrameArena;
+
+
+/*!
+    @class KRFrameAllocator
+    @group  Game System
+    @abstract <p>KRFrameArena クラスからメモリを確保する、STL コンテナのためのアロケータです。</p>
+    <p>このアロケータを指定したコンテナは、毎フレームの一時的な値を malloc() を呼ぶことなく格納できます。コンテナ自体も、そのフレームの中でだけ使用してください。</p>
+    <pre>std::vector&lt;int, KRFrameAllocator&lt;int&gt; &gt; touchIDs;
+gKRInputInst->getTouchIDs(touchIDs);</pre>
+    <p>アリーナを指定せずに作成した場合は、gKRFrameArena が使用されます。</p>
+ */
+template <class T>
+class KRFrameAllocator {
+
+public:
+    typedef T               value_type;
+    typedef T*              pointer;
+    typedef const T*        const_pointer;
+    typedef T&              reference;
+    typedef const T&        const_reference;
+    typedef std::size_t     size_type;
+    typedef std::ptrdiff_t  difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef KRFrameAllocator<U> other;
+    };
+
+public:
+    KRFrameArena*   mArena;
+
+public:
+    KRFrameAllocator() : mArena(gKRFrameArena) {}
+    KRFrameAllocator(KRFrameArena* arena) : mArena(arena) {}
+    template <class U>
+    KRFrameAllocator(const KRFrameAllocator<U>& other) : mArena(other.mArena) {}
+
+public:
+    pointer         address(reference x) const { return &x; }
+    const_pointer   address(const_reference x) const { return &x; }
+
+    pointer allocate(size_type n, const void* hint = 0) {
+        if (n > max_size()) {
+            throw std::bad_alloc();
+        }
+        return static_cast<pointer>(mArena->allocate(n * sizeof(T), (__alignof__(T) > 8)? __alignof__(T): 8));
+    }
+    void    deallocate(pointer p, size_type n) { mArena->release(p, n * sizeof(T)); }
+
+    void    construct(pointer p, const T& value) { new(static_cast<void*>(p)) T(value); }
+    void    destroy(pointer p) { p->~T(); }
+
+    size_type   max_size() const { return static_cast<size_type>(-1) / sizeof(T); }
+
+};
+
+template <class T, class U>
+inline bool operator==(const KRFrameAllocator<T>& a, const KRFrameAllocator<U>& b) { return (a.mArena == b.mArena); }
+
+template <class T, class U>
+inline bool operator!=(const KRFrameAllocator<T>& a, const KRFrameAllocator<U>& b) { return (a.mArena != b.mArena); }
+
+
+/*!
+    @typedef KRFrameString
+    @group  Game System
+    @abstract KRFrameArena クラスのメモリを使う文字列です。そのフレームの中でだけ使用してください。
+ */
+typedef std::basic_string<char, std::char_traits<char>, KRFrameAllocator<char> >    KRFrameString;
+
+/*!
+    @typedef KRFrameStringList
+    @group  Game System
+    @abstract KRFrameArena クラスのメモリを使う、KRFrameString のリストです。そのフレームの中でだけ使用してください。
+ */
+typedef std::list<KRFrameString, KRFrameAllocator<KRFrameString> >                 KRFrameStringList;
+
@@ -85,6 +85,7 @@ extern int      _gCharaDrawCountPos;
     KRTexture2DManager* mTex2DManager;
     KRAnime2DManager*   mAnime2DManager;
     KRAudioManager*     mAudioManager;
+    KRFrameArena*       mFrameArena;
     
     KRNetwork*          mNetworkServer;
     NSString*           mNetworkPeerName;
@@ -112,11 +112,12 @@ static inline uint64_t ConvertNanoSecToMachTime(uint64_t nanoSec) {
         
         _KRSetupSaveBox();
 
+        mFrameArena = new KRFrameArena(64 * 1024);
         mGameManager = [mLibraryConnector createGameInstance];
         mGraphics = new KRGraphics();
         mInput = new KRInput();
         mTex2DManager = new KRTexture2DManager();
-        mAnime2DManager = new KRAnime2DManager(mGameManager->getMaxChara2DCount(), mGameManager->getMaxChara2DSize());
+        mAnime2DManager = new KRAnime2DManager(mGameManager->getMaxChara2DCount(), mGameManager->getChara2DSizes());
         mAudioManager = new KRAudioManager();
         
         mMCFrameInterval = ConvertNanoSecToMachTime((uint64_t)(1000000000 / mGameManager->getFrameRate()));
@@ -187,6 +188,7 @@ static inline uint64_t ConvertNanoSecToMachTime(uint64_t nanoSec) {
     delete mAudioManager;
     delete mAnime2DManager;
     delete mTex2DManager;
+    delete mFrameArena;
     
 #if __DEBUG__
     if (mFPSDisplay != NULL) {
@@ -845,9 +847,12 @@ static inline uint64_t ConvertNanoSecToMachTime(uint64_t nanoSec) {
             
             mGraphics->setupDefaultSetting();
             
+            double drawStartTime = mGameManager->getCurrentTime();
+            
             mLoadingScreenWorld->startDrawView(mGraphics);
             
             _KRTexture2D::processBatchedTexture2DDraws();
+            gKRAnime2DMan->_updateParticleBudget(mGameManager->getCurrentTime() - drawStartTime);
 
 #if KR_IPHONE_MACOSX_EMU
             [gKRGLViewInst drawTouches];
@@ -1032,6 +1037,7 @@ static inline uint64_t ConvertNanoSecToMachTime(uint64_t nanoSec) {
             _KRTextureChangeCount = 0;
             _KRTextureBatchProcessCount = 0;
 #endif
+            double drawStartTime = mGameManager->getCurrentTime();
             if (mLoadingScreenWorld != NULL) {
                 mLoadingScreenWorld->startDrawView(mGraphics);
             } else {
@@ -1041,6 +1047,10 @@ static inline uint64_t ConvertNanoSecToMachTime(uint64_t nanoSec) {
             mDebugControlManager->drawAllControls(gKRGraphicsInst, 0);
 #endif
             _KRTexture2D::processBatchedTexture2DDraws();
+
+            // パーティクルの描画の大部分はバッチの処理で行われるので、処理が終わるまでの時間で生成率を調整する。
+            gKRAnime2DMan->_updateParticleBudget(mGameManager->getCurrentTime() - drawStartTime);
+            mFrameArena->reset();
 #if __DEBUG__
             if (mFPSDisplay != NULL) {
                 mTextureChangeCounts[mTextureChangeCountPos++] = _KRTextureChangeCount;
@@ -1340,12 +1350,15 @@ static inline uint64_t ConvertNanoSecToMachTime(uint64_t nanoSec) {
             KRColor::Black.setAsClearColor();
             glClear(GL_COLOR_BUFFER_BIT);
                 
+            double drawStartTime = mGameManager->getCurrentTime();
             if (mLoadingScreenWorld != NULL) {
                 mLoadingScreenWorld->startDrawView(mGraphics);
             } else {
                 mGameManager->drawView(mGraphics);
             }
             _KRTexture2D::processBatchedTexture2DDraws();
+            gKRAnime2DMan->_updateParticleBudget(mGameManager->getCurrentTime() - drawStartTime);
+            mFrameArena->reset();
 #if __DEBUG__
             if (mFPSDisplay != NULL) {
                 mTextureChangeCounts[mTextureChangeCountPos++] = _KRTextureChangeCount;
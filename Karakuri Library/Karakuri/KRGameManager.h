@@ -53,6 +53,7 @@ class KRGameManager : public KRObject {
     bool            mShowsFPS;
     int             mMaxChara2DCount;
     size_t          mMaxChara2DSize;
+    std::vector<size_t> mChara2DSizes;
     
     std::string     mGameIDForNetwork;
     std::string     mNetworkStartWorldName;
@@ -183,6 +184,12 @@ public:
      */
     KRAudioMixType  getAudioMixType() const;
     
+    /*!
+        @method     getChara2DSizes
+        updateMaxChara2DSize() 関数で登録されたキャラクタクラスのサイズの一覧を取得します。キャラクタのメモリは、これらのサイズから決められたサイズクラスごとに分けて管理されます。
+     */
+    const std::vector<size_t>&  getChara2DSizes() const;
+    
     /*!
         @method     getGameIDForNetwork
      */
@@ -255,6 +262,7 @@ protected:
         @method     setMaxChara2DCount
         2Dアニメーション機構で使用する最大のキャラクタ個数を設定します。デフォルトの個数は256個です。
         この個数には、パーティクル用のキャラクタも含まれることに留意してください。
+        キャラクタのメモリはこの個数ずつまとめて確保され、この個数を超えてキャラクタが作成されたときには、同じ個数分のメモリが追加で確保されます。
      */
     void            setMaxChara2DCount(int count);
     
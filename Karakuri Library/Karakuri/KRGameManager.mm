@@ -47,7 +47,8 @@ KRGameManager::KRGameManager()
     mShowsFPS = false;
     
     mMaxChara2DCount = 1024;
-    mMaxChara2DSize = sizeof(KRChara2D);
+    mMaxChara2DSize = 0;
+    updateMaxChara2DSize(sizeof(KRChara2D));
     updateMaxChara2DSize(sizeof(_KRParticle2D));
 
     mGameIDForNetwork = "";
@@ -284,11 +285,17 @@ size_t KRGameManager::getMaxChara2DSize() const
     return mMaxChara2DSize;
 }
 
+const std::vector<size_t>& KRGameManager::getChara2DSizes() const
+{
+    return mChara2DSizes;
+}
+
 void KRGameManager::updateMaxChara2DSize(size_t size)
 {
     if (mMaxChara2DSize < size) {
         mMaxChara2DSize = size;
     }
+    mChara2DSizes.push_back(size);
 }
 
 void KRGameManager::_startWorldChanging()
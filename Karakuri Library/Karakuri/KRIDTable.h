@@ -0,0 +1,73 @@
+/*!
+    @file   KRIDTable.h
+
+    小さな整数の ID から値を引くための表です。
+ */
+
+#pragma once
+
+#include <Karakuri/KarakuriLibrary.h>
+
+#include <vector>
+
+
+/*
+    @class _KRIDTable
+    @group  Game System
+    <p>テクスチャIDや効果音IDのような、0 から始まる小さな整数の ID をキーにして値を格納する表です。</p>
+    <p>ID をそのまま添字にしたベクタに格納するため、値の取得は1回の添字アクセスで済みます。std::map の operator[] と違って、get() 関数や contains() 関数は、登録されていない ID に対して要素を追加しません。erase() 関数で削除した ID は、再び登録されるまで contains() 関数で false になります。</p>
+    <p>メモリは、登録された ID の最大値に比例して使用されます。ID が数千程度に収まる表にだけ使用してください。</p>
+ */
+template <class T>
+class _KRIDTable {
+
+    std::vector<T>      mValues;
+    std::vector<bool>   mHasValues;
+
+public:
+    // 登録されていない ID に対しては false をリターンする。
+    bool contains(int id) const {
+        return (id >= 0 && (size_t)id < mHasValues.size() && mHasValues[id]);
+    }
+
+    // 登録されていない ID に対しては T() をリターンする。ポインタの表では NULL になる。
+    T get(int id) const {
+        if (id < 0 || (size_t)id >= mValues.size()) {
+            return T();
+        }
+        return mValues[id];
+    }
+
+    // 登録されていない ID の場合は、T() で初期化された要素を追加してリターンする。
+    T& operator[](int id) {
+        if (id < 0) {
+            const char* errorFormat = "Invalid ID %d was specified for the table.";
+            if (gKRLanguage == KRLanguageJapanese) {
+                errorFormat = "表に対して不正な ID %d が指定されました。";
+            }
+            throw KRRuntimeError(errorFormat, id);
+        }
+        if ((size_t)id >= mValues.size()) {
+            mValues.resize(id + 1, T());
+            mHasValues.resize(id + 1, false);
+        }
+        mHasValues[id] = true;
+        return mValues[id];
+    }
+
+    // 登録されていない ID に対しては何もしない。値は T() に戻される。
+    void erase(int id) {
+        if (id < 0 || (size_t)id >= mValues.size()) {
+            return;
+        }
+        mValues[id] = T();
+        mHasValues[id] = false;
+    }
+
+    void clear() {
+        mValues.clear();
+        mHasValues.clear();
+    }
+
+};
+
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <Karakuri/KarakuriLibrary.h>
+#include <Karakuri/KRFrameArena.h>
 #include <AvailabilityMacros.h>
 
 
@@ -334,6 +335,13 @@ public:
      */
     std::vector<int> getTouchIDs() const;
     
+    /*!
+        @method getTouchIDs
+        @abstract 現在のすべてのマルチタッチの ID を、KRFrameArena クラスのメモリを使う vector に格納します。
+        vector の以前の内容は消去されます。毎フレーム呼び出してもメモリの確保が起こらないため、updateModel() 関数の中ではこちらの使用をお勧めします。
+     */
+    void            getTouchIDs(std::vector<int, KRFrameAllocator<int> >& touchIDs) const;
+    
     /*!
         @method getTouchLocation
         @abstract 指定された ID のタッチ位置を取得します。指定された ID が無効な場合には、X方向、Y方向ともにマイナスの値をもった KRVector2D がリターンされます。
@@ -236,6 +236,20 @@ std::vector<int> KRInput::getTouchIDs() const
     return ret;
 }
 
+void KRInput::getTouchIDs(std::vector<int, KRFrameAllocator<int> >& touchIDs) const
+{
+    touchIDs.clear();
+
+    [sTouchLock lock];
+    
+    touchIDs.reserve(mTouchInfos.size());
+    for (std::vector<_KRTouchInfo>::const_iterator it = mTouchInfos.begin(); it != mTouchInfos.end(); it++) {
+        touchIDs.push_back(it->touch_id);
+    }
+    
+    [sTouchLock unlock];
+}
+
 KRVector2D KRInput::getTouchLocation(int touchID) const
 {
     for (std::vector<_KRTouchInfo>::const_iterator it = mTouchInfos.begin(); it != mTouchInfos.end(); it++) {
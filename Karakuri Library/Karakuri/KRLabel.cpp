@@ -99,6 +99,16 @@ void KRLabel::setText(const std::string& text)
     mHasChangedText = true;
 }
 
+void KRLabel::setText(const char* text)
+{
+    if (mText == text) {
+        return;
+    }
+    // 既存の領域に収まる場合には、std::string はメモリを確保し直さずに書き換える。
+    mText = text;
+    mHasChangedText = true;
+}
+
 KRTextAlignment KRLabel::getTextAlignment() const
 {
     return mTextAlignment;
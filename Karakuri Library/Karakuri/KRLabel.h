@@ -79,6 +79,22 @@ public:
         このラベルのテキストを設定します。
      */
     void            setText(const std::string& text);
+
+    /*!
+        @method setText
+        このラベルのテキストを C 言語文字列で設定します。テキストが変わらない場合には何もしません。
+     */
+    void            setText(const char* text);
+    
+    /*!
+        @method setText
+        このラベルのテキストを KRStringBuffer で設定します。
+        毎フレーム書式付きの文字列を設定する場合でも、テキストの長さが以前より長くならない限りメモリを確保しません。
+     */
+    template <size_t N>
+    void            setText(const KRStringBuffer<N>& text) {
+        setText(text.c_str());
+    }
     
     /*!
         @task 見た目の設定
@@ -7,38 +7,44 @@
 #include "KRMemoryAllocator.h"
 
 
+static const size_t _KRMemorySlotAlignment          = 16;
+static const int    _KRMemoryThreadCacheRefillCount = 32;   // キャッシュが空になったときに共有の空きリストから移す個数
+static const int    _KRMemoryThreadCacheMaxCount    = 64;   // キャッシュがこれを超えたら、_KRMemoryThreadCacheRefillCount 個を共有の空きリストに戻す
+
+static const int    _KRSizeClassMaxCount            = 8;    // サイズクラスの最大数
+static const double _KRSizeClassMergeRatio          = 1.25; // 大きさの比がこれ以下のクラスは、同じサイズクラスにまとめる
+static const int    _KRSizeClassMinCountPerChunk    = 32;
+
+
+static inline size_t _KRMemoryAlign(size_t size)
+{
+    return (size + _KRMemorySlotAlignment - 1) & ~(_KRMemorySlotAlignment - 1);
+}
+
+
 /*
     @method KRMemoryAllocator
     Constructor
  */
 KRMemoryAllocator::KRMemoryAllocator(size_t maxClassSize, int maxCount, const std::string& debugName)
-    : mMaxClassSize(maxClassSize), mMaxCount(maxCount), mDebugName(debugName)
+    : mDebugName(debugName), mMaxClassSize(maxClassSize)
 {
-    size_t allocateSize = (maxClassSize + 1) * maxCount;
-    
-    mDummyElement.prev = NULL;
-    mDummyElement.next = NULL;
-    
-    _KRMemoryElement* lastElem = &mDummyElement;
-
-    for (int i = 0; i < maxCount; i++) {
-        _KRMemoryElement* newElem = (_KRMemoryElement*)malloc(maxClassSize + sizeof(_KRMemoryElement));
-        if (newElem == NULL) {
-            const char* errorFormat = "KRMemoryAllocator: Failed to allocate enough memory (size=%d) <%s>.";
-            if (gKRLanguage == KRLanguageJapanese) {
-                errorFormat = "KRMemoryAllocator: 十分なメモリを確保できませんでした。 (size=%d) <%s>.";
-            }
-            throw KRRuntimeError(errorFormat, allocateSize, mDebugName.c_str());
-        }
-        lastElem->next = newElem;
-        newElem->prev = lastElem;
-        newElem->next = NULL;
-        lastElem = newElem;
-    }
+    mSlotSize = _KRMemoryAlign(std::max(maxClassSize, sizeof(_KRMemoryFreeSlot)));
+    mSlotCountPerChunk = std::max(maxCount, 1);
 
-    mLastFreeElement = lastElem;
+    mChunks = NULL;
+    mFreeSlots = NULL;
 
+    mChunkCount = 0;
+    mCapacity = 0;
     mAllocateCount = 0;
+    mHighWaterCount = 0;
+
+    mUsesThreadCache = false;
+    mThreadCaches = NULL;
+    pthread_mutex_init(&mMutex, NULL);
+
+    addChunk();
 }
 
 /*!
@@ -47,77 +53,430 @@ KRMemoryAllocator::KRMemoryAllocator(size_t maxClassSize, int maxCount, const st
  */
 KRMemoryAllocator::~KRMemoryAllocator()
 {
-    _KRMemoryElement* theElem = mDummyElement.next;
-    
-    while (theElem != NULL) {
-        _KRMemoryElement* nextElem = theElem->next;
-        free(theElem);
-        theElem = nextElem;
+    setUsesThreadCache(false);
+
+    _KRMemoryChunk* theChunk = mChunks;
+    while (theChunk != NULL) {
+        _KRMemoryChunk* nextChunk = theChunk->next;
+        free(theChunk);
+        theChunk = nextChunk;
+    }
+
+    pthread_mutex_destroy(&mMutex);
+}
+
+void KRMemoryAllocator::addChunk()
+{
+    size_t headerSize = _KRMemoryAlign(sizeof(_KRMemoryChunk));
+    size_t chunkSize = headerSize + mSlotSize * mSlotCountPerChunk;
+
+    _KRMemoryChunk* theChunk = (_KRMemoryChunk*)malloc(chunkSize);
+    if (theChunk == NULL) {
+        const char* errorFormat = "KRMemoryAllocator: Failed to allocate enough memory (size=%d) <%s>.";
+        if (gKRLanguage == KRLanguageJapanese) {
+            errorFormat = "KRMemoryAllocator: 十分なメモリを確保できませんでした。 (size=%d) <%s>.";
+        }
+        throw KRRuntimeError(errorFormat, (int)chunkSize, mDebugName.c_str());
+    }
+
+    theChunk->slots = (char*)theChunk + headerSize;
+    theChunk->slotCount = mSlotCountPerChunk;
+    theChunk->next = mChunks;
+    mChunks = theChunk;
+
+    // アドレスの小さいスロットから使われるように、後ろから空きリストに積む。
+    for (int i = mSlotCountPerChunk - 1; i >= 0; i--) {
+        _KRMemoryFreeSlot* theSlot = (_KRMemoryFreeSlot*)(theChunk->slots + mSlotSize * i);
+        theSlot->next = mFreeSlots;
+        mFreeSlots = theSlot;
     }
+
+    mChunkCount++;
+    mCapacity += mSlotCountPerChunk;
 }
 
 void* KRMemoryAllocator::allocate(size_t size)
 {
     if (size > mMaxClassSize) {
-        if (mDebugName == "kr-chara2d-alloc") {
-            if (gKRLanguage == KRLanguageJapanese) {
-                throw KRRuntimeError("最大サイズ %d バイトを超えるキャラクタを作成しようとしました。GameMain::GameMain() で全キャラクタクラスのサイズを登録しているのを確認してください。", (int)mMaxClassSize);
-            } else {
-                throw KRRuntimeError("Tried to create a character instance over %d bytes. Please confirm that all character class sizes are registered at GameMain::GameMain().", (int)mMaxClassSize);
-            }
-        }
+        throwSizeError(size);
+    }
+
+    if (mUsesThreadCache) {
+        return allocateFromCache(getThreadCache());
+    }
+
+    if (mFreeSlots == NULL) {
+        addChunk();
+    }
+
+    _KRMemoryFreeSlot* theSlot = mFreeSlots;
+    mFreeSlots = theSlot->next;
+
+    mAllocateCount++;
+    if (mAllocateCount > mHighWaterCount) {
+        mHighWaterCount = mAllocateCount;
+    }
+
+    return theSlot;
+}
+
+void KRMemoryAllocator::release(void* ptr)
+{
+    if (ptr == NULL) {
+        return;
+    }
+
+    _KRMemoryFreeSlot* theSlot = (_KRMemoryFreeSlot*)ptr;
+
+    if (mUsesThreadCache) {
+        releaseToCache(getThreadCache(), theSlot);
+        return;
+    }
+
+    theSlot->next = mFreeSlots;
+    mFreeSlots = theSlot;
+
+    mAllocateCount--;
+}
+
+void KRMemoryAllocator::throwSizeError(size_t size) const
+{
+    if (mDebugName == "kr-chara2d-alloc") {
         if (gKRLanguage == KRLanguageJapanese) {
-            throw KRRuntimeError("KRMemoryAllocator: new で要求されたメモリサイズが、登録されたクラスの最大メモリサイズを超えました。 (request=%dbytes, limit=%dbytes) <%s>", (int)size, (int)mMaxClassSize, mDebugName.c_str());
+            throw KRRuntimeError("最大サイズ %d バイトを超えるキャラクタを作成しようとしました。GameMain::GameMain() で全キャラクタクラスのサイズを登録しているのを確認してください。", (int)mMaxClassSize);
         } else {
-            throw KRRuntimeError("KRMemoryAllocator: Memory allocation size error (request=%dbytes, limit=%dbytes) <%s>.", (int)size, (int)mMaxClassSize, mDebugName.c_str());
+            throw KRRuntimeError("Tried to create a character instance over %d bytes. Please confirm that all character class sizes are registered at GameMain::GameMain().", (int)mMaxClassSize);
         }
     }
-    if (mAllocateCount >= mMaxCount) {
-        if (mDebugName == "kr-chara2d-alloc") {
-            if (gKRLanguage == KRLanguageJapanese) {
-                throw KRRuntimeError("最大数 %d を超えるキャラクタを作成しようとしました。GameMain::GameMain() で設定を変更してください。", mMaxCount);
-            } else {
-                throw KRRuntimeError("Tried to create characters over max count %d. Change the setting at GameMain()::GameMain().", mMaxCount);
+    if (gKRLanguage == KRLanguageJapanese) {
+        throw KRRuntimeError("KRMemoryAllocator: new で要求されたメモリサイズが、登録されたクラスの最大メモリサイズを超えました。 (request=%dbytes, limit=%dbytes) <%s>", (int)size, (int)mMaxClassSize, mDebugName.c_str());
+    } else {
+        throw KRRuntimeError("KRMemoryAllocator: Memory allocation size error (request=%dbytes, limit=%dbytes) <%s>.", (int)size, (int)mMaxClassSize, mDebugName.c_str());
+    }
+}
+
+
+#pragma mark -
+#pragma mark スレッドごとのキャッシュ
+
+void KRMemoryAllocator::setUsesThreadCache(bool flag)
+{
+    if (flag == mUsesThreadCache) {
+        return;
+    }
+
+    if (flag) {
+        pthread_key_create(&mThreadCacheKey, _flushThreadCache);
+        mUsesThreadCache = true;
+        return;
+    }
+
+    // キャッシュを使ったスレッドはすでに終了しているので、残っているスロットを共有の空きリストに戻すだけでよい。
+    pthread_key_delete(mThreadCacheKey);
+    mUsesThreadCache = false;
+
+    _KRMemoryThreadCache* theCache = mThreadCaches;
+    while (theCache != NULL) {
+        _KRMemoryThreadCache* nextCache = theCache->next;
+        _flushThreadCache(theCache);
+        free(theCache);
+        theCache = nextCache;
+    }
+    mThreadCaches = NULL;
+}
+
+_KRMemoryThreadCache* KRMemoryAllocator::getThreadCache()
+{
+    _KRMemoryThreadCache* theCache = (_KRMemoryThreadCache*)pthread_getspecific(mThreadCacheKey);
+    if (theCache != NULL) {
+        return theCache;
+    }
+
+    theCache = (_KRMemoryThreadCache*)malloc(sizeof(_KRMemoryThreadCache));
+    if (theCache == NULL) {
+        const char* errorFormat = "KRMemoryAllocator: Failed to allocate enough memory (size=%d) <%s>.";
+        if (gKRLanguage == KRLanguageJapanese) {
+            errorFormat = "KRMemoryAllocator: 十分なメモリを確保できませんでした。 (size=%d) <%s>.";
+        }
+        throw KRRuntimeError(errorFormat, (int)sizeof(_KRMemoryThreadCache), mDebugName.c_str());
+    }
+    theCache->allocator = this;
+    theCache->freeSlots = NULL;
+    theCache->freeCount = 0;
+
+    pthread_mutex_lock(&mMutex);
+    theCache->next = mThreadCaches;
+    mThreadCaches = theCache;
+    pthread_mutex_unlock(&mMutex);
+
+    pthread_setspecific(mThreadCacheKey, theCache);
+    return theCache;
+}
+
+void* KRMemoryAllocator::allocateFromCache(_KRMemoryThreadCache* cache)
+{
+    if (cache->freeSlots == NULL) {
+        pthread_mutex_lock(&mMutex);
+        for (int i = 0; i < _KRMemoryThreadCacheRefillCount; i++) {
+            if (mFreeSlots == NULL) {
+                try {
+                    addChunk();
+                } catch (...) {
+                    pthread_mutex_unlock(&mMutex);
+                    throw;
+                }
             }
+            _KRMemoryFreeSlot* theSlot = mFreeSlots;
+            mFreeSlots = theSlot->next;
+            theSlot->next = cache->freeSlots;
+            cache->freeSlots = theSlot;
         }
-        const char* errorFormat = "KRMemoryAllocator: Tried to instantiate over max count %d <%s>.";
-        if (gKRLanguage == KRLanguageJapanese) {
-            errorFormat = "KRMemoryAllocator: 設定された最大数 %d を超えてインスタンスを作成しようとしました。 <%s>";
+        pthread_mutex_unlock(&mMutex);
+        cache->freeCount = _KRMemoryThreadCacheRefillCount;
+    }
+
+    _KRMemoryFreeSlot* theSlot = cache->freeSlots;
+    cache->freeSlots = theSlot->next;
+    cache->freeCount--;
+
+    updateHighWater(__sync_add_and_fetch(&mAllocateCount, 1));
+
+    return theSlot;
+}
+
+void KRMemoryAllocator::releaseToCache(_KRMemoryThreadCache* cache, _KRMemoryFreeSlot* slot)
+{
+    slot->next = cache->freeSlots;
+    cache->freeSlots = slot;
+    cache->freeCount++;
+
+    __sync_sub_and_fetch(&mAllocateCount, 1);
+
+    if (cache->freeCount > _KRMemoryThreadCacheMaxCount) {
+        pthread_mutex_lock(&mMutex);
+        for (int i = 0; i < _KRMemoryThreadCacheRefillCount; i++) {
+            _KRMemoryFreeSlot* theSlot = cache->freeSlots;
+            cache->freeSlots = theSlot->next;
+            theSlot->next = mFreeSlots;
+            mFreeSlots = theSlot;
         }
-        throw KRRuntimeError(errorFormat, mMaxCount, mDebugName.c_str());
+        pthread_mutex_unlock(&mMutex);
+        cache->freeCount -= _KRMemoryThreadCacheRefillCount;
     }
+}
+
+void KRMemoryAllocator::updateHighWater(int count)
+{
+    int highWater = mHighWaterCount;
+    while (count > highWater) {
+        if (__sync_bool_compare_and_swap(&mHighWaterCount, highWater, count)) {
+            break;
+        }
+        highWater = mHighWaterCount;
+    }
+}
+
+// スレッドの終了時に呼ばれ、キャッシュに残っているスロットを共有の空きリストに戻す。
+// キャッシュの構造体自体は、アロケータが削除されるときに解放する。
+void KRMemoryAllocator::_flushThreadCache(void* cache)
+{
+    _KRMemoryThreadCache* theCache = (_KRMemoryThreadCache*)cache;
+    KRMemoryAllocator* theAllocator = theCache->allocator;
+
+    pthread_mutex_lock(&theAllocator->mMutex);
+    while (theCache->freeSlots != NULL) {
+        _KRMemoryFreeSlot* theSlot = theCache->freeSlots;
+        theCache->freeSlots = theSlot->next;
+        theSlot->next = theAllocator->mFreeSlots;
+        theAllocator->mFreeSlots = theSlot;
+    }
+    theCache->freeCount = 0;
+    pthread_mutex_unlock(&theAllocator->mMutex);
+}
+
+
+#pragma mark -
+#pragma mark メモリ使用状況の確認
+
+struct _KRMemoryChunkUsage {
+    const char* start;
+    int         freeCount;
+
+    bool operator<(const _KRMemoryChunkUsage& usage) const { return start < usage.start; }
+};
+
+KRMemoryAllocatorStats KRMemoryAllocator::getStats() const
+{
+    KRMemoryAllocatorStats stats;
+
+    pthread_mutex_lock(&mMutex);
+
+    stats.slotSize = mSlotSize;
+    stats.chunkCount = mChunkCount;
+    stats.capacity = mCapacity;
+    stats.allocatedCount = mAllocateCount;
+    stats.highWaterCount = mHighWaterCount;
+    stats.reservedBytes = (_KRMemoryAlign(sizeof(_KRMemoryChunk)) + mSlotSize * mSlotCountPerChunk) * mChunkCount;
+    stats.highWaterBytes = mSlotSize * mHighWaterCount;
+
+    stats.threadCachedCount = 0;
+    for (_KRMemoryThreadCache* theCache = mThreadCaches; theCache != NULL; theCache = theCache->next) {
+        stats.threadCachedCount += theCache->freeCount;
+    }
+
+    // 共有の空きリストにあるスロットを、チャンクごとに数える。
+    std::vector<_KRMemoryChunkUsage> usages;
+    usages.reserve(mChunkCount);
+    for (_KRMemoryChunk* theChunk = mChunks; theChunk != NULL; theChunk = theChunk->next) {
+        _KRMemoryChunkUsage usage;
+        usage.start = theChunk->slots;
+        usage.freeCount = 0;
+        usages.push_back(usage);
+    }
+    std::sort(usages.begin(), usages.end());
+
+    for (_KRMemoryFreeSlot* theSlot = mFreeSlots; theSlot != NULL; theSlot = theSlot->next) {
+        _KRMemoryChunkUsage key;
+        key.start = (const char*)theSlot;
+        std::vector<_KRMemoryChunkUsage>::iterator it = std::upper_bound(usages.begin(), usages.end(), key);
+        (it - 1)->freeCount++;
+    }
+
+    pthread_mutex_unlock(&mMutex);
+
+    stats.emptyChunkCount = 0;
+    int scatteredFreeCount = 0;
+    for (size_t i = 0; i < usages.size(); i++) {
+        if (usages[i].freeCount == mSlotCountPerChunk) {
+            stats.emptyChunkCount++;
+        } else {
+            scatteredFreeCount += usages[i].freeCount;
+        }
+    }
+    stats.fragmentation = (mCapacity > 0)? (double)scatteredFreeCount / mCapacity: 0.0;
+
+    return stats;
+}
+
+// getStats() と違って空きスロットを数えないので、毎フレーム呼び出しても時間がかからない。
+void KRMemoryAllocator::_getUsage(size_t* reservedBytes, int* allocatedCount) const
+{
+    pthread_mutex_lock(&mMutex);
+    *reservedBytes = (_KRMemoryAlign(sizeof(_KRMemoryChunk)) + mSlotSize * mSlotCountPerChunk) * mChunkCount;
+    *allocatedCount = mAllocateCount;
+    pthread_mutex_unlock(&mMutex);
+}
+
+
+#pragma mark -
+#pragma mark KRSizeClassAllocator クラスの実装
+
+KRSizeClassAllocator::KRSizeClassAllocator(const std::vector<size_t>& classSizes, int countPerChunk, const std::string& debugName)
+{
+    mSizeClasses = _makeSizeClasses(classSizes);
     
-    _KRMemoryElement* theElem = mLastFreeElement;
-    mLastFreeElement = theElem->prev;
-    mLastFreeElement->next = NULL;
-    
-    mDummyElement.next->prev = theElem;
-    theElem->next = mDummyElement.next;
-    theElem->prev = &mDummyElement;
-    mDummyElement.next = theElem;
-    
-    mAllocateCount++;
+    int classCountPerChunk = std::max(countPerChunk / (int)mSizeClasses.size(), _KRSizeClassMinCountPerChunk);
+    for (size_t i = 0; i < mSizeClasses.size(); i++) {
+        mAllocators.push_back(new KRMemoryAllocator(mSizeClasses[i], classCountPerChunk, debugName));
+    }
     
-    return (void*)((char*)theElem + sizeof(_KRMemoryElement));
+    size_t tableSize = mSizeClasses.back() / _KRMemorySlotAlignment + 1;
+    mClassIndexTable.resize(tableSize);
+    int classIndex = 0;
+    for (size_t i = 0; i < tableSize; i++) {
+        while (mSizeClasses[classIndex] < i * _KRMemorySlotAlignment) {
+            classIndex++;
+        }
+        mClassIndexTable[i] = (unsigned char)classIndex;
+    }
 }
 
-void KRMemoryAllocator::release(void* ptr)
+KRSizeClassAllocator::~KRSizeClassAllocator()
 {
-    _KRMemoryElement* theElem = (_KRMemoryElement*)((char*)ptr - sizeof(_KRMemoryElement));
+    for (size_t i = 0; i < mAllocators.size(); i++) {
+        delete mAllocators[i];
+    }
+}
+
+std::vector<size_t> KRSizeClassAllocator::_makeSizeClasses(const std::vector<size_t>& classSizes)
+{
+    std::vector<size_t> sizes;
+    for (size_t i = 0; i < classSizes.size(); i++) {
+        sizes.push_back(_KRMemoryAlign(std::max(classSizes[i], sizeof(_KRMemoryFreeSlot))));
+    }
+    if (sizes.empty()) {
+        sizes.push_back(_KRMemoryAlign(sizeof(_KRMemoryFreeSlot)));
+    }
+    std::sort(sizes.begin(), sizes.end());
+    sizes.erase(std::unique(sizes.begin(), sizes.end()), sizes.end());
     
-    if (theElem != mLastFreeElement) {
-        theElem->prev->next = theElem->next;
-        if (theElem->next != NULL) {
-            theElem->next->prev = theElem->prev;
+    // 大きい方から見ていき、直前のサイズクラスに少しの無駄で収まるクラスはまとめる。
+    std::vector<size_t> classes;
+    for (int i = (int)sizes.size() - 1; i >= 0; i--) {
+        if (classes.empty() || classes.back() > sizes[i] * _KRSizeClassMergeRatio) {
+            classes.push_back(sizes[i]);
         }
-        theElem->next = NULL;
-        
-        mLastFreeElement->next = theElem;
-        theElem->prev = mLastFreeElement;
-        mLastFreeElement = theElem;
     }
+    std::reverse(classes.begin(), classes.end());
     
-    mAllocateCount--;
+    // まだ多すぎる場合は、隣のサイズクラスとの比がもっとも小さいものから順にまとめる。
+    while (classes.size() > (size_t)_KRSizeClassMaxCount) {
+        size_t mergeIndex = 0;
+        double minRatio = 0.0;
+        for (size_t i = 0; i + 1 < classes.size(); i++) {
+            double ratio = (double)classes[i + 1] / classes[i];
+            if (i == 0 || ratio < minRatio) {
+                minRatio = ratio;
+                mergeIndex = i;
+            }
+        }
+        classes.erase(classes.begin() + mergeIndex);
+    }
+    
+    return classes;
+}
+
+void* KRSizeClassAllocator::allocate(size_t size)
+{
+    size_t tableIndex = (size + _KRMemorySlotAlignment - 1) / _KRMemorySlotAlignment;
+    if (tableIndex >= mClassIndexTable.size()) {
+        // 一番大きいサイズクラスのアロケータに、サイズ超過のエラーを投げさせる。
+        return mAllocators.back()->allocate(size);
+    }
+    return mAllocators[mClassIndexTable[tableIndex]]->allocate(size);
+}
+
+void KRSizeClassAllocator::release(void* ptr, size_t size)
+{
+    size_t tableIndex = (size + _KRMemorySlotAlignment - 1) / _KRMemorySlotAlignment;
+    mAllocators[mClassIndexTable[tableIndex]]->release(ptr);
+}
+
+size_t KRSizeClassAllocator::getSizeClass(int index) const
+{
+    return mSizeClasses[index];
+}
+
+int KRSizeClassAllocator::getSizeClassCount() const
+{
+    return (int)mSizeClasses.size();
+}
+
+KRMemoryAllocatorStats KRSizeClassAllocator::getStats(int index) const
+{
+    return mAllocators[index]->getStats();
 }
 
+void KRSizeClassAllocator::_getUsage(size_t* reservedBytes, int* allocatedCount) const
+{
+    *reservedBytes = 0;
+    *allocatedCount = 0;
+    for (size_t i = 0; i < mAllocators.size(); i++) {
+        size_t theReservedBytes;
+        int theAllocatedCount;
+        mAllocators[i]->_getUsage(&theReservedBytes, &theAllocatedCount);
+        *reservedBytes += theReservedBytes;
+        *allocatedCount += theAllocatedCount;
+    }
+}
 
@@ -10,6 +10,8 @@
 
 #include <Karakuri/KarakuriLibrary.h>
 
+#include <pthread.h>
+
 
 /*!
     @define KR_DECLARE_USE_ALLOCATOR
@@ -24,6 +26,18 @@
         void    operator delete(void* ptr) { allocator->release(ptr); }\
     private:
 
+/*
+    @define KR_DECLARE_USE_SIZE_CLASS_ALLOCATOR
+    @group  Game System
+    <p>KRSizeClassAllocator クラスのアロケータの変数名を指定して、アロケータの使用を宣言するためのマクロ関数です。必ずクラス宣言の先頭に記述してください。</p>
+    <p>delete 時にインスタンスのサイズを使って解放先を決めるため、このマクロを使うクラスのデストラクタは virtual にしてください。</p>
+ */
+#define KR_DECLARE_USE_SIZE_CLASS_ALLOCATOR(allocator)\
+    public:\
+        void*   operator new(size_t size) { return allocator->allocate(size); }\
+        void    operator delete(void* ptr, size_t size) { allocator->release(ptr, size); }\
+    private:
+
 /*
     @define KR_UPDATE_MAX_CLASS_SIZE
     @group  Game System
@@ -36,30 +50,127 @@
 #define KR_UPDATE_MAX_CLASS_SIZE(size_var, the_class)  if (sizeof(the_class) > size_var) { size_var = sizeof(the_class); }
 
 
-struct _KRMemoryElement {
-    _KRMemoryElement*  prev;
-    _KRMemoryElement*  next;
+// 空きスロットの先頭に埋め込まれる、空きリストの要素
+struct _KRMemoryFreeSlot {
+    _KRMemoryFreeSlot*  next;
+};
+
+// まとめて確保される領域。この構造体の直後にスロットが並ぶ。
+struct _KRMemoryChunk {
+    _KRMemoryChunk*     next;
+    char*               slots;
+    int                 slotCount;
+};
+
+class KRMemoryAllocator;
+
+// スレッドごとに持つ空きスロットのキャッシュ
+struct _KRMemoryThreadCache {
+    KRMemoryAllocator*      allocator;
+    _KRMemoryThreadCache*   next;
+    _KRMemoryFreeSlot*      freeSlots;
+    int                     freeCount;
 };
 
 
+/*!
+    @struct KRMemoryAllocatorStats
+    @group  Game System
+    @abstract KRMemoryAllocator クラスのメモリの使用状況を格納しておくための構造体です。
+ */
+typedef struct KRMemoryAllocatorStats {
+    /*!
+        @var slotSize
+        1つのスロットのバイト数です。登録されたクラスの最大サイズを、16バイト境界に切り上げた値になります。
+     */
+    size_t      slotSize;
+    
+    /*!
+        @var chunkCount
+        確保されているチャンク（スロットをまとめて確保した領域）の個数です。
+     */
+    int         chunkCount;
+    
+    /*!
+        @var capacity
+        すべてのチャンクに含まれるスロットの総数です。
+     */
+    int         capacity;
+    
+    /*!
+        @var allocatedCount
+        現在使用されているスロットの個数です。
+     */
+    int         allocatedCount;
+    
+    /*!
+        @var highWaterCount
+        アロケータが作成されてから、同時に使用されたスロットの個数の最大値です。
+     */
+    int         highWaterCount;
+    
+    /*!
+        @var threadCachedCount
+        スレッドごとのキャッシュに保持されている空きスロットの個数です。
+     */
+    int         threadCachedCount;
+    
+    /*!
+        @var emptyChunkCount
+        1つのスロットも使用されていないチャンクの個数です。
+     */
+    int         emptyChunkCount;
+    
+    /*!
+        @var reservedBytes
+        チャンクのために確保されているバイト数です。
+     */
+    size_t      reservedBytes;
+    
+    /*!
+        @var highWaterBytes
+        同時に使用されたスロットの個数が最大のときの、スロットのバイト数の合計です。
+     */
+    size_t      highWaterBytes;
+    
+    /*!
+        @var fragmentation
+        @abstract 使用中のスロットと同じチャンクに散らばっている空きスロットの、全スロットに対する割合（0.0〜1.0）です。
+        値が大きいほど、使用中のスロットがチャンク全体にまばらに散らばっています。
+     */
+    double      fragmentation;
+} KRMemoryAllocatorStats;
+
+
 /*
     @class KRMemoryAllocator
     @group  Game System
     @deprecated
     @abstract <p><strong class="warning">(Deprecated) 現在、このクラスの利用は推奨されません。代わりに KRAnime2DManager クラスのアニメーション管理機構を使用してください。</strong></p>
-    <p>同じ種類のクラスのインスタンスを複数個作成するために、あらかじめ必要な領域を確保して、連結リストで管理しておくクラスです。</p>
+    <p>同じ種類のクラスのインスタンスを複数個作成するために、大きな連続した領域（チャンク）をあらかじめ確保して、同じサイズのスロットに分けて管理しておくクラスです。</p>
+    <p>空きスロットは、スロット自身の先頭に埋め込まれた単方向リストで管理されます。すべてのスロットが使用されている状態で新たなインスタンスが作成されると、新しいチャンクが追加されます。</p>
     <p>このクラスのメソッドなどは直接使用しません。主にマクロを使って利用します。主な使い方は、「<a href="../../../../guide/memory_allocator.html">多数インスタンスのメモリ管理</a>」を参照してください。</p>
  */
 class KRMemoryAllocator : public KRObject {
     
     std::string mDebugName;
     
-    int         mAllocateCount;
     size_t      mMaxClassSize;
-    int         mMaxCount;
+    size_t      mSlotSize;
+    int         mSlotCountPerChunk;
 
-    _KRMemoryElement     mDummyElement;
-    _KRMemoryElement*    mLastFreeElement;
+    _KRMemoryChunk*     mChunks;
+    _KRMemoryFreeSlot*  mFreeSlots;
+    
+    int         mChunkCount;
+    int         mCapacity;
+    int         mAllocateCount;
+    int         mHighWaterCount;
+    
+    bool                    mUsesThreadCache;
+    mutable pthread_mutex_t mMutex;
+    pthread_key_t           mThreadCacheKey;
+    _KRMemoryThreadCache*   mThreadCaches;
 
 public:
     /*!
@@ -68,7 +179,8 @@ public:
     /*!
         @method KRMemoryAllocator
         @abstract <p><strong class="warning">(Deprecated) 現在、このクラスの利用は推奨されません。代わりに KRAnime2DManager クラスのアニメーション管理機構を使用してください。</strong></p>
-        メモリサイズ、インスタンスの最大生成個数、デバッグ用のアロケータの名称を指定して、アロケータを生成します。
+        メモリサイズ、1つのチャンクに含めるインスタンスの個数、デバッグ用のアロケータの名称を指定して、アロケータを生成します。
+        maxCount 個を超えるインスタンスが作成されると、同じ個数のチャンクが追加されます。
      */
     KRMemoryAllocator(size_t maxClassSize, int maxCount, const std::string &debugName);
 
@@ -78,5 +190,102 @@ public:
     void*   allocate(size_t size);
     void    release(void* ptr);
     
+public:
+    /*!
+        @task メモリ使用状況の確認のための関数
+     */
+    
+    /*!
+        @method getStats
+        @abstract 現在のメモリの使用状況を取得します。
+        空きスロットを数えるため、使用されていないスロットの個数に比例した時間がかかります。
+     */
+    KRMemoryAllocatorStats  getStats() const;
+    
+public:
+    /*!
+        @task マルチスレッドのための関数
+     */
+    
+    /*!
+        @method setUsesThreadCache
+        @abstract スレッドごとに空きスロットのキャッシュを持たせるかどうかを設定します。
+        <p>デフォルトでは false で、1つのスレッドからだけインスタンスを作成・削除できます。true にすると、複数のスレッドから同時にインスタンスを作成・削除できるようになり、各スレッドはキャッシュが空になったときやあふれたときだけロックを取ります。</p>
+        <p>インスタンスを1つも作成していない状態で呼び出してください。キャッシュを使用したスレッドは、アロケータが削除される前に終了している必要があります。</p>
+     */
+    void    setUsesThreadCache(bool flag);
+    
+public:
+    void    _getUsage(size_t* reservedBytes, int* allocatedCount) const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    
+private:
+    void    addChunk();
+    void*   allocateFromCache(_KRMemoryThreadCache* cache);
+    _KRMemoryThreadCache*   getThreadCache();
+    void    releaseToCache(_KRMemoryThreadCache* cache, _KRMemoryFreeSlot* slot);
+    void    throwSizeError(size_t size) const;
+    void    updateHighWater(int count);
+    
+    static void _flushThreadCache(void* cache);
+    
+};
+
+
+/*
+    @class KRSizeClassAllocator
+    @group  Game System
+    @abstract <p>サイズの異なる複数のクラスのインスタンスを、サイズごとに分けた KRMemoryAllocator で管理するクラスです。</p>
+    <p>登録されたクラスのサイズから、いくつかのサイズクラスが自動的に決められます。インスタンスは、そのサイズが収まるもっとも小さいサイズクラスのスロットに格納されるため、小さなクラスのインスタンスが大きなクラスと同じ大きさのスロットを使うことはありません。</p>
+    <p>このクラスのメソッドなどは直接使用しません。KR_DECLARE_USE_SIZE_CLASS_ALLOCATOR マクロを使って利用します。</p>
+ */
+class KRSizeClassAllocator : public KRObject {
+    
+    std::vector<KRMemoryAllocator*>     mAllocators;
+    std::vector<size_t>                 mSizeClasses;
+    std::vector<unsigned char>          mClassIndexTable;   // (size + 15) / 16 からサイズクラスの番号を引くための表
+
+public:
+    /*!
+        @task コンストラクタ
+     */
+    /*!
+        @method KRSizeClassAllocator
+        @abstract 管理するクラスのサイズの一覧、1つのサイズクラスあたりのチャンクに含めるインスタンスの個数、デバッグ用のアロケータの名称を指定して、アロケータを生成します。
+     */
+    KRSizeClassAllocator(const std::vector<size_t>& classSizes, int countPerChunk, const std::string& debugName);
+    
+    virtual ~KRSizeClassAllocator();
+    
+public:
+    void*   allocate(size_t size);
+    void    release(void* ptr, size_t size);
+    
+public:
+    /*!
+        @task メモリ使用状況の確認のための関数
+     */
+    
+    /*!
+        @method getSizeClass
+        @abstract 指定された番号のサイズクラスに格納できる最大のバイト数を取得します。
+     */
+    size_t  getSizeClass(int index) const;
+    
+    /*!
+        @method getSizeClassCount
+        @abstract サイズクラスの個数を取得します。
+     */
+    int     getSizeClassCount() const;
+    
+    /*!
+        @method getStats
+        @abstract 指定された番号のサイズクラスの、現在のメモリの使用状況を取得します。
+     */
+    KRMemoryAllocatorStats  getStats(int index) const;
+    
+public:
+    void    _getUsage(size_t* reservedBytes, int* allocatedCount) const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    static std::vector<size_t>  _makeSizeClasses(const std::vector<size_t>& classSizes) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    
 };
 
@@ -0,0 +1,181 @@
+/*!
+    @file   KRMemoryStats.cpp
+ */
+
+#include "KRMemoryStats.h"
+
+#include "KRChara2D.h"
+#include "KRFrameArena.h"
+
+#include <cstdio>
+#include <pthread.h>
+
+
+// テクスチャと効果音はローディング用のスレッドからも報告されるので、ロックを取って更新する。
+static pthread_mutex_t          sMemoryStatsMutex = PTHREAD_MUTEX_INITIALIZER;
+static KRMemoryCategoryStats    sMemoryStats[KRMemoryCategoryCount];
+static bool                     sDumpsOnWorldChange = false;
+
+// パーティクルのように、メインスレッドからしか報告されずに頻繁に作成・破棄されるカテゴリは、
+// ロックを取らずに別の表で集計しておき、値が読み出されるときに書き写す。
+static KRMemoryCategoryStats    sMainThreadMemoryStats[KRMemoryCategoryCount];
+static bool                     sIsMainThreadCategory[KRMemoryCategoryCount];
+
+
+static void _KRUpdateMemoryPeaks(KRMemoryCategoryStats& stats)
+{
+    if (stats.bytes > stats.peakBytes) {
+        stats.peakBytes = stats.bytes;
+    }
+    if (stats.count > stats.peakCount) {
+        stats.peakCount = stats.count;
+    }
+}
+
+// アロケータから直接読み出すカテゴリの現在の値を、表に書き込む。
+static void _KRPollMemoryStats(KRMemoryCategory category)
+{
+    if (sIsMainThreadCategory[category]) {
+        sMemoryStats[category] = sMainThreadMemoryStats[category];
+        return;
+    }
+    if (category == KRMemoryCategoryChara2D) {
+        if (_gKRChara2DAllocator == NULL) {
+            return;
+        }
+        size_t reservedBytes;
+        int allocatedCount;
+        _gKRChara2DAllocator->_getUsage(&reservedBytes, &allocatedCount);
+        sMemoryStats[category].bytes = reservedBytes;
+        sMemoryStats[category].count = allocatedCount;
+    } else if (category == KRMemoryCategoryFrameArena) {
+        if (gKRFrameArena == NULL) {
+            return;
+        }
+        sMemoryStats[category].bytes = gKRFrameArena->getCapacity();
+        sMemoryStats[category].count = gKRFrameArena->getChunkCount();
+    } else {
+        return;
+    }
+    _KRUpdateMemoryPeaks(sMemoryStats[category]);
+}
+
+
+#pragma mark -
+#pragma mark 使用量の取得
+
+std::string KRMemoryStats::getCategoryName(KRMemoryCategory category)
+{
+    switch (category) {
+        case KRMemoryCategoryTexture:
+            return "Texture";
+        case KRMemoryCategorySound:
+            return "Sound";
+        case KRMemoryCategoryChara2D:
+            return "Chara2D";
+        case KRMemoryCategoryParticle:
+            return "Particle";
+        case KRMemoryCategorySimulator:
+            return "Simulator2D";
+        case KRMemoryCategoryFrameArena:
+            return "FrameArena";
+        default:
+            return "Unknown";
+    }
+}
+
+KRMemoryCategoryStats KRMemoryStats::getStats(KRMemoryCategory category)
+{
+    pthread_mutex_lock(&sMemoryStatsMutex);
+    _KRPollMemoryStats(category);
+    KRMemoryCategoryStats ret = sMemoryStats[category];
+    pthread_mutex_unlock(&sMemoryStatsMutex);
+
+    return ret;
+}
+
+size_t KRMemoryStats::getTotalBytes()
+{
+    size_t ret = 0;
+    for (int i = 0; i < KRMemoryCategoryCount; i++) {
+        if (i != KRMemoryCategoryParticle) {
+            ret += getStats((KRMemoryCategory)i).bytes;
+        }
+    }
+    return ret;
+}
+
+void KRMemoryStats::resetPeaks()
+{
+    pthread_mutex_lock(&sMemoryStatsMutex);
+    for (int i = 0; i < KRMemoryCategoryCount; i++) {
+        _KRPollMemoryStats((KRMemoryCategory)i);
+        sMemoryStats[i].peakBytes = sMemoryStats[i].bytes;
+        sMemoryStats[i].peakCount = sMemoryStats[i].count;
+        sMainThreadMemoryStats[i].peakBytes = sMainThreadMemoryStats[i].bytes;
+        sMainThreadMemoryStats[i].peakCount = sMainThreadMemoryStats[i].count;
+    }
+    pthread_mutex_unlock(&sMemoryStatsMutex);
+}
+
+
+#pragma mark -
+#pragma mark 使用量の出力
+
+void KRMemoryStats::dump(const std::string& title)
+{
+    printf("---- Memory Stats: %s ----\n", title.c_str());
+    printf("%-12s %10s %8s %10s %8s\n", "category", "KB", "count", "peak KB", "peak");
+    for (int i = 0; i < KRMemoryCategoryCount; i++) {
+        KRMemoryCategoryStats stats = getStats((KRMemoryCategory)i);
+        printf("%-12s %10.1f %8d %10.1f %8d\n", getCategoryName((KRMemoryCategory)i).c_str(),
+               stats.bytes / 1024.0, stats.count, stats.peakBytes / 1024.0, stats.peakCount);
+    }
+    printf("%-12s %10.1f\n", "total", getTotalBytes() / 1024.0);
+}
+
+bool KRMemoryStats::getDumpsOnWorldChange()
+{
+    return sDumpsOnWorldChange;
+}
+
+void KRMemoryStats::setDumpsOnWorldChange(bool flag)
+{
+    sDumpsOnWorldChange = flag;
+}
+
+
+#pragma mark -
+#pragma mark サブシステムからの報告
+
+void KRMemoryStats::_add(KRMemoryCategory category, size_t bytes, int count)
+{
+    pthread_mutex_lock(&sMemoryStatsMutex);
+    sMemoryStats[category].bytes += bytes;
+    sMemoryStats[category].count += count;
+    _KRUpdateMemoryPeaks(sMemoryStats[category]);
+    pthread_mutex_unlock(&sMemoryStatsMutex);
+}
+
+void KRMemoryStats::_remove(KRMemoryCategory category, size_t bytes, int count)
+{
+    pthread_mutex_lock(&sMemoryStatsMutex);
+    sMemoryStats[category].bytes -= bytes;
+    sMemoryStats[category].count -= count;
+    pthread_mutex_unlock(&sMemoryStatsMutex);
+}
+
+void KRMemoryStats::_addFromMainThread(KRMemoryCategory category, size_t bytes, int count)
+{
+    sIsMainThreadCategory[category] = true;
+    sMainThreadMemoryStats[category].bytes += bytes;
+    sMainThreadMemoryStats[category].count += count;
+    _KRUpdateMemoryPeaks(sMainThreadMemoryStats[category]);
+}
+
+void KRMemoryStats::_removeFromMainThread(KRMemoryCategory category, size_t bytes, int count)
+{
+    sMainThreadMemoryStats[category].bytes -= bytes;
+    sMainThreadMemoryStats[category].count -= count;
+}
+
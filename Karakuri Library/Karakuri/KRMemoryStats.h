@@ -0,0 +1,141 @@
+/*!
+    @file   KRMemoryStats.h
+
+    サブシステムごとのメモリ使用量を集計するためのクラスです。
+ */
+
+#pragma once
+
+#include <Karakuri/KarakuriLibrary.h>
+
+#include <string>
+
+
+/*!
+    @enum   KRMemoryCategory
+    @group  Game System
+    @constant   KRMemoryCategoryTexture     テクスチャです。バイト数は、2のべき乗に広げたテクスチャのサイズとピクセルフォーマットから見積もった GPU 上のバイト数です。
+    @constant   KRMemoryCategorySound       KRAudioManager の効果音と KRSound の、デコード済みのオーディオバッファです。OpenAL が持つコピーを含みます。
+    @constant   KRMemoryCategoryChara2D     キャラクタのスロット（KRChara2D と、そのサブクラスのインスタンスを格納するためのアロケータ）です。パーティクルのスロットも含みます。
+    @constant   KRMemoryCategoryParticle    パーティクルです。キャラクタのスロットのうち、パーティクルが使用している分です。
+    @constant   KRMemoryCategorySimulator   2次元物理シミュレータです。衝突情報やブロードフェーズのためのプールのバイト数で、個数は図形の個数です。
+    @constant   KRMemoryCategoryFrameArena  1フレームの一時的なメモリのための KRFrameArena です。個数はチャンクの個数です。
+    @constant   KRMemoryCategoryCount       カテゴリの個数です。
+    @abstract   メモリ使用量を集計するカテゴリを表す型です。
+ */
+typedef enum {
+    KRMemoryCategoryTexture,
+    KRMemoryCategorySound,
+    KRMemoryCategoryChara2D,
+    KRMemoryCategoryParticle,
+    KRMemoryCategorySimulator,
+    KRMemoryCategoryFrameArena,
+    KRMemoryCategoryCount,
+} KRMemoryCategory;
+
+
+/*!
+    @struct KRMemoryCategoryStats
+    @group  Game System
+    @abstract 1つのカテゴリのメモリ使用量を格納しておくための構造体です。
+ */
+typedef struct KRMemoryCategoryStats {
+    /*!
+        @var bytes
+        現在使用されているバイト数です。
+     */
+    size_t      bytes;
+
+    /*!
+        @var count
+        現在存在しているオブジェクトの個数です。
+     */
+    int         count;
+
+    /*!
+        @var peakBytes
+        ゲームの開始時か、最後に KRMemoryStats::resetPeaks() 関数が呼ばれてからの bytes の最大値です。
+     */
+    size_t      peakBytes;
+
+    /*!
+        @var peakCount
+        ゲームの開始時か、最後に KRMemoryStats::resetPeaks() 関数が呼ばれてからの count の最大値です。
+     */
+    int         peakCount;
+} KRMemoryCategoryStats;
+
+
+/*!
+    @class KRMemoryStats
+    @group  Game System
+    @abstract <p>テクスチャ、オーディオ、キャラクタ、パーティクル、物理シミュレータなどのサブシステムごとに、メモリの使用量とオブジェクトの個数を集計するクラスです。</p>
+    <p>各サブシステムはオブジェクトの作成時と破棄時に使用量を報告するため、値の取得には時間がかかりません。毎フレーム読み出して画面に表示することもできます。</p>
+    <p>setDumpsOnWorldChange() 関数で true を設定しておくと、ワールドが切り替わるたびに、前のワールドの終了後の使用量がコンソールに出力されます。ワールドの切り替えで解放されるはずのリソースが残っていないかを確認するのに便利です。</p>
+    <p>このクラスのメソッドはすべて static です。インスタンスを作成する必要はありません。</p>
+ */
+class KRMemoryStats {
+
+public:
+    /*!
+        @task 使用量の取得
+     */
+
+    /*!
+        @method getCategoryName
+        @abstract カテゴリの名前を取得します。
+     */
+    static std::string  getCategoryName(KRMemoryCategory category);
+
+    /*!
+        @method getStats
+        @abstract 指定されたカテゴリのメモリ使用量を取得します。
+        KRMemoryCategoryChara2D と KRMemoryCategoryFrameArena はアロケータから直接値を読み出すため、これらの最大値は値が読み出されたときにだけ更新されます。
+     */
+    static KRMemoryCategoryStats    getStats(KRMemoryCategory category);
+
+    /*!
+        @method getTotalBytes
+        @abstract すべてのカテゴリのバイト数の合計を取得します。
+        KRMemoryCategoryParticle は KRMemoryCategoryChara2D に含まれているため、合計には加えません。
+     */
+    static size_t   getTotalBytes();
+
+    /*!
+        @method resetPeaks
+        @abstract すべてのカテゴリの最大値を、現在の値に戻します。
+     */
+    static void     resetPeaks();
+
+public:
+    /*!
+        @task 使用量の出力
+     */
+
+    /*!
+        @method dump
+        @abstract すべてのカテゴリのメモリ使用量を、見出しを付けてコンソールに出力します。
+        Release ビルドでも出力されます。
+     */
+    static void     dump(const std::string& title);
+
+    /*!
+        @method getDumpsOnWorldChange
+        @abstract ワールドが切り替わるたびにメモリ使用量を出力するかどうかを取得します。
+     */
+    static bool     getDumpsOnWorldChange();
+
+    /*!
+        @method setDumpsOnWorldChange
+        @abstract ワールドが切り替わるたびにメモリ使用量を出力するかどうかを設定します。デフォルトでは false です。
+     */
+    static void     setDumpsOnWorldChange(bool flag);
+
+public:
+    static void     _add(KRMemoryCategory category, size_t bytes, int count) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    static void     _remove(KRMemoryCategory category, size_t bytes, int count) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    static void     _addFromMainThread(KRMemoryCategory category, size_t bytes, int count) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    static void     _removeFromMainThread(KRMemoryCategory category, size_t bytes, int count) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+
+};
+
@@ -10,6 +10,7 @@
 
 #include <Karakuri/KarakuriLibrary.h>
 #include <Karakuri/KarakuriException.h>
+#include <Karakuri/KRFrameArena.h>
 
 #include <sys/socket.h>
 #include <netinet/in.h>
@@ -38,6 +39,13 @@ public:
      */
     std::list<std::string>  getMessages() throw(KRNetworkError, KRRuntimeError);
     
+    /*!
+        @method getMessages
+        通信中のピアから受信したすべてのメッセージを、KRFrameArena クラスのメモリを使うリストに格納します。
+        リストの以前の内容は消去されます。毎フレーム呼び出してもメモリの確保が起こらないため、updateModel() 関数の中ではこちらの使用をお勧めします。
+     */
+    void                    getMessages(KRFrameStringList& messages) throw(KRNetworkError, KRRuntimeError);
+    
     /*!
         @method isConnected
         ピアとの通信が保たれているかどうかをチェックします。
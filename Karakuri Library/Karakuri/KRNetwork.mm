@@ -92,6 +92,7 @@ const int KRNetworkBufferSize = 2048;
 - (id)initWithGameID:(NSString*)gameID;
 
 - (std::list<std::string>)receivedMessages;
+- (void)receiveMessagesToFrameList:(KRFrameStringList*)messages;
 
 - (KRNetworkServerState)state;
 - (void)setState:(KRNetworkServerState)value;
@@ -403,13 +404,23 @@ static void KRTCPServerAcceptCallBack(CFSocketRef socket, CFSocketCallBackType t
 - (std::list<std::string>)receivedMessages
 {
     //[mDataLock lock];
-    std::list<std::string> ret(*mInMessages);
-    mInMessages->clear();
+    std::list<std::string> ret;
+    ret.swap(*mInMessages);
     //[mDataLock unlock];
 
     return ret;
 }
 
+- (void)receiveMessagesToFrameList:(KRFrameStringList*)messages
+{
+    //[mDataLock lock];
+    for (std::list<std::string>::const_iterator it = mInMessages->begin(); it != mInMessages->end(); it++) {
+        messages->push_back(KRFrameString(it->data(), it->size()));
+    }
+    mInMessages->clear();
+    //[mDataLock unlock];
+}
+
 - (BOOL)isConnected
 {
     return (mState == KRNetworkServerStateConnected);
@@ -736,6 +747,23 @@ std::list<std::string> KRNetwork::getMessages() throw(KRNetworkError, KRRuntimeE
     return [(KRNetworkImpl*)mImpl receivedMessages];
 }
 
+void KRNetwork::getMessages(KRFrameStringList& messages) throw(KRNetworkError, KRRuntimeError)
+{
+    messages.clear();
+
+    if (mImpl == NULL) {
+        const char* errorFormat = "You have tried to invoke KRNetwork::getMessages() without setting the game ID.";
+        if (gKRLanguage == KRLanguageJapanese) {
+            errorFormat = "ゲームIDが設定されていない環境で、KRNetwork::getMessages() 関数が呼ばれました。";
+        }
+        throw KRRuntimeError(errorFormat);
+    }
+    if (![(KRNetworkImpl*)mImpl isConnected]) {
+        throw KRNetworkError("No connection");
+    }
+    [(KRNetworkImpl*)mImpl receiveMessagesToFrameList:&messages];
+}
+
 bool KRNetwork::isConnected()
 {
     if (mImpl == NULL) {
@@ -0,0 +1,20 @@
+/*!
+    @file   KRParticle2DBudget.cpp
+ */
+
+#include "KRParticle2DBudget.h"
+
+
+KRParticle2DBudgetStats::KRParticle2DBudgetStats()
+    : updateTime(0.0), drawTime(0.0), smoothedTime(0.0), budget(0.0),
+      particleCount(0), requestedCount(0), suppressedCount(0), culledCount(0), throttledSystemCount(0)
+{
+    // Do nothing
+}
+
+std::string KRParticle2DBudgetStats::to_s() const
+{
+    return KRFS("<particle2_budget>(time=%.2fms (update=%.2fms, draw=%.2fms), budget=%.2fms, count=%u, requested=%u, suppressed=%u, culled=%u, throttled=%d)",
+                smoothedTime * 1000, updateTime * 1000, drawTime * 1000, budget * 1000,
+                particleCount, requestedCount, suppressedCount, culledCount, throttledSystemCount);
+}
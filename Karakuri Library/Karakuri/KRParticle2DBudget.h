@@ -0,0 +1,107 @@
+/*!
+    @file   KRParticle2DBudget.h
+    
+    パーティクルの負荷管理と衝突判定で使われる型の定義です。
+ */
+
+#pragma once
+
+#include <Karakuri/KarakuriLibrary.h>
+
+
+/*!
+    @enum KRParticle2DCullMode
+    @group  Game Graphics
+    @constant KRParticle2DCullModeNone      フレームの処理時間が予算を超えても、生成済みのパーティクルは削除しません。
+    @constant KRParticle2DCullModeOldest    生成されてから時間が経っているパーティクルから順に削除します。
+    @constant KRParticle2DCullModeSmallest  現在の拡大率がもっとも小さいパーティクルから順に削除します。
+    @abstract フレームの処理時間が予算を大きく超えたときに、生成済みのパーティクルをどのように間引くかを示す列挙型です。
+ */
+typedef enum {
+    KRParticle2DCullModeNone        = 0,
+    KRParticle2DCullModeOldest      = 1,
+    KRParticle2DCullModeSmallest    = 2,
+} KRParticle2DCullMode;
+
+
+/*!
+    @enum KRParticle2DCollisionMode
+    @group  Game Graphics
+    @constant KRParticle2DCollisionModeNone     パーティクルの衝突判定を行いません。
+    @constant KRParticle2DCollisionModeBounce   静的な図形に当たったパーティクルを跳ね返らせます。
+    @constant KRParticle2DCollisionModeKill     静的な図形に当たったパーティクルをその場で削除します。
+    @constant KRParticle2DCollisionModeStick    静的な図形に当たったパーティクルを、生存期間が終わるまでその場に留めます。
+    @abstract シミュレータの静的な図形に当たったパーティクルをどのように扱うかを示す列挙型です。
+ */
+typedef enum {
+    KRParticle2DCollisionModeNone       = 0,
+    KRParticle2DCollisionModeBounce     = 1,
+    KRParticle2DCollisionModeKill       = 2,
+    KRParticle2DCollisionModeStick      = 3,
+} KRParticle2DCollisionMode;
+
+
+/*!
+    @struct KRParticle2DBudgetStats
+    @group  Game Graphics
+    @abstract パーティクルの負荷管理機構の、直前のフレームにおける判断の結果を格納しておくための構造体です。
+ */
+typedef struct KRParticle2DBudgetStats : public KRObject {
+    /*!
+        @var updateTime
+        直前のフレームで、モデルの更新にかかった時間（秒）です。
+     */
+    double      updateTime;
+
+    /*!
+        @var drawTime
+        直前のフレームで、描画にかかった時間（秒）です。まとめて行われるテクスチャの描画処理の時間も含みます。
+     */
+    double      drawTime;
+    
+    /*!
+        @var smoothedTime
+        負荷の判断に使われる、更新と描画にかかった時間の移動平均（秒）です。
+     */
+    double      smoothedTime;
+    
+    /*!
+        @var budget
+        負荷の判断に使われた、1フレームあたりの処理時間の予算（秒）です。
+     */
+    double      budget;
+
+    /*!
+        @var particleCount
+        現在生成されているパーティクルの総数です。
+     */
+    unsigned    particleCount;
+    
+    /*!
+        @var requestedCount
+        直前のフレームで、各パーティクルシステムが生成しようとしたパーティクルの個数です。
+     */
+    unsigned    requestedCount;
+    
+    /*!
+        @var suppressedCount
+        直前のフレームで、生成率の調整または最大個数の制限によって生成されなかったパーティクルの個数です。
+     */
+    unsigned    suppressedCount;
+    
+    /*!
+        @var culledCount
+        直前のフレームで、負荷を下げるために削除されたパーティクルの個数です。
+     */
+    unsigned    culledCount;
+    
+    /*!
+        @var throttledSystemCount
+        現在、生成率が下げられているパーティクルシステムの個数です。
+     */
+    int         throttledSystemCount;
+    
+    KRParticle2DBudgetStats();
+
+    virtual std::string to_s() const;
+} KRParticle2DBudgetStats;
@@ -6,25 +6,35 @@
 
 #include "KRParticle2DSystem.h"
 #include "KRChara2D.h"
+#include "KRMemoryStats.h"
 
 
 /*!
     @method _KRParticle2D
     Constructor
  */
-_KRParticle2D::_KRParticle2D(int charaSpecID, unsigned life, const KRVector2D& pos, const KRVector2D& v, const KRVector2D& gravity,
-                             double angleV, const KRColor& color, double size, double scale,
-                             double deltaRed, double deltaGreen, double deltaBlue, double deltaAlpha, double deltaSize, double deltaScale)
-    : KRChara2D(1000000, charaSpecID), mBaseLife(life), mLife(life), mV(v), mGravity(gravity), mAngleV(angleV), mColor(color), mSize(size), mScale(scale),
-      mDeltaRed(deltaRed), mDeltaGreen(deltaGreen), mDeltaBlue(deltaBlue), mDeltaAlpha(deltaAlpha), mDeltaSize(deltaSize), mDeltaScale(deltaScale)
-{
-    mAngle = 0.0;
+_KRParticle2D::_KRParticle2D(int charaSpecID, unsigned life, const KRVector2D& pos, const KRVector2Df& v, const KRVector2Df& gravity,
+                             double angleV, double size, double scale, _KRParticle2DLifeTable* lifeTable)
+    : KRChara2D(1000000, charaSpecID), mBaseLife(life), mLife(life), mV(v), mGravity(gravity), mAngleV((float)angleV), mSize((float)size), mScale((float)scale),
+      mLifeTable(lifeTable)
+{
+    mAngle = 0.0f;
+    mLifeTablePos = 0.0f;
+    mLifeTableStep = (life > 0)? (float)(_KRParticle2DLifeTableSize - 1) / life: 0.0f;
+    mIsStuck = false;
+    mIsRemoved = false;
     setCenterPos(pos);
+    
+    mLifeTable->retain();
+    
+    KRMemoryStats::_addFromMainThread(KRMemoryCategoryParticle, sizeof(_KRParticle2D), 1);
 }
 
 _KRParticle2D::~_KRParticle2D()
 {
-    // Do nothing
+    KRMemoryStats::_removeFromMainThread(KRMemoryCategoryParticle, sizeof(_KRParticle2D), 1);
+    
+    mLifeTable->release();
 }
 
 bool _KRParticle2D::step()
@@ -35,27 +45,58 @@ bool _KRParticle2D::step()
     mAngle += mAngleV;
     mV += mGravity;
     
-    KRVector2D pos = getPos();
+    KRVector2Df pos = _getPosf();
+    mPrevPos = pos;
     pos += mV;
-    setPos(pos);
+    _setPosf(pos);
 
     this->_angle = mAngle;
 
-    double ratio = 1.0 - (double)mLife / mBaseLife;
-
-    double scale = KRMax(mScale + mDeltaScale * ratio, 0.0);
-    setScale(KRVector2D(scale, scale));
+    // 生存期間の割り合いに応じた色と拡大率は、テーブルから引くだけで済ませる。
+    int index = (int)mLifeTablePos;
+    if (index >= _KRParticle2DLifeTableSize) {
+        index = _KRParticle2DLifeTableSize - 1;
+    }
+    const _KRParticle2DLifeEntry& entry = mLifeTable->entries[index];
+    mLifeTablePos += mLifeTableStep;
 
-    double r = KRMax(mColor.r + mDeltaRed * ratio, 0.0);
-    double g = KRMax(mColor.g + mDeltaGreen * ratio, 0.0);
-    double b = KRMax(mColor.b + mDeltaBlue * ratio, 0.0);
-    double a = KRMax(mColor.a + mDeltaAlpha * ratio, 0.0);
-    setColor(KRColor(r, g, b, a));
+    float scale = mScale * entry.scale_mul + entry.scale_add;
+    if (scale < 0.0f) {
+        scale = 0.0f;
+    }
+    _setScalef(KRVector2Df(scale, scale));
+    _setPackedColor(entry.color);
 
     mLife--;  
     return true;
 }
 
+void _KRParticle2D::advance(unsigned frames)
+{
+    if (frames == 0 || mLife == 0) {
+        return;
+    }
+    if (frames > mLife) {
+        frames = mLife;
+    }
+    
+    // 最後の1フレームを除いて、等加速度運動の式で一気に進める。
+    unsigned k = frames - 1;
+    if (k > 0) {
+        KRVector2Df pos = _getPosf();
+        pos += mV * (float)k + mGravity * (k * (k + 1) / 2.0f);
+        _setPosf(pos);
+        
+        mV += mGravity * (float)k;
+        mAngle += mAngleV * k;
+        mLifeTablePos += mLifeTableStep * k;
+        mLife -= k;
+    }
+
+    // 最後の1フレームは通常通りに進めて、色と拡大率を反映させる。
+    step();
+}
+
 std::string _KRParticle2D::to_s() const
 {
     return "<particle2>()";
@@ -107,6 +148,9 @@ void _KRParticle2DSystem::init()
     mDeltaBlue = 0.0;
     mDeltaAlpha = -2.0;
     
+    mLifeTable = new _KRParticle2DLifeTable();
+    mIsLifeTableDirty = true;
+    
     mBlendMode = KRBlendModeAlpha;
     
     mParticleCount = 256;
@@ -114,16 +158,24 @@ void _KRParticle2DSystem::init()
     
     mLife = 60;
     
-    mActiveGenCount = 0;
-    for (int i = 0; i < _KRParticle2DGenMaxCount; i++) {
-        mGenInfos[i].gen_count = 0;
-        mGenInfos[i].count_int = 0;
-        mGenInfos[i].count_decimals = 0;
-    }
+    mGenInfos.reserve(_KRParticle2DGenInitialCount);
+    mActiveGenIndices.reserve(_KRParticle2DGenInitialCount);
+    mFreeGenIndices.reserve(_KRParticle2DGenInitialCount);
     
     mIsAutoGenerating = false;
     mAutoGenInfo.count_int = 0;
     mAutoGenInfo.count_decimals = 0;    
+    
+    mGeneratedParticleCount = 0;
+    
+    mPriority = 0;
+    mSpawnScale = 1.0;
+    mSpawnRemainder = 0.0;
+    
+    mCollisionSimulator = NULL;
+    mCollisionMode = KRParticle2DCollisionModeNone;
+    mCollisionRadius = 0.0;
+    mCollisionBounce = 0.5;
 }
 
 /*!
@@ -136,6 +188,9 @@ _KRParticle2DSystem::~_KRParticle2DSystem()
         gKRAnime2DMan->removeChara2D(*it);
     }
     mParticles.clear();
+    mGeneratedParticleCount = 0;
+    
+    mLifeTable->release();
 }
 
 
@@ -194,7 +249,7 @@ int _KRParticle2DSystem::getGenerateCount() const
 
 unsigned _KRParticle2DSystem::getGeneratedParticleCount() const
 {
-    return mParticles.size();
+    return mGeneratedParticleCount;
 }
 
 KRBlendMode _KRParticle2DSystem::getBlendMode() const
@@ -259,6 +314,7 @@ void _KRParticle2DSystem::setStartPos(const KRVector2D& pos)
 void _KRParticle2DSystem::setColor(const KRColor& color)
 {
     mColor = color;
+    mIsLifeTableDirty = true;
 }
 
 void _KRParticle2DSystem::setColorDelta(double red, double green, double blue, double alpha)
@@ -267,6 +323,7 @@ void _KRParticle2DSystem::setColorDelta(double red, double green, double blue, d
     mDeltaGreen = green;
     mDeltaBlue = blue;
     mDeltaAlpha = alpha;
+    mIsLifeTableDirty = true;
 }
 
 void _KRParticle2DSystem::setBlendMode(KRBlendMode blendMode)
@@ -307,6 +364,7 @@ void _KRParticle2DSystem::setMaxSize(double size)
 void _KRParticle2DSystem::setScaleDelta(double value)
 {
     mDeltaScale = value;
+    mIsLifeTableDirty = true;
 }
 
 void _KRParticle2DSystem::setSizeDelta(double value)
@@ -344,133 +402,155 @@ void _KRParticle2DSystem::setGravity(const KRVector2D& a)
     mGravity = a;
 }
 
-void _KRParticle2DSystem::addGenerationPoint(const KRVector2D& pos, int zOrder)
+void _KRParticle2DSystem::initGenInfo(_KRParticle2DGenInfo& info, const KRVector2D& pos, int zOrder)
 {
-    if (mActiveGenCount >= _KRParticle2DGenMaxCount) {
+    info.center_pos = pos;
+    info.z_order = zOrder;
+    info.count_int = (int)mGenerateCount;
+    double fraction = mGenerateCount - info.count_int;
+    if (fraction > 0.0001) {
+        info.count_decimals_base = (int)(1.0 / fraction);
+    } else {
+        info.count_decimals_base = 0;
+    }
+    if (info.count_int == 0) {
+        info.count_decimals = 1;
+    } else {
+        info.count_decimals = info.count_decimals_base;
+    }
+}
+
+int _KRParticle2DSystem::getGenerateCountForFrame(_KRParticle2DGenInfo& info)
+{
+    // Integer part
+    int count = (info.count_int > 0)? info.count_int: 0;
+
+    // Decimal part
+    if (info.count_decimals > 0) {
+        info.count_decimals--;
+        if (info.count_decimals == 0) {
+            info.count_decimals = info.count_decimals_base;
+            count++;
+        }
+    }
+    return count;
+}
+
+bool _KRParticle2DSystem::canGenerate(const _KRParticle2DGenInfo& info) const
+{
+    return (info.count_int > 0 || info.count_decimals > 0);
+}
+
+int _KRParticle2DSystem::throttleGenerateCount(int count)
+{
+    int scaledCount = count;
+
+    // 負荷管理によって生成率が下げられている場合には、端数を持ち越しながら間引く。
+    if (mSpawnScale < 1.0) {
+        mSpawnRemainder += count * mSpawnScale;
+        scaledCount = (int)mSpawnRemainder;
+        mSpawnRemainder -= scaledCount;
+    }
+    
+    return gKRAnime2DMan->_requestParticleSpawn(count, scaledCount);
+}
+
+void _KRParticle2DSystem::generateParticles(const _KRParticle2DGenInfo& info, int count, unsigned age)
+{
+    if (count <= 0) {
         return;
     }
-    for (int i = 0; i < _KRParticle2DGenMaxCount; i++) {
-        if (mGenInfos[i].gen_count == 0) {
-            mGenInfos[i].center_pos = pos;
-            mGenInfos[i].gen_count = mParticleCount;
-            mGenInfos[i].count_int = (int)mGenerateCount;
-            mGenInfos[i].z_order = zOrder;
-            double fraction = mGenerateCount - mGenInfos[i].count_int;
-            if (fraction > 0.0001) {
-                mGenInfos[i].count_decimals_base = (int)(1.0 / fraction);
-            } else {
-                mGenInfos[i].count_decimals_base = 0;
-            }
-            if (mGenInfos[i].count_int == 0) {
-                mGenInfos[i].count_decimals = 1;
-            } else {
-                mGenInfos[i].count_decimals = mGenInfos[i].count_decimals_base;
-            }
-            mActiveGenCount++;
-            break;
+    
+    count = throttleGenerateCount(count);
+    if (count <= 0) {
+        return;
+    }
+    
+    if (mIsLifeTableDirty) {
+        _bakeLifeTable();
+    }
+
+    // 乱数の範囲は生成ごとに変わらないので、まとめて計算しておく。
+    double rangeVX = mMaxV.x - mMinV.x;
+    double rangeVY = mMaxV.y - mMinV.y;
+    double rangeSize = mMaxSize - mMinSize;
+    double rangeScale = mMaxScale - mMinScale;
+    double rangeAngleV = mMaxAngleV - mMinAngleV;
+
+    for (int i = 0; i < count; i++) {
+        KRVector2D theV(KRRandDouble() * rangeVX + mMinV.x, KRRandDouble() * rangeVY + mMinV.y);
+        double theSize = KRRandDouble() * rangeSize + mMinSize;
+        double theScale = KRRandDouble() * rangeScale + mMinScale;
+        double theAngleV = KRRandDouble() * rangeAngleV + mMinAngleV;
+        
+        _KRParticle2D* particle = new _KRParticle2D(mCharaSpecID, mLife, info.center_pos, KRVector2Df(theV), KRVector2Df(mGravity), theAngleV, theSize, theScale, mLifeTable);
+        particle->setZOrder(info.z_order);
+        particle->setBlendMode(mBlendMode);
+        if (age > 0) {
+            particle->advance(age);
         }
+        mParticles.push_back(particle);
+        gKRAnime2DMan->addChara2D(particle);
     }
+    mGeneratedParticleCount += count;
+}
+
+void _KRParticle2DSystem::addGenerationPoint(const KRVector2D& pos, int zOrder)
+{
+    if (mParticleCount == 0) {
+        return;
+    }
+    
+    // 使い終わった生成ポイントがあれば再利用し、なければプールを拡張する。
+    int index;
+    if (mFreeGenIndices.empty()) {
+        index = (int)mGenInfos.size();
+        mGenInfos.push_back(_KRParticle2DGenInfo());
+    } else {
+        index = mFreeGenIndices.back();
+        mFreeGenIndices.pop_back();
+    }
+    
+    _KRParticle2DGenInfo& theInfo = mGenInfos[index];
+    initGenInfo(theInfo, pos, zOrder);
+    theInfo.gen_count = mParticleCount;
+
+    // 1つもパーティクルを生成しない生成ポイントは、削除されずに残り続けるので追加しない。
+    if (!canGenerate(theInfo)) {
+        mFreeGenIndices.push_back(index);
+        return;
+    }
+
+    mActiveGenIndices.push_back(index);
 }
 
 void _KRParticle2DSystem::step()
 {
     // Auto Generation
     if (mIsAutoGenerating) {
-        // Integer part
-        if (mAutoGenInfo.count_int > 0) {
-            for (int i = 0; i < mAutoGenInfo.count_int; i++) {
-                KRVector2D theV(KRRandInt(mMaxV.x - mMinV.x) + mMinV.x, KRRandInt(mMaxV.y - mMinV.y) + mMinV.y);
-                double theSize = KRRandDouble() * (mMaxSize - mMinSize) + mMinSize;
-                double theScale = KRRandDouble() * (mMaxScale - mMinScale) + mMinScale;
-                double theAngleV = KRRandDouble() * (mMaxAngleV - mMinAngleV) + mMinAngleV;
-                
-                _KRParticle2D* particle = new _KRParticle2D(mCharaSpecID, mLife, mAutoGenInfo.center_pos, theV, mGravity, theAngleV, mColor, theSize, theScale,
-                                                            mDeltaRed, mDeltaGreen, mDeltaBlue, mDeltaAlpha, mDeltaSize, mDeltaScale);
-                particle->setZOrder(mAutoGenInfo.z_order);
-                particle->setBlendMode(mBlendMode);
-                mParticles.push_back(particle);
-                gKRAnime2DMan->addChara2D(particle);
-            }
-        }
-        // Decimal part
-        if (mAutoGenInfo.count_decimals > 0) {
-            mAutoGenInfo.count_decimals--;
-            if (mAutoGenInfo.count_decimals == 0) {
-                mAutoGenInfo.count_decimals = mAutoGenInfo.count_decimals_base;
-                
-                KRVector2D theV(KRRandInt(mMaxV.x - mMinV.x) + mMinV.x, KRRandInt(mMaxV.y - mMinV.y) + mMinV.y);
-                double theSize = KRRandDouble() * (mMaxSize - mMinSize) + mMinSize;
-                double theScale = KRRandDouble() * (mMaxScale - mMinScale) + mMinScale;
-                double theAngleV = KRRandDouble() * (mMaxAngleV - mMinAngleV) + mMinAngleV;
-                
-                _KRParticle2D* particle = new _KRParticle2D(mCharaSpecID, mLife, mAutoGenInfo.center_pos, theV, mGravity, theAngleV, mColor, theSize, theScale,
-                                                            mDeltaRed, mDeltaGreen, mDeltaBlue, mDeltaAlpha, mDeltaSize, mDeltaScale);
-                particle->setZOrder(mAutoGenInfo.z_order);
-                particle->setBlendMode(mBlendMode);
-                mParticles.push_back(particle);
-                gKRAnime2DMan->addChara2D(particle);
-            }
-        }
+        generateParticles(mAutoGenInfo, getGenerateCountForFrame(mAutoGenInfo));
     }
     
-    // Point Generation
-    int finishedCount = 0;
-    for (int i = 0; i < _KRParticle2DGenMaxCount; i++) {
-        // Integer part
-        if (mGenInfos[i].gen_count > 0 && mGenInfos[i].count_int > 0) {
-            for (int j = 0; j < mGenInfos[i].count_int && mGenInfos[i].gen_count > 0; j++) {
-                double dx = mMaxV.x - mMinV.x;
-                double dy = mMaxV.x - mMinV.x;
-                KRVector2D theV(KRRandDouble() * dx + mMinV.x, KRRandDouble() * dy + mMinV.y);
-                double theSize = KRRandDouble() * (mMaxSize - mMinSize) + mMinSize;
-                double theScale = KRRandDouble() * (mMaxScale - mMinScale) + mMinScale;
-                double theAngleV = KRRandDouble() * (mMaxAngleV - mMinAngleV) + mMinAngleV;
-
-                _KRParticle2D* particle = new _KRParticle2D(mCharaSpecID, mLife, mGenInfos[i].center_pos, theV, mGravity, theAngleV, mColor, theSize, theScale,
-                                                            mDeltaRed, mDeltaGreen, mDeltaBlue, mDeltaAlpha, mDeltaSize, mDeltaScale);
-                particle->setZOrder(mGenInfos[i].z_order);
-                particle->setBlendMode(mBlendMode);
-                mParticles.push_back(particle);
-                gKRAnime2DMan->addChara2D(particle);
-
-                mGenInfos[i].gen_count--;
-            }
-            if (mGenInfos[i].gen_count == 0) {
-                finishedCount++;
-                if (finishedCount >= mActiveGenCount) {
-                    break;
-                }
-            }
+    // Point Generation（アクティブな生成ポイントだけを処理する）
+    for (size_t i = 0; i < mActiveGenIndices.size();) {
+        int index = mActiveGenIndices[i];
+        _KRParticle2DGenInfo& theInfo = mGenInfos[index];
+
+        int count = getGenerateCountForFrame(theInfo);
+        if (count > theInfo.gen_count) {
+            count = theInfo.gen_count;
         }
-        // Decimal part
-        if (mGenInfos[i].gen_count > 0 && mGenInfos[i].count_decimals > 0) {
-            mGenInfos[i].count_decimals--;
-            if (mGenInfos[i].count_decimals == 0) {
-                mGenInfos[i].count_decimals = mGenInfos[i].count_decimals_base;
-                
-                KRVector2D theV(KRRandInt(mMaxV.x - mMinV.x) + mMinV.x, KRRandInt(mMaxV.y - mMinV.y) + mMinV.y);
-                double theSize = KRRandDouble() * (mMaxSize - mMinSize) + mMinSize;
-                double theScale = KRRandDouble() * (mMaxScale - mMinScale) + mMinScale;
-                double theAngleV = KRRandDouble() * (mMaxAngleV - mMinAngleV) + mMinAngleV;
-                
-                _KRParticle2D* particle = new _KRParticle2D(mCharaSpecID, mLife, mGenInfos[i].center_pos, theV, mGravity, theAngleV, mColor, theSize, theScale,
-                                                            mDeltaRed, mDeltaGreen, mDeltaBlue, mDeltaAlpha, mDeltaSize, mDeltaScale);
-                particle->setZOrder(mGenInfos[i].z_order);
-                particle->setBlendMode(mBlendMode);
-                mParticles.push_back(particle);
-                gKRAnime2DMan->addChara2D(particle);
-
-                mGenInfos[i].gen_count--;
-                if (mGenInfos[i].gen_count == 0) {
-                    finishedCount++;
-                    if (finishedCount >= mActiveGenCount) {
-                        break;
-                    }
-                }
-            }
+        generateParticles(theInfo, count);
+        theInfo.gen_count -= count;
+
+        if (theInfo.gen_count == 0 || !canGenerate(theInfo)) {
+            mFreeGenIndices.push_back(index);
+            mActiveGenIndices[i] = mActiveGenIndices.back();
+            mActiveGenIndices.pop_back();
+        } else {
+            i++;
         }
     }
-    mActiveGenCount -= finishedCount;
     
     // 各パーティクルの移動
     for (std::list<_KRParticle2D*>::iterator it = mParticles.begin(); it != mParticles.end();) {
@@ -479,29 +559,279 @@ void _KRParticle2DSystem::step()
         } else {
             _KRParticle2D* theParticle = *it;
             it = mParticles.erase(it);
+            mGeneratedParticleCount--;
             gKRAnime2DMan->removeChara2D(theParticle);
         }
     }
+    
+    // 静的な図形との衝突判定
+    if (mCollisionMode != KRParticle2DCollisionModeNone && mCollisionSimulator != NULL) {
+        collideParticles();
+    }
 }
 
-void _KRParticle2DSystem::startAutoGeneration(int zOrder)
+void _KRParticle2DSystem::collideParticles()
 {
-    mIsAutoGenerating = true;
+    // このフレームで動いたパーティクルの移動線分を集めて、まとめて判定する。
+    mCollisionParticles.clear();
+    mCollisionStarts.clear();
+    mCollisionEnds.clear();
+    for (std::list<_KRParticle2D*>::iterator it = mParticles.begin(); it != mParticles.end(); it++) {
+        _KRParticle2D* theParticle = *it;
+        if (theParticle->mIsStuck) {
+            continue;
+        }
+        mCollisionParticles.push_back(theParticle);
+        mCollisionStarts.push_back(theParticle->mPrevPos.toVector2D());
+        mCollisionEnds.push_back(theParticle->getPos());
+    }
     
-    mAutoGenInfo.z_order = zOrder;
-    mAutoGenInfo.center_pos = mStartPos;
-    mAutoGenInfo.count_int = (int)mGenerateCount;
-    double fraction = mGenerateCount - mAutoGenInfo.count_int;
-    if (fraction > 0.0001) {
-        mAutoGenInfo.count_decimals_base = (int)(1.0 / fraction);
-    } else {
-        mAutoGenInfo.count_decimals_base = 0;
+    int count = (int)mCollisionParticles.size();
+    if (count == 0) {
+        return;
     }
-    if (mAutoGenInfo.count_int == 0) {
-        mAutoGenInfo.count_decimals = 1;
-    } else {
-        mAutoGenInfo.count_decimals = mAutoGenInfo.count_decimals_base;
+    mCollisionHits.resize(count);
+    mCollisionSimulator->_queryStaticSegments(count, &mCollisionStarts[0], &mCollisionEnds[0], mCollisionRadius, &mCollisionHits[0]);
+    
+    bool hasKilled = false;
+    for (int i = 0; i < count; i++) {
+        const _KRStaticSegmentHit2D& theHit = mCollisionHits[i];
+        if (!theHit.hit) {
+            continue;
+        }
+        _KRParticle2D* theParticle = mCollisionParticles[i];
+        
+        if (mCollisionMode == KRParticle2DCollisionModeKill) {
+            theParticle->mIsRemoved = true;
+            hasKilled = true;
+            continue;
+        }
+
+        // 図形の表面から半径分だけ離した位置に戻す。
+        theParticle->setPos(theHit.point + theHit.normal * (mCollisionRadius + 0.01));
+
+        if (mCollisionMode == KRParticle2DCollisionModeBounce) {
+            KRVector2Df& v = theParticle->mV;
+            double vn = v.x * theHit.normal.x + v.y * theHit.normal.y;
+            v -= KRVector2Df(theHit.normal * ((1.0 + mCollisionBounce) * vn));
+        } else {
+            theParticle->mV = KRVector2Df();
+            theParticle->mGravity = KRVector2Df();
+            theParticle->mAngleV = 0.0f;
+            theParticle->mIsStuck = true;
+        }
+    }
+    
+    // 当たって消えたパーティクルだけを、描画される前に取り除いておく。
+    if (hasKilled) {
+        removeMarkedParticles();
+    }
+}
+
+unsigned _KRParticle2DSystem::removeMarkedParticles()
+{
+    // パーティクルごとに removeChara2D() を呼ぶとキャラクタのリストを毎回たどることになるので、まとめて削除する。
+    for (std::list<_KRParticle2D*>::iterator it = mParticles.begin(); it != mParticles.end();) {
+        if ((*it)->mIsRemoved) {
+            mRemovedCharas.push_back(*it);
+            it = mParticles.erase(it);
+        } else {
+            it++;
+        }
+    }
+    
+    unsigned count = (unsigned)mRemovedCharas.size();
+    gKRAnime2DMan->_removeCharas2D(mRemovedCharas);
+    mRemovedCharas.clear();
+    
+    mGeneratedParticleCount -= count;
+    return count;
+}
+
+KRParticle2DCollisionMode _KRParticle2DSystem::getCollisionMode() const
+{
+    return mCollisionMode;
+}
+
+void _KRParticle2DSystem::setCollision(KRSimulator2D* simulator, KRParticle2DCollisionMode mode, double radius, double bounce)
+{
+    mCollisionSimulator = simulator;
+    mCollisionMode = (simulator != NULL)? mode: KRParticle2DCollisionModeNone;
+    mCollisionRadius = radius;
+    mCollisionBounce = bounce;
+}
+
+
+#pragma mark -
+#pragma mark Prewarm
+
+void _KRParticle2DSystem::prewarmGenInfo(_KRParticle2DGenInfo& info, unsigned frames, bool isLimited)
+{
+    for (unsigned i = 0; i < frames; i++) {
+        int count = getGenerateCountForFrame(info);
+        if (isLimited) {
+            if (count > info.gen_count) {
+                count = info.gen_count;
+            }
+            info.gen_count -= count;
+        }
+        
+        // i フレーム目に生成されたパーティクルは、frames - i 回移動済みになっている。
+        // 生存期間を過ぎたものは生成しない。
+        unsigned age = frames - i;
+        if (age < mLife) {
+            generateParticles(info, count, age);
+        }
+        
+        if (isLimited && info.gen_count == 0) {
+            break;
+        }
+    }
+}
+
+void _KRParticle2DSystem::prewarm(double seconds)
+{
+    unsigned frames = (unsigned)(seconds * gKRGameMan->getFrameRate() + 0.5);
+    if (frames == 0) {
+        return;
+    }
+    
+    // 古いパーティクルから生成されるように、経過時間の長い順に生成する。
+    if (mIsAutoGenerating) {
+        prewarmGenInfo(mAutoGenInfo, frames, false);
+    }
+    
+    for (size_t i = 0; i < mActiveGenIndices.size();) {
+        int index = mActiveGenIndices[i];
+        _KRParticle2DGenInfo& theInfo = mGenInfos[index];
+        
+        prewarmGenInfo(theInfo, frames, true);
+
+        if (theInfo.gen_count == 0 || !canGenerate(theInfo)) {
+            mFreeGenIndices.push_back(index);
+            mActiveGenIndices[i] = mActiveGenIndices.back();
+            mActiveGenIndices.pop_back();
+        } else {
+            i++;
+        }
+    }
+}
+
+
+#pragma mark -
+#pragma mark Over-Life Curves
+
+void _KRParticle2DSystem::addCurveKey(std::vector<_KRParticle2DCurveKey>& keys, double time, double value)
+{
+    _KRParticle2DCurveKey theKey;
+    theKey.time = time;
+    if (theKey.time < 0.0) {
+        theKey.time = 0.0;
+    } else if (theKey.time > 1.0) {
+        theKey.time = 1.0;
+    }
+    theKey.value = value;
+
+    // 時間順に並ぶように挿入する（同じ時間のキーは後から追加したものを後ろに置く）。
+    std::vector<_KRParticle2DCurveKey>::iterator it = keys.begin();
+    while (it != keys.end() && it->time <= theKey.time) {
+        it++;
+    }
+    keys.insert(it, theKey);
+    
+    mIsLifeTableDirty = true;
+}
+
+double _KRParticle2DSystem::evaluateCurve(const std::vector<_KRParticle2DCurveKey>& keys, double time) const
+{
+    if (time <= keys.front().time) {
+        return keys.front().value;
+    }
+    for (size_t i = 1; i < keys.size(); i++) {
+        const _KRParticle2DCurveKey& key2 = keys[i];
+        if (time <= key2.time) {
+            const _KRParticle2DCurveKey& key1 = keys[i-1];
+            double span = key2.time - key1.time;
+            if (span <= 0.0) {
+                return key2.value;
+            }
+            return key1.value + (key2.value - key1.value) * (time - key1.time) / span;
+        }
+    }
+    return keys.back().value;
+}
+
+void _KRParticle2DSystem::addAlphaKey(double time, double alpha)
+{
+    addCurveKey(mAlphaKeys, time, alpha);
+}
+
+void _KRParticle2DSystem::addColorKey(double time, const KRColor& color)
+{
+    addCurveKey(mRedKeys, time, color.r);
+    addCurveKey(mGreenKeys, time, color.g);
+    addCurveKey(mBlueKeys, time, color.b);
+}
+
+void _KRParticle2DSystem::addScaleKey(double time, double scale)
+{
+    addCurveKey(mScaleKeys, time, scale);
+}
+
+void _KRParticle2DSystem::removeAllCurveKeys()
+{
+    mRedKeys.clear();
+    mGreenKeys.clear();
+    mBlueKeys.clear();
+    mAlphaKeys.clear();
+    mScaleKeys.clear();
+    
+    mIsLifeTableDirty = true;
+}
+
+void _KRParticle2DSystem::_bakeLifeTable()
+{
+    // 生成済みのパーティクルが参照しているテーブルは書き換えず、生成時の色と拡大率のまま最後まで動かす。
+    if (mLifeTable->ref_count > 1) {
+        mLifeTable->release();
+        mLifeTable = new _KRParticle2DLifeTable();
+    }
+    
+    for (int i = 0; i < _KRParticle2DLifeTableSize; i++) {
+        double ratio = (double)i / (_KRParticle2DLifeTableSize - 1);
+        _KRParticle2DLifeEntry& entry = mLifeTable->entries[i];
+        
+        // キーがなければ、従来通りの線形の変化量を使う。
+        KRColor color;
+        color.r = mRedKeys.empty()? (mColor.r + mDeltaRed * ratio): evaluateCurve(mRedKeys, ratio);
+        color.g = mGreenKeys.empty()? (mColor.g + mDeltaGreen * ratio): evaluateCurve(mGreenKeys, ratio);
+        color.b = mBlueKeys.empty()? (mColor.b + mDeltaBlue * ratio): evaluateCurve(mBlueKeys, ratio);
+        color.a = mAlphaKeys.empty()? (mColor.a + mDeltaAlpha * ratio): evaluateCurve(mAlphaKeys, ratio);
+        
+        // 0.0〜1.0 の範囲への丸めは、描画用の形式への変換で行われる。
+        entry.color = _KRPackedColor(color);
+                
+        if (mScaleKeys.empty()) {
+            entry.scale_mul = 1.0f;
+            entry.scale_add = (float)(mDeltaScale * ratio);
+        } else {
+            entry.scale_mul = (float)evaluateCurve(mScaleKeys, ratio);
+            entry.scale_add = 0.0f;
+        }
     }
+    
+    mIsLifeTableDirty = false;
+}
+
+
+#pragma mark -
+#pragma mark Auto Generation
+
+void _KRParticle2DSystem::startAutoGeneration(int zOrder)
+{
+    mIsAutoGenerating = true;
+    
+    initGenInfo(mAutoGenInfo, mStartPos, zOrder);
 }
 
 void _KRParticle2DSystem::stopAutoGeneration()
@@ -512,9 +842,67 @@ void _KRParticle2DSystem::stopAutoGeneration()
     mAutoGenInfo.count_decimals = 0;
 }
 
+int _KRParticle2DSystem::getPriority() const
+{
+    return mPriority;
+}
+
+void _KRParticle2DSystem::setPriority(int priority)
+{
+    mPriority = priority;
+}
+
+double _KRParticle2DSystem::_getSpawnScale() const
+{
+    return mSpawnScale;
+}
+
+void _KRParticle2DSystem::_setSpawnScale(double scale)
+{
+    mSpawnScale = scale;
+    if (mSpawnScale >= 1.0) {
+        mSpawnScale = 1.0;
+        mSpawnRemainder = 0.0;
+    }
+}
+
+static bool _KRParticle2DScaleLess(const _KRParticle2D* p1, const _KRParticle2D* p2)
+{
+    return (p1->getScale().x < p2->getScale().x);
+}
+
+unsigned _KRParticle2DSystem::_cullParticles(unsigned count, KRParticle2DCullMode mode)
+{
+    if (count > mGeneratedParticleCount) {
+        count = mGeneratedParticleCount;
+    }
+    if (count == 0 || mode == KRParticle2DCullModeNone) {
+        return 0;
+    }
+    
+    // リストの先頭ほど古いパーティクルなので、先頭から削除する。
+    if (mode == KRParticle2DCullModeOldest) {
+        std::list<_KRParticle2D*>::iterator it = mParticles.begin();
+        for (unsigned i = 0; i < count; i++, it++) {
+            (*it)->mIsRemoved = true;
+        }
+    }
+    // 拡大率の小さい順に count 個を選び出して削除する。
+    else {
+        mCullParticles.assign(mParticles.begin(), mParticles.end());
+        std::nth_element(mCullParticles.begin(), mCullParticles.begin() + (count - 1), mCullParticles.end(), _KRParticle2DScaleLess);
+        for (unsigned i = 0; i < count; i++) {
+            mCullParticles[i]->mIsRemoved = true;
+        }
+        mCullParticles.clear();
+    }
+    
+    return removeMarkedParticles();
+}
+
 std::string _KRParticle2DSystem::to_s() const
 {
-    return KRFS("<particle2_sys>(size=(%3.1f, %3.1f), life=%u, count=%u, generated=%u, charaspec=%d)", mMinSize, mMaxSize, mLife, mParticleCount, mParticles.size(), mCharaSpecID);
+    return KRFS("<particle2_sys>(size=(%3.1f, %3.1f), life=%u, count=%u, generated=%u, charaspec=%d)", mMinSize, mMaxSize, mLife, mParticleCount, mGeneratedParticleCount, mCharaSpecID);
 }
 
 
@@ -10,6 +10,8 @@
 
 #include <Karakuri/Karakuri.h>
 #include "KRChara2D.h"
+#include "KRParticle2DBudget.h"
+#include "KRSimulator2D.h"
 
 
 struct _KRParticle2DGenInfo {
@@ -22,37 +24,75 @@ struct _KRParticle2DGenInfo {
 };
 
 
-const int _KRParticle2DGenMaxCount = 20;
+const int _KRParticle2DGenInitialCount = 20;
+
+
+/*
+    生存期間中のカーブのキーです。time は生存期間の割り合い（0.0〜1.0）です。
+ */
+struct _KRParticle2DCurveKey {
+    double  time;
+    double  value;
+};
+
+
+/*
+    生存期間の割り合いに応じた色と拡大率をあらかじめ計算しておくためのテーブルです。
+    色は描画用の形式に変換した状態で格納しておきます。
+    拡大率は、各パーティクルの初期拡大率 × scale_mul + scale_add で求めます。
+ */
+const int _KRParticle2DLifeTableSize = 64;
+
+struct _KRParticle2DLifeEntry {
+    _KRPackedColor  color;
+    float           scale_mul;
+    float           scale_add;
+};
+
+/*
+    生存期間のテーブル全体です。パーティクルは生成時のテーブルを参照し続けるので、参照カウントで寿命を管理します。
+    パーティクルが参照している間に設定が変わった場合は、書き換えずに新しいテーブルを作成します。
+ */
+struct _KRParticle2DLifeTable {
+    _KRParticle2DLifeEntry  entries[_KRParticle2DLifeTableSize];
+    int                     ref_count;
+    
+    _KRParticle2DLifeTable() : ref_count(1) {}
+    
+    void    retain() { ref_count++; }
+    void    release() { if (--ref_count == 0) { delete this; } }
+};
 
 
 class _KRParticle2D : public KRChara2D {
     
 public:
+    // 毎フレーム更新される状態は、メモリの読み書きを減らすために float で持つ。
     unsigned    mLife;
     unsigned    mBaseLife;
-    KRVector2D  mV;
-    KRVector2D  mGravity;
-    KRColor     mColor;
-    double      mScale;
-    double      mSize;
-    double      mAngle;
-    double      mAngleV;
-    
-    double      mDeltaScale;
-    double      mDeltaSize;
-    double      mDeltaRed;
-    double      mDeltaGreen;
-    double      mDeltaBlue;
-    double      mDeltaAlpha;
+    KRVector2Df mV;
+    KRVector2Df mGravity;
+    float       mScale;
+    float       mSize;
+    float       mAngle;
+    float       mAngleV;
+    
+    _KRParticle2DLifeTable*         mLifeTable;
+    float       mLifeTablePos;
+    float       mLifeTableStep;
+    
+    KRVector2Df mPrevPos;
+    bool        mIsStuck;
+    bool        mIsRemoved;     // まとめて削除するための印
     
 public:
-	_KRParticle2D(int charaSpecID, unsigned life, const KRVector2D& pos, const KRVector2D& v, const KRVector2D& gravity,
-                  double angleV, const KRColor& color, double size, double scale,
-                  double deltaRed, double deltaGreen, double deltaBlue, double deltaAlpha, double deltaSize, double deltaScale);
+	_KRParticle2D(int charaSpecID, unsigned life, const KRVector2D& pos, const KRVector2Df& v, const KRVector2Df& gravity,
+                  double angleV, double size, double scale, _KRParticle2DLifeTable* lifeTable);
     ~_KRParticle2D();
     
 public:
     bool    step();
+    void    advance(unsigned frames);
     
 public:
     virtual std::string to_s() const;
@@ -68,6 +108,7 @@ public:
 class _KRParticle2DSystem : public KRObject {
     
     std::list<_KRParticle2D*>   mParticles;
+    unsigned                    mGeneratedParticleCount;
     
     int             mGroupID;
     int             mZOrder;
@@ -96,9 +137,19 @@ class _KRParticle2DSystem : public KRObject {
     double          mDeltaBlue;
     double          mDeltaAlpha;
     
+    std::vector<_KRParticle2DCurveKey>  mRedKeys;
+    std::vector<_KRParticle2DCurveKey>  mGreenKeys;
+    std::vector<_KRParticle2DCurveKey>  mBlueKeys;
+    std::vector<_KRParticle2DCurveKey>  mAlphaKeys;
+    std::vector<_KRParticle2DCurveKey>  mScaleKeys;
+    
+    _KRParticle2DLifeTable* mLifeTable;
+    bool                    mIsLifeTableDirty;
+    
     bool            mDoLoop;
-    _KRParticle2DGenInfo    mGenInfos[_KRParticle2DGenMaxCount];
-    int             mActiveGenCount;
+    std::vector<_KRParticle2DGenInfo>   mGenInfos;
+    std::vector<int>                    mActiveGenIndices;
+    std::vector<int>                    mFreeGenIndices;
 
     _KRParticle2DGenInfo    mAutoGenInfo;
 
@@ -108,6 +159,23 @@ class _KRParticle2DSystem : public KRObject {
     double          mMaxSize;
     
     bool            mIsAutoGenerating;
+    
+    int             mPriority;
+    double          mSpawnScale;
+    double          mSpawnRemainder;
+    
+    KRSimulator2D*              mCollisionSimulator;
+    KRParticle2DCollisionMode   mCollisionMode;
+    double                      mCollisionRadius;
+    double                      mCollisionBounce;
+    
+    std::vector<_KRParticle2D*>         mCollisionParticles;
+    std::vector<KRVector2D>             mCollisionStarts;
+    std::vector<KRVector2D>             mCollisionEnds;
+    std::vector<_KRStaticSegmentHit2D>  mCollisionHits;
+    
+    std::vector<_KRParticle2D*>         mCullParticles;     // 間引きの対象を選ぶための作業領域
+    std::vector<KRChara2D*>             mRemovedCharas;     // まとめて削除するパーティクル
 
 public:
     /*!
@@ -120,6 +188,16 @@ public:
     
 private:
     void    init();
+    void    initGenInfo(_KRParticle2DGenInfo& info, const KRVector2D& pos, int zOrder);
+    bool    canGenerate(const _KRParticle2DGenInfo& info) const;
+    int     getGenerateCountForFrame(_KRParticle2DGenInfo& info);
+    void    generateParticles(const _KRParticle2DGenInfo& info, int count, unsigned age = 0);
+    void    prewarmGenInfo(_KRParticle2DGenInfo& info, unsigned frames, bool isLimited);
+    int     throttleGenerateCount(int count);
+    void    addCurveKey(std::vector<_KRParticle2DCurveKey>& keys, double time, double value);
+    double  evaluateCurve(const std::vector<_KRParticle2DCurveKey>& keys, double time) const;
+    void    collideParticles();
+    unsigned    removeMarkedParticles();
     
 public:
     /*!
@@ -157,9 +235,22 @@ public:
     /*!
         @method addGenerationPoint
         @abstract 新しいパーティクル生成ポイントを指定された座標に追加します。
-        setParticleCount() 関数で設定された最大個数だけパーティクルを生成した時点で、その生成ポイントは削除されます。
+        setParticleCount() 関数で設定された最大個数だけパーティクルを生成した時点で、その生成ポイントは削除されます。setGenerateCount() 関数で 0 以下の値が設定されていて、それ以上パーティクルを生成できなくなった生成ポイントも削除されます。
      */
     void    addGenerationPoint(const KRVector2D& pos, int zOrder);
+    
+public:
+    /*!
+        @task 事前実行のための関数
+     */
+    
+    /*!
+        @method prewarm
+        @abstract 指定された秒数だけパーティクルの生成と移動を行った状態を、フレームを進めることなく作ります。
+        パーティクルの移動は重力による等加速度運動なので、各パーティクルは経過時間から直接計算された位置・速度・色・拡大率で生成されます。
+        ループ実行中の生成と、アクティブな生成ポイントの両方が対象になります。静的な図形との衝突判定は、事前実行中には行われません。
+     */
+    void    prewarm(double seconds);
 
 public:
     /*!
@@ -371,10 +462,85 @@ public:
     double      getMinSize() const;
     double      getMinScale() const;
 
+public:
+    /*!
+        @task 生存期間中の変化のための関数
+     */
+    
+    /*!
+        @method addAlphaKey
+        @abstract 生存期間の割り合い（0.0〜1.0）に対するアルファ値のキーを追加します。
+        キーが1つ以上追加されている場合、アルファ成分は setColorDelta() 関数の設定ではなく、キーの間を線形補間した値になります。
+     */
+    void        addAlphaKey(double time, double alpha);
+
+    /*!
+        @method addColorKey
+        @abstract 生存期間の割り合い（0.0〜1.0）に対するカラーのキーを追加します。
+        キーが1つ以上追加されている場合、赤・緑・青の各成分は setColorDelta() 関数の設定ではなく、キーの間を線形補間した値になります。アルファ成分は無視されます。
+     */
+    void        addColorKey(double time, const KRColor& color);
+    
+    /*!
+        @method addScaleKey
+        @abstract 生存期間の割り合い（0.0〜1.0）に対する拡大率の倍率のキーを追加します。
+        キーが1つ以上追加されている場合、パーティクルの拡大率は、生成時の拡大率にキーの間を線形補間した倍率を掛けた値になります。
+     */
+    void        addScaleKey(double time, double scale);
+    
+    /*!
+        @method removeAllCurveKeys
+        @abstract 追加されたすべてのキーを削除し、setColorDelta() 関数と setScaleDelta() 関数による線形の変化に戻します。
+     */
+    void        removeAllCurveKeys();
+    
+    void        _bakeLifeTable();   KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+
+public:
+    /*!
+        @task 衝突判定のための関数
+     */
+    
+    /*!
+        @method getCollisionMode
+        @abstract シミュレータの静的な図形に当たったパーティクルの扱いを取得します。
+     */
+    KRParticle2DCollisionMode   getCollisionMode() const;
+    
+    /*!
+        @method setCollision
+        @abstract 指定されたシミュレータの静的な図形とパーティクルとの衝突判定を設定します。
+        パーティクルは半径 radius の小さな円（0 のときは点）として扱われ、物理ボディを作成することなく、静的な図形の空間ハッシュに対してまとめて判定されます。
+        bounce は KRParticle2DCollisionModeBounce のときの反発係数です。simulator に NULL を指定するか、mode に KRParticle2DCollisionModeNone を指定すると、衝突判定を行わなくなります。
+     */
+    void        setCollision(KRSimulator2D* simulator, KRParticle2DCollisionMode mode, double radius = 0.0, double bounce = 0.5);
+
 public:
     void        startAutoGeneration(int zOrder);
     void        stopAutoGeneration();
     
+public:
+    /*!
+        @task 負荷管理のための関数
+     */
+    
+    /*!
+        @method getPriority
+        @abstract 負荷が高いときに生成率を下げる順番を決めるための優先度を取得します。
+     */
+    int         getPriority() const;
+
+    /*!
+        @method setPriority
+        @abstract 負荷が高いときに生成率を下げる順番を決めるための優先度を設定します。
+        値が小さいパーティクルシステムから順に生成率が下げられます。デフォルトの優先度は 0 です。
+     */
+    void        setPriority(int priority);
+    
+    double      _getSpawnScale() const;             KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    void        _setSpawnScale(double scale);       KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    unsigned    _cullParticles(unsigned count, KRParticle2DCullMode mode);  KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+    
 public:
     virtual std::string to_s() const;
 
@@ -7,9 +7,12 @@
 #include "KRSimulator2D.h"
 
 #include <Karakuri/KRGameManager.h>
+#include <Karakuri/KRMemoryStats.h>
 #include "KRSimulator2DCollision.h"
 
 #include <Karakuri/chipmunk/chipmunk.h>
+#include <algorithm>
+#include <functional>
 
 
 void KRSimulator2D::initSimulatorSystem()
@@ -21,18 +24,48 @@ void KRSimulator2D::initSimulatorSystem()
     @method KRSimulator2D
     Constructor
  */
-KRSimulator2D::KRSimulator2D(const KRVector2D& gravity)
-    : mHasChangedAngle(false)
+KRSimulator2D::KRSimulator2D(const KRVector2D& gravity, KRSimulator2DBroadphase broadphase)
+    : mBroadphase(broadphase), mStepAllocCount(0), mStepHeapAllocCount(0), mMemoryStatsBytes(0), mMemoryStatsCount(0),
+      mHasChangedAngle(false), mFixedTimeStep(0.0), mMaxSubStepCount(4), mTimeAccumulator(0.0), mInterpolationAlpha(1.0)
 {
     mCPSpace = cpSpaceNew();
     mCPStaticBody = cpBodyNew(INFINITY, INFINITY);
     
+    // 衝突情報やハッシュのビンは、このシミュレータ専用のプールから確保する。
+    mCPPools = cpSpacePoolsNew();
+    cpSpaceUsePools((cpSpace*)mCPSpace, (cpSpacePools*)mCPPools);
+    
     ((cpSpace*)mCPSpace)->iterations = 20;
 
-	cpSpaceResizeActiveHash((cpSpace*)mCPSpace, 40.0, 1000);
-    cpSpaceResizeStaticHash((cpSpace*)mCPSpace, 200.0, 1000);
+    if (broadphase == KRSimulator2DBroadphaseSpatialHash) {
+        cpSpaceResizeActiveHash((cpSpace*)mCPSpace, 40.0, 1000);
+        cpSpaceResizeStaticHash((cpSpace*)mCPSpace, 200.0, 1000);
+        
+        // 40.0 は初期値で、図形が追加された後は平均の大きさに合わせて調整される。
+        cpSpaceHashSetAutoResize((cpSpaceHash*)((cpSpace*)mCPSpace)->activeShapes, 1);
+    } else {
+        // 線分の判定などで静的な図形を毎回走査しないように、静的な図形には常にツリーを使う。
+        cpSpatialIndexBBFunc bbFunc = ((cpSpace*)mCPSpace)->activeShapes->bbfunc;
+        cpSpatialIndex* staticIndex = (cpSpatialIndex*)cpBBTreeNew(bbFunc);
+        cpSpatialIndex* activeIndex;
+        if (broadphase == KRSimulator2DBroadphaseAABBTree) {
+            activeIndex = (cpSpatialIndex*)cpBBTreeNew(bbFunc);
+        } else {
+            activeIndex = (cpSpatialIndex*)cpSweep1DNew(bbFunc);
+        }
+        cpSpaceUseSpatialIndex((cpSpace*)mCPSpace, staticIndex, activeIndex);
+    }
+
+    // 衝突情報のバッファは使い回すので、ステップのたびに確保し直すことはない。
+    mCollisions.reserve(128);
+    mCollisionPairs.reserve(128);
+    mStepCollisions.reserve(128);
+    mNextCollisionPairs.reserve(128);
+    mStepContacts.reserve(128);
 
     setGravity(gravity);
+    
+    updateMemoryStats();
 }
 
 /*!
@@ -44,18 +77,26 @@ KRSimulator2D::~KRSimulator2D()
     cpBodyFree((cpBody*)mCPStaticBody);
 	cpSpaceFreeChildren((cpSpace*)mCPSpace);
     cpSpaceFree((cpSpace*)mCPSpace);
+    
+    // スペースが解放された後で、プールをまとめて解放する。
+    cpSpacePoolsFree((cpSpacePools*)mCPPools);
+    
+    KRMemoryStats::_remove(KRMemoryCategorySimulator, mMemoryStatsBytes, mMemoryStatsCount);
 }
 
 void KRSimulator2D::addShape(KRShape2D* aShape)
 {
     aShape->addToSimulator(this);
+    aShape->_savePrevTransform();
     mShapes.push_back(aShape);
+    updateMemoryStats();
 }
 
 void KRSimulator2D::removeShape(KRShape2D* aShape)
 {
     aShape->removeFromSimulator();
     mShapes.remove(aShape);
+    updateMemoryStats();
 }
 
 std::list<KRShape2D*>* KRSimulator2D::getAllShapes()
@@ -80,6 +121,11 @@ std::list<KRJoint2D*>* KRSimulator2D::getAllJoints()
     return &mJoints;
 }
 
+KRSimulator2DBroadphase KRSimulator2D::getBroadphase() const
+{
+    return mBroadphase;
+}
+
 double KRSimulator2D::getBodyAngle() const
 {
     return ((cpBody*)mCPStaticBody)->a;
@@ -118,12 +164,193 @@ static int KRCollisionFunc(cpShape* a, cpShape* b, cpContact* contacts, int numC
     KRCollisionInfo2D collisionInfo;
     collisionInfo.shape1 = (KRShape2D*)(a->data);
     collisionInfo.shape2 = (KRShape2D*)(b->data);
+    collisionInfo.colID1 = a->collision_type;
+    collisionInfo.colID2 = b->collision_type;
+    collisionInfo.phase = KRCollisionPhase2DBegin;
+    collisionInfo.contactCount = std::min(numContacts, (int)KRCollisionInfo2DMaxContactCount);
+    for (int i = 0; i < collisionInfo.contactCount; i++) {
+        collisionInfo.contactPoints[i] = KRVector2D(contacts[i].p.x, contacts[i].p.y);
+    }
+    collisionInfo.normal = KRVector2D(contacts[0].n.x * normal_coef, contacts[0].n.y * normal_coef);
+    collisionInfo.normalImpulse = 0.0;
 
-    simulator->addCollisionInfo(collisionInfo);
+    // 接触点の配列は cpSpaceStep() の終了まで有効なので、力積はステップの実行後に読み出す。
+    simulator->addCollisionInfo(collisionInfo, contacts, numContacts);
 
     return 1;
 }
 
+// まとめて空間ハッシュに渡す線分の本数。
+#define KRSegmentQueryBatchSize    64
+
+// 動く図形と静的な図形の両方を検索するためのレイヤー。
+#define KRAllShapesMask     (GRABABLE_MASK_BIT | NOT_GRABABLE_MASK)
+
+typedef struct _KRSegmentQuery {
+    cpSpatialIndexSegment   segments[KRSegmentQueryBatchSize];
+    cpSegmentQueryInfo      infos[KRSegmentQueryBatchSize];
+} _KRSegmentQuery;
+
+static cpFloat KRStaticSegmentQueryFunc(void* obj, int index, void* data)
+{
+    _KRSegmentQuery* query = (_KRSegmentQuery*)data;
+    cpSpatialIndexSegment& segment = query->segments[index];
+    cpShape* shape = (cpShape*)obj;
+    
+    // スリープ中の図形も静的な空間ハッシュに入っているので除外する。
+    if (shape->body->sleeping) {
+        return segment.t_exit;
+    }
+    
+    // 空間ハッシュの候補から、線分の始点にもっとも近い交点を持つ図形を選ぶ。
+    cpSegmentQueryInfo info = { NULL, 1.0f, cpvzero };
+    if (cpShapeSegmentQuery(shape, segment.a, segment.b, NOT_GRABABLE_MASK, 0, &info) && info.t < segment.t_exit) {
+        query->infos[index] = info;
+        return info.t;
+    }
+    return segment.t_exit;
+}
+
+void KRSimulator2D::_queryStaticSegments(int count, const KRVector2D* starts, const KRVector2D* ends, double radius, _KRStaticSegmentHit2D* hits) const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+{
+    cpSpatialIndex* staticIndex = ((cpSpace*)mCPSpace)->staticShapes;
+    _KRSegmentQuery query;
+
+    for (int base = 0; base < count; base += KRSegmentQueryBatchSize) {
+        int batchCount = std::min(count - base, KRSegmentQueryBatchSize);
+        
+        for (int i = 0; i < batchCount; i++) {
+            cpVect a = cpv(starts[base + i].x, starts[base + i].y);
+            cpVect b = cpv(ends[base + i].x, ends[base + i].y);
+            cpVect d = cpvsub(b, a);
+            cpFloat length = cpvlength(d);
+            if (radius > 0.0 && length > 0.0f) {
+                b = cpvadd(b, cpvmult(d, radius / length));
+            }
+            
+            // 長さのない線分は検索しない。
+            cpSpatialIndexSegment segment = { a, b, (length > 0.0f)? 1.0f: 0.0f };
+            query.segments[i] = segment;
+            query.infos[i].shape = NULL;
+        }
+        
+        cpSpatialIndexSegmentQuery(staticIndex, query.segments, batchCount, KRStaticSegmentQueryFunc, &query);
+        
+        for (int i = 0; i < batchCount; i++) {
+            _KRStaticSegmentHit2D& theHit = hits[base + i];
+            const cpSegmentQueryInfo& info = query.infos[i];
+            
+            theHit.hit = (info.shape != NULL);
+            if (theHit.hit) {
+                cpVect point = cpvlerp(query.segments[i].a, query.segments[i].b, info.t);
+                theHit.point = KRVector2D(point.x, point.y);
+                theHit.normal = KRVector2D(info.n.x, info.n.y);
+            }
+        }
+    }
+}
+
+static void KRSetRaycastHit(KRRaycastHit2D& hit, const cpSegmentQueryInfo& info, const cpVect& a, const cpVect& b)
+{
+    if (info.shape != NULL) {
+        cpVect point = cpvlerp(a, b, info.t);
+        hit.shape = (KRShape2D*)info.shape->data;
+        hit.point = KRVector2D(point.x, point.y);
+        hit.normal = KRVector2D(info.n.x, info.n.y);
+        hit.fraction = info.t;
+    } else {
+        hit.shape = NULL;
+        hit.point = KRVector2D(b.x, b.y);
+        hit.normal = KRVector2DZero;
+        hit.fraction = 1.0;
+    }
+}
+
+static void KRBoxQueryFunc(cpShape* shape, void* data)
+{
+    std::vector<KRShape2D*>* shapes = (std::vector<KRShape2D*>*)data;
+    shapes->push_back((KRShape2D*)shape->data);
+}
+
+int KRSimulator2D::boxQuery(const KRRect2D& rect, std::vector<KRShape2D*>& shapes) const
+{
+    shapes.clear();
+    cpBB bb = cpBBNew(rect.x, rect.y, rect.x + rect.width, rect.y + rect.height);
+    cpSpaceBBQuery((cpSpace*)mCPSpace, bb, KRAllShapesMask, 0, KRBoxQueryFunc, &shapes);
+    return (int)shapes.size();
+}
+
+KRShape2D* KRSimulator2D::raycast(const KRVector2D& start, const KRVector2D& end, KRRaycastHit2D* hit) const
+{
+    cpVect a = cpv(start.x, start.y);
+    cpVect b = cpv(end.x, end.y);
+    
+    cpSegmentQueryInfo info;
+    cpSpaceSegmentQueryFirst((cpSpace*)mCPSpace, a, b, KRAllShapesMask, 0, &info);
+    
+    if (hit != NULL) {
+        KRSetRaycastHit(*hit, info, a, b);
+    }
+    return (info.shape != NULL)? (KRShape2D*)info.shape->data: NULL;
+}
+
+void KRSimulator2D::raycast(int count, const KRVector2D* starts, const KRVector2D* ends, KRRaycastHit2D* hits) const
+{
+    cpVect a[KRSegmentQueryBatchSize];
+    cpVect b[KRSegmentQueryBatchSize];
+    cpSegmentQueryInfo infos[KRSegmentQueryBatchSize];
+
+    for (int base = 0; base < count; base += KRSegmentQueryBatchSize) {
+        int batchCount = std::min(count - base, KRSegmentQueryBatchSize);
+        
+        for (int i = 0; i < batchCount; i++) {
+            a[i] = cpv(starts[base + i].x, starts[base + i].y);
+            b[i] = cpv(ends[base + i].x, ends[base + i].y);
+        }
+        
+        cpSpaceSegmentQueryFirstBatch((cpSpace*)mCPSpace, batchCount, a, b, KRAllShapesMask, 0, infos);
+        
+        for (int i = 0; i < batchCount; i++) {
+            KRSetRaycastHit(hits[base + i], infos[i], a[i], b[i]);
+        }
+    }
+}
+
+typedef struct _KRSegmentQueryAll {
+    cpVect                          a;
+    cpVect                          b;
+    std::vector<KRRaycastHit2D>*    hits;
+} _KRSegmentQueryAll;
+
+static void KRSegmentQueryAllFunc(cpShape* shape, cpFloat t, cpVect n, void* data)
+{
+    _KRSegmentQueryAll* query = (_KRSegmentQueryAll*)data;
+    cpSegmentQueryInfo info = { shape, t, n };
+
+    KRRaycastHit2D hit;
+    KRSetRaycastHit(hit, info, query->a, query->b);
+    query->hits->push_back(hit);
+}
+
+static bool KRCompareRaycastHits(const KRRaycastHit2D& hit1, const KRRaycastHit2D& hit2)
+{
+    return (hit1.fraction < hit2.fraction);
+}
+
+int KRSimulator2D::segmentQuery(const KRVector2D& start, const KRVector2D& end, std::vector<KRRaycastHit2D>& hits) const
+{
+    hits.clear();
+    
+    _KRSegmentQueryAll query;
+    query.a = cpv(start.x, start.y);
+    query.b = cpv(end.x, end.y);
+    query.hits = &hits;
+    cpSpaceSegmentQuery((cpSpace*)mCPSpace, query.a, query.b, KRAllShapesMask, 0, KRSegmentQueryAllFunc, &query);
+    
+    std::sort(hits.begin(), hits.end(), KRCompareRaycastHits);
+    return (int)hits.size();
+}
+
 void KRSimulator2D::addCollisionPair(unsigned colID1, unsigned colID2)
 {
     cpSpaceAddCollisionPairFunc((cpSpace*)mCPSpace, colID1, colID2, KRCollisionFunc, this);
@@ -134,16 +361,144 @@ void KRSimulator2D::removeCollisionPair(unsigned colID1, unsigned colID2)
     cpSpaceRemoveCollisionPairFunc((cpSpace*)mCPSpace, colID1, colID2);
 }
 
-void KRSimulator2D::addCollisionInfo(const KRCollisionInfo2D& anInfo) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+void KRSimulator2D::addCollisionInfo(const KRCollisionInfo2D& anInfo, void* contacts, int contactCount) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
 {
-    mCollisions.push_back(anInfo);
+    _KRCollisionContacts2D theContacts;
+    theContacts.contacts = contacts;
+    theContacts.count = contactCount;
+    
+    mStepCollisions.push_back(anInfo);
+    mStepContacts.push_back(theContacts);
 }
 
-std::list<KRCollisionInfo2D>* KRSimulator2D::getCollisions()
+std::vector<KRCollisionInfo2D>* KRSimulator2D::getCollisions()
 {
     return &mCollisions;
 }
 
+// 衝突検出IDの組（小さい方が先）、図形の組の順に並べるためのキーを比較する。
+static int KRCompareCollisionKeys(const KRCollisionInfo2D& info1, const KRCollisionInfo2D& info2)
+{
+    unsigned low1 = std::min(info1.colID1, info1.colID2);
+    unsigned low2 = std::min(info2.colID1, info2.colID2);
+    if (low1 != low2) {
+        return (low1 < low2)? -1: 1;
+    }
+    unsigned high1 = std::max(info1.colID1, info1.colID2);
+    unsigned high2 = std::max(info2.colID1, info2.colID2);
+    if (high1 != high2) {
+        return (high1 < high2)? -1: 1;
+    }
+    
+    std::less<KRShape2D*> less;
+    if (info1.shape1 != info2.shape1) {
+        return less(info1.shape1, info2.shape1)? -1: 1;
+    }
+    if (info1.shape2 != info2.shape2) {
+        return less(info1.shape2, info2.shape2)? -1: 1;
+    }
+    return 0;
+}
+
+// 同じ図形の組の中では、力積の大きいものを先に並べる。
+static bool KRCollisionLessForMerge(const KRCollisionInfo2D& info1, const KRCollisionInfo2D& info2)
+{
+    int result = KRCompareCollisionKeys(info1, info2);
+    if (result != 0) {
+        return (result < 0);
+    }
+    return (info1.normalImpulse > info2.normalImpulse);
+}
+
+static bool KRCollisionIDLess(const KRCollisionInfo2D& info, const std::pair<unsigned, unsigned>& ids)
+{
+    unsigned low = std::min(info.colID1, info.colID2);
+    unsigned high = std::max(info.colID1, info.colID2);
+    return (low < ids.first || (low == ids.first && high < ids.second));
+}
+
+const KRCollisionInfo2D* KRSimulator2D::getCollisions(unsigned colID1, unsigned colID2, int* count) const
+{
+    std::pair<unsigned, unsigned> ids(std::min(colID1, colID2), std::max(colID1, colID2));
+
+    std::vector<KRCollisionInfo2D>::const_iterator it = std::lower_bound(mCollisions.begin(), mCollisions.end(), ids, KRCollisionIDLess);
+    std::vector<KRCollisionInfo2D>::const_iterator end = it;
+    while (end != mCollisions.end() && std::min(end->colID1, end->colID2) == ids.first && std::max(end->colID1, end->colID2) == ids.second) {
+        end++;
+    }
+    
+    *count = (int)(end - it);
+    return (*count > 0)? &(*it): NULL;
+}
+
+void KRSimulator2D::_removeCollisionsOfShape(KRShape2D* aShape) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+{
+    // 取り除かれた図形の組は、次のステップで離れたことにしない。
+    std::vector<KRCollisionInfo2D>::iterator dest = mCollisionPairs.begin();
+    for (std::vector<KRCollisionInfo2D>::iterator it = mCollisionPairs.begin(); it != mCollisionPairs.end(); it++) {
+        if (it->shape1 != aShape && it->shape2 != aShape) {
+            *dest++ = *it;
+        }
+    }
+    mCollisionPairs.erase(dest, mCollisionPairs.end());
+}
+
+void KRSimulator2D::updateCollisions()
+{
+    // 固定ステップ実行で同じ図形の組が複数回記録された場合は、力積の最も大きいものを残す。
+    std::sort(mStepCollisions.begin(), mStepCollisions.end(), KRCollisionLessForMerge);
+    if (!mStepCollisions.empty()) {
+        std::vector<KRCollisionInfo2D>::iterator dest = mStepCollisions.begin();
+        for (std::vector<KRCollisionInfo2D>::iterator it = mStepCollisions.begin() + 1; it != mStepCollisions.end(); it++) {
+            if (KRCompareCollisionKeys(*dest, *it) != 0) {
+                *(++dest) = *it;
+            }
+        }
+        mStepCollisions.erase(dest + 1, mStepCollisions.end());
+    }
+    
+    // 前回接触していた図形の組と比較して、イベントの種類を決める。
+    mCollisions.clear();
+    mNextCollisionPairs.clear();
+    
+    std::vector<KRCollisionInfo2D>::iterator prev = mCollisionPairs.begin();
+    std::vector<KRCollisionInfo2D>::iterator cur = mStepCollisions.begin();
+    while (prev != mCollisionPairs.end() || cur != mStepCollisions.end()) {
+        int result;
+        if (prev == mCollisionPairs.end()) {
+            result = 1;
+        } else if (cur == mStepCollisions.end()) {
+            result = -1;
+        } else {
+            result = KRCompareCollisionKeys(*prev, *cur);
+        }
+        
+        if (result < 0) {
+            // スリープした図形の組は、起きるまで接触していることにしておく。
+            if (prev->shape1->isSleeping() || prev->shape2->isSleeping()) {
+                mNextCollisionPairs.push_back(*prev);
+            } else {
+                KRCollisionInfo2D endInfo = *prev;
+                endInfo.phase = KRCollisionPhase2DEnd;
+                endInfo.contactCount = 0;
+                endInfo.normalImpulse = 0.0;
+                mCollisions.push_back(endInfo);
+            }
+            prev++;
+        } else {
+            cur->phase = (result == 0)? KRCollisionPhase2DPersist: KRCollisionPhase2DBegin;
+            mCollisions.push_back(*cur);
+            mNextCollisionPairs.push_back(*cur);
+            if (result == 0) {
+                prev++;
+            }
+            cur++;
+        }
+    }
+    
+    mCollisionPairs.swap(mNextCollisionPairs);
+}
+
 void KRSimulator2D::step()
 {
     step(1.0 / gKRGameMan->getFrameRate());    
@@ -151,10 +506,437 @@ void KRSimulator2D::step()
 
 void KRSimulator2D::step(double time)
 {
+    mStepCollisions.clear();
+    
+    cpSpacePoolsResetCounters((cpSpacePools*)mCPPools);
+    
+    if (mFixedTimeStep <= 0.0) {
+        stepOnce(time);
+        updateCollisions();
+        updateAllocCounts();
+        return;
+    }
+    
+    // 経過時間を蓄積し、固定ステップ単位で実行する。
+    mTimeAccumulator += time;
+    
+    int stepCount = 0;
+    while (mTimeAccumulator >= mFixedTimeStep && stepCount < mMaxSubStepCount) {
+        for (std::list<KRShape2D*>::iterator it = mShapes.begin(); it != mShapes.end(); it++) {
+            (*it)->_savePrevTransform();
+        }
+        stepOnce(mFixedTimeStep);
+        mTimeAccumulator -= mFixedTimeStep;
+        stepCount++;
+    }
+    
+    // 処理が追いつかない分は切り捨てて、負荷が際限なく増えないようにする。
+    if (mTimeAccumulator >= mFixedTimeStep) {
+        mTimeAccumulator = fmod(mTimeAccumulator, mFixedTimeStep);
+    }
+    
+    mInterpolationAlpha = mTimeAccumulator / mFixedTimeStep;
+    
+    if (stepCount > 0) {
+        updateCollisions();
+    } else {
+        mCollisions.clear();
+    }
+    
+    updateAllocCounts();
+}
+
+double KRSimulator2D::getIdleSpeedThreshold() const
+{
+    return ((cpSpace*)mCPSpace)->idleSpeedThreshold;
+}
+
+int KRSimulator2D::getSleepingShapeCount() const
+{
+    return ((cpSpace*)mCPSpace)->sleepingShapes->num;
+}
+
+double KRSimulator2D::getSleepTimeThreshold() const
+{
+    cpFloat threshold = ((cpSpace*)mCPSpace)->sleepTimeThreshold;
+    return (threshold == INFINITY)? 0.0: threshold;
+}
+
+void KRSimulator2D::setIdleSpeedThreshold(double speed)
+{
+    ((cpSpace*)mCPSpace)->idleSpeedThreshold = (speed > 0.0)? speed: 0.0;
+}
+
+void KRSimulator2D::setSleepTimeThreshold(double time)
+{
+    ((cpSpace*)mCPSpace)->sleepTimeThreshold = (time > 0.0)? time: INFINITY;
+    if (time <= 0.0) {
+        cpSpaceActivateAll((cpSpace*)mCPSpace);
+    }
+}
+
+void KRSimulator2D::wakeUpAllShapes()
+{
+    cpSpaceActivateAll((cpSpace*)mCPSpace);
+}
+
+int KRSimulator2D::getSolverThreadCount() const
+{
+    cpParallelSolver* solver = ((cpSpace*)mCPSpace)->solver;
+    return (solver != NULL)? cpParallelSolverGetThreadCount(solver): 1;
+}
+
+bool KRSimulator2D::isSolverDeterministic() const
+{
+    cpParallelSolver* solver = ((cpSpace*)mCPSpace)->solver;
+    return (solver != NULL && cpParallelSolverIsDeterministic(solver));
+}
+
+void KRSimulator2D::setSolverThreadCount(int count, bool deterministic)
+{
+    cpSpaceSetSolverThreads((cpSpace*)mCPSpace, (count > 0)? count: 0, deterministic? 1: 0);
+}
+
+// saveState() で書き出すデータの先頭を識別するための値。
+#define KRSimulator2DStateMagic     0x4b523253
+
+/*
+    saveState() で書き出すデータの形式。
+    ヘッダの後に、動く図形のボディ、ジョイント、衝突（それぞれの接触点が続く）、接触中の図形の組が並ぶ。
+    並べて書き込んでも double やポインタの境界がずれないように、どの構造体も、cpFloat が float の場合でも
+    大きさが8バイトの倍数になるように明示的に詰め物を入れておく。
+ */
+
+// 構造体の大きさが8バイトの倍数でなければ、コンパイルエラーにする。
+#define KR_CHECK_STATE_RECORD_SIZE(type)    typedef char type##SizeCheck[(sizeof(type) % 8 == 0)? 1: -1]
+
+struct _KRSimulator2DStateHeader {
+    unsigned    magic;
+    unsigned    shapeChecksum;
+    int         shapeCount;
+    int         bodyCount;
+    int         jointCount;
+    int         arbiterCount;
+    int         contactCount;
+    int         pairCount;
+    int         stamp;
+    int         reserved;
+    double      staticBodyAngle;
+    double      timeAccumulator;
+    double      interpolationAlpha;
+};
+
+struct _KRBodyState2D {
+    cpVect      p, v, f, v_bias, rot;
+    cpFloat     a, w, t, w_bias;
+    cpFloat     idleTime;
+    cpFloat     padding;
+};
+
+struct _KRArbiterState2D {
+    cpShape*    a;
+    cpShape*    b;
+    int         stamp;
+    int         numContacts;
+};
+
+// 接触点の位置や法線は次のステップの衝突判定で作り直されるので、力積を引き継ぐための情報だけを保存する。
+struct _KRContactState2D {
+    cpFloat     jnAcc, jtAcc;
+    unsigned long long  hash;   // cpHashValue は32ビット環境では4バイトになるので、8バイトで格納する。
+};
+
+struct _KRCollisionPairState2D {
+    KRShape2D*  shape1;
+    KRShape2D*  shape2;
+    unsigned    colID1;
+    unsigned    colID2;
+    cpVect      normal;
+};
+
+KR_CHECK_STATE_RECORD_SIZE(_KRSimulator2DStateHeader);
+KR_CHECK_STATE_RECORD_SIZE(_KRBodyState2D);
+KR_CHECK_STATE_RECORD_SIZE(_KRArbiterState2D);
+KR_CHECK_STATE_RECORD_SIZE(_KRContactState2D);
+KR_CHECK_STATE_RECORD_SIZE(_KRCollisionPairState2D);
+KR_CHECK_STATE_RECORD_SIZE(cpVect);
+
+// 追加されている図形の並びを表すチェックサム。図形のIDは作成された順に振られるので、図形の入れ替えも検出できる。
+static unsigned KRGetShapeChecksum(const std::list<KRShape2D*>& shapes)
+{
+    unsigned checksum = 2166136261U;
+    for (std::list<KRShape2D*>::const_iterator it = shapes.begin(); it != shapes.end(); it++) {
+        checksum = (checksum ^ (unsigned)((cpShape*)(*it)->getCPShape())->id) * 16777619U;
+    }
+    return checksum;
+}
+
+static void KRCountArbiterFunc(cpArbiter* arb, void* data)
+{
+    int* counts = (int*)data;
+    counts[0]++;
+    counts[1] += arb->numContacts;
+}
+
+static void KRSaveArbiterFunc(cpArbiter* arb, void* data)
+{
+    unsigned char** p = (unsigned char**)data;
+    
+    _KRArbiterState2D* arbiterState = (_KRArbiterState2D*)*p;
+    arbiterState->a = arb->a;
+    arbiterState->b = arb->b;
+    arbiterState->stamp = arb->stamp;
+    arbiterState->numContacts = arb->numContacts;
+    
+    _KRContactState2D* contactStates = (_KRContactState2D*)(arbiterState + 1);
+    for (int i = 0; i < arb->numContacts; i++) {
+        cpContact* con = &arb->contacts[i];
+        contactStates[i].jnAcc = con->jnAcc;
+        contactStates[i].jtAcc = con->jtAcc;
+        contactStates[i].hash = con->hash;
+    }
+    
+    *p = (unsigned char*)(contactStates + arb->numContacts);
+}
+
+void KRSimulator2D::saveState(std::vector<unsigned char>& buffer) const
+{
+    cpSpace* space = (cpSpace*)mCPSpace;
+    
+    int bodyCount = 0;
+    for (std::list<KRShape2D*>::const_iterator it = mShapes.begin(); it != mShapes.end(); it++) {
+        if (!(*it)->isStatic()) {
+            bodyCount++;
+        }
+    }
+    int arbiterCounts[2] = { 0, 0 };
+    cpSpaceEachArbiter(space, KRCountArbiterFunc, arbiterCounts);
+    
+    size_t size = sizeof(_KRSimulator2DStateHeader) + sizeof(_KRBodyState2D) * bodyCount + sizeof(cpVect) * mJoints.size()
+                + sizeof(_KRArbiterState2D) * arbiterCounts[0] + sizeof(_KRContactState2D) * arbiterCounts[1]
+                + sizeof(_KRCollisionPairState2D) * mCollisionPairs.size();
+    buffer.resize(size);
+    
+    _KRSimulator2DStateHeader* header = (_KRSimulator2DStateHeader*)&buffer[0];
+    header->magic = KRSimulator2DStateMagic;
+    header->shapeChecksum = KRGetShapeChecksum(mShapes);
+    header->shapeCount = (int)mShapes.size();
+    header->bodyCount = bodyCount;
+    header->jointCount = (int)mJoints.size();
+    header->arbiterCount = arbiterCounts[0];
+    header->contactCount = arbiterCounts[1];
+    header->pairCount = (int)mCollisionPairs.size();
+    header->stamp = space->stamp;
+    header->reserved = 0;
+    header->staticBodyAngle = ((cpBody*)mCPStaticBody)->a;
+    header->timeAccumulator = mTimeAccumulator;
+    header->interpolationAlpha = mInterpolationAlpha;
+    
+    // 動く図形のボディ
+    _KRBodyState2D* bodyState = (_KRBodyState2D*)(header + 1);
+    for (std::list<KRShape2D*>::const_iterator it = mShapes.begin(); it != mShapes.end(); it++) {
+        if ((*it)->isStatic()) {
+            continue;
+        }
+        cpBody* body = (cpBody*)(*it)->getCPBody();
+        bodyState->p = body->p;
+        bodyState->v = body->v;
+        bodyState->f = body->f;
+        bodyState->a = body->a;
+        bodyState->rot = body->rot;
+        bodyState->w = body->w;
+        bodyState->t = body->t;
+        bodyState->v_bias = body->v_bias;
+        bodyState->w_bias = body->w_bias;
+        bodyState->idleTime = body->idleTime;
+        bodyState->padding = 0.0f;
+        bodyState++;
+    }
+    
+    // ジョイント（ばねは力積を持ち越さない）
+    cpVect* jointState = (cpVect*)bodyState;
+    for (std::list<KRJoint2D*>::const_iterator it = mJoints.begin(); it != mJoints.end(); it++) {
+        cpConstraint* constraint = (cpConstraint*)(*it)->getCPConstraint();
+        *jointState = (constraint->klass == cpPivotJointGetClass())? ((cpPivotJoint*)constraint)->jAcc: cpvzero;
+        jointState++;
+    }
+    
+    // 衝突と接触点
+    unsigned char* p = (unsigned char*)jointState;
+    cpSpaceEachArbiter(space, KRSaveArbiterFunc, &p);
+    
+    // 接触中の図形の組
+    _KRCollisionPairState2D* pairState = (_KRCollisionPairState2D*)p;
+    for (std::vector<KRCollisionInfo2D>::const_iterator it = mCollisionPairs.begin(); it != mCollisionPairs.end(); it++) {
+        pairState->shape1 = it->shape1;
+        pairState->shape2 = it->shape2;
+        pairState->colID1 = it->colID1;
+        pairState->colID2 = it->colID2;
+        pairState->normal = cpv(it->normal.x, it->normal.y);
+        pairState++;
+    }
+}
+
+void KRSimulator2D::restoreState(const std::vector<unsigned char>& buffer)
+{
+    const _KRSimulator2DStateHeader* header = (buffer.size() >= sizeof(_KRSimulator2DStateHeader))? (const _KRSimulator2DStateHeader*)&buffer[0]: NULL;
+    
+    // 図形とジョイントの構成が保存した時点と同じであることを確認する。
+    if (header == NULL || header->magic != KRSimulator2DStateMagic ||
+        header->shapeCount != (int)mShapes.size() || header->jointCount != (int)mJoints.size() ||
+        header->shapeChecksum != KRGetShapeChecksum(mShapes) ||
+        buffer.size() != sizeof(_KRSimulator2DStateHeader) + sizeof(_KRBodyState2D) * header->bodyCount + sizeof(cpVect) * header->jointCount
+                         + sizeof(_KRArbiterState2D) * header->arbiterCount + sizeof(_KRContactState2D) * header->contactCount
+                         + sizeof(_KRCollisionPairState2D) * header->pairCount)
+    {
+        if (gKRLanguage == KRLanguageJapanese) {
+            throw KRRuntimeError("KRSimulator2D::restoreState() 保存された状態は、このシミュレータの図形やジョイントの構成と一致しません。");
+        } else {
+            throw KRRuntimeError("KRSimulator2D::restoreState() The saved state does not match the shapes and joints of this simulator.");
+        }
+    }
+    
+    cpSpace* space = (cpSpace*)mCPSpace;
+    
+    // スリープ中のボディは、アクティブな配列に戻してから上書きする。
+    cpSpaceActivateAll(space);
+    
+    // 動く図形のボディ
+    const _KRBodyState2D* bodyState = (const _KRBodyState2D*)(header + 1);
+    for (std::list<KRShape2D*>::iterator it = mShapes.begin(); it != mShapes.end(); it++) {
+        if ((*it)->isStatic()) {
+            continue;
+        }
+        cpBody* body = (cpBody*)(*it)->getCPBody();
+        body->p = bodyState->p;
+        body->v = bodyState->v;
+        body->f = bodyState->f;
+        // 三角関数を計算し直さないように、回転も保存したものを使う。
+        body->a = bodyState->a;
+        body->rot = bodyState->rot;
+        body->w = bodyState->w;
+        body->t = bodyState->t;
+        body->idleTime = bodyState->idleTime;
+        // ソルバが位置の補正のために加えた速度は、次のステップの最初に使われる。
+        body->v_bias = bodyState->v_bias;
+        body->w_bias = bodyState->w_bias;
+        cpShapeCacheBB((cpShape*)(*it)->getCPShape());
+        (*it)->_savePrevTransform();
+        bodyState++;
+    }
+    cpSpatialIndexReindex(space->activeShapes);
+    
+    // ジョイント
+    const cpVect* jointState = (const cpVect*)bodyState;
+    for (std::list<KRJoint2D*>::iterator it = mJoints.begin(); it != mJoints.end(); it++) {
+        cpConstraint* constraint = (cpConstraint*)(*it)->getCPConstraint();
+        if (constraint->klass == cpPivotJointGetClass()) {
+            ((cpPivotJoint*)constraint)->jAcc = *jointState;
+        }
+        jointState++;
+    }
+    
+    // 衝突と接触点
+    cpSpaceBeginRestoreArbiters(space);
+    const unsigned char* p = (const unsigned char*)jointState;
+    for (int i = 0; i < header->arbiterCount; i++) {
+        const _KRArbiterState2D* arbiterState = (const _KRArbiterState2D*)p;
+        const _KRContactState2D* contactStates = (const _KRContactState2D*)(arbiterState + 1);
+        
+        cpArbiter* arb = cpSpaceRestoreArbiter(space, arbiterState->a, arbiterState->b, arbiterState->stamp, arbiterState->numContacts);
+        for (int j = 0; j < arbiterState->numContacts; j++) {
+            cpContact* con = &arb->contacts[j];
+            con->jnAcc = contactStates[j].jnAcc;
+            con->jtAcc = contactStates[j].jtAcc;
+            con->hash = (cpHashValue)contactStates[j].hash;
+        }
+        
+        p = (const unsigned char*)(contactStates + arbiterState->numContacts);
+    }
+    cpSpaceEndRestoreArbiters(space);
+    space->stamp = header->stamp;
+    
+    // 接触中の図形の組
+    const _KRCollisionPairState2D* pairState = (const _KRCollisionPairState2D*)p;
     mCollisions.clear();
+    mCollisionPairs.clear();
+    for (int i = 0; i < header->pairCount; i++) {
+        KRCollisionInfo2D pair;
+        pair.shape1 = pairState->shape1;
+        pair.shape2 = pairState->shape2;
+        pair.colID1 = pairState->colID1;
+        pair.colID2 = pairState->colID2;
+        pair.phase = KRCollisionPhase2DPersist;
+        pair.contactCount = 0;
+        pair.normal = KRVector2D(pairState->normal.x, pairState->normal.y);
+        pair.normalImpulse = 0.0;
+        mCollisionPairs.push_back(pair);
+        pairState++;
+    }
+    
+    // 静的な図形のボディの回転
+    mHasChangedAngle = false;
+    if (((cpBody*)mCPStaticBody)->a != (cpFloat)header->staticBodyAngle) {
+        cpBodySetAngle((cpBody*)mCPStaticBody, (cpFloat)header->staticBodyAngle);
+        cpSpaceRehashStatic(space);
+    }
+    
+    mTimeAccumulator = header->timeAccumulator;
+    mInterpolationAlpha = header->interpolationAlpha;
+}
+
+void KRSimulator2D::updateAllocCounts()
+{
+    mStepAllocCount = cpSpacePoolsGetAllocCount((cpSpacePools*)mCPPools);
+    mStepHeapAllocCount = cpSpacePoolsGetHeapAllocCount((cpSpacePools*)mCPPools);
+    
+    if (mStepHeapAllocCount > 0) {
+        updateMemoryStats();
+    }
+}
 
+void KRSimulator2D::updateMemoryStats()
+{
+    // プールが確保した領域と、図形の個数を報告する。
+    size_t bytes = sizeof(KRSimulator2D) + cpSpacePoolsGetReservedBytes((cpSpacePools*)mCPPools);
+    int count = (int)mShapes.size();
+    if (bytes == mMemoryStatsBytes && count == mMemoryStatsCount) {
+        return;
+    }
+    
+    KRMemoryStats::_remove(KRMemoryCategorySimulator, mMemoryStatsBytes, mMemoryStatsCount);
+    KRMemoryStats::_add(KRMemoryCategorySimulator, bytes, count);
+    mMemoryStatsBytes = bytes;
+    mMemoryStatsCount = count;
+}
+
+unsigned KRSimulator2D::getStepAllocCount() const
+{
+    return mStepAllocCount;
+}
+
+unsigned KRSimulator2D::getStepHeapAllocCount() const
+{
+    return mStepHeapAllocCount;
+}
+
+void KRSimulator2D::stepOnce(double time)
+{
+    size_t firstCollision = mStepCollisions.size();
+    mStepContacts.clear();
+    
     cpSpaceStep((cpSpace*)mCPSpace, time);
     
+    // ソルバが加えた力積を、このステップで記録された衝突に書き込む。
+    for (size_t i = 0; i < mStepContacts.size(); i++) {
+        cpContact* contacts = (cpContact*)mStepContacts[i].contacts;
+        double impulse = 0.0;
+        for (int j = 0; j < mStepContacts[i].count; j++) {
+            impulse += contacts[j].jnAcc;
+        }
+        mStepCollisions[firstCollision + i].normalImpulse = impulse;
+    }
+    
     if (mHasChangedAngle) {
         cpBodySetAngle((cpBody*)mCPStaticBody, mNextAngle);
         cpSpaceRehashStatic((cpSpace*)mCPSpace);
@@ -162,6 +944,28 @@ void KRSimulator2D::step(double time)
     }
 }
 
+double KRSimulator2D::getFixedTimeStep() const
+{
+    return (mFixedTimeStep > 0.0)? mFixedTimeStep: 0.0;
+}
+
+double KRSimulator2D::getInterpolationAlpha() const
+{
+    return mInterpolationAlpha;
+}
+
+void KRSimulator2D::setFixedTimeStep(double timeStep, int maxSubStepCount)
+{
+    mFixedTimeStep = timeStep;
+    mMaxSubStepCount = (maxSubStepCount > 0)? maxSubStepCount: 1;
+    mTimeAccumulator = 0.0;
+    mInterpolationAlpha = 1.0;
+    
+    for (std::list<KRShape2D*>::iterator it = mShapes.begin(); it != mShapes.end(); it++) {
+        (*it)->_savePrevTransform();
+    }
+}
+
 void* KRSimulator2D::getCPSpace() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
 {
     return mCPSpace;
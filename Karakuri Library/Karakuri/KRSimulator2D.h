@@ -14,6 +14,40 @@
 #include <Karakuri/KRSimulator2DCollision.h>
 
 
+/*!
+    @enum KRSimulator2DBroadphase
+    @group Game 2D Simulator
+    @constant KRSimulator2DBroadphaseSpatialHash    空間ハッシュを使います。動く図形のセルの大きさは、図形の平均の大きさに合わせて自動的に調整されます。
+    @constant KRSimulator2DBroadphaseAABBTree       動的なAABBツリーを使います。図形の大きさがまちまちなシーンや、図形の数が数千を超えるシーンに向いています。
+    @constant KRSimulator2DBroadphaseSweepAndPrune  動く図形をx軸方向に整列させて判定します（静的な図形にはAABBツリーを使います）。動く図形が多く、横方向に散らばっているシーンに向いています。
+    @abstract 衝突する可能性のある図形の組を見つけるための手法（ブロードフェーズ）を示す列挙型です。
+    どの手法を選んでも、衝突する図形の組は同じになります。
+ */
+typedef enum {
+    KRSimulator2DBroadphaseSpatialHash      = 0,
+    KRSimulator2DBroadphaseAABBTree         = 1,
+    KRSimulator2DBroadphaseSweepAndPrune    = 2,
+} KRSimulator2DBroadphase;
+
+
+/*
+    静的な図形に対する線分の当たり判定の結果です。
+ */
+struct _KRStaticSegmentHit2D {
+    bool        hit;
+    KRVector2D  point;
+    KRVector2D  normal;
+};
+
+/*
+    ステップ実行中に記録された衝突の接触点です。力積はステップの実行後に読み出します。
+ */
+struct _KRCollisionContacts2D {
+    void*   contacts;
+    int     count;
+};
+
+
 /*!
     @class KRSimulator2D
     @group Game 2D Simulator
@@ -27,12 +61,26 @@ public:
 private:
     void*       mCPSpace;
     void*       mCPStaticBody;
+    void*       mCPPools;
+    KRSimulator2DBroadphase mBroadphase;
+    unsigned    mStepAllocCount;
+    unsigned    mStepHeapAllocCount;
+    size_t      mMemoryStatsBytes;
+    int         mMemoryStatsCount;
     double      mNextAngle;
     bool        mHasChangedAngle;
     KRVector2D  mGravity;
+    double      mFixedTimeStep;
+    int         mMaxSubStepCount;
+    double      mTimeAccumulator;
+    double      mInterpolationAlpha;
     std::list<KRShape2D*>           mShapes;
     std::list<KRJoint2D*>           mJoints;
-    std::list<KRCollisionInfo2D>    mCollisions;
+    std::vector<KRCollisionInfo2D>  mCollisions;
+    std::vector<KRCollisionInfo2D>  mCollisionPairs;
+    std::vector<KRCollisionInfo2D>  mStepCollisions;
+    std::vector<KRCollisionInfo2D>  mNextCollisionPairs;
+    std::vector<_KRCollisionContacts2D> mStepContacts;
 
 public:
     /*!
@@ -41,9 +89,10 @@ public:
 
     /*!
         @method KRSimulator2D
-        重力を設定して、このシミュレータを作成します。
+        @abstract 重力とブロードフェーズの手法を設定して、このシミュレータを作成します。
+        ブロードフェーズを省略した場合は、空間ハッシュが使われます。
      */
-	KRSimulator2D(const KRVector2D& gravity);
+	KRSimulator2D(const KRVector2D& gravity, KRSimulator2DBroadphase broadphase = KRSimulator2DBroadphaseSpatialHash);
 
 	virtual ~KRSimulator2D();
     
@@ -60,10 +109,156 @@ public:
 
     /*!
         @method step
-        シミュレータを秒数を指定してステップ実行します。
+        @abstract シミュレータを秒数を指定してステップ実行します。
+        固定ステップが設定されている場合、指定された時間は蓄積され、固定ステップ単位で最大 setFixedTimeStep() 関数で指定された回数まで実行されます。
      */
     void    step(double time);
 
+private:
+    void    stepOnce(double time);
+    void    updateCollisions();
+    void    updateAllocCounts();
+    void    updateMemoryStats();
+
+public:
+    /*!
+        @task 固定ステップ実行のための関数
+     */
+    
+    /*!
+        @method getFixedTimeStep
+        @abstract 固定ステップの1回あたりの秒数を取得します。固定ステップが無効の場合は 0.0 がリターンされます。
+     */
+    double  getFixedTimeStep() const;
+    
+    /*!
+        @method getInterpolationAlpha
+        @abstract 直前のステップ実行後に蓄積されている時間の、固定ステップ1回分に対する割り合い（0.0〜1.0）を取得します。
+        固定ステップが無効の場合は、常に 1.0 がリターンされます。
+     */
+    double  getInterpolationAlpha() const;
+    
+    /*!
+        @method setFixedTimeStep
+        @abstract 固定ステップの1回あたりの秒数と、1回の step() 関数呼び出しで実行する最大のステップ数を設定します。
+        <p>固定ステップを設定すると、物理演算の負荷はフレームレートや描画の負荷によらず一定になります。描画には KRShape2D::getInterpolatedCenterPos() 関数と KRShape2D::getInterpolatedAngle() 関数を使うと、ステップ間の動きが滑らかになります。</p>
+        <p>最大のステップ数を超えて蓄積された時間は切り捨てられます。timeStep に 0.0 以下の値を設定すると、固定ステップは無効になります（デフォルト）。</p>
+     */
+    void    setFixedTimeStep(double timeStep, int maxSubStepCount = 4);
+
+public:
+    /*!
+        @task スリープのための関数
+     */
+    
+    /*!
+        @method getIdleSpeedThreshold
+        @abstract 図形が静止しているとみなされる速度を取得します。
+        0.0 の場合は、重力によって1ステップで加算される速度が使われます。
+     */
+    double  getIdleSpeedThreshold() const;
+    
+    /*!
+        @method getSleepingShapeCount
+        現在スリープしている図形の個数を取得します。
+     */
+    int     getSleepingShapeCount() const;
+    
+    /*!
+        @method getSleepTimeThreshold
+        @abstract 図形がスリープするまでの静止時間（秒）を取得します。
+        スリープが無効の場合は、0.0 がリターンされます。
+     */
+    double  getSleepTimeThreshold() const;
+    
+    /*!
+        @method setIdleSpeedThreshold
+        @abstract 図形が静止しているとみなされる速度を設定します。
+        0.0 を設定すると、重力によって1ステップで加算される速度が使われます（デフォルト）。
+     */
+    void    setIdleSpeedThreshold(double speed);
+    
+    /*!
+        @method setSleepTimeThreshold
+        @abstract 図形がスリープするまでの静止時間（秒）を設定します。
+        <p>接触やジョイントでつながった図形のグループ（アイランド）の全体が、指定された時間だけ静止し続けると、そのグループはスリープします。スリープしている図形は、移動の計算、空間ハッシュの更新、衝突の解決のいずれも行われなくなるため、積み上がって静止した図形の負荷はほとんどなくなります。</p>
+        <p>スリープしている図形は、動いている図形との接触、ジョイントの追加や削除、KRShape2D::setVelocity() 関数などによる状態の設定、setBodyAngle() 関数によるボディの回転で起こされます。スリープ中の図形同士の衝突は検知されません。</p>
+        <p>0.0 以下の値を設定すると、スリープは無効になります（デフォルト）。</p>
+     */
+    void    setSleepTimeThreshold(double time);
+    
+    /*!
+        @method wakeUpAllShapes
+        スリープしているすべての図形を起こします。
+     */
+    void    wakeUpAllShapes();
+
+public:
+    /*!
+        @task マルチスレッド計算のための関数
+     */
+    
+    /*!
+        @method getSolverThreadCount
+        @abstract 衝突とジョイントの解決に使われるスレッドの数を取得します。
+        シングルスレッドの通常の計算が行われている場合は、1 がリターンされます。
+     */
+    int     getSolverThreadCount() const;
+    
+    /*!
+        @method isSolverDeterministic
+        マルチスレッド計算が、実行環境によらず同じ結果を返すモードで行われているかどうかを取得します。
+     */
+    bool    isSolverDeterministic() const;
+    
+    /*!
+        @method setSolverThreadCount
+        @abstract 衝突とジョイントの解決に使うスレッドの数を設定します。
+        <p>マルチスレッド計算では、同じボディを共有しない衝突とジョイントをグループ（色）に分けて、同じ色の中の衝突とジョイントを複数のスレッドで同時に解決します。色の分け方は衝突とジョイントの並び順だけで決まるため、計算結果はスレッドの数やスケジューリングには左右されません。ただし、解決の順序が異なるため、シングルスレッドの通常の計算とは少しだけ異なる結果になります。</p>
+        <p>deterministic に false を指定した場合、CPU が1つしかないときや、衝突とジョイントの数が少なくてスレッドを使う意味がないときには、通常の計算が行われます。deterministic に true を指定すると、この場合にも色分けした順序で計算されるため、ネットワーク対戦のように複数の端末で同じ結果が必要な場合に利用できます。</p>
+        <p>0 を指定すると、CPU の数だけスレッドが使われます。1 を指定し、deterministic に false を指定すると、通常の計算に戻ります（デフォルト）。この関数を step() 関数の実行中に呼び出すことはできません。</p>
+     */
+    void    setSolverThreadCount(int count, bool deterministic = false);
+
+public:
+    /*!
+        @task 状態の保存と復元のための関数
+     */
+    
+    /*!
+        @method restoreState
+        @abstract saveState() 関数で保存された状態に、このシミュレータを戻します。
+        <p>図形の位置・速度・角度・角速度と、衝突やジョイントの解決に使われる力積が復元されるため、保存した時点から計算し直した結果は、保存した時点からそのまま計算を続けた結果と一致します。ネットワーク対戦の巻き戻しや、リプレイの早送りと巻き戻しに利用できます。</p>
+        <p>保存した時点と同じ図形とジョイントが、同じ順序で追加されている必要があります。異なる場合は例外が投げられます。スリープしていた図形は、起きた状態で復元されます。</p>
+     */
+    void    restoreState(const std::vector<unsigned char>& buffer);
+    
+    /*!
+        @method saveState
+        @abstract このシミュレータの状態を、buffer にまとめて書き込みます。
+        buffer のサイズは必要な大きさに変更されます。同じ buffer を繰り返し使えば、通常はメモリの確保は発生しません。保存されたデータは、同じシミュレータの restoreState() 関数でのみ使うことができます（ファイルなどに保存して、別の実行で使うことはできません）。
+     */
+    void    saveState(std::vector<unsigned char>& buffer) const;
+
+public:
+    /*!
+        @task メモリ使用状況の確認のための関数
+     */
+    
+    /*!
+        @method getStepAllocCount
+        @abstract 直前の step() 関数の実行中に、衝突情報やハッシュのために確保されたオブジェクトの個数を取得します。
+        これらのオブジェクトはシミュレータごとのメモリプールから確保されます。
+     */
+    unsigned    getStepAllocCount() const;
+    
+    /*!
+        @method getStepHeapAllocCount
+        @abstract 直前の step() 関数の実行中に、メモリプールの拡張などのために malloc() が呼び出された回数を取得します。
+        通常、図形の数が安定していれば 0 になります。
+     */
+    unsigned    getStepHeapAllocCount() const;
+
 public:
     /*!
         @task 図形管理のための関数
@@ -89,6 +284,38 @@ public:
      */
     KRShape2D*  getShape(const KRVector2D& pos) const;
 
+    /*!
+        @task 図形の検索のための関数
+     */
+    
+    /*!
+        @method boxQuery
+        @abstract 指定された矩形とバウンディングボックスが重なっているすべての図形を取得します。
+        見つかった図形は shapes に追加されます（shapes は最初に空にされます）。見つかった図形の個数がリターンされます。
+     */
+    int     boxQuery(const KRRect2D& rect, std::vector<KRShape2D*>& shapes) const;
+    
+    /*!
+        @method raycast
+        @abstract start から end までの線分が最初に当たる図形を取得します。
+        何にも当たらなかった場合は NULL がリターンされます。hit を指定すると、当たった位置と法線ベクトルが格納されます。静的な図形やスリープしている図形も検索されます。
+     */
+    KRShape2D*  raycast(const KRVector2D& start, const KRVector2D& end, KRRaycastHit2D* hit = NULL) const;
+    
+    /*!
+        @method raycast
+        @abstract count 本の線分（starts[i] から ends[i] まで）が最初に当たる図形を、まとめて検索します。
+        <p>結果は hits[i] に格納されます。すべての線分が、空間ハッシュなどのブロードフェーズの構造を1回たどるだけで検索されるため、多数の敵の視線の判定などを1本ずつ raycast() 関数で行うよりも高速です。</p>
+     */
+    void    raycast(int count, const KRVector2D* starts, const KRVector2D* ends, KRRaycastHit2D* hits) const;
+    
+    /*!
+        @method segmentQuery
+        @abstract start から end までの線分が当たるすべての図形を、始点に近い順に取得します。
+        見つかった図形の情報は hits に追加されます（hits は最初に空にされます）。見つかった図形の個数がリターンされます。
+     */
+    int     segmentQuery(const KRVector2D& start, const KRVector2D& end, std::vector<KRRaycastHit2D>& hits) const;
+
     /*!
         @method removeShape
         指定された図形をシミュレータから取り除きます。
@@ -122,6 +349,12 @@ public:
         @task 設定のための関数
      */
 
+    /*!
+        @method getBroadphase
+        このシミュレータのブロードフェーズの手法を取得します。
+     */
+    KRSimulator2DBroadphase getBroadphase() const;
+
     /*!
         @method getBodyAngle
         @abstract 現在のボディの角度を取得します。
@@ -159,9 +392,18 @@ public:
 
     /*!
         @method getCollisions
-        直前のステップ実行で衝突が検知されたすべての図形の組をリターンします。
+        @abstract 直前の step() 関数の実行で発生したすべての衝突イベントをリターンします。
+        <p>接触し始めた図形の組（KRCollisionPhase2DBegin）、接触し続けている図形の組（KRCollisionPhase2DPersist）、離れた図形の組（KRCollisionPhase2DEnd）のイベントが、衝突検出IDの組の順に並んでいます。この配列は step() 関数の実行ごとに再利用されるため、通常はメモリの確保は発生しません。</p>
+        <p>固定ステップ実行で1回の step() 関数の中で物理計算が行われなかった場合は、空になります。removeShape() 関数で取り除かれた図形や、スリープした図形の組については、KRCollisionPhase2DEnd のイベントは発生しません。</p>
      */
-    std::list<KRCollisionInfo2D>* getCollisions();
+    std::vector<KRCollisionInfo2D>* getCollisions();
+    
+    /*!
+        @method getCollisions
+        @abstract 直前の step() 関数の実行で発生した衝突イベントのうち、指定された衝突検出IDの組のものを取得します。
+        イベントは衝突検出IDの組の順に並べられているため、すべてのイベントを調べることなく見つけられます。該当するイベントの個数が count に格納され、最初のイベントへのポインタがリターンされます（該当するイベントがない場合は NULL）。colID1 と colID2 の順序は問いません。
+     */
+    const KRCollisionInfo2D* getCollisions(unsigned colID1, unsigned colID2, int* count) const;
     
     /*!
         @method removeCollisionPair
@@ -169,7 +411,14 @@ public:
      */
     void    removeCollisionPair(unsigned colID1, unsigned colID2);
     
-    void    addCollisionInfo(const KRCollisionInfo2D& anInfo) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    void    addCollisionInfo(const KRCollisionInfo2D& anInfo, void* contacts, int contactCount) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    void    _removeCollisionsOfShape(KRShape2D* aShape) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    
+    /*
+        count 本の線分（starts[i] から ends[i] まで）を、静的な図形の空間ハッシュに対してまとめて判定します。
+        radius を指定すると、線分の終点を移動方向に radius だけ延ばして判定します。
+     */
+    void    _queryStaticSegments(int count, const KRVector2D* starts, const KRVector2D* ends, double radius, _KRStaticSegmentHit2D* hits) const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
     
 public:
     void*   getCPSpace() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
@@ -14,6 +14,29 @@
 class KRShape2D;
 
 
+/*!
+    @enum KRCollisionPhase2D
+    @group Game 2D Simulator
+    @constant KRCollisionPhase2DBegin     前回のステップでは接触していなかった図形の組が、接触し始めたことを表します。
+    @constant KRCollisionPhase2DPersist   前回のステップに続いて、図形の組が接触し続けていることを表します。
+    @constant KRCollisionPhase2DEnd       前回のステップで接触していた図形の組が、離れたことを表します。
+    @abstract 衝突イベントの種類を表す列挙型です。
+ */
+typedef enum {
+    KRCollisionPhase2DBegin     = 0,
+    KRCollisionPhase2DPersist   = 1,
+    KRCollisionPhase2DEnd       = 2,
+} KRCollisionPhase2D;
+
+
+/*!
+    @const KRCollisionInfo2DMaxContactCount
+    @group Game 2D Simulator
+    KRCollisionInfo2D 構造体に格納される接触点の最大数です。
+ */
+#define KRCollisionInfo2DMaxContactCount    4
+
+
 /*!
     @struct KRCollisionInfo2D
     @group Game 2D Simulator
@@ -23,15 +46,92 @@ typedef struct KRCollisionInfo2D : public KRObject {
     /*!
         @var shape1
         衝突した図形に対応したオブジェクトのポインタです。
+        KRSimulator2D::addCollisionPair() 関数の colID1 に指定された衝突検出IDを持つ図形です。
      */
     KRShape2D*  shape1;
 
     /*!
         @var shape2
         衝突した図形に対応したオブジェクトのポインタです。
+        KRSimulator2D::addCollisionPair() 関数の colID2 に指定された衝突検出IDを持つ図形です。
      */
     KRShape2D*  shape2;
+    
+    /*!
+        @var colID1
+        shape1 の衝突検出IDです。
+     */
+    unsigned    colID1;
+    
+    /*!
+        @var colID2
+        shape2 の衝突検出IDです。
+     */
+    unsigned    colID2;
+    
+    /*!
+        @var phase
+        衝突イベントの種類です。
+     */
+    KRCollisionPhase2D  phase;
+    
+    /*!
+        @var contactCount
+        contactPoints に格納されている接触点の数です。KRCollisionPhase2DEnd のイベントでは 0 になります。
+     */
+    int         contactCount;
+    
+    /*!
+        @var contactPoints
+        接触点の座標です。最大で KRCollisionInfo2DMaxContactCount 個まで格納されます。
+     */
+    KRVector2D  contactPoints[KRCollisionInfo2DMaxContactCount];
+    
+    /*!
+        @var normal
+        shape1 から shape2 に向かう接触面の法線ベクトルです。
+     */
+    KRVector2D  normal;
+    
+    /*!
+        @var normalImpulse
+        @abstract 接触を解決するために、法線方向に加えられた力積の大きさです（すべての接触点の合計）。
+        衝撃の強さの判定に利用できます。1回の step() で複数の固定ステップが実行された場合は、その中の最大値になります。
+     */
+    double      normalImpulse;
 } KRCollisionInfo2D;
 
 
+/*!
+    @struct KRRaycastHit2D
+    @group Game 2D Simulator
+    KRSimulator2D クラスの線分による検索で見つかった図形の情報を格納しておくための構造体です。
+ */
+typedef struct KRRaycastHit2D {
+    /*!
+        @var shape
+        線分が当たった図形に対応したオブジェクトのポインタです。何にも当たらなかった場合は NULL になります。
+     */
+    KRShape2D*  shape;
+    
+    /*!
+        @var point
+        線分が図形に当たった位置です。何にも当たらなかった場合は線分の終点になります。
+     */
+    KRVector2D  point;
+    
+    /*!
+        @var normal
+        線分が当たった位置での図形の表面の法線ベクトルです。
+     */
+    KRVector2D  normal;
+    
+    /*!
+        @var fraction
+        線分の始点から終点までを 0.0〜1.0 とした、当たった位置の割合です。
+     */
+    double      fraction;
+} KRRaycastHit2D;
+
+
 
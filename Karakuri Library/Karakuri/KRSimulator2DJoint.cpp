@@ -13,15 +13,15 @@
 
 
 KRJoint2D::KRJoint2D(KRShape2D* shape, const KRVector2D& anchor, const KRVector2D& staticAnchor)
-    : mConstraint(NULL), mRepresentedObject(NULL), mIsStatic(true), mShape1(shape), mShape2(NULL),
-      mAnchor1(anchor), mAnchor2(staticAnchor), mIsRemovedFromSpace(true), mTag(0)
+    : mRepresentedObject(NULL), mTag(0), mConstraint(NULL), mShape1(shape), mShape2(NULL),
+      mAnchor1(anchor), mAnchor2(staticAnchor), mIsStatic(true), mIsRemovedFromSpace(true)
 {
     // Do nothing
 }
 
 KRJoint2D::KRJoint2D(KRShape2D* shape1, const KRVector2D& anchor1,  KRShape2D* shape2, const KRVector2D& anchor2)
-    : mConstraint(NULL), mRepresentedObject(NULL), mIsStatic(false), mShape1(shape1),
-      mAnchor1(anchor1), mShape2(shape2), mAnchor2(anchor2), mIsRemovedFromSpace(true), mTag(0)
+    : mRepresentedObject(NULL), mTag(0), mConstraint(NULL), mShape1(shape1), mShape2(shape2),
+      mAnchor1(anchor1), mAnchor2(anchor2), mIsStatic(false), mIsRemovedFromSpace(true)
 {
     // Do nothing
 }
@@ -94,6 +94,11 @@ void KRJoint2D::removeFromSimulator() KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     mIsRemovedFromSpace = true;
 }
 
+void* KRJoint2D::getCPConstraint() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+{
+    return mConstraint;
+}
+
 std::string KRJoint2D::to_s() const
 {
     return "<joint2d>()";
@@ -123,6 +123,8 @@ public:
 public:
     virtual void    addToSimulator(KRSimulator2D* simulator) = 0 KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
     virtual void    removeFromSimulator() KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    
+    void*   getCPConstraint() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
 
 public:
     virtual std::string to_s() const;
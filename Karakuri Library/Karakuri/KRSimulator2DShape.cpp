@@ -15,7 +15,8 @@
 
 KRShape2D::KRShape2D()
     : mCPBody(NULL), mCPShape(NULL), mIsStatic(false), mMass(1.0), mElasticity(0.0), mFriction(1.0),
-      mIsRemovedFromSpace(true), mRepresentedObject(NULL), mSimulator(NULL), mCollisionID(0), mTag(0)
+      mPrevAngle(0.0), mSimulator(NULL), mCollisionID(0), mRepresentedObject(NULL), mTag(0),
+      mIsRemovedFromSpace(true)
 {
     // Nothing to do.
 }
@@ -30,6 +31,22 @@ bool KRShape2D::isStatic() const
     return mIsStatic;
 }
 
+bool KRShape2D::isSleeping() const
+{
+    if (mIsStatic || mCPBody == NULL) {
+        return false;
+    }
+    return cpBodyIsSleeping((cpBody*)mCPBody);
+}
+
+void KRShape2D::wakeUp()
+{
+    if (mIsStatic || mCPBody == NULL) {
+        return;
+    }
+    cpBodyActivate((cpBody*)mCPBody);
+}
+
 void KRShape2D::setStatic(bool flag)
 {
     mIsStatic = flag;
@@ -71,6 +88,32 @@ KRVector2D KRShape2D::getCenterPos() const
     return KRVector2D(((cpBody*)mCPBody)->p.x, ((cpBody*)mCPBody)->p.y);
 }
 
+KRVector2D KRShape2D::getInterpolatedCenterPos() const
+{
+    KRVector2D pos = getCenterPos();
+    if (mIsStatic || mSimulator == NULL) {
+        return pos;
+    }
+    double alpha = mSimulator->getInterpolationAlpha();
+    if (alpha >= 1.0) {
+        return pos;
+    }
+    return mPrevCenterPos + (pos - mPrevCenterPos) * alpha;
+}
+
+double KRShape2D::getInterpolatedAngle() const
+{
+    double angle = getAngle();
+    if (mIsStatic || mSimulator == NULL) {
+        return angle;
+    }
+    double alpha = mSimulator->getInterpolationAlpha();
+    if (alpha >= 1.0) {
+        return angle;
+    }
+    return mPrevAngle + (angle - mPrevAngle) * alpha;
+}
+
 double KRShape2D::getAngle() const
 {
     if (mIsStatic) {
@@ -100,7 +143,9 @@ void KRShape2D::setAngle(double angle)
     if (mIsStatic) {
         return;
     }
+    cpBodyActivate((cpBody*)mCPBody);
     cpBodySetAngle((cpBody*)mCPBody, angle);
+    mPrevAngle = angle;
 }
 
 void KRShape2D::setCenterPos(const KRVector2D& pos)
@@ -108,7 +153,9 @@ void KRShape2D::setCenterPos(const KRVector2D& pos)
     if (mIsStatic) {
         return;
     }
+    cpBodyActivate((cpBody*)mCPBody);
     cpBodySetPos((cpBody*)mCPBody, cpv(pos.x, pos.y));
+    mPrevCenterPos = pos;
 }
 
 void KRShape2D::setVelocity(const KRVector2D& v)
@@ -116,6 +163,7 @@ void KRShape2D::setVelocity(const KRVector2D& v)
     if (mIsStatic) {
         return;
     }
+    cpBodyActivate((cpBody*)mCPBody);
     cpBodySetVel((cpBody*)mCPBody, cpv(v.x, v.y));
 }
 
@@ -124,6 +172,7 @@ void KRShape2D::setAngleVelocity(double w)
     if (mIsStatic) {
         return;
     }
+    cpBodyActivate((cpBody*)mCPBody);
     cpBodySetAngVel((cpBody*)mCPBody, w);
 }
 
@@ -171,6 +220,7 @@ void KRShape2D::removeFromSimulator() KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
         mCPBody = NULL;
     }
     
+    mSimulator->_removeCollisionsOfShape(this);
     mSimulator = NULL;
     mIsRemovedFromSpace = true;
 }
@@ -180,6 +230,20 @@ void* KRShape2D::getCPBody() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     return mCPBody;
 }
 
+void* KRShape2D::getCPShape() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+{
+    return mCPShape;
+}
+
+void KRShape2D::_savePrevTransform() KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
+{
+    if (mIsStatic || mCPBody == NULL) {
+        return;
+    }
+    mPrevCenterPos = KRVector2D(((cpBody*)mCPBody)->p.x, ((cpBody*)mCPBody)->p.y);
+    mPrevAngle = ((cpBody*)mCPBody)->a;
+}
+
 std::string KRShape2D::to_s() const
 {
     return "<shape2d>()";
@@ -35,6 +35,9 @@ protected:
     double      mFriction;
     KRVector2D  mCenterPos;
     
+    KRVector2D  mPrevCenterPos;
+    double      mPrevAngle;
+    
     KRSimulator2D*  mSimulator;
     
     unsigned    mCollisionID;
@@ -73,6 +76,20 @@ public:
      */
     KRVector2D  getCenterPos() const;
     
+    /*!
+        @method getInterpolatedAngle
+        @abstract 描画に使うための、直前の2回の固定ステップの間で補間された角度を取得します。
+        シミュレータが固定ステップで実行されていない場合は、getAngle() 関数と同じ値をリターンします。
+     */
+    double      getInterpolatedAngle() const;
+    
+    /*!
+        @method getInterpolatedCenterPos
+        @abstract 描画に使うための、直前の2回の固定ステップの間で補間された中心位置を取得します。
+        シミュレータが固定ステップで実行されていない場合は、getCenterPos() 関数と同じ値をリターンします。
+     */
+    KRVector2D  getInterpolatedCenterPos() const;
+    
     /*!
         @method getSimulator
         この図形が追加されているシミュレータを取得します。
@@ -91,6 +108,20 @@ public:
      */
     bool    isStatic() const;
     
+    /*!
+        @method isSleeping
+        @abstract この図形がスリープしているかどうかをリターンします。
+        スリープについては KRSimulator2D::setSleepTimeThreshold() 関数を参照してください。
+     */
+    bool    isSleeping() const;
+    
+    /*!
+        @method wakeUp
+        @abstract この図形がスリープしている場合、接触やジョイントでつながった図形と一緒に起こします。
+        setVelocity() 関数などで状態を設定した場合は、自動的に起こされます。
+     */
+    void    wakeUp();
+    
     /*!
         @task 図形の設定管理のための関数
      */
@@ -133,7 +164,8 @@ public:
     
     /*!
         @method setVelocity
-        この図形の移動速度を設定します。
+        @abstract この図形の移動速度を設定します。
+        図形がスリープしている場合は、起こされます。
      */
     void    setVelocity(const KRVector2D& v);
     
@@ -192,6 +224,8 @@ public:
     virtual void    removeFromSimulator() KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
     
     void*   getCPBody() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    void*   getCPShape() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+    void    _savePrevTransform() KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
 
 public:
     virtual std::string to_s() const;
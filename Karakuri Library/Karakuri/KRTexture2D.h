@@ -18,7 +18,7 @@ class _KRFont;
 struct _KRTexture2DDrawData {
     GLshort vertex_x, vertex_y;
     GLfloat texCoords_x, texCoords_y;
-    GLubyte colors[4];
+    _KRPackedColor  color;
 };
 
 
@@ -37,6 +37,7 @@ private:
     GLenum      mTextureTarget;
     KRVector2D  mImageSize;         //!< The actual size of the image.
     KRVector2D  mTextureSize;       //!< Full size of the area used as a texture. （サイズが2の乗数になっていない場合のサイズ割合）
+    size_t      mEstimatedBytes;    //!< KRMemoryStats に報告した GPU 上のバイト数
     
 public:
     static int  getResourceSize(const std::string& filename);
@@ -99,12 +100,15 @@ public:
      */
     void    drawAtPoint(const KRVector2D& pos, const KRColor& color);
     void    drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect, double rotate, const KRVector2D& origin, const KRVector2D& scale, const KRColor& color);
+    void    drawAtPointEx(const KRVector2Df& pos, const KRRect2Df& srcRect, float rotate, const KRVector2Df& origin, const KRVector2Df& scale, const _KRPackedColor& color);
     
     void    drawAtPointCenter(const KRVector2D& centerPos, const KRColor& color);
     void    drawAtPointCenterEx(const KRVector2D& centerPos, const KRRect2D& srcRect, double rotate, const KRVector2D& scale, const KRColor& color);
+    void    drawAtPointCenterEx(const KRVector2Df& centerPos, const KRRect2Df& srcRect, float rotate, const KRVector2Df& scale, const _KRPackedColor& color);
 
     void    drawInRect(const KRRect2D& destRect, const KRColor& color);
     void    drawInRect(const KRRect2D& destRect, const KRRect2D& srcRect, const KRColor& color);
+    void    drawInRect(const KRRect2Df& destRect, const KRRect2Df& srcRect, const _KRPackedColor& color);
     
 public:
     GLuint  getTextureName() const KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
@@ -113,6 +117,9 @@ public:
 public:
     static void processBatchedTexture2DDraws() KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
 
+private:
+    void    addToMemoryStats(int bitsPerPixel);
+
 #pragma mark -
 #pragma mark Debug Support
 
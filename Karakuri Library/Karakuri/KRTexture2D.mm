@@ -14,6 +14,7 @@
 #include "KRPNGLoader.h"
 #include "KRTexture2DAtlas.h"
 #include "KarakuriGlobals.h"
+#include "KRMemoryStats.h"
 
 
 const int _gKRTexture2DBatchSize = 1024;    // KRTexture2DBatchSize * 16 bytes will be used.
@@ -82,7 +83,8 @@ _KRTexture2D::_KRTexture2D(const std::string& filename, KRTexture2DScaleMode sca
 
     mFileName = filename;
     NSString* filenameStr = [[NSString alloc] initWithCString:filename.c_str() encoding:NSUTF8StringEncoding];
-    mTextureName = KRCreateGLTextureFromImageWithName(filenameStr, &mImageSize, &mTextureSize, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
+    int bitsPerPixel = 32;
+    mTextureName = KRCreateGLTextureFromImageWithName(filenameStr, &mImageSize, &mTextureSize, &bitsPerPixel, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
     [filenameStr release];
 
     if (mTextureName == GL_INVALID_VALUE || mTextureName == GL_INVALID_OPERATION) {
@@ -94,6 +96,8 @@ _KRTexture2D::_KRTexture2D(const std::string& filename, KRTexture2DScaleMode sca
     }
 
     _KRTexture2DName = GL_INVALID_VALUE;
+    
+    addToMemoryStats(bitsPerPixel);
 }
 
 _KRTexture2D::_KRTexture2D(const std::string& resourceFileName, unsigned startPos, unsigned length, KRTexture2DScaleMode scaleMode)
@@ -110,9 +114,10 @@ _KRTexture2D::_KRTexture2D(const std::string& resourceFileName, unsigned startPo
     NSData* data = [[NSData alloc] initWithContentsOfMappedFile:filepath];
     NSData* imageData = [data subdataWithRange:NSMakeRange(startPos, length)];
     
-    mTextureName = KRCreatePNGGLTextureFromImageData(imageData, &mImageSize, &mTextureSize, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
+    int bitsPerPixel = 32;
+    mTextureName = KRCreatePNGGLTextureFromImageData(imageData, &mImageSize, &mTextureSize, &bitsPerPixel, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
     if (mTextureName == GL_INVALID_VALUE) {
-        mTextureName = KRCreateGLTextureFromImageData(imageData, &mImageSize, &mTextureSize, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
+        mTextureName = KRCreateGLTextureFromImageData(imageData, &mImageSize, &mTextureSize, &bitsPerPixel, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
     }
     
     [data release];
@@ -127,6 +132,8 @@ _KRTexture2D::_KRTexture2D(const std::string& resourceFileName, unsigned startPo
     }
     
     _KRTexture2DName = GL_INVALID_VALUE;
+    
+    addToMemoryStats(bitsPerPixel);
 }
 
 _KRTexture2D::_KRTexture2D(const std::string& str, _KRFont* font)
@@ -136,7 +143,8 @@ _KRTexture2D::_KRTexture2D(const std::string& str, _KRFont* font)
     }
     
     NSString* strStr = [[NSString alloc] initWithCString:str.c_str() encoding:NSUTF8StringEncoding];
-    mTextureName = KRCreateGLTextureFromString(strStr, font->getFontObject(), KRColor::White, &mTextureTarget, &mImageSize, &mTextureSize);
+    int bitsPerPixel = 32;
+    mTextureName = KRCreateGLTextureFromString(strStr, font->getFontObject(), KRColor::White, &mTextureTarget, &mImageSize, &mTextureSize, &bitsPerPixel);
     [strStr release];
     if (mTextureName == GL_INVALID_VALUE || mTextureName == GL_INVALID_OPERATION) {
         const char* errorFormat = "Failed to create a texture for a string: \"%s\"";
@@ -146,6 +154,8 @@ _KRTexture2D::_KRTexture2D(const std::string& str, _KRFont* font)
         throw KRRuntimeError(errorFormat, str.c_str());
     }
     _KRTexture2DName = GL_INVALID_VALUE;
+    
+    addToMemoryStats(bitsPerPixel);
 }
 
 _KRTexture2D::~_KRTexture2D()
@@ -154,6 +164,18 @@ _KRTexture2D::~_KRTexture2D()
         _KRTexture2DName = GL_INVALID_VALUE;
     }
     glDeleteTextures(1, &mTextureName);
+    
+    KRMemoryStats::_remove(KRMemoryCategoryTexture, mEstimatedBytes, 1);
+}
+
+void _KRTexture2D::addToMemoryStats(int bitsPerPixel)
+{
+    // mTextureSize は画像が占める割合なので、そこから2のべき乗に広げたテクスチャ全体のサイズを求める。
+    double width = (mTextureSize.x > 0.0)? mImageSize.x / mTextureSize.x: mImageSize.x;
+    double height = (mTextureSize.y > 0.0)? mImageSize.y / mTextureSize.y: mImageSize.y;
+    mEstimatedBytes = (size_t)((int)(width + 0.5) * (int)(height + 0.5)) * bitsPerPixel / 8;
+    
+    KRMemoryStats::_add(KRMemoryCategoryTexture, mEstimatedBytes, 1);
 }
 
 
@@ -189,7 +211,12 @@ void _KRTexture2D::drawAtPoint(const KRVector2D& pos, const KRColor& color)
     drawAtPointEx(pos, KRRect2DZero, 0.0, KRVector2DZero, KRVector2DOne, color);
 }
 
-void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect, double rotate, const KRVector2D& origin_, const KRVector2D& scale, const KRColor& color)
+void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect, double rotate, const KRVector2D& origin, const KRVector2D& scale, const KRColor& color)
+{
+    drawAtPointEx(KRVector2Df(pos), KRRect2Df(srcRect), (float)rotate, KRVector2Df(origin), KRVector2Df(scale), _KRPackedColor(color));
+}
+
+void _KRTexture2D::drawAtPointEx(const KRVector2Df& pos, const KRRect2Df& srcRect, float rotate, const KRVector2Df& origin_, const KRVector2Df& scale, const _KRPackedColor& color)
 {
     if (_KRTexture2DName != mTextureName) {
         processBatchedTexture2DDraws();
@@ -208,20 +235,23 @@ void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect,
 #endif
     }
     
-    KRVector2D origin = KRVector2D(mImageSize.x * origin_.x, mImageSize.y * origin_.y);
+    KRVector2Df imageSize(mImageSize);
+    KRVector2Df textureSize(mTextureSize);
+    
+    KRVector2Df origin(imageSize.x * origin_.x, imageSize.y * origin_.y);
     
-    KRRect2D theSrcRect = srcRect;
-    if (theSrcRect.width == 0.0 && theSrcRect.height == 0.0) {
-        theSrcRect.x = 0;
-        theSrcRect.y = 0;
-        theSrcRect.width = mImageSize.x;
-        theSrcRect.height = mImageSize.y;
+    KRRect2Df theSrcRect = srcRect;
+    if (theSrcRect.width == 0.0f && theSrcRect.height == 0.0f) {
+        theSrcRect.x = 0.0f;
+        theSrcRect.y = 0.0f;
+        theSrcRect.width = imageSize.x;
+        theSrcRect.height = imageSize.y;
     }
 
-    float texX = (theSrcRect.x / mImageSize.x) * mTextureSize.x;
-    float texY = (theSrcRect.y / mImageSize.y) * mTextureSize.y;
-    float texWidth = (theSrcRect.width / mImageSize.x) * mTextureSize.x;
-    float texHeight = (theSrcRect.height / mImageSize.y) * mTextureSize.y;
+    float texX = (theSrcRect.x / imageSize.x) * textureSize.x;
+    float texY = (theSrcRect.y / imageSize.y) * textureSize.y;
+    float texWidth = (theSrcRect.width / imageSize.x) * textureSize.x;
+    float texHeight = (theSrcRect.height / imageSize.y) * textureSize.y;
 
     float p1_x = 0.0f;
     float p2_x = theSrcRect.width;
@@ -234,13 +264,13 @@ void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect,
     float p4_y = 0.0f;
     
     // Scale the 4 coord points
-    if (scale.x != 1.0) {
+    if (scale.x != 1.0f) {
         p1_x *= scale.x;
         p2_x *= scale.x;
         p3_x *= scale.x;
         p4_x *= scale.x;
     }
-    if (scale.y != 1.0) {
+    if (scale.y != 1.0f) {
         p1_y *= scale.y;
         p2_y *= scale.y;
         p3_y *= scale.y;
@@ -248,13 +278,13 @@ void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect,
     }
     
     // Translate the 4 coord points according to the origin
-    if (origin.x != 0.0) {
+    if (origin.x != 0.0f) {
         p1_x -= origin.x * scale.x;
         p2_x -= origin.x * scale.x;
         p3_x -= origin.x * scale.x;
         p4_x -= origin.x * scale.x;
     }
-    if (origin.y != 0.0) {
+    if (origin.y != 0.0f) {
         p1_y -= origin.y * scale.y;
         p2_y -= origin.y * scale.y;
         p3_y -= origin.y * scale.y;
@@ -262,9 +292,9 @@ void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect,
     }
     
     // Rotate the 4 coord points
-    if (rotate != 0.0) {
-        double cos_value = cos(rotate);
-        double sin_value = sin(rotate);
+    if (rotate != 0.0f) {
+        float cos_value = cosf(rotate);
+        float sin_value = sinf(rotate);
         float p1_x2 = p1_x * cos_value - p1_y * sin_value;
         float p2_x2 = p2_x * cos_value - p2_y * sin_value;
         float p3_x2 = p3_x * cos_value - p3_y * sin_value;
@@ -286,13 +316,13 @@ void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect,
         p4_y = p4_y2;
     }
     
-    if (origin.x != 0.0) {
+    if (origin.x != 0.0f) {
         p1_x += origin.x * scale.x;
         p2_x += origin.x * scale.x;
         p3_x += origin.x * scale.x;
         p4_x += origin.x * scale.x;
     }
-    if (origin.y != 0.0) {
+    if (origin.y != 0.0f) {
         p1_y += origin.y * scale.y;
         p2_y += origin.y * scale.y;
         p3_y += origin.y * scale.y;
@@ -332,37 +362,12 @@ void _KRTexture2D::drawAtPointEx(const KRVector2D& pos, const KRRect2D& srcRect,
     _gKRTexture2DDrawData[batchPos+4].texCoords_x = tx_1;    _gKRTexture2DDrawData[batchPos+4].texCoords_y = ty_1;
     _gKRTexture2DDrawData[batchPos+5].texCoords_x = tx_2;    _gKRTexture2DDrawData[batchPos+5].texCoords_y = ty_1;
     
-    _gKRTexture2DDrawData[batchPos].colors[0] =
-    _gKRTexture2DDrawData[batchPos+1].colors[0] =
-    _gKRTexture2DDrawData[batchPos+2].colors[0] =
-    _gKRTexture2DDrawData[batchPos+3].colors[0] =
-    _gKRTexture2DDrawData[batchPos+4].colors[0] =
-    _gKRTexture2DDrawData[batchPos+5].colors[0] =
-    (GLubyte)(255 * color.r);
-    
-    _gKRTexture2DDrawData[batchPos].colors[1] =
-    _gKRTexture2DDrawData[batchPos+1].colors[1] =
-    _gKRTexture2DDrawData[batchPos+2].colors[1] =
-    _gKRTexture2DDrawData[batchPos+3].colors[1] =
-    _gKRTexture2DDrawData[batchPos+4].colors[1] =
-    _gKRTexture2DDrawData[batchPos+5].colors[1] =
-    (GLubyte)(255 * color.g);
-    
-    _gKRTexture2DDrawData[batchPos].colors[2] =
-    _gKRTexture2DDrawData[batchPos+1].colors[2] =
-    _gKRTexture2DDrawData[batchPos+2].colors[2] =
-    _gKRTexture2DDrawData[batchPos+3].colors[2] =
-    _gKRTexture2DDrawData[batchPos+4].colors[2] =
-    _gKRTexture2DDrawData[batchPos+5].colors[2] =
-    (GLubyte)(255 * color.b);
-    
-    _gKRTexture2DDrawData[batchPos].colors[3] =
-    _gKRTexture2DDrawData[batchPos+1].colors[3] =
-    _gKRTexture2DDrawData[batchPos+2].colors[3] =
-    _gKRTexture2DDrawData[batchPos+3].colors[3] =
-    _gKRTexture2DDrawData[batchPos+4].colors[3] =
-    _gKRTexture2DDrawData[batchPos+5].colors[3] =
-    (GLubyte)(255 * color.a);
+    _gKRTexture2DDrawData[batchPos].color = color;
+    _gKRTexture2DDrawData[batchPos+1].color = color;
+    _gKRTexture2DDrawData[batchPos+2].color = color;
+    _gKRTexture2DDrawData[batchPos+3].color = color;
+    _gKRTexture2DDrawData[batchPos+4].color = color;
+    _gKRTexture2DDrawData[batchPos+5].color = color;
     
     _gKRTexture2DBatchCount++;
     
@@ -378,13 +383,20 @@ void _KRTexture2D::drawAtPointCenter(const KRVector2D& centerPos, const KRColor&
 
 void _KRTexture2D::drawAtPointCenterEx(const KRVector2D& centerPos, const KRRect2D& srcRect, double rotate, const KRVector2D& scale, const KRColor& color)
 {
-    KRVector2D theSize = srcRect.getSize();
-    if (theSize.x == 0.0 || theSize.y == 0.0) {
-        theSize = getSize();
+    drawAtPointCenterEx(KRVector2Df(centerPos), KRRect2Df(srcRect), (float)rotate, KRVector2Df(scale), _KRPackedColor(color));
+}
+
+void _KRTexture2D::drawAtPointCenterEx(const KRVector2Df& centerPos, const KRRect2Df& srcRect, float rotate, const KRVector2Df& scale, const _KRPackedColor& color)
+{
+    KRVector2Df imageSize(mImageSize);
+    KRVector2Df textureSize(mTextureSize);
+    
+    KRVector2Df theSize(srcRect.width, srcRect.height);
+    if (theSize.x == 0.0f || theSize.y == 0.0f) {
+        theSize = imageSize;
     }
     theSize.x *= scale.x;
     theSize.y *= scale.y;
-    KRVector2D pos = centerPos - theSize / 2;
 
     if (_KRTexture2DName != mTextureName) {
         processBatchedTexture2DDraws();
@@ -403,21 +415,21 @@ void _KRTexture2D::drawAtPointCenterEx(const KRVector2D& centerPos, const KRRect
 #endif
     }
     
-    KRVector2D origin = KRVector2D(theSize.x / scale.x / 2, theSize.y / scale.y / 2);
+    KRVector2Df origin(theSize.x / scale.x / 2, theSize.y / scale.y / 2);
 
-    KRRect2D theSrcRect = srcRect;
-    if (theSrcRect.width == 0.0 && theSrcRect.height == 0.0) {
-        theSrcRect.x = 0;
-        theSrcRect.y = 0;
-        theSrcRect.width = mImageSize.x;
-        theSrcRect.height = mImageSize.y;
+    KRRect2Df theSrcRect = srcRect;
+    if (theSrcRect.width == 0.0f && theSrcRect.height == 0.0f) {
+        theSrcRect.x = 0.0f;
+        theSrcRect.y = 0.0f;
+        theSrcRect.width = imageSize.x;
+        theSrcRect.height = imageSize.y;
     }
-    theSrcRect.y = mImageSize.y - theSrcRect.y;
+    theSrcRect.y = imageSize.y - theSrcRect.y;
     
-    float texX = (theSrcRect.x / mImageSize.x) * mTextureSize.x;
-    float texY = (theSrcRect.y / mImageSize.y) * mTextureSize.y;
-    float texWidth = (theSrcRect.width / mImageSize.x) * mTextureSize.x;
-    float texHeight = (theSrcRect.height / mImageSize.y) * mTextureSize.y * -1;
+    float texX = (theSrcRect.x / imageSize.x) * textureSize.x;
+    float texY = (theSrcRect.y / imageSize.y) * textureSize.y;
+    float texWidth = (theSrcRect.width / imageSize.x) * textureSize.x;
+    float texHeight = (theSrcRect.height / imageSize.y) * textureSize.y * -1;
     
     float p1_x = 0.0f;
     float p2_x = theSrcRect.width;
@@ -430,13 +442,13 @@ void _KRTexture2D::drawAtPointCenterEx(const KRVector2D& centerPos, const KRRect
     float p4_y = 0.0f;
     
     // Scale the 4 coord points
-    if (scale.x != 1.0) {
+    if (scale.x != 1.0f) {
         p1_x *= scale.x;
         p2_x *= scale.x;
         p3_x *= scale.x;
         p4_x *= scale.x;
     }
-    if (scale.y != 1.0) {
+    if (scale.y != 1.0f) {
         p1_y *= scale.y;
         p2_y *= scale.y;
         p3_y *= scale.y;
@@ -444,13 +456,13 @@ void _KRTexture2D::drawAtPointCenterEx(const KRVector2D& centerPos, const KRRect
     }
     
     // Translate the 4 coord points according to the origin
-    if (origin.x != 0.0) {
+    if (origin.x != 0.0f) {
         p1_x -= origin.x * scale.x;
         p2_x -= origin.x * scale.x;
         p3_x -= origin.x * scale.x;
         p4_x -= origin.x * scale.x;
     }
-    if (origin.y != 0.0) {
+    if (origin.y != 0.0f) {
         p1_y -= origin.y * scale.y;
         p2_y -= origin.y * scale.y;
         p3_y -= origin.y * scale.y;
@@ -458,9 +470,9 @@ void _KRTexture2D::drawAtPointCenterEx(const KRVector2D& centerPos, const KRRect
     }
     
     // Rotate the 4 coord points
-    if (rotate != 0.0) {
-        double cos_value = cos(rotate);
-        double sin_value = sin(rotate);
+    if (rotate != 0.0f) {
+        float cos_value = cosf(rotate);
+        float sin_value = sinf(rotate);
         float p1_x2 = p1_x * cos_value - p1_y * sin_value;
         float p2_x2 = p2_x * cos_value - p2_y * sin_value;
         float p3_x2 = p3_x * cos_value - p3_y * sin_value;
@@ -515,37 +527,12 @@ void _KRTexture2D::drawAtPointCenterEx(const KRVector2D& centerPos, const KRRect
     _gKRTexture2DDrawData[batchPos+4].texCoords_x = tx_1;    _gKRTexture2DDrawData[batchPos+4].texCoords_y = ty_1;
     _gKRTexture2DDrawData[batchPos+5].texCoords_x = tx_2;    _gKRTexture2DDrawData[batchPos+5].texCoords_y = ty_1;
     
-    _gKRTexture2DDrawData[batchPos].colors[0] =
-    _gKRTexture2DDrawData[batchPos+1].colors[0] =
-    _gKRTexture2DDrawData[batchPos+2].colors[0] =
-    _gKRTexture2DDrawData[batchPos+3].colors[0] =
-    _gKRTexture2DDrawData[batchPos+4].colors[0] =
-    _gKRTexture2DDrawData[batchPos+5].colors[0] =
-        (GLubyte)(255 * color.r);
-    
-    _gKRTexture2DDrawData[batchPos].colors[1] =
-    _gKRTexture2DDrawData[batchPos+1].colors[1] =
-    _gKRTexture2DDrawData[batchPos+2].colors[1] =
-    _gKRTexture2DDrawData[batchPos+3].colors[1] =
-    _gKRTexture2DDrawData[batchPos+4].colors[1] =
-    _gKRTexture2DDrawData[batchPos+5].colors[1] =
-        (GLubyte)(255 * color.g);
-    
-    _gKRTexture2DDrawData[batchPos].colors[2] =
-    _gKRTexture2DDrawData[batchPos+1].colors[2] =
-    _gKRTexture2DDrawData[batchPos+2].colors[2] =
-    _gKRTexture2DDrawData[batchPos+3].colors[2] =
-    _gKRTexture2DDrawData[batchPos+4].colors[2] =
-    _gKRTexture2DDrawData[batchPos+5].colors[2] =
-        (GLubyte)(255 * color.b);
-    
-    _gKRTexture2DDrawData[batchPos].colors[3] =
-    _gKRTexture2DDrawData[batchPos+1].colors[3] =
-    _gKRTexture2DDrawData[batchPos+2].colors[3] =
-    _gKRTexture2DDrawData[batchPos+3].colors[3] =
-    _gKRTexture2DDrawData[batchPos+4].colors[3] =
-    _gKRTexture2DDrawData[batchPos+5].colors[3] =
-        (GLubyte)(255 * color.a);
+    _gKRTexture2DDrawData[batchPos].color = color;
+    _gKRTexture2DDrawData[batchPos+1].color = color;
+    _gKRTexture2DDrawData[batchPos+2].color = color;
+    _gKRTexture2DDrawData[batchPos+3].color = color;
+    _gKRTexture2DDrawData[batchPos+4].color = color;
+    _gKRTexture2DDrawData[batchPos+5].color = color;
     
     _gKRTexture2DBatchCount++;
     
@@ -560,6 +547,11 @@ void _KRTexture2D::drawInRect(const KRRect2D& destRect, const KRColor& color)
 }
 
 void _KRTexture2D::drawInRect(const KRRect2D& destRect, const KRRect2D& srcRect, const KRColor& color)
+{
+    drawInRect(KRRect2Df(destRect), KRRect2Df(srcRect), _KRPackedColor(color));
+}
+
+void _KRTexture2D::drawInRect(const KRRect2Df& destRect, const KRRect2Df& srcRect, const _KRPackedColor& color)
 {
     if (_KRTexture2DName != mTextureName) {
         processBatchedTexture2DDraws();
@@ -578,19 +570,22 @@ void _KRTexture2D::drawInRect(const KRRect2D& destRect, const KRRect2D& srcRect,
 #endif
     }
     
-    KRRect2D theSrcRect = srcRect;
-    if (theSrcRect.width == 0.0 || theSrcRect.height == 0.0) {
-        theSrcRect.x = 0.0;
-        theSrcRect.y = 0.0;
-        theSrcRect.width = mImageSize.x;
-        theSrcRect.height = mImageSize.y;
+    KRVector2Df imageSize(mImageSize);
+    KRVector2Df textureSize(mTextureSize);
+    
+    KRRect2Df theSrcRect = srcRect;
+    if (theSrcRect.width == 0.0f || theSrcRect.height == 0.0f) {
+        theSrcRect.x = 0.0f;
+        theSrcRect.y = 0.0f;
+        theSrcRect.width = imageSize.x;
+        theSrcRect.height = imageSize.y;
     }
-    theSrcRect.y = mImageSize.y - theSrcRect.y;
+    theSrcRect.y = imageSize.y - theSrcRect.y;
     
-    float texX = (theSrcRect.x / mImageSize.x) * mTextureSize.x;
-    float texY = (theSrcRect.y / mImageSize.y) * mTextureSize.y;
-    float texWidth = (theSrcRect.width / mImageSize.x) * mTextureSize.x;
-    float texHeight = (theSrcRect.height / mImageSize.y) * mTextureSize.y * -1;
+    float texX = (theSrcRect.x / imageSize.x) * textureSize.x;
+    float texY = (theSrcRect.y / imageSize.y) * textureSize.y;
+    float texWidth = (theSrcRect.width / imageSize.x) * textureSize.x;
+    float texHeight = (theSrcRect.height / imageSize.y) * textureSize.y * -1;
     
     short p1_x = destRect.x;
     short p2_x = destRect.x + destRect.width;
@@ -624,37 +619,12 @@ void _KRTexture2D::drawInRect(const KRRect2D& destRect, const KRRect2D& srcRect,
     _gKRTexture2DDrawData[batchPos+4].texCoords_x = tx_1;    _gKRTexture2DDrawData[batchPos+4].texCoords_y = ty_1;
     _gKRTexture2DDrawData[batchPos+5].texCoords_x = tx_2;    _gKRTexture2DDrawData[batchPos+5].texCoords_y = ty_1;
     
-    _gKRTexture2DDrawData[batchPos].colors[0] =
-    _gKRTexture2DDrawData[batchPos+1].colors[0] =
-    _gKRTexture2DDrawData[batchPos+2].colors[0] =
-    _gKRTexture2DDrawData[batchPos+3].colors[0] =
-    _gKRTexture2DDrawData[batchPos+4].colors[0] =
-    _gKRTexture2DDrawData[batchPos+5].colors[0] =
-        (GLubyte)(255 * color.r);
-    
-    _gKRTexture2DDrawData[batchPos].colors[1] =
-    _gKRTexture2DDrawData[batchPos+1].colors[1] =
-    _gKRTexture2DDrawData[batchPos+2].colors[1] =
-    _gKRTexture2DDrawData[batchPos+3].colors[1] =
-    _gKRTexture2DDrawData[batchPos+4].colors[1] =
-    _gKRTexture2DDrawData[batchPos+5].colors[1] =
-        (GLubyte)(255 * color.g);
-    
-    _gKRTexture2DDrawData[batchPos].colors[2] =
-    _gKRTexture2DDrawData[batchPos+1].colors[2] =
-    _gKRTexture2DDrawData[batchPos+2].colors[2] =
-    _gKRTexture2DDrawData[batchPos+3].colors[2] =
-    _gKRTexture2DDrawData[batchPos+4].colors[2] =
-    _gKRTexture2DDrawData[batchPos+5].colors[2] =
-        (GLubyte)(255 * color.b);
-    
-    _gKRTexture2DDrawData[batchPos].colors[3] =
-    _gKRTexture2DDrawData[batchPos+1].colors[3] =
-    _gKRTexture2DDrawData[batchPos+2].colors[3] =
-    _gKRTexture2DDrawData[batchPos+3].colors[3] =
-    _gKRTexture2DDrawData[batchPos+4].colors[3] =
-    _gKRTexture2DDrawData[batchPos+5].colors[3] =
-        (GLubyte)(255 * color.a);
+    _gKRTexture2DDrawData[batchPos].color = color;
+    _gKRTexture2DDrawData[batchPos+1].color = color;
+    _gKRTexture2DDrawData[batchPos+2].color = color;
+    _gKRTexture2DDrawData[batchPos+3].color = color;
+    _gKRTexture2DDrawData[batchPos+4].color = color;
+    _gKRTexture2DDrawData[batchPos+5].color = color;
     
     _gKRTexture2DBatchCount++;
     
@@ -13,8 +13,8 @@
 #include <Karakuri/KRColor.h>
 
 
-GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear=NO) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
-GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear=NO) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear=NO) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear=NO) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
 
-GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor& color, GLenum* textureTarget, KRVector2D* imageSize, KRVector2D* textureSize) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
+GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor& color, GLenum* textureTarget, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel) KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY;
 
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <Karakuri/Karakuri.h>
+#include <Karakuri/KRIDTable.h>
 
 
 struct _KRTexture2DResourceInfo {
@@ -30,13 +31,14 @@ struct _KRTexture2DResourceInfo {
 class KRTexture2DManager : public KRObject {
 
     std::map<int, std::vector<int> >    mGroupID_TexIDList_Map;
-    std::map<int, std::string>          mTexID_ImageFileName_Map;
-    std::map<int, KRTexture2DScaleMode> mTexID_ScaleMode_Map;
+    _KRIDTable<std::string>             mTexID_ImageFileName_Map;
+    _KRIDTable<KRTexture2DScaleMode>    mTexID_ScaleMode_Map;
     std::map<int, bool>                 mGroupID_Loaded_Map;
     
-    std::map<int, _KRTexture2DResourceInfo>     mTexID_ResourceInfo_Map;
+    _KRIDTable<_KRTexture2DResourceInfo>    mTexID_ResourceInfo_Map;
     
-    std::map<int, _KRTexture2D*>        mTexMap;
+    // 描画のたびに引かれるので、テクスチャIDを添字にした表で持つ。
+    _KRIDTable<_KRTexture2D*>           mTexMap;
 
     int         mNextNewTexID;
 
@@ -73,9 +73,9 @@ int KRTexture2DManager::_getResourceSizeInGroup(int groupID)
 
         int resourceSize;
         if (texID >= 1000) {
-            resourceSize = mTexID_ResourceInfo_Map[texID].length;
+            resourceSize = mTexID_ResourceInfo_Map.get(texID).length;
         } else {
-            std::string filename = mTexID_ImageFileName_Map[texID];
+            std::string filename = mTexID_ImageFileName_Map.get(texID);
             resourceSize = _KRTexture2D::getResourceSize(filename);
         }
         ret += resourceSize;
@@ -103,9 +103,9 @@ void KRTexture2DManager::_loadTextureFilesInGroup(int groupID, KRWorld* loaderWo
 
         int resourceSize;
         if (texID >= 1000) {
-            resourceSize = mTexID_ResourceInfo_Map[texID].length;
+            resourceSize = mTexID_ResourceInfo_Map.get(texID).length;
         } else {
-            std::string filename = mTexID_ImageFileName_Map[texID];
+            std::string filename = mTexID_ImageFileName_Map.get(texID);
             resourceSize = _KRTexture2D::getResourceSize(filename);
         }
         allResourceSize += resourceSize;
@@ -118,10 +118,10 @@ void KRTexture2DManager::_loadTextureFilesInGroup(int groupID, KRWorld* loaderWo
         // リソースサイズの取得
         int resourceSize;
         if (texID >= 1000) {
-            resourceSize = mTexID_ResourceInfo_Map[texID].length;
+            resourceSize = mTexID_ResourceInfo_Map.get(texID).length;
             //printf("   KRRS: %d\n", texID);
         } else {
-            std::string filename = mTexID_ImageFileName_Map[texID];
+            std::string filename = mTexID_ImageFileName_Map.get(texID);
             resourceSize = _KRTexture2D::getResourceSize(filename);
             //printf("   file: %s(%d)\n", filename.c_str(), texID);
         }
@@ -135,13 +135,13 @@ void KRTexture2DManager::_loadTextureFilesInGroup(int groupID, KRWorld* loaderWo
         }
         
         NSTimeInterval startTime = [NSDate timeIntervalSinceReferenceDate];
-        if (mTexMap[texID] == NULL) {
+        if (!mTexMap.contains(texID)) {
             if (texID >= 1000) {
-                _KRTexture2DResourceInfo info = mTexID_ResourceInfo_Map[texID];
+                _KRTexture2DResourceInfo info = mTexID_ResourceInfo_Map.get(texID);
                 mTexMap[texID] = new _KRTexture2D(info.file_name, info.start_pos, info.length, info.scale_mode);
             } else {
-                KRTexture2DScaleMode scaleMode = mTexID_ScaleMode_Map[texID];
-                std::string filename = mTexID_ImageFileName_Map[texID];
+                KRTexture2DScaleMode scaleMode = mTexID_ScaleMode_Map.get(texID);
+                std::string filename = mTexID_ImageFileName_Map.get(texID);
                 mTexMap[texID] = new _KRTexture2D(filename, scaleMode);
             }
         }
@@ -183,9 +183,10 @@ void KRTexture2DManager::_unloadTextureFilesInGroup(int groupID)
     for (std::vector<int>::const_iterator it = theTexIDList.begin(); it != theTexIDList.end(); it++) {
         int texID = *it;
         //printf("  Deleting %d...\n", texID);
-        if (mTexMap[texID] != NULL) {
-            delete mTexMap[texID];
-            mTexMap[texID] = NULL;
+        _KRTexture2D* theTexture = mTexMap.get(texID);
+        if (theTexture != NULL) {
+            delete theTexture;
+            mTexMap.erase(texID);
         }
     }
     
@@ -194,9 +195,8 @@ void KRTexture2DManager::_unloadTextureFilesInGroup(int groupID)
 
 _KRTexture2D* KRTexture2DManager::_getTexture(int texID)
 {
-    _KRTexture2D* ret = mTexMap[texID];
-
-    if (ret == NULL) {
+    // 登録されていない ID でも要素は追加されない。
+    if (!mTexMap.contains(texID)) {
         const char* errorFormat = "Texture is not loaded with ID %d.";
         if (gKRLanguage == KRLanguageJapanese) {
             errorFormat = "ID が %d のテクスチャはロードされていません。";
@@ -204,7 +204,7 @@ _KRTexture2D* KRTexture2DManager::_getTexture(int texID)
         throw KRRuntimeError(errorFormat, texID);
     }
 
-    return mTexMap[texID];
+    return mTexMap.get(texID);
 }
 
 KRVector2D KRTexture2DManager::getTextureSize(int texID)
@@ -33,7 +33,8 @@ KRTexture2D::KRTexture2D(const std::string& filename, KRTexture2DScaleMode scale
 
     mFileName = filename;
     NSString* filenameStr = [[NSString alloc] initWithCString:filename.c_str() encoding:NSUTF8StringEncoding];
-    mTextureName = KRCreateGLTextureFromImageWithName(filenameStr, &mImageSize, &mTextureSize, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
+    int bitsPerPixel = 32;
+    mTextureName = KRCreateGLTextureFromImageWithName(filenameStr, &mImageSize, &mTextureSize, &bitsPerPixel, (scaleMode==KRTexture2DScaleModeLinear)? YES: NO);
     [filenameStr release];
 
     if (mTextureName == GL_INVALID_VALUE || mTextureName == GL_INVALID_OPERATION) {
@@ -60,7 +61,8 @@ KRTexture2D::KRTexture2D(const std::string& filename, const KRVector2D& atlasSiz
 
     mFileName = filename;
     NSString* filenameStr = [[NSString alloc] initWithCString:filename.c_str() encoding:NSUTF8StringEncoding];
-    mTextureName = KRCreateGLTextureFromImageWithName(filenameStr, &mImageSize, &mTextureSize);
+    int bitsPerPixel = 32;
+    mTextureName = KRCreateGLTextureFromImageWithName(filenameStr, &mImageSize, &mTextureSize, &bitsPerPixel);
     [filenameStr release];
     if (mTextureName == GL_INVALID_VALUE || mTextureName == GL_INVALID_OPERATION) {
         const char* errorFormat = "Failed to load \"%s\". Please confirm that the image file exists.";
@@ -85,7 +87,8 @@ KRTexture2D::KRTexture2D(const std::string& str, KRFont* font)
     mAtlas = NULL;
 
     NSString* strStr = [[NSString alloc] initWithCString:str.c_str() encoding:NSUTF8StringEncoding];
-    mTextureName = KRCreateGLTextureFromString(strStr, font->getFontObject(), KRColor::White, &mTextureTarget, &mImageSize, &mTextureSize);
+    int bitsPerPixel = 32;
+    mTextureName = KRCreateGLTextureFromString(strStr, font->getFontObject(), KRColor::White, &mTextureTarget, &mImageSize, &mTextureSize, &bitsPerPixel);
     [strStr release];
     if (mTextureName == GL_INVALID_VALUE || mTextureName == GL_INVALID_OPERATION) {
         const char* errorFormat = "Failed to create a texture for a string: \"%s\"";
@@ -304,37 +307,13 @@ void KRTexture2D::drawC(const KRVector2D& centerPos, const KRRect2D& srcRect, do
     _gKRTexture2DDrawData[batchPos+4].texCoords_x = tx_1;    _gKRTexture2DDrawData[batchPos+4].texCoords_y = ty_1;
     _gKRTexture2DDrawData[batchPos+5].texCoords_x = tx_2;    _gKRTexture2DDrawData[batchPos+5].texCoords_y = ty_1;
     
-    _gKRTexture2DDrawData[batchPos].colors[0] =
-    _gKRTexture2DDrawData[batchPos+1].colors[0] =
-    _gKRTexture2DDrawData[batchPos+2].colors[0] =
-    _gKRTexture2DDrawData[batchPos+3].colors[0] =
-    _gKRTexture2DDrawData[batchPos+4].colors[0] =
-    _gKRTexture2DDrawData[batchPos+5].colors[0] =
-        (GLubyte)(255 * color.r);
-    
-    _gKRTexture2DDrawData[batchPos].colors[1] =
-    _gKRTexture2DDrawData[batchPos+1].colors[1] =
-    _gKRTexture2DDrawData[batchPos+2].colors[1] =
-    _gKRTexture2DDrawData[batchPos+3].colors[1] =
-    _gKRTexture2DDrawData[batchPos+4].colors[1] =
-    _gKRTexture2DDrawData[batchPos+5].colors[1] =
-        (GLubyte)(255 * color.g);
-    
-    _gKRTexture2DDrawData[batchPos].colors[2] =
-    _gKRTexture2DDrawData[batchPos+1].colors[2] =
-    _gKRTexture2DDrawData[batchPos+2].colors[2] =
-    _gKRTexture2DDrawData[batchPos+3].colors[2] =
-    _gKRTexture2DDrawData[batchPos+4].colors[2] =
-    _gKRTexture2DDrawData[batchPos+5].colors[2] =
-        (GLubyte)(255 * color.b);
-    
-    _gKRTexture2DDrawData[batchPos].colors[3] =
-    _gKRTexture2DDrawData[batchPos+1].colors[3] =
-    _gKRTexture2DDrawData[batchPos+2].colors[3] =
-    _gKRTexture2DDrawData[batchPos+3].colors[3] =
-    _gKRTexture2DDrawData[batchPos+4].colors[3] =
-    _gKRTexture2DDrawData[batchPos+5].colors[3] =
-        (GLubyte)(255 * color.a);
+    _KRPackedColor packedColor(color);
+    _gKRTexture2DDrawData[batchPos].color = packedColor;
+    _gKRTexture2DDrawData[batchPos+1].color = packedColor;
+    _gKRTexture2DDrawData[batchPos+2].color = packedColor;
+    _gKRTexture2DDrawData[batchPos+3].color = packedColor;
+    _gKRTexture2DDrawData[batchPos+4].color = packedColor;
+    _gKRTexture2DDrawData[batchPos+5].color = packedColor;
     
     _gKRTexture2DBatchCount++;
     
@@ -89,6 +89,8 @@ void KRWorld::startUpdateModel(KRInput* input)
     
     input->_updateOnceInfo();
     
+    double startTime = gKRGameMan->getCurrentTime();
+    
     mHasProcessedControl = false;
     if (!mIsControlProcessDisabled && !mIsManualControlManagementEnabled) {
         processControls(input);
@@ -97,6 +99,8 @@ void KRWorld::startUpdateModel(KRInput* input)
     updateModel(input);
     
     gKRAnime2DMan->_stepAllCharas();
+    
+    gKRAnime2DMan->_addModelUpdateTime(gKRGameMan->getCurrentTime() - startTime);
 
     gInputLogFrameCounter++;
 }
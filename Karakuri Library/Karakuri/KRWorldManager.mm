@@ -11,6 +11,7 @@
 
 #include "KRGameManager.h"
 #include "KRWorld.h"
+#include "KRMemoryStats.h"
 
 #import "KRGameController.h"
 
@@ -63,6 +64,10 @@ KRWorld* KRWorldManager::selectWorldWithName(const std::string &name, bool useLo
     gKRGameMan->_startWorldChanging();
     if (mCurrentWorld != NULL) {
         mCurrentWorld->startResignedActive();
+        
+        if (KRMemoryStats::getDumpsOnWorldChange()) {
+            KRMemoryStats::dump(mCurrentWorld->getName() + " -> " + name);
+        }
     }
 
     mCurrentWorld = world;
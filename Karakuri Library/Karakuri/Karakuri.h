@@ -44,9 +44,11 @@
 // Fundamental Classes
 #include <Karakuri/KarakuriDebug.h>
 #include <Karakuri/KRColor.h>
+#include <Karakuri/KRFrameArena.h>
 #include <Karakuri/KRGraphics.h>
 #include <Karakuri/KRInput.h>
 #include <Karakuri/KRMemoryAllocator.h>
+#include <Karakuri/KRMemoryStats.h>
 #include <Karakuri/KRRandom.h>
 #include <Karakuri/KRWorld.h>
 
@@ -13,20 +13,21 @@ void KRDebug(const char* format, ...)
 {
 #if __DEBUG__
     
-    static char buffer[1024];
+    char buffer[1024];
     va_list marker;
     va_start(marker, format);
-    vsprintf(buffer, format, marker);
+    KRFormatV(buffer, sizeof(buffer), format, marker);
     va_end(marker);
     
     timeval tp;
     gettimeofday(&tp, NULL);
     
     time_t theTime = time(NULL);
-    tm* date = localtime(&theTime);
+    tm date;
+    localtime_r(&theTime, &date);
     
-    static char dateBuffer[16];
-    strftime(dateBuffer, 15, "%H:%M:%S", date);
+    char dateBuffer[16];
+    strftime(dateBuffer, sizeof(dateBuffer), "%H:%M:%S", &date);
     
     printf("[%s.%02d] %s\n", dateBuffer, tp.tv_usec / 10000, buffer);
 
@@ -37,10 +38,10 @@ void KRDebugScreen(const char* format, ...)
 {
 #if __DEBUG__
     
-    static char buffer[1024];
+    char buffer[1024];
     va_list marker;
     va_start(marker, format);
-    vsprintf(buffer, format, marker);
+    KRFormatV(buffer, sizeof(buffer), format, marker);
     va_end(marker);
     
     [[KRGameController sharedController] addDebugString:buffer];
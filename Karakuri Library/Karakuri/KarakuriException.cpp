@@ -39,7 +39,7 @@ KRRuntimeError::KRRuntimeError(const char* format, ...)
     char buffer[1024];
     va_list marker;
     va_start(marker, format);
-    vsprintf(buffer, format, marker);
+    KRFormatV(buffer, sizeof(buffer), format, marker);
     va_end(marker);
     
     mMessage = buffer;
@@ -71,7 +71,7 @@ KRNetworkError::KRNetworkError(const char* format, ...)
     char buffer[1024];
     va_list marker;
     va_start(marker,format);
-    vsprintf(buffer, format, marker);
+    KRFormatV(buffer, sizeof(buffer), format, marker);
     va_end(marker);
     
     mMessage = buffer;    
@@ -99,7 +99,7 @@ KRGameError::KRGameError(const char* format, ...)
     char buffer[1024];
     va_list marker;
     va_start(marker,format);
-    vsprintf(buffer, format, marker);
+    KRFormatV(buffer, sizeof(buffer), format, marker);
     va_end(marker);
     
     mMessage = buffer;    
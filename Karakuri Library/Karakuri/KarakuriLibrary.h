@@ -19,8 +19,8 @@
 
 #import <OpenGL/OpenGL.h>
 #endif
-#import <OpenGL/gl.h>
-#import <OpenGL/glext.h>
+#include <OpenGL/gl.h>
+#include <OpenGL/glext.h>
 #endif
 
 #if KR_IPHONE && !KR_IPHONE_MACOSX_EMU
@@ -33,8 +33,8 @@
 
 #import <OpenGLES/EAGL.h>
 #endif
-#import <OpenGLES/ES1/gl.h>
-#import <OpenGLES/ES1/glext.h>
+#include <OpenGLES/ES1/gl.h>
+#include <OpenGLES/ES1/glext.h>
 #endif
 
 #include <Karakuri/KarakuriGlobals.h>
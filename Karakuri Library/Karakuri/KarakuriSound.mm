@@ -9,6 +9,7 @@
 #import "KarakuriSound.h"
 
 #import "KRGameManager.h"
+#import "KRMemoryStats.h"
 
 
 static ALCdevice*   sALDevice = NULL;
@@ -200,6 +201,9 @@ static float    sListenerPos[3]         = { 0.0f, 0.0f, 0.0f };
         // データをバッファに設定する
         alBufferData(mALBuffer, mOutputFormat, mAudioBuffer, mDataSize, mSampleRate);
         
+        // デコードしたバッファと、OpenAL が内部に持つコピーの分
+        KRMemoryStats::_add(KRMemoryCategorySound, (size_t)mDataSize * 2, 1);
+        
         // バッファをソースに設定する
         alSourcei(mALSource, AL_BUFFER, mALBuffer);
         
@@ -223,6 +227,8 @@ static float    sListenerPos[3]         = { 0.0f, 0.0f, 0.0f };
         free(mAudioBuffer);
     }
     
+    KRMemoryStats::_remove(KRMemoryCategorySound, (size_t)mDataSize * 2, 1);
+    
     [super dealloc];
 }
 
@@ -9,15 +9,87 @@
 
 #include "KarakuriString.h"
 
+#include <pthread.h>
+
 
 std::string KRFS(const char* format, ...)
 {
-    static char buffer[1024];
+    // ほとんどの文字列はスタック上のバッファに収まる。収まらなかったときにだけ、必要な長さを確保して書き直す。
+    char buffer[256];
+    va_list marker;
+    va_start(marker, format);
+    int length = KRFormatV(buffer, sizeof(buffer), format, marker);
+    va_end(marker);
+    
+    if (length < (int)sizeof(buffer)) {
+        return std::string(buffer, length);
+    }
+    
+    std::vector<char> longBuffer(length + 1);
+    va_start(marker, format);
+    KRFormatV(&longBuffer[0], longBuffer.size(), format, marker);
+    va_end(marker);
+    return std::string(&longBuffer[0], length);
+}
+
+int KRFormat(char* buffer, size_t size, const char* format, ...)
+{
     va_list marker;
-    va_start(marker,format);
-    vsprintf(buffer, format, marker);
+    va_start(marker, format);
+    int ret = KRFormatV(buffer, size, format, marker);
     va_end(marker);
-    return buffer;
+    return ret;
+}
+
+int KRFormatV(char* buffer, size_t size, const char* format, va_list args)
+{
+    int ret = vsnprintf(buffer, size, format, args);
+    if (ret < 0) {
+        // 書式の誤りなどで書き出せなかった場合は、空の文字列にしておく。
+        if (size > 0) {
+            buffer[0] = '\0';
+        }
+        ret = 0;
+    }
+    return ret;
+}
+
+// c_str() 関数の戻り値のための領域。printf() の1回の呼び出しで複数の c_str() を使えるように、順番に使い回す。
+// ローディング用のスレッドからも呼ばれるので、領域はスレッドごとに用意する。
+#define KR_STORED_CSTRING_COUNT 8
+
+struct _KRStoredCStrings {
+    std::string strings[KR_STORED_CSTRING_COUNT];
+    int         index;
+
+    _KRStoredCStrings() : index(0) {}
+};
+
+static pthread_key_t    sStoredCStringsKey;
+static pthread_once_t   sStoredCStringsKeyOnce = PTHREAD_ONCE_INIT;
+
+static void _KRDeleteStoredCStrings(void* storage)
+{
+    delete (_KRStoredCStrings*)storage;
+}
+
+static void _KRCreateStoredCStringsKey()
+{
+    pthread_key_create(&sStoredCStringsKey, _KRDeleteStoredCStrings);
+}
+
+const char* _KRStoreCString(const std::string& str)
+{
+    pthread_once(&sStoredCStringsKeyOnce, _KRCreateStoredCStringsKey);
+    _KRStoredCStrings* storage = (_KRStoredCStrings*)pthread_getspecific(sStoredCStringsKey);
+    if (storage == NULL) {
+        storage = new _KRStoredCStrings();
+        pthread_setspecific(sStoredCStringsKey, storage);
+    }
+    
+    storage->index = (storage->index + 1) % KR_STORED_CSTRING_COUNT;
+    storage->strings[storage->index] = str;
+    return storage->strings[storage->index].c_str();
 }
 
 std::vector<std::string> KRSplitString(const std::string& str, const std::string& separators)
@@ -11,6 +11,8 @@
 
 #include <Karakuri/KarakuriLibrary.h>
 
+#include <cstdarg>
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -20,9 +22,26 @@
     @group      Game Type
     @abstract   C++版の sprintf() です。
     指定された書式に従って C++ 文字列を生成します。
+    <p>どのスレッドから呼び出しても構いません。長さに制限はありませんが、呼び出すたびに文字列のためのメモリが確保されます。毎フレーム呼び出す場合には、KRStringBuffer クラスを使うとメモリを確保せずに済みます。</p>
  */
 std::string KRFS(const char* format, ...);
 
+/*!
+    @function   KRFormat
+    @group      Game Type
+    @abstract   書式に従って、与えられたバッファに文字列を書き出します。
+    <p>バッファのサイズ（終端の '\0' を含むバイト数）を超えて書き込むことはありません。収まらなかった部分は切り捨てられ、バッファの内容は常に '\0' で終端されます。</p>
+    <p>切り捨てられる前の文字列の長さをリターンします。リターン値がサイズ以上であれば、文字列が切り捨てられたことを表します。メモリの確保は行わず、どのスレッドから呼び出しても構いません。</p>
+ */
+int KRFormat(char* buffer, size_t size, const char* format, ...);
+
+/*!
+    @function   KRFormatV
+    @group      Game Type
+    @abstract   va_list で引数を受け取る KRFormat() 関数です。
+ */
+int KRFormatV(char* buffer, size_t size, const char* format, va_list args);
+
 /*!
     @function   KRSplitString
     @group      Game Type
@@ -31,3 +50,132 @@ std::string KRFS(const char* format, ...);
  */
 std::vector<std::string> KRSplitString(const std::string& str, const std::string& separators);
 
+
+
+/*!
+    @class  KRStringBuffer
+    @group  Game Type
+    @abstract 書式付きの文字列を、オブジェクトの中の固定長のバッファに作成するためのクラスです。
+    <p>テンプレート引数の N は、終端の '\0' を含むバッファのバイト数です。ローカル変数として作成すればメモリの確保が一切行われないため、スコアの表示のように毎フレーム文字列を作成する場合に適しています。</p>
+    <pre>KRStringBuffer&lt;32&gt; text("Score: %04d", score);
+mScoreLabel-&gt;setText(text);</pre>
+    <p>バッファに収まらなかった部分は切り捨てられ、isTruncated() 関数が true をリターンするようになります。</p>
+ */
+template <size_t N>
+class KRStringBuffer {
+
+    char    mBuffer[N];
+    size_t  mLength;
+    bool    mIsTruncated;
+
+public:
+    /*!
+        @task コンストラクタ
+     */
+
+    /*!
+        @method KRStringBuffer
+        @abstract 空の文字列を作成します。
+     */
+    KRStringBuffer() {
+        clear();
+    }
+
+    /*!
+        @method KRStringBuffer
+        @abstract 書式に従って文字列を作成します。
+     */
+    explicit KRStringBuffer(const char* format, ...) {
+        clear();
+        va_list marker;
+        va_start(marker, format);
+        appendV(format, marker);
+        va_end(marker);
+    }
+
+public:
+    /*!
+        @task 文字列の作成
+     */
+
+    /*!
+        @method append
+        @abstract 書式に従って、現在の文字列の後ろに文字列を追加します。
+     */
+    void    append(const char* format, ...) {
+        va_list marker;
+        va_start(marker, format);
+        appendV(format, marker);
+        va_end(marker);
+    }
+
+    /*!
+        @method clear
+        @abstract 文字列を空にします。
+     */
+    void    clear() {
+        mBuffer[0] = '\0';
+        mLength = 0;
+        mIsTruncated = false;
+    }
+
+    /*!
+        @method format
+        @abstract 書式に従って、文字列を作り直します。
+     */
+    void    format(const char* format, ...) {
+        clear();
+        va_list marker;
+        va_start(marker, format);
+        appendV(format, marker);
+        va_end(marker);
+    }
+
+public:
+    /*!
+        @task 文字列の取得
+     */
+
+    /*!
+        @method c_str
+        @abstract 作成された文字列を取得します。
+     */
+    const char* c_str() const {
+        return mBuffer;
+    }
+
+    /*!
+        @method isTruncated
+        @abstract 文字列がバッファに収まらずに切り捨てられたかどうかを取得します。
+     */
+    bool    isTruncated() const {
+        return mIsTruncated;
+    }
+
+    /*!
+        @method length
+        @abstract 作成された文字列の長さを取得します。
+     */
+    size_t  length() const {
+        return mLength;
+    }
+
+private:
+    void    appendV(const char* format, va_list args) {
+        size_t rest = N - mLength;
+        int length = KRFormatV(mBuffer + mLength, rest, format, args);
+        if ((size_t)length >= rest) {
+            mLength = N - 1;
+            mIsTruncated = true;
+        } else {
+            mLength += length;
+        }
+    }
+
+};
+
+
+// 各クラスの c_str() 関数のために、文字列をスレッドごとの領域にコピーして返す。
+// 返されたポインタは、同じスレッドで _KRStoreCString() がさらに 8 回呼ばれるまでの間だけ有効。
+const char* _KRStoreCString(const std::string& str);
+
@@ -34,7 +34,7 @@ KRObject::KRObject()
 
 const char* KRObject::c_str() const
 {
-    return to_s().c_str();
+    return _KRStoreCString(to_s());
 }
 
 std::string KRObject::to_s() const
@@ -46,26 +46,6 @@ std::string KRObject::to_s() const
 #pragma mark -
 #pragma mark KRRect2D Class Implementation
 
-KRRect2D::KRRect2D()
-: x(0.0), y(0.0), width(0.0), height(0.0)
-{
-}
-
-KRRect2D::KRRect2D(double _x, double _y, double _width, double _height)
-: x(_x), y(_y), width(_width), height(_height)
-{
-}
-
-KRRect2D::KRRect2D(const KRVector2D& _origin, const KRVector2D& _size)
-: x(_origin.x), y(_origin.y), width(_size.x), height(_size.y)
-{
-}
-
-KRRect2D::KRRect2D(const KRRect2D& _rect)
-: x(_rect.x), y(_rect.y), width(_rect.width), height(_rect.height)
-{
-}
-
 double KRRect2D::getMinX() const
 {
     return x;
@@ -229,77 +209,19 @@ KRRect2D KRRect2D::makeUnion(const KRRect2D& src1, const KRRect2D& src2)
     return KRRect2D(x1, y1, x2 - x1, y2 - y1);
 }
 
-std::string KRRect2D::to_s() const
-{
-    return KRFS("<rect2>(%3.2f, %3.2f, %3.2f, %3.2f)", x, y);
-}
-
-
-#pragma mark -
-#pragma mark KRVector2D Class Implementation
-
-KRVector2D::KRVector2D()
-    : x(0.0), y(0.0)
-{
-}
-
-KRVector2D::KRVector2D(double _x, double _y)
-    : x(_x), y(_y)
+const char* KRRect2D::c_str() const
 {
+    return _KRStoreCString(to_s());
 }
 
-KRVector2D::KRVector2D(const KRVector2D &vec)
-    : x(vec.x), y(vec.y)
-{
-}
-
-KRVector2D KRVector2D::operator+(const KRVector2D &vec) const
-{
-    return KRVector2D(x + vec.x, y + vec.y);
-}
-
-KRVector2D& KRVector2D::operator+=(const KRVector2D &vec)
-{
-    x += vec.x;
-    y += vec.y;
-    return *this;
-}
-
-KRVector2D KRVector2D::operator-(const KRVector2D &vec) const
-{
-    return KRVector2D(x - vec.x, y - vec.y);
-}
-
-KRVector2D& KRVector2D::operator-=(const KRVector2D &vec)
-{
-    x -= vec.x;
-    y -= vec.y;
-    return *this;
-}
-
-KRVector2D KRVector2D::operator*(double value) const
+std::string KRRect2D::to_s() const
 {
-    return KRVector2D(x * value, y * value);
+    return KRFS("<rect2>(%3.2f, %3.2f, %3.2f, %3.2f)", x, y, width, height);
 }
 
-KRVector2D& KRVector2D::operator*=(double value)
-{
-    x *= value;
-    y *= value;
-    return *this;
-}
 
-KRVector2D KRVector2D::operator/(double value) const
-{
-    return KRVector2D(x / value, y / value);
-}
-
-KRVector2D& KRVector2D::operator/=(double value)
-{
-    x /= value;
-    y /= value;
-    return *this;
-}
+#pragma mark -
+#pragma mark KRVector2D Class Implementation
 
 bool KRVector2D::operator==(const KRVector2D &vec) const
 {
@@ -313,11 +235,6 @@ bool KRVector2D::operator!=(const KRVector2D &vec) const
             fabs(y - vec.y) >= KR_MATH_DIFF);
 }
 
-KRVector2D KRVector2D::operator-() const
-{
-    return KRVector2D(-x, -y);
-}
-
 bool KRVector2D::operator<(const KRVector2D& vec) const
 {
     return (x < vec.x || (x == vec.x && y < vec.y));
@@ -356,6 +273,11 @@ double KRVector2D::outerProduct(const KRVector2D &vec) const
     return (x * vec.y - y * vec.x);
 }
 
+const char* KRVector2D::c_str() const
+{
+    return _KRStoreCString(to_s());
+}
+
 std::string KRVector2D::to_s() const
 {
     return KRFS("<vec2>(%3.2f, %3.2f)", x, y);
@@ -375,11 +297,6 @@ KRVector2DInt::KRVector2DInt(int _x, int _y)
 {
 }
     
-KRVector2DInt::KRVector2DInt(const KRVector2DInt& vec)
-    : x(vec.x), y(vec.y)
-{
-}
-    
 double KRVector2DInt::angle(const KRVector2DInt &vec) const
 {
     return atan2((double)(vec.y - y), (double)(vec.x - x));
@@ -479,6 +396,11 @@ KRVector2DInt KRVector2DInt::operator-() const
     return KRVector2DInt(-x, -y);
 }
     
+const char* KRVector2DInt::c_str() const
+{
+    return _KRStoreCString(to_s());
+}
+
 std::string KRVector2DInt::to_s() const
 {
     return KRFS("<vec2int>(%d, %d)", x, y);
@@ -489,73 +411,6 @@ std::string KRVector2DInt::to_s() const
 #pragma mark -
 #pragma mark KRVector3D Class Implementation
 
-KRVector3D::KRVector3D()
-    : x(0.0), y(0.0), z(0.0)
-{
-}
-
-KRVector3D::KRVector3D(double _x, double _y, double _z)
-    : x(_x), y(_y), z(_z)
-{
-}
-
-KRVector3D::KRVector3D(const KRVector3D& vec)
-    : x(vec.x), y(vec.y), z(vec.z)
-{
-}
-
-KRVector3D KRVector3D::operator+(const KRVector3D &vec) const
-{
-    return KRVector3D(x + vec.x, y + vec.y, z + vec.z);
-}
-
-KRVector3D& KRVector3D::operator+=(const KRVector3D &vec)
-{
-    x += vec.x;
-    y += vec.y;
-    z += vec.z;
-    return *this;
-}
-
-KRVector3D KRVector3D::operator-(const KRVector3D &vec) const
-{
-    return KRVector3D(x - vec.x, y - vec.y, z - vec.z);
-}
-
-KRVector3D& KRVector3D::operator-=(const KRVector3D &vec)
-{
-    x -= vec.x;
-    y -= vec.y;
-    z -= vec.z;
-    return *this;
-}
-
-KRVector3D KRVector3D::operator*(double value) const
-{
-    return KRVector3D(x * value, y * value, z * value);
-}
-
-KRVector3D& KRVector3D::operator*=(double value)
-{
-    x *= value;
-    y *= value;
-    z *= value;
-    return *this;
-}
-
-KRVector3D KRVector3D::operator/(double value) const
-{
-    return KRVector3D(x / value, y / value, z / value);
-}
-
-KRVector3D& KRVector3D::operator/=(double value)
-{
-    x /= value;
-    y /= value;
-    z /= value;
-    return *this;
-}
-
 bool KRVector3D::operator==(const KRVector3D &vec) const
 {
     return (fabs(x - vec.x) < KR_MATH_DIFF &&
@@ -577,11 +432,6 @@ bool KRVector3D::operator<(const KRVector3D &vec) const
              (y == vec.y && z < vec.z))));
 }
 
-KRVector3D KRVector3D::operator-() const
-{
-    return KRVector3D(-x, -y, -z);
-}
-
 double KRVector3D::length() const
 {
     return sqrt(x * x + y * y + z * z);
@@ -613,6 +463,11 @@ KRVector3D KRVector3D::outerProduct(const KRVector3D& vec) const
                       x * vec.y - y * vec.x);
 }
 
+const char* KRVector3D::c_str() const
+{
+    return _KRStoreCString(to_s());
+}
+
 std::string KRVector3D::to_s() const
 {
     return KRFS("<vec3>(%3.2f, %3.2f, %3.2f)", x, y, z);
@@ -739,6 +594,11 @@ KRVector3DInt KRVector3DInt::operator-() const
     return KRVector3DInt(-x, -y, -z);
 }
 
+const char* KRVector3DInt::c_str() const
+{
+    return _KRStoreCString(to_s());
+}
+
 std::string KRVector3DInt::to_s() const
 {
     return KRFS("<vec3int>(%d, %d, %d)", x, y, z);
@@ -21,6 +21,7 @@ struct KRVector2D;
     @class KRObject
     @group Game Type
     @abstract Karakuri Framework 内のすべてのクラスの基底クラスとなるクラスです。
+    <p>KRVector2D、KRRect2D、KRColor などの値を表す構造体は、仮想関数テーブルを持たない POD 型として扱えるように、このクラスを継承せずに同じ名前の c_str() 関数と to_s() 関数を持っています。</p>
  */
 typedef struct KRObject {
     KRObject();
@@ -48,7 +49,7 @@ typedef struct KRObject {
     @group  Game Type
     @abstract 位置およびサイズで定義される矩形を表すための構造体です。
  */
-typedef struct KRRect2D : public KRObject {
+typedef struct KRRect2D {
     
     /*!
         @var x
@@ -95,12 +96,6 @@ typedef struct KRRect2D : public KRObject {
         位置とサイズを指定してこの矩形を作成します。
      */
     KRRect2D(const KRVector2D& _origin, const KRVector2D& _size);
-    
-    /*!
-        @method KRRect2D
-        与えられた矩形をコピーして、この矩形を作成します。
-     */
-    KRRect2D(const KRRect2D& _rect);
 
     
     /*!
@@ -243,7 +238,21 @@ typedef struct KRRect2D : public KRObject {
     static KRRect2D makeIntersection(const KRRect2D& src1, const KRRect2D& src2);   KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     static KRRect2D makeUnion(const KRRect2D& src1, const KRRect2D& src2);          KARAKURI_FRAMEWORK_INTERNAL_USE_ONLY
     
-    virtual std::string to_s() const;
+    /*!
+        @task デバッグのサポート
+     */
+    
+    /*!
+        @method c_str
+        この矩形の内容を表すC言語文字列をリターンします。
+     */
+    const char* c_str() const;
+
+    /*!
+        @method to_s
+        この矩形の内容を表す C++ 文字列をリターンします。
+     */
+    std::string to_s() const;
     
 } KRRect2D;
 
@@ -254,7 +263,7 @@ typedef struct KRRect2D : public KRObject {
     @abstract double 型の2次元ベクトルを表すための構造体です。
     点情報、サイズ情報を表すためにも使われます。
  */
-typedef struct KRVector2D : public KRObject {
+typedef struct KRVector2D {
     
     /*!
         @var    x
@@ -286,12 +295,6 @@ typedef struct KRVector2D : public KRObject {
      */
     KRVector2D(double _x, double _y);
     
-    /*!
-        @method KRVector2D
-        与えられたベクトルをコピーして、このベクトルを初期化します。
-     */
-    KRVector2D(const KRVector2D& vec);
-    
     /*!
         @task 幾何計算のための関数
      */
@@ -394,7 +397,21 @@ typedef struct KRVector2D : public KRObject {
      */
     KRVector2D operator-() const;
 
-    virtual std::string to_s() const;
+    /*!
+        @task デバッグのサポート
+     */
+    
+    /*!
+        @method c_str
+        このベクトルの内容を表すC言語文字列をリターンします。
+     */
+    const char* c_str() const;
+
+    /*!
+        @method to_s
+        このベクトルの内容を表す C++ 文字列をリターンします。
+     */
+    std::string to_s() const;
 
 } KRVector2D;
 
@@ -405,7 +422,7 @@ typedef struct KRVector2D : public KRObject {
     @abstract int 型の2次元ベクトルを表すための構造体です。
     点情報、サイズ情報を表すためにも使われます。
  */
-typedef struct KRVector2DInt : public KRObject {
+typedef struct KRVector2DInt {
     
     /*!
         @var    x
@@ -437,12 +454,6 @@ typedef struct KRVector2DInt : public KRObject {
      */
     KRVector2DInt(int _x, int _y);
     
-    /*!
-        @method KRVector2DInt
-        与えられたベクトルをコピーして、このベクトルを初期化します。
-     */
-    KRVector2DInt(const KRVector2DInt& vec);
-    
     /*!
         @task 幾何計算のための関数
      */
@@ -546,7 +557,21 @@ typedef struct KRVector2DInt : public KRObject {
      */
     KRVector2DInt operator-() const;
 
-    virtual std::string to_s() const;
+    /*!
+        @task デバッグのサポート
+     */
+    
+    /*!
+        @method c_str
+        このベクトルの内容を表すC言語文字列をリターンします。
+     */
+    const char* c_str() const;
+
+    /*!
+        @method to_s
+        このベクトルの内容を表す C++ 文字列をリターンします。
+     */
+    std::string to_s() const;
 
 } KRVector2DInt;
 
@@ -557,7 +582,7 @@ typedef struct KRVector2DInt : public KRObject {
     @abstract double 型の3次元ベクトルを表すための構造体です。
     点情報、サイズ情報を表すためにも使われます。
  */
-typedef struct KRVector3D : public KRObject {
+typedef struct KRVector3D {
     
     /*!
         @var x
@@ -592,12 +617,6 @@ typedef struct KRVector3D : public KRObject {
         このベクトルを、与えられた3つの数値で初期化します。
      */
     KRVector3D(double _x, double _y, double _z);
-
-    /*!
-        @method KRVector3D
-        与えられたベクトルをコピーして、このベクトルを初期化します。
-     */
-    KRVector3D(const KRVector3D& vec);
     
     /*!
         @task 幾何計算のための関数
@@ -695,7 +714,21 @@ typedef struct KRVector3D : public KRObject {
      */
     KRVector3D operator-() const;
     
-    virtual std::string to_s() const;
+    /*!
+        @task デバッグのサポート
+     */
+    
+    /*!
+        @method c_str
+        このベクトルの内容を表すC言語文字列をリターンします。
+     */
+    const char* c_str() const;
+
+    /*!
+        @method to_s
+        このベクトルの内容を表す C++ 文字列をリターンします。
+     */
+    std::string to_s() const;
 
 } KRVector3D;
 
@@ -706,7 +739,7 @@ typedef struct KRVector3D : public KRObject {
     @abstract int 型の3次元ベクトルを表すための構造体です。
     点情報、サイズ情報を表すためにも使われます。
  */
-typedef struct KRVector3DInt : public KRObject {
+typedef struct KRVector3DInt {
     
     /*!
         @var x
@@ -845,11 +878,441 @@ typedef struct KRVector3DInt : public KRObject {
      */
     KRVector3DInt operator-() const;
     
-    virtual std::string to_s() const;
+    /*!
+        @task デバッグのサポート
+     */
+    
+    /*!
+        @method c_str
+        このベクトルの内容を表すC言語文字列をリターンします。
+     */
+    const char* c_str() const;
+
+    /*!
+        @method to_s
+        このベクトルの内容を表す C++ 文字列をリターンします。
+     */
+    std::string to_s() const;
 
 } KRVector3DInt;
 
 
+/*!
+    @struct KRVector2Df
+    @group  Game Type
+    @abstract float 型の2次元ベクトルを表すための構造体です。
+    <p>テクスチャの描画やパーティクルの更新など、毎フレーム大量に計算されるフレームワーク内部の処理で使われます。頂点配列は float で作られるため、倍精度で計算しても描画結果は変わらず、メモリの読み書きが半分で済みます。</p>
+    <p>ゲームのコードでは、これまで通り KRVector2D 構造体を使用してください。KRVector2D との変換は明示的に行います。</p>
+ */
+typedef struct KRVector2Df {
+    
+    /*!
+        @var    x
+        @abstract   このベクトルのX成分を表す数値です。
+     */
+    float   x;
+    
+    /*!
+        @var    y
+        @abstract   このベクトルのY成分を表す数値です。
+     */
+    float   y;
+    
+    /*!
+        @task コンストラクタ
+     */
+    
+    /*!
+        @method KRVector2Df
+        このベクトルを、x=0.0f, y=0.0f で初期化します。
+     */
+    KRVector2Df();
+    
+    /*!
+        @method KRVector2Df
+        このベクトルを、与えられた2つの数値で初期化します。
+     */
+    KRVector2Df(float _x, float _y);
+    
+    /*!
+        @method KRVector2Df
+        KRVector2D 構造体の各成分を float に変換して、このベクトルを初期化します。
+     */
+    explicit KRVector2Df(const KRVector2D& vec);
+    
+    /*!
+        @task 変換
+     */
+    
+    /*!
+        @method toVector2D
+        このベクトルを KRVector2D 構造体に変換します。
+     */
+    KRVector2D  toVector2D() const;
+    
+    /*!
+        @task 演算子のオーバーライド
+     */
+    
+    /*!
+        @method operator+
+     */
+    KRVector2Df operator+(const KRVector2Df& vec) const;
+
+    /*!
+        @method operator+=
+     */
+    KRVector2Df& operator+=(const KRVector2Df& vec);
+
+    /*!
+        @method operator-
+     */
+    KRVector2Df operator-(const KRVector2Df& vec) const;
+
+    /*!
+        @method operator-=
+     */
+    KRVector2Df& operator-=(const KRVector2Df& vec);
+
+    /*!
+        @method operator/
+     */
+    KRVector2Df operator/(float value) const;
+
+    /*!
+        @method operator/=
+     */
+    KRVector2Df& operator/=(float value);
+
+    /*!
+        @method operator*
+     */
+    KRVector2Df operator*(float value) const;
+
+    /*!
+        @method operator*=
+     */
+    KRVector2Df& operator*=(float value);
+
+    /*!
+        @method operator-
+     */
+    KRVector2Df operator-() const;
+
+} KRVector2Df;
+
+
+/*!
+    @struct KRRect2Df
+    @group  Game Type
+    @abstract float 型の成分を持つ矩形を表すための構造体です。
+    KRVector2Df 構造体と同じく、フレームワーク内部の描画処理で使われます。ゲームのコードでは KRRect2D 構造体を使用してください。
+ */
+typedef struct KRRect2Df {
+    
+    /*!
+        @var x
+        矩形の位置のX座標です。
+     */
+    float   x;
+    
+    /*!
+        @var y
+        矩形の位置のY座標です。
+     */
+    float   y;
+    
+    /*!
+        @var width
+        矩形の横幅です。
+     */
+    float   width;
+    
+    /*!
+        @var height
+        矩形の高さです。
+     */
+    float   height;
+    
+    /*!
+        @task コンストラクタ
+     */
+    
+    /*!
+        @method KRRect2Df
+        位置が (0, 0) であり、幅と高さが両方とも 0 の矩形を作成します。
+     */
+    KRRect2Df();
+    
+    /*!
+        @method KRRect2Df
+        位置と幅と高さを指定してこの矩形を作成します。
+     */
+    KRRect2Df(float _x, float _y, float _width, float _height);
+    
+    /*!
+        @method KRRect2Df
+        KRRect2D 構造体の各成分を float に変換して、この矩形を作成します。
+     */
+    explicit KRRect2Df(const KRRect2D& rect);
+    
+    /*!
+        @task 変換
+     */
+    
+    /*!
+        @method toRect2D
+        この矩形を KRRect2D 構造体に変換します。
+     */
+    KRRect2D    toRect2D() const;
+
+} KRRect2Df;
+
+
+#pragma mark -
+#pragma mark Inline Functions
+
+// コンストラクタと四則演算は、パーティクルやキャラクタの更新で大量に呼ばれるため、インライン展開できるようにここで定義する。
+
+inline KRRect2D::KRRect2D()
+    : x(0.0), y(0.0), width(0.0), height(0.0)
+{
+}
+
+inline KRRect2D::KRRect2D(double _x, double _y, double _width, double _height)
+    : x(_x), y(_y), width(_width), height(_height)
+{
+}
+
+inline KRRect2D::KRRect2D(const KRVector2D& _origin, const KRVector2D& _size)
+    : x(_origin.x), y(_origin.y), width(_size.x), height(_size.y)
+{
+}
+
+inline KRVector2D::KRVector2D()
+    : x(0.0), y(0.0)
+{
+}
+
+inline KRVector2D::KRVector2D(double _x, double _y)
+    : x(_x), y(_y)
+{
+}
+
+inline KRVector2D KRVector2D::operator+(const KRVector2D &vec) const
+{
+    return KRVector2D(x + vec.x, y + vec.y);
+}
+
+inline KRVector2D& KRVector2D::operator+=(const KRVector2D &vec)
+{
+    x += vec.x;
+    y += vec.y;
+    return *this;
+}
+
+inline KRVector2D KRVector2D::operator-(const KRVector2D &vec) const
+{
+    return KRVector2D(x - vec.x, y - vec.y);
+}
+
+inline KRVector2D& KRVector2D::operator-=(const KRVector2D &vec)
+{
+    x -= vec.x;
+    y -= vec.y;
+    return *this;
+}
+
+inline KRVector2D KRVector2D::operator*(double value) const
+{
+    return KRVector2D(x * value, y * value);
+}
+
+inline KRVector2D& KRVector2D::operator*=(double value)
+{
+    x *= value;
+    y *= value;
+    return *this;
+}
+
+inline KRVector2D KRVector2D::operator/(double value) const
+{
+    return KRVector2D(x / value, y / value);
+}
+
+inline KRVector2D& KRVector2D::operator/=(double value)
+{
+    x /= value;
+    y /= value;
+    return *this;
+}
+
+inline KRVector2D KRVector2D::operator-() const
+{
+    return KRVector2D(-x, -y);
+}
+
+inline KRVector3D::KRVector3D()
+    : x(0.0), y(0.0), z(0.0)
+{
+}
+
+inline KRVector3D::KRVector3D(double _x, double _y, double _z)
+    : x(_x), y(_y), z(_z)
+{
+}
+
+inline KRVector3D KRVector3D::operator+(const KRVector3D &vec) const
+{
+    return KRVector3D(x + vec.x, y + vec.y, z + vec.z);
+}
+
+inline KRVector3D& KRVector3D::operator+=(const KRVector3D &vec)
+{
+    x += vec.x;
+    y += vec.y;
+    z += vec.z;
+    return *this;
+}
+
+inline KRVector3D KRVector3D::operator-(const KRVector3D &vec) const
+{
+    return KRVector3D(x - vec.x, y - vec.y, z - vec.z);
+}
+
+inline KRVector3D& KRVector3D::operator-=(const KRVector3D &vec)
+{
+    x -= vec.x;
+    y -= vec.y;
+    z -= vec.z;
+    return *this;
+}
+
+inline KRVector3D KRVector3D::operator*(double value) const
+{
+    return KRVector3D(x * value, y * value, z * value);
+}
+
+inline KRVector3D& KRVector3D::operator*=(double value)
+{
+    x *= value;
+    y *= value;
+    z *= value;
+    return *this;
+}
+
+inline KRVector3D KRVector3D::operator/(double value) const
+{
+    return KRVector3D(x / value, y / value, z / value);
+}
+
+inline KRVector3D& KRVector3D::operator/=(double value)
+{
+    x /= value;
+    y /= value;
+    z /= value;
+    return *this;
+}
+
+inline KRVector3D KRVector3D::operator-() const
+{
+    return KRVector3D(-x, -y, -z);
+}
+
+inline KRVector2Df::KRVector2Df()
+    : x(0.0f), y(0.0f)
+{
+}
+
+inline KRVector2Df::KRVector2Df(float _x, float _y)
+    : x(_x), y(_y)
+{
+}
+
+inline KRVector2Df::KRVector2Df(const KRVector2D& vec)
+    : x((float)vec.x), y((float)vec.y)
+{
+}
+
+inline KRVector2D KRVector2Df::toVector2D() const
+{
+    return KRVector2D(x, y);
+}
+
+inline KRVector2Df KRVector2Df::operator+(const KRVector2Df &vec) const
+{
+    return KRVector2Df(x + vec.x, y + vec.y);
+}
+
+inline KRVector2Df& KRVector2Df::operator+=(const KRVector2Df &vec)
+{
+    x += vec.x;
+    y += vec.y;
+    return *this;
+}
+
+inline KRVector2Df KRVector2Df::operator-(const KRVector2Df &vec) const
+{
+    return KRVector2Df(x - vec.x, y - vec.y);
+}
+
+inline KRVector2Df& KRVector2Df::operator-=(const KRVector2Df &vec)
+{
+    x -= vec.x;
+    y -= vec.y;
+    return *this;
+}
+
+inline KRVector2Df KRVector2Df::operator*(float value) const
+{
+    return KRVector2Df(x * value, y * value);
+}
+
+inline KRVector2Df& KRVector2Df::operator*=(float value)
+{
+    x *= value;
+    y *= value;
+    return *this;
+}
+
+inline KRVector2Df KRVector2Df::operator/(float value) const
+{
+    return KRVector2Df(x / value, y / value);
+}
+
+inline KRVector2Df& KRVector2Df::operator/=(float value)
+{
+    x /= value;
+    y /= value;
+    return *this;
+}
+
+inline KRVector2Df KRVector2Df::operator-() const
+{
+    return KRVector2Df(-x, -y);
+}
+
+inline KRRect2Df::KRRect2Df()
+    : x(0.0f), y(0.0f), width(0.0f), height(0.0f)
+{
+}
+
+inline KRRect2Df::KRRect2Df(float _x, float _y, float _width, float _height)
+    : x(_x), y(_y), width(_width), height(_height)
+{
+}
+
+inline KRRect2Df::KRRect2Df(const KRRect2D& rect)
+    : x((float)rect.x), y((float)rect.y), width((float)rect.width), height((float)rect.height)
+{
+}
+
+inline KRRect2D KRRect2Df::toRect2D() const
+{
+    return KRRect2D(x, y, width, height);
+}
+
+
 /*!
     @const  KRRect2DZero
     @group  Game Type
@@ -897,7 +1360,7 @@ extern const KRVector3D     KRVector3DZero;
     @group  Game Type
     @abstract x成分、y成分、z成分がすべて 0 となっている KRVector3DInt 構造体の定数です。
  */
-extern const KRVector2DInt  KRVector2DIntZero;
+extern const KRVector3DInt  KRVector3DIntZero;
 
 
 /*!
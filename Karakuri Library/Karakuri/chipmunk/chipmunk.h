@@ -26,6 +26,8 @@
 extern "C" {
 #endif
 
+#include <math.h>
+
 #include "chipmunk_types.h"
 	
 static inline cpFloat
@@ -66,11 +68,16 @@ cpfclamp(cpFloat f, cpFloat min, cpFloat max){
 #endif
 
 #include "cpVect.h"
+#include "cpSIMD.h"
 #include "cpBB.h"
 #include "cpBody.h"
 #include "cpArray.h"
 #include "cpHashSet.h"
+#include "cpPool.h"
+#include "cpSpatialIndex.h"
 #include "cpSpaceHash.h"
+#include "cpBBTree.h"
+#include "cpSweep1D.h"
 
 #include "cpShape.h"
 #include "cpPolyShape.h"
@@ -79,6 +86,7 @@ cpfclamp(cpFloat f, cpFloat min, cpFloat max){
 #include "cpCollision.h"
 	
 #include "constraints/cpConstraint.h"
+#include "cpParallelSolver.h"
 
 #include "cpSpace.h"
 
@@ -1,4 +1,11 @@
-#if 1 // use doubles by default for higher precision
+// Define CP_USE_DOUBLES to 0 in the build settings for a single precision build.
+// It halves the size of the bodies and contacts, and the polygon tests use SSE2 or NEON. (See cpSIMD.h)
+#ifndef CP_USE_DOUBLES
+	// use doubles by default for higher precision
+	#define CP_USE_DOUBLES 1
+#endif
+
+#if CP_USE_DOUBLES
 
 typedef double cpFloat;
 #define cpfsqrt sqrt
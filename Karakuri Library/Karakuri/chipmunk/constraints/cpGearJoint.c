@@ -42,8 +42,8 @@ preStep(cpGearJoint *joint, cpFloat dt, cpFloat dt_inv)
 
 	// apply joint torque
 	cpFloat j = joint->jAcc;
-	a->w -= j*a->i_inv*joint->ratio_inv;
-	b->w += j*b->i_inv;
+	apply_angular_impulse(a, -j*joint->ratio_inv);
+	apply_angular_impulse(b, j);
 }
 
 static void
@@ -62,8 +62,8 @@ applyImpulse(cpGearJoint *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv*joint->ratio_inv;
-	b->w += j*b->i_inv;
+	apply_angular_impulse(a, -j*joint->ratio_inv);
+	apply_angular_impulse(b, j);
 }
 
 static cpFloat
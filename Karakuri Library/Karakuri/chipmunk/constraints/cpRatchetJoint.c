@@ -54,8 +54,8 @@ preStep(cpRatchetJoint *joint, cpFloat dt, cpFloat dt_inv)
 		joint->jAcc = 0.0f;
 
 	// apply joint torque
-	a->w -= joint->jAcc*a->i_inv;
-	b->w += joint->jAcc*b->i_inv;
+	apply_angular_impulse(a, -joint->jAcc);
+	apply_angular_impulse(b, joint->jAcc);
 }
 
 static void
@@ -77,8 +77,8 @@ applyImpulse(cpRatchetJoint *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	apply_angular_impulse(a, -j);
+	apply_angular_impulse(b, j);
 }
 
 static cpFloat
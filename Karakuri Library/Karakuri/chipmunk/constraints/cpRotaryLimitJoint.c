@@ -53,8 +53,8 @@ preStep(cpRotaryLimitJoint *joint, cpFloat dt, cpFloat dt_inv)
 		joint->jAcc = 0.0f;
 
 	// apply joint torque
-	a->w -= joint->jAcc*a->i_inv;
-	b->w += joint->jAcc*b->i_inv;
+	apply_angular_impulse(a, -joint->jAcc);
+	apply_angular_impulse(b, joint->jAcc);
 }
 
 static void
@@ -79,8 +79,8 @@ applyImpulse(cpRotaryLimitJoint *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	apply_angular_impulse(a, -j);
+	apply_angular_impulse(b, j);
 }
 
 static cpFloat
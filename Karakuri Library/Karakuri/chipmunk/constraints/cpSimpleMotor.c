@@ -37,8 +37,8 @@ preStep(cpSimpleMotor *joint, cpFloat dt, cpFloat dt_inv)
 	joint->jMax = J_MAX(joint, dt);
 
 	// apply joint torque
-	a->w -= joint->jAcc*a->i_inv;
-	b->w += joint->jAcc*b->i_inv;
+	apply_angular_impulse(a, -joint->jAcc);
+	apply_angular_impulse(b, joint->jAcc);
 }
 
 static void
@@ -57,8 +57,8 @@ applyImpulse(cpSimpleMotor *joint)
 	j = joint->jAcc - jOld;
 	
 	// apply impulse
-	a->w -= j*a->i_inv;
-	b->w += j*b->i_inv;
+	apply_angular_impulse(a, -j);
+	apply_angular_impulse(b, j);
 }
 
 static cpFloat
@@ -45,6 +45,13 @@ apply_impulses(cpBody *a , cpBody *b, cpVect r1, cpVect r2, cpVect j)
 	cpBodyApplyImpulse(b, j, r2);
 }
 
+// Bodies with an infinite moment are never written to, as cpParallelSolver lets any number of threads share them.
+static inline void
+apply_angular_impulse(cpBody *body, cpFloat j)
+{
+	if(body->i_inv != 0.0f) body->w += j*body->i_inv;
+}
+
 static inline void
 apply_bias_impulses(cpBody *a , cpBody *b, cpVect r1, cpVect r2, cpVect j)
 {
@@ -20,6 +20,7 @@
  */
  
 #include <stdlib.h>
+#include <string.h>
 
 #include "chipmunk.h"
 #include "constraints/util.h"
@@ -103,6 +104,8 @@ cpArbiterInit(cpArbiter *arb, cpShape *a, cpShape *b, int stamp)
 	arb->b = b;
 	
 	arb->stamp = stamp;
+	
+	arb->pools = NULL;
 		
 	return arb;
 }
@@ -116,19 +119,26 @@ cpArbiterNew(cpShape *a, cpShape *b, int stamp)
 void
 cpArbiterDestroy(cpArbiter *arb)
 {
-	free(arb->contacts);
+	if(arb->contacts) cpSpacePoolsFreeContacts(arb->pools, arb->contacts, arb->numContacts);
 }
 
 void
 cpArbiterFree(cpArbiter *arb)
 {
-	if(arb) cpArbiterDestroy(arb);
-	free(arb);
+	if(!arb) return;
+	cpArbiterDestroy(arb);
+	
+	if(arb->pools) cpPoolFree(&arb->pools->arbiters, arb);
+	else free(arb);
 }
 
 void
-cpArbiterInject(cpArbiter *arb, cpContact *contacts, int numContacts)
+cpArbiterInject(cpArbiter *arb, cpContact *newContacts, int numContacts)
 {
+	// Copy the new contacts out of the caller's scratch buffer.
+	cpContact *contacts = cpSpacePoolsAllocContacts(arb->pools, numContacts);
+	memcpy(contacts, newContacts, numContacts*sizeof(cpContact));
+	
 	// Iterate over the possible pairs to look for hash value matches.
 	for(int i=0; i<arb->numContacts; i++){
 		cpContact *old = &arb->contacts[i];
@@ -145,7 +155,7 @@ cpArbiterInject(cpArbiter *arb, cpContact *contacts, int numContacts)
 		}
 	}
 
-	free(arb->contacts);
+	if(arb->contacts) cpSpacePoolsFreeContacts(arb->pools, arb->contacts, arb->numContacts);
 	
 	arb->contacts = contacts;
 	arb->numContacts = numContacts;
@@ -65,6 +65,9 @@ typedef struct cpArbiter{
 	
 	// Time stamp of the arbiter. (from cpSpace)
 	int stamp;
+	
+	// Pools the arbiter and its contacts were allocated from. (NULL for malloc)
+	struct cpSpacePools *pools;
 } cpArbiter;
 
 // Basic allocation/destruction functions.
@@ -77,6 +80,7 @@ void cpArbiterFree(cpArbiter *arb);
 
 // These functions are all intended to be used internally.
 // Inject new contact points into the arbiter while preserving contact history.
+// The contacts are copied, so the caller keeps ownership of the array.
 void cpArbiterInject(cpArbiter *arb, cpContact *contacts, int numContacts);
 // Precalculate values used by the solver.
 void cpArbiterPreStep(cpArbiter *arb, cpFloat dt_inv);
@@ -49,5 +49,38 @@ cpBBcontainsVect(const cpBB bb, const cpVect v)
 	return (bb.l < v.x && bb.r > v.x && bb.b < v.y && bb.t > v.y);
 }
 
+// Smallest BBox containing both a and b.
+static inline cpBB
+cpBBmerge(const cpBB a, const cpBB b)
+{
+	return cpBBNew(cpfmin(a.l, b.l), cpfmin(a.b, b.b), cpfmax(a.r, b.r), cpfmax(a.t, b.t));
+}
+
+// Fraction along the segment from a to b where it enters bb. (0 if a is inside, INFINITY if it misses)
+static inline cpFloat
+cpBBSegmentQuery(const cpBB bb, const cpVect a, const cpVect b)
+{
+	cpFloat idx = 1.0f/(b.x - a.x);
+	cpFloat tx1 = (bb.l == a.x ? -INFINITY : (bb.l - a.x)*idx);
+	cpFloat tx2 = (bb.r == a.x ?  INFINITY : (bb.r - a.x)*idx);
+	cpFloat txmin = cpfmin(tx1, tx2);
+	cpFloat txmax = cpfmax(tx1, tx2);
+	
+	cpFloat idy = 1.0f/(b.y - a.y);
+	cpFloat ty1 = (bb.b == a.y ? -INFINITY : (bb.b - a.y)*idy);
+	cpFloat ty2 = (bb.t == a.y ?  INFINITY : (bb.t - a.y)*idy);
+	cpFloat tymin = cpfmin(ty1, ty2);
+	cpFloat tymax = cpfmax(ty1, ty2);
+	
+	if(tymin <= txmax && txmin <= tymax){
+		cpFloat min = cpfmax(txmin, tymin);
+		cpFloat max = cpfmin(txmax, tymax);
+		
+		if(0.0f <= max && min <= 1.0f) return cpfmax(min, 0.0f);
+	}
+	
+	return INFINITY;
+}
+
 cpVect cpBBClampVect(const cpBB bb, const cpVect v); // clamps the vector to lie within the bbox
 cpVect cpBBWrapVect(const cpBB bb, const cpVect v); // wrap a vector to a bbox
@@ -0,0 +1,479 @@
+/* cpBBTree.c
+ * Incremental dynamic AABB tree broadphase, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+#include <stdlib.h>
+
+#include "chipmunk.h"
+
+// Fraction of an object's size added on each side of its leaf BBox.
+#define LEAF_MARGIN 0.1f
+
+#pragma mark Nodes
+
+static cpBBTreeNode *
+nodeAlloc(cpBBTree *tree)
+{
+	cpBBTreeNode *node = (tree->nodePool ? (cpBBTreeNode *)cpPoolAlloc(tree->nodePool) : (cpBBTreeNode *)malloc(sizeof(cpBBTreeNode)));
+	
+	node->obj = NULL;
+	node->parent = NULL;
+	node->a = NULL;
+	node->b = NULL;
+	node->height = 0;
+	
+	return node;
+}
+
+static void
+nodeFree(cpBBTree *tree, cpBBTreeNode *node)
+{
+	if(tree->nodePool) cpPoolFree(tree->nodePool, node);
+	else free(node);
+}
+
+static void
+subtreeFree(cpBBTree *tree, cpBBTreeNode *node)
+{
+	if(node->a){
+		subtreeFree(tree, node->a);
+		subtreeFree(tree, node->b);
+	}
+	
+	nodeFree(tree, node);
+}
+
+static inline cpFloat
+bbPerimeter(cpBB bb)
+{
+	return (bb.r - bb.l) + (bb.t - bb.b);
+}
+
+static inline cpBB
+leafBB(cpBB bb)
+{
+	cpFloat margin = cpfmax(bb.r - bb.l, bb.t - bb.b)*LEAF_MARGIN;
+	return cpBBNew(bb.l - margin, bb.b - margin, bb.r + margin, bb.t + margin);
+}
+
+static inline void
+updateBranch(cpBBTreeNode *node)
+{
+	node->bb = cpBBmerge(node->a->bb, node->b->bb);
+	node->height = 1 + (node->a->height > node->b->height ? node->a->height : node->b->height);
+}
+
+// Move child up into the place of node, and node down under child.
+// The taller grandchild stays under child, the other one takes the place of child under node.
+static cpBBTreeNode *
+rotateUp(cpBBTree *tree, cpBBTreeNode *node, cpBBTreeNode *child)
+{
+	cpBBTreeNode *parent = node->parent;
+	cpBBTreeNode *keep = (child->a->height > child->b->height ? child->a : child->b);
+	cpBBTreeNode *move = (keep == child->a ? child->b : child->a);
+	
+	if(node->a == child) node->a = move;
+	else node->b = move;
+	move->parent = node;
+	updateBranch(node);
+	
+	child->a = node;
+	child->b = keep;
+	node->parent = child;
+	child->parent = parent;
+	updateBranch(child);
+	
+	if(parent){
+		if(parent->a == node) parent->a = child;
+		else parent->b = child;
+	} else {
+		tree->root = child;
+	}
+	
+	return child;
+}
+
+// Rotate the taller child up if the children differ in height by more than 1.
+static cpBBTreeNode *
+balance(cpBBTree *tree, cpBBTreeNode *node)
+{
+	int diff = node->b->height - node->a->height;
+	if(diff > 1) return rotateUp(tree, node, node->b);
+	if(diff < -1) return rotateUp(tree, node, node->a);
+	return node;
+}
+
+// Rebalance and recompute the branches from node up to the root.
+static void
+refit(cpBBTree *tree, cpBBTreeNode *node)
+{
+	for(; node; node = node->parent){
+		node = balance(tree, node);
+		updateBranch(node);
+	}
+}
+
+// Cost of putting the leaf under node, not counting the branches above it.
+static inline cpFloat
+insertCost(cpBBTreeNode *node, cpBB bb, cpFloat inherited)
+{
+	cpFloat cost = bbPerimeter(cpBBmerge(node->bb, bb)) + inherited;
+	return (node->a ? cost - bbPerimeter(node->bb) : cost);
+}
+
+static void
+insertLeaf(cpBBTree *tree, cpBBTreeNode *leaf)
+{
+	if(!tree->root){
+		tree->root = leaf;
+		leaf->parent = NULL;
+		return;
+	}
+	
+	// Walk down to the sibling that grows the total perimeter the least.
+	cpBB bb = leaf->bb;
+	cpBBTreeNode *sibling = tree->root;
+	while(sibling->a){
+		cpFloat combined = bbPerimeter(cpBBmerge(sibling->bb, bb));
+		cpFloat cost = 2.0f*combined;
+		cpFloat inherited = 2.0f*(combined - bbPerimeter(sibling->bb));
+		
+		cpFloat costA = insertCost(sibling->a, bb, inherited);
+		cpFloat costB = insertCost(sibling->b, bb, inherited);
+		if(cost < costA && cost < costB) break;
+		
+		sibling = (costA < costB ? sibling->a : sibling->b);
+	}
+	
+	// Put a new branch between the sibling and its parent.
+	cpBBTreeNode *parent = sibling->parent;
+	cpBBTreeNode *branch = nodeAlloc(tree);
+	branch->parent = parent;
+	branch->a = sibling;
+	branch->b = leaf;
+	updateBranch(branch);
+	
+	sibling->parent = branch;
+	leaf->parent = branch;
+	
+	if(parent){
+		if(parent->a == sibling) parent->a = branch;
+		else parent->b = branch;
+		refit(tree, parent);
+	} else {
+		tree->root = branch;
+	}
+}
+
+static void
+removeLeaf(cpBBTree *tree, cpBBTreeNode *leaf)
+{
+	cpBBTreeNode *parent = leaf->parent;
+	leaf->parent = NULL;
+	
+	if(!parent){
+		tree->root = NULL;
+		return;
+	}
+	
+	// Replace the parent branch with the leaf's sibling.
+	cpBBTreeNode *sibling = (parent->a == leaf ? parent->b : parent->a);
+	cpBBTreeNode *grandparent = parent->parent;
+	sibling->parent = grandparent;
+	
+	if(grandparent){
+		if(grandparent->a == parent) grandparent->a = sibling;
+		else grandparent->b = sibling;
+		refit(tree, grandparent);
+	} else {
+		tree->root = sibling;
+	}
+	
+	nodeFree(tree, parent);
+}
+
+#pragma mark Leaf Set Helpers
+
+// Equality function for the leaf set.
+static int
+leafSetEql(void *obj, cpBBTreeNode *leaf)
+{
+	return (obj == leaf->obj);
+}
+
+// Transformation function for the leaf set.
+static void *
+leafSetTrans(void *obj, cpBBTree *tree)
+{
+	cpBBTreeNode *leaf = nodeAlloc(tree);
+	leaf->obj = obj;
+	
+	return leaf;
+}
+
+#pragma mark Memory Management Functions
+
+cpBBTree *
+cpBBTreeAlloc(void)
+{
+	return (cpBBTree *)calloc(1, sizeof(cpBBTree));
+}
+
+cpBBTree *
+cpBBTreeInit(cpBBTree *tree, cpSpatialIndexBBFunc bbfunc)
+{
+	tree->index.klass = cpBBTreeGetClass();
+	tree->index.bbfunc = bbfunc;
+	
+	tree->leaves = cpHashSetNew(0, (cpHashSetEqlFunc)leafSetEql, (cpHashSetTransFunc)leafSetTrans);
+	tree->root = NULL;
+	tree->nodePool = NULL;
+	
+	tree->segmentStack = NULL;
+	tree->segmentStackMax = 0;
+	
+	return tree;
+}
+
+cpBBTree *
+cpBBTreeNew(cpSpatialIndexBBFunc bbfunc)
+{
+	return cpBBTreeInit(cpBBTreeAlloc(), bbfunc);
+}
+
+void
+cpBBTreeDestroy(cpBBTree *tree)
+{
+	if(tree->root) subtreeFree(tree, tree->root);
+	tree->root = NULL;
+	
+	cpHashSetFree(tree->leaves);
+	free(tree->segmentStack);
+}
+
+void
+cpBBTreeFree(cpBBTree *tree)
+{
+	if(!tree) return;
+	cpBBTreeDestroy(tree);
+	free(tree);
+}
+
+#pragma mark Queries
+
+static void
+subtreeQuery(cpBBTreeNode *node, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data)
+{
+	if(!cpBBintersects(node->bb, bb)) return;
+	
+	if(node->a){
+		subtreeQuery(node->a, obj, bb, func, data);
+		subtreeQuery(node->b, obj, bb, func, data);
+	} else if(node->obj != obj){
+		func(obj, node->obj, data);
+	}
+}
+
+// Report the overlapping leaves between two disjoint subtrees.
+static void
+crossPairQuery(cpBBTreeNode *a, cpBBTreeNode *b, cpSpatialIndexQueryFunc func, void *data)
+{
+	if(!cpBBintersects(a->bb, b->bb)) return;
+	
+	if(!a->a && !b->a){
+		func(a->obj, b->obj, data);
+	} else if(!b->a || (a->a && bbPerimeter(a->bb) > bbPerimeter(b->bb))){
+		// Descend into the larger branch first.
+		crossPairQuery(a->a, b, func, data);
+		crossPairQuery(a->b, b, func, data);
+	} else {
+		crossPairQuery(a, b->a, func, data);
+		crossPairQuery(a, b->b, func, data);
+	}
+}
+
+// Report the overlapping leaves within a subtree, every pair exactly once.
+static void
+subtreePairQuery(cpBBTreeNode *node, cpSpatialIndexQueryFunc func, void *data)
+{
+	if(!node->a) return;
+	
+	subtreePairQuery(node->a, func, data);
+	subtreePairQuery(node->b, func, data);
+	crossPairQuery(node->a, node->b, func, data);
+}
+
+// Segments still searched at a node are kept on the stack from top to top + num.
+// The segments crossing the node are copied above them for the children,
+// so the whole batch descends the tree once.
+static void
+subtreeSegmentQuery(cpBBTree *tree, cpBBTreeNode *node, int top, int num, cpSpatialIndexSegment *segments, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	if(tree->segmentStackMax < top + num*2){
+		while(tree->segmentStackMax < top + num*2) tree->segmentStackMax = (tree->segmentStackMax ? tree->segmentStackMax*2 : 64);
+		tree->segmentStack = (int *)realloc(tree->segmentStack, tree->segmentStackMax*sizeof(int));
+	}
+	
+	int crossing = 0;
+	for(int i=0; i<num; i++){
+		int index = tree->segmentStack[top + i];
+		cpSpatialIndexSegment *segment = &segments[index];
+		if(cpBBSegmentQuery(node->bb, segment->a, segment->b) < segment->t_exit){
+			tree->segmentStack[top + num + crossing++] = index;
+		}
+	}
+	if(!crossing) return;
+	
+	if(node->a){
+		subtreeSegmentQuery(tree, node->a, top + num, crossing, segments, func, data);
+		subtreeSegmentQuery(tree, node->b, top + num, crossing, segments, func, data);
+	} else {
+		for(int i=0; i<crossing; i++){
+			int index = tree->segmentStack[top + num + i];
+			cpSpatialIndexSegment *segment = &segments[index];
+			segment->t_exit = cpfmin(segment->t_exit, func(node->obj, index, data));
+		}
+	}
+}
+
+#pragma mark Spatial Index Class
+
+static void
+treeDestroy(cpSpatialIndex *index)
+{
+	cpBBTreeDestroy((cpBBTree *)index);
+}
+
+static void
+treeSetPools(cpSpatialIndex *index, cpSpacePools *pools)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	tree->nodePool = &pools->treeNodes;
+	tree->leaves->binPool = &pools->hashSetBins;
+}
+
+static int
+treeCount(cpSpatialIndex *index)
+{
+	return ((cpBBTree *)index)->leaves->entries;
+}
+
+typedef struct eachContext {
+	cpSpatialIndexIterator func;
+	void *data;
+} eachContext;
+
+static void
+eachHelper(cpBBTreeNode *leaf, eachContext *context)
+{
+	context->func(leaf->obj, context->data);
+}
+
+static void
+treeEach(cpSpatialIndex *index, cpSpatialIndexIterator func, void *data)
+{
+	eachContext context = {func, data};
+	cpHashSetEach(((cpBBTree *)index)->leaves, (cpHashSetIterFunc)eachHelper, &context);
+}
+
+static void
+treeInsert(cpSpatialIndex *index, void *obj, cpHashValue id, cpBB bb)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	
+	cpBBTreeNode *leaf = (cpBBTreeNode *)cpHashSetInsert(tree->leaves, id, obj, tree);
+	if(leaf->parent || tree->root == leaf) return; // Already in the tree.
+	
+	leaf->bb = leafBB(bb);
+	insertLeaf(tree, leaf);
+}
+
+static void
+treeRemove(cpSpatialIndex *index, void *obj, cpHashValue id)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	
+	cpBBTreeNode *leaf = (cpBBTreeNode *)cpHashSetRemove(tree->leaves, id, obj);
+	if(!leaf) return;
+	
+	removeLeaf(tree, leaf);
+	nodeFree(tree, leaf);
+}
+
+// Reinsert the leaves whose objects moved out of their BBox.
+static void
+reindexHelper(cpBBTreeNode *leaf, cpBBTree *tree)
+{
+	cpBB bb = tree->index.bbfunc(leaf->obj);
+	if(cpBBcontainsBB(leaf->bb, bb)) return;
+	
+	removeLeaf(tree, leaf);
+	leaf->bb = leafBB(bb);
+	insertLeaf(tree, leaf);
+}
+
+static void
+treeReindex(cpSpatialIndex *index)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	cpHashSetEach(tree->leaves, (cpHashSetIterFunc)reindexHelper, tree);
+}
+
+static void
+treeReindexQuery(cpSpatialIndex *index, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	treeReindex(index);
+	
+	if(tree->root) subtreePairQuery(tree->root, func, data);
+}
+
+static void
+treePointQuery(cpSpatialIndex *index, cpVect point, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	if(tree->root) subtreeQuery(tree->root, &point, cpBBNew(point.x, point.y, point.x, point.y), func, data);
+}
+
+static void
+treeQuery(cpSpatialIndex *index, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	if(tree->root) subtreeQuery(tree->root, obj, bb, func, data);
+}
+
+static void
+treeSegmentQuery(cpSpatialIndex *index, cpSpatialIndexSegment *segments, int count, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	cpBBTree *tree = (cpBBTree *)index;
+	if(!tree->root || count <= 0) return;
+	
+	if(tree->segmentStackMax < count){
+		tree->segmentStackMax = count;
+		tree->segmentStack = (int *)realloc(tree->segmentStack, count*sizeof(int));
+	}
+	for(int i=0; i<count; i++) tree->segmentStack[i] = i;
+	
+	subtreeSegmentQuery(tree, tree->root, 0, count, segments, func, data);
+}
+
+static const cpSpatialIndexClass klass = {
+	treeDestroy,
+	treeSetPools,
+	treeCount,
+	treeEach,
+	treeInsert,
+	treeRemove,
+	treeReindex,
+	treeReindexQuery,
+	treePointQuery,
+	treeQuery,
+	treeSegmentQuery,
+};
+
+const cpSpatialIndexClass *
+cpBBTreeGetClass(void)
+{
+	return &klass;
+}
@@ -0,0 +1,52 @@
+/* cpBBTree.h
+ * Incremental dynamic AABB tree broadphase, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+// The AABB tree keeps every object in a leaf whose BBox is slightly larger
+// than the object. Leaves are only reinserted when an object leaves its BBox,
+// so a cpBBTree handles scenes with many objects of very different sizes
+// without any tuning. Branches are rotated to keep the tree balanced, so
+// objects inserted in sorted order do not build a deep list-like tree.
+// Use it through the cpSpatialIndex functions.
+
+typedef struct cpBBTreeNode {
+	// Enlarged BBox of a leaf, or the union of the children of a branch.
+	cpBB bb;
+	
+	// Object of a leaf. NULL for branches.
+	void *obj;
+	
+	struct cpBBTreeNode *parent;
+	// Children of a branch. NULL for leaves.
+	struct cpBBTreeNode *a, *b;
+	
+	// Height of the subtree. 0 for leaves. Sibling subtrees differ by at most 1.
+	int height;
+} cpBBTreeNode;
+
+typedef struct cpBBTree {
+	// Common spatial index header. (Holds the BBox callback.)
+	cpSpatialIndex index;
+	
+	// Leaves by object.
+	cpHashSet *leaves;
+	cpBBTreeNode *root;
+	
+	// Pool to allocate the nodes from. Defaults to NULL (use malloc).
+	struct cpPool *nodePool;
+	
+	// Stack of segment indexes for the batched segment queries.
+	int *segmentStack;
+	int segmentStackMax;
+} cpBBTree;
+
+// Basic allocation/destruction functions.
+cpBBTree *cpBBTreeAlloc(void);
+cpBBTree *cpBBTreeInit(cpBBTree *tree, cpSpatialIndexBBFunc bbfunc);
+cpBBTree *cpBBTreeNew(cpSpatialIndexBBFunc bbfunc);
+
+void cpBBTreeDestroy(cpBBTree *tree);
+void cpBBTreeFree(cpBBTree *tree);
+
+const cpSpatialIndexClass *cpBBTreeGetClass(void);
@@ -54,7 +54,14 @@ cpBodyInit(cpBody *body, cpFloat m, cpFloat i)
 	body->w_bias = 0.0f;
 	
 	body->data = NULL;
-//	body->active = 1;
+	
+	body->space = NULL;
+	body->idleTime = 0.0f;
+	body->islandIdleTime = 0.0f;
+	body->islandRoot = NULL;
+	body->islandNext = NULL;
+	body->sleeping = 0;
+	body->solverColors = 0;
 
 	return body;
 }
@@ -160,23 +167,3 @@ cpApplyDampedSpring(cpBody *a, cpBody *b, cpVect anchr1, cpVect anchr2, cpFloat
 	cpBodyApplyForce(a, f, r1);
 	cpBodyApplyForce(b, cpvneg(f), r2);
 }
-
-//int
-//cpBodyMarkLowEnergy(cpBody *body, cpFloat dvsq, int max)
-//{
-//	cpFloat ke = body->m*cpvdot(body->v, body->v);
-//	cpFloat re = body->i*body->w*body->w;
-//	
-//	if(ke + re > body->m*dvsq)
-//		body->active = 1;
-//	else if(body->active)
-//		body->active = (body->active + 1)%(max + 1);
-//	else {
-//		body->v = cpvzero;
-//		body->v_bias = cpvzero;
-//		body->w = 0.0f;
-//		body->w_bias = 0.0f;
-//	}
-//	
-//	return body->active;
-//}
@@ -20,6 +20,7 @@
  */
 
 struct cpBody;
+struct cpSpace;
 typedef void (*cpBodyVelocityFunc)(struct cpBody *body, cpVect gravity, cpFloat damping, cpFloat dt);
 typedef void (*cpBodyPositionFunc)(struct cpBody *body, cpFloat dt);
 
@@ -69,7 +70,26 @@ typedef struct cpBody{
 	cpVect v_bias;
 	cpFloat w_bias;
 	
-//	int active;
+	// *** Sleeping Fields (Used by cpSpace.c)
+	
+	// Space the body was added to. (NULL for static and rogue bodies)
+	struct cpSpace *space;
+	
+	// Time in seconds the body has been moving slower than the idle speed threshold.
+	cpFloat idleTime;
+	// Smallest idleTime in the body's island. Only valid on the island root while stepping.
+	cpFloat islandIdleTime;
+	
+	// Union-find parent while building islands. Root of the island while sleeping.
+	struct cpBody *islandRoot;
+	// Next body in the same sleeping island.
+	struct cpBody *islandNext;
+	
+	// Non-zero while the body's island is sleeping.
+	int sleeping;
+	
+	// Colors used by the arbiters and constraints of the body in this step. (Used by cpParallelSolver.c)
+	unsigned int solverColors;
 } cpBody;
 
 // Basic allocation/destruction functions
@@ -128,9 +148,11 @@ cpBodyWorld2Local(cpBody *body, cpVect v)
 }
 
 // Apply an impulse (in world coordinates) to the body at a point relative to the center of gravity (also in world coordinates).
+// Bodies with infinite mass and moment are left untouched, as cpParallelSolver lets any number of threads share them.
 static inline void
 cpBodyApplyImpulse(cpBody *body, cpVect j, cpVect r)
 {
+	if(body->m_inv == 0.0f && body->i_inv == 0.0f) return;
 	body->v = cpvadd(body->v, cpvmult(j, body->m_inv));
 	body->w += body->i_inv*cpvcross(r, j);
 }
@@ -139,6 +161,7 @@ cpBodyApplyImpulse(cpBody *body, cpVect j, cpVect r)
 static inline void
 cpBodyApplyBiasImpulse(cpBody *body, cpVect j, cpVect r)
 {
+	if(body->m_inv == 0.0f && body->i_inv == 0.0f) return;
 	body->v_bias = cpvadd(body->v_bias, cpvmult(j, body->m_inv));
 	body->w_bias += body->i_inv*cpvcross(r, j);
 }
@@ -152,4 +175,12 @@ void cpBodyApplyForce(cpBody *body, cpVect f, cpVect r);
 // Warning: Large damping values can be unstable. Use a cpDampedSpring constraint for this instead.
 void cpApplyDampedSpring(cpBody *a, cpBody *b, cpVect anchr1, cpVect anchr2, cpFloat rlen, cpFloat k, cpFloat dmp, cpFloat dt);
 
-//int cpBodyMarkLowEnergy(cpBody *body, cpFloat dvsq, int max);
+// Wake the body and every other body in its sleeping island.
+// Does nothing if the body is not sleeping. Defined in cpSpace.c.
+void cpBodyActivate(cpBody *body);
+
+static inline int
+cpBodyIsSleeping(cpBody *body)
+{
+	return body->sleeping;
+}
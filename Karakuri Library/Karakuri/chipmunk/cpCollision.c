@@ -26,12 +26,29 @@
 
 #include "chipmunk.h"
 
-typedef int (*collisionFunc)(cpShape*, cpShape*, cpContact**);
+typedef int (*collisionFunc)(cpShape*, cpShape*, cpContactBuffer*);
+
+// Helper function for adding a contact point to the scratch buffer.
+static cpContact *
+addContactPoint(cpContactBuffer *buf)
+{
+	if(buf->num == buf->max){
+		// Extend it if necessary. The buffer is reused, so this rarely happens.
+		buf->max = (buf->max ? buf->max*2 : 8);
+		buf->arr = (cpContact *)realloc(buf->arr, buf->max*sizeof(cpContact));
+		if(buf->pools) buf->pools->mallocCount++;
+	}
+	
+	cpContact *con = &buf->arr[buf->num];
+	buf->num++;
+	
+	return con;
+}
 
 // Add contact points for circle to circle collisions.
 // Used by several collision tests.
 static int
-circle2circleQuery(cpVect p1, cpVect p2, cpFloat r1, cpFloat r2, cpContact **con)
+circle2circleQuery(cpVect p1, cpVect p2, cpFloat r1, cpFloat r2, cpContactBuffer *buf)
 {
 	cpFloat mindist = r1 + r2;
 	cpVect delta = cpvsub(p2, p1);
@@ -43,9 +60,8 @@ circle2circleQuery(cpVect p1, cpVect p2, cpFloat r1, cpFloat r2, cpContact **con
 	cpFloat non_zero_dist = (dist ? dist : INFINITY);
 
 	// Allocate and initialize the contact.
-	(*con) = (cpContact *)malloc(sizeof(cpContact));
 	cpContactInit(
-		(*con),
+		addContactPoint(buf),
 		cpvadd(p1, cpvmult(delta, 0.5 + (r1 - 0.5*mindist)/non_zero_dist)),
 		cpvmult(delta, 1.0/non_zero_dist),
 		dist - mindist,
@@ -57,17 +73,17 @@ circle2circleQuery(cpVect p1, cpVect p2, cpFloat r1, cpFloat r2, cpContact **con
 
 // Collide circle shapes.
 static int
-circle2circle(cpShape *shape1, cpShape *shape2, cpContact **arr)
+circle2circle(cpShape *shape1, cpShape *shape2, cpContactBuffer *buf)
 {
 	cpCircleShape *circ1 = (cpCircleShape *)shape1;
 	cpCircleShape *circ2 = (cpCircleShape *)shape2;
 	
-	return circle2circleQuery(circ1->tc, circ2->tc, circ1->r, circ2->r, arr);
+	return circle2circleQuery(circ1->tc, circ2->tc, circ1->r, circ2->r, buf);
 }
 
 // Collide circles to segment shapes.
 static int
-circle2segment(cpShape *circleShape, cpShape *segmentShape, cpContact **con)
+circle2segment(cpShape *circleShape, cpShape *segmentShape, cpContactBuffer *buf)
 {
 	cpCircleShape *circ = (cpCircleShape *)circleShape;
 	cpSegmentShape *seg = (cpSegmentShape *)segmentShape;
@@ -90,14 +106,13 @@ circle2segment(cpShape *circleShape, cpShape *segmentShape, cpContact **con)
 		if(dt < (dtMin - rsum)){
 			return 0;
 		} else {
-			return circle2circleQuery(circ->tc, seg->ta, circ->r, seg->r, con);
+			return circle2circleQuery(circ->tc, seg->ta, circ->r, seg->r, buf);
 		}
 	} else {
 		if(dt < dtMax){
 			cpVect n = (dn < 0.0f) ? seg->tn : cpvneg(seg->tn);
-			(*con) = (cpContact *)malloc(sizeof(cpContact));
 			cpContactInit(
-				(*con),
+				addContactPoint(buf),
 				cpvadd(circ->tc, cpvmult(n, circ->r + dist*0.5f)),
 				n,
 				dist,
@@ -106,7 +121,7 @@ circle2segment(cpShape *circleShape, cpShape *segmentShape, cpContact **con)
 			return 1;
 		} else {
 			if(dt < (dtMax + rsum)) {
-				return circle2circleQuery(circ->tc, seg->tb, circ->r, seg->r, con);
+				return circle2circleQuery(circ->tc, seg->tb, circ->r, seg->r, buf);
 			} else {
 				return 0;
 			}
@@ -116,27 +131,6 @@ circle2segment(cpShape *circleShape, cpShape *segmentShape, cpContact **con)
 	return 1;
 }
 
-// Helper function for allocating contact point lists.
-static cpContact *
-addContactPoint(cpContact **arr, int *max, int *num)
-{
-	if(*arr == NULL){
-		// Allocate the array if it hasn't been done.
-		(*max) = 2;
-		(*num) = 0;
-		(*arr) = (cpContact *)malloc((*max)*sizeof(cpContact));
-	} else if(*num == *max){
-		// Extend it if necessary.
-		(*max) *= 2;
-		(*arr) = (cpContact *)realloc(*arr, (*max)*sizeof(cpContact));
-	}
-	
-	cpContact *con = &(*arr)[*num];
-	(*num)++;
-	
-	return con;
-}
-
 // Find the minimum separating axis for the give poly and axis list.
 static inline int
 findMSA(cpPolyShape *poly, cpPolyShapeAxis *axes, int num, cpFloat *min_out)
@@ -159,34 +153,72 @@ findMSA(cpPolyShape *poly, cpPolyShapeAxis *axes, int num, cpFloat *min_out)
 	return min_index;
 }
 
+#if CP_USE_SIMD
+
+// Add a contact for each vertex of poly inside other, four vertices at a time.
+// Same as the loops in the scalar findVerts() below.
+static inline void
+addVertsInside(cpContactBuffer *buf, cpPolyShape *poly, cpPolyShape *other, cpVect partialN, cpVect n, cpFloat dist)
+{
+	cpVect *verts = poly->tVerts;
+	int num = poly->numVerts;
+	cpPolyShapeAxis *axes = other->tAxes;
+	
+	for(int i=0; i<num; i+=4){
+		cpVect4 v = cpVect4Load(verts + i, num - i);
+		
+		int outside = 0;
+		for(int j=0; j<other->numVerts && outside != 0xF; j++){
+			if(cpvdot(axes[j].n, partialN) < 0.0f) continue;
+			outside |= cpVect4OutsideMask(v, axes[j].n, axes[j].d);
+		}
+		
+		for(int k=0; k<4 && i + k<num; k++){
+			if(!(outside & (1<<k)))
+				cpContactInit(addContactPoint(buf), verts[i + k], n, dist, CP_HASH_PAIR(poly, i + k));
+		}
+	}
+}
+
 // Add contacts for penetrating vertexes.
 static inline int
-findVerts(cpContact **arr, cpPolyShape *poly1, cpPolyShape *poly2, cpVect n, cpFloat dist)
+findVerts(cpContactBuffer *buf, cpPolyShape *poly1, cpPolyShape *poly2, cpVect n, cpFloat dist)
 {
-	int max = 0;
-	int num = 0;
+	addVertsInside(buf, poly1, poly2, cpvneg(n), n, dist);
+	addVertsInside(buf, poly2, poly1, n, n, dist);
 	
+	return buf->num;
+}
+
+#else
+
+// Add contacts for penetrating vertexes.
+static inline int
+findVerts(cpContactBuffer *buf, cpPolyShape *poly1, cpPolyShape *poly2, cpVect n, cpFloat dist)
+{
 	for(int i=0; i<poly1->numVerts; i++){
 		cpVect v = poly1->tVerts[i];
 		if(cpPolyShapeContainsVertPartial(poly2, v, cpvneg(n)))
-			cpContactInit(addContactPoint(arr, &max, &num), v, n, dist, CP_HASH_PAIR(poly1, i));
+			cpContactInit(addContactPoint(buf), v, n, dist, CP_HASH_PAIR(poly1, i));
 	}
 	
 	for(int i=0; i<poly2->numVerts; i++){
 		cpVect v = poly2->tVerts[i];
 		if(cpPolyShapeContainsVertPartial(poly1, v, n))
-			cpContactInit(addContactPoint(arr, &max, &num), v, n, dist, CP_HASH_PAIR(poly2, i));
+			cpContactInit(addContactPoint(buf), v, n, dist, CP_HASH_PAIR(poly2, i));
 	}
 	
 	//	if(!num)
 	//		addContactPoint(arr, &size, &num, cpContactNew(shape1->body->p, n, dist, 0));
 
-	return num;
+	return buf->num;
 }
 
+#endif
+
 // Collide poly shapes together.
 static int
-poly2poly(cpShape *shape1, cpShape *shape2, cpContact **arr)
+poly2poly(cpShape *shape1, cpShape *shape2, cpContactBuffer *buf)
 {
 	cpPolyShape *poly1 = (cpPolyShape *)shape1;
 	cpPolyShape *poly2 = (cpPolyShape *)shape2;
@@ -201,9 +233,9 @@ poly2poly(cpShape *shape1, cpShape *shape2, cpContact **arr)
 	
 	// There is overlap, find the penetrating verts
 	if(min1 > min2)
-		return findVerts(arr, poly1, poly2, poly1->tAxes[mini1].n, min1);
+		return findVerts(buf, poly1, poly2, poly1->tAxes[mini1].n, min1);
 	else
-		return findVerts(arr, poly1, poly2, cpvneg(poly2->tAxes[mini2].n), min2);
+		return findVerts(buf, poly1, poly2, cpvneg(poly2->tAxes[mini2].n), min2);
 }
 
 // Like cpPolyValueOnAxis(), but for segments.
@@ -217,7 +249,7 @@ segValueOnAxis(cpSegmentShape *seg, cpVect n, cpFloat d)
 
 // Identify vertexes that have penetrated the segment.
 static inline void
-findPointsBehindSeg(cpContact **arr, int *max, int *num, cpSegmentShape *seg, cpPolyShape *poly, cpFloat pDist, cpFloat coef) 
+findPointsBehindSeg(cpContactBuffer *buf, cpSegmentShape *seg, cpPolyShape *poly, cpFloat pDist, cpFloat coef) 
 {
 	cpFloat dta = cpvcross(seg->tn, seg->ta);
 	cpFloat dtb = cpvcross(seg->tn, seg->tb);
@@ -228,7 +260,7 @@ findPointsBehindSeg(cpContact **arr, int *max, int *num, cpSegmentShape *seg, cp
 		if(cpvdot(v, n) < cpvdot(seg->tn, seg->ta)*coef + seg->r){
 			cpFloat dt = cpvcross(seg->tn, v);
 			if(dta >= dt && dt >= dtb){
-				cpContactInit(addContactPoint(arr, max, num), v, n, pDist, CP_HASH_PAIR(poly, i));
+				cpContactInit(addContactPoint(buf), v, n, pDist, CP_HASH_PAIR(poly, i));
 			}
 		}
 	}
@@ -237,7 +269,7 @@ findPointsBehindSeg(cpContact **arr, int *max, int *num, cpSegmentShape *seg, cp
 // This one is complicated and gross. Just don't go there...
 // TODO: Comment me!
 static int
-seg2poly(cpShape *shape1, cpShape *shape2, cpContact **arr)
+seg2poly(cpShape *shape1, cpShape *shape2, cpContactBuffer *buf)
 {
 	cpSegmentShape *seg = (cpSegmentShape *)shape1;
 	cpPolyShape *poly = (cpPolyShape *)shape2;
@@ -261,53 +293,50 @@ seg2poly(cpShape *shape1, cpShape *shape2, cpContact **arr)
 		}
 	}
 	
-	int max = 0;
-	int num = 0;
-	
 	cpVect poly_n = cpvneg(axes[mini].n);
 	
 	cpVect va = cpvadd(seg->ta, cpvmult(poly_n, seg->r));
 	cpVect vb = cpvadd(seg->tb, cpvmult(poly_n, seg->r));
 	if(cpPolyShapeContainsVert(poly, va))
-		cpContactInit(addContactPoint(arr, &max, &num), va, poly_n, poly_min, CP_HASH_PAIR(seg, 0));
+		cpContactInit(addContactPoint(buf), va, poly_n, poly_min, CP_HASH_PAIR(seg, 0));
 	if(cpPolyShapeContainsVert(poly, vb))
-		cpContactInit(addContactPoint(arr, &max, &num), vb, poly_n, poly_min, CP_HASH_PAIR(seg, 1));
+		cpContactInit(addContactPoint(buf), vb, poly_n, poly_min, CP_HASH_PAIR(seg, 1));
 
 	// Floating point precision problems here.
 	// This will have to do for now.
 	poly_min -= cp_collision_slop;
 	if(minNorm >= poly_min || minNeg >= poly_min) {
 		if(minNorm > minNeg)
-			findPointsBehindSeg(arr, &max, &num, seg, poly, minNorm, 1.0f);
+			findPointsBehindSeg(buf, seg, poly, minNorm, 1.0f);
 		else
-			findPointsBehindSeg(arr, &max, &num, seg, poly, minNeg, -1.0f);
+			findPointsBehindSeg(buf, seg, poly, minNeg, -1.0f);
 	}
 	
 	// If no other collision points are found, try colliding endpoints.
-	if(num == 0){
+	if(buf->num == 0){
 		cpVect poly_a = poly->tVerts[mini];
 		cpVect poly_b = poly->tVerts[(mini + 1)%poly->numVerts];
 		
-		if(circle2circleQuery(seg->ta, poly_a, seg->r, 0.0f, arr))
+		if(circle2circleQuery(seg->ta, poly_a, seg->r, 0.0f, buf))
 			return 1;
 			
-		if(circle2circleQuery(seg->tb, poly_a, seg->r, 0.0f, arr))
+		if(circle2circleQuery(seg->tb, poly_a, seg->r, 0.0f, buf))
 			return 1;
 			
-		if(circle2circleQuery(seg->ta, poly_b, seg->r, 0.0f, arr))
+		if(circle2circleQuery(seg->ta, poly_b, seg->r, 0.0f, buf))
 			return 1;
 			
-		if(circle2circleQuery(seg->tb, poly_b, seg->r, 0.0f, arr))
+		if(circle2circleQuery(seg->tb, poly_b, seg->r, 0.0f, buf))
 			return 1;
 	}
 
-	return num;
+	return buf->num;
 }
 
 // This one is less gross, but still gross.
 // TODO: Comment me!
 static int
-circle2poly(cpShape *shape1, cpShape *shape2, cpContact **con)
+circle2poly(cpShape *shape1, cpShape *shape2, cpContactBuffer *buf)
 {
 	cpCircleShape *circ = (cpCircleShape *)shape1;
 	cpPolyShape *poly = (cpPolyShape *)shape2;
@@ -333,11 +362,10 @@ circle2poly(cpShape *shape1, cpShape *shape2, cpContact **con)
 	cpFloat dt = cpvcross(n, circ->tc);
 		
 	if(dt < dtb){
-		return circle2circleQuery(circ->tc, b, circ->r, 0.0f, con);
+		return circle2circleQuery(circ->tc, b, circ->r, 0.0f, buf);
 	} else if(dt < dta) {
-		(*con) = (cpContact *)malloc(sizeof(cpContact));
 		cpContactInit(
-			(*con),
+			addContactPoint(buf),
 			cpvsub(circ->tc, cpvmult(n, circ->r + min/2.0f)),
 			cpvneg(n),
 			min,
@@ -346,7 +374,7 @@ circle2poly(cpShape *shape1, cpShape *shape2, cpContact **con)
 	
 		return 1;
 	} else {
-		return circle2circleQuery(circ->tc, a, circ->r, 0.0f, con);
+		return circle2circleQuery(circ->tc, a, circ->r, 0.0f, buf);
 	}
 }
 
@@ -393,11 +421,13 @@ extern "C" {
 #endif
 
 int
-cpCollideShapes(cpShape *a, cpShape *b, cpContact **arr)
+cpCollideShapes(cpShape *a, cpShape *b, cpContactBuffer *buf)
 {
+	buf->num = 0;
+	
 	// Their shape types must be in order.
 	assert(a->klass->type <= b->klass->type);
 	
 	collisionFunc cfunc = colfuncs[a->klass->type + b->klass->type*CP_NUM_SHAPES];
-	return (cfunc) ? cfunc(a, b, arr) : 0;
+	return (cfunc) ? cfunc(a, b, buf) : 0;
 }
@@ -19,5 +19,17 @@
  * SOFTWARE.
  */
 
+// Growable scratch array the collision functions write their contacts into.
+// It is owned by the space and reused, so it only grows to the largest contact count seen.
+typedef struct cpContactBuffer {
+	cpContact *arr;
+	int num;
+	int max;
+	
+	// Pools to report buffer growth to. (may be NULL)
+	struct cpSpacePools *pools;
+} cpContactBuffer;
+
 // Collides two cpShape structures. (this function is lonely :( )
-int cpCollideShapes(cpShape *a, cpShape *b, cpContact **arr);
+// The contacts are stored in buffer->arr and their count is returned.
+int cpCollideShapes(cpShape *a, cpShape *b, cpContactBuffer *buffer);
@@ -25,6 +25,19 @@
 #include "chipmunk.h"
 #include "prime.h"
 
+static inline cpHashSetBin *
+binAlloc(cpHashSet *set)
+{
+	return (set->binPool ? (cpHashSetBin *)cpPoolAlloc(set->binPool) : (cpHashSetBin *)malloc(sizeof(cpHashSetBin)));
+}
+
+static inline void
+binFree(cpHashSet *set, cpHashSetBin *bin)
+{
+	if(set->binPool) cpPoolFree(set->binPool, bin);
+	else free(bin);
+}
+
 void
 cpHashSetDestroy(cpHashSet *set)
 {
@@ -34,7 +47,7 @@ cpHashSetDestroy(cpHashSet *set)
 		cpHashSetBin *bin = set->table[i];
 		while(bin){
 			cpHashSetBin *next = bin->next;
-			free(bin);
+			binFree(set, bin);
 			bin = next;
 		}
 	}
@@ -66,6 +79,7 @@ cpHashSetInit(cpHashSet *set, int size, cpHashSetEqlFunc eqlFunc, cpHashSetTrans
 	set->trans = trans;
 	
 	set->default_value = NULL;
+	set->binPool = NULL;
 	
 	set->table = (cpHashSetBin **)calloc(set->size, sizeof(cpHashSetBin *));
 	
@@ -125,7 +139,7 @@ cpHashSetInsert(cpHashSet *set, cpHashValue hash, void *ptr, void *data)
 	
 	// Create it necessary.
 	if(!bin){
-		bin = (cpHashSetBin *)malloc(sizeof(cpHashSetBin));
+		bin = binAlloc(set);
 		bin->hash = hash;
 		bin->elt = set->trans(ptr, data); // Transform the pointer.
 		
@@ -167,7 +181,7 @@ cpHashSetRemove(cpHashSet *set, cpHashValue hash, void *ptr)
 		void *return_value = bin->elt;
 		
 //		*bin = (cpHashSetBin){};
-		free(bin);
+		binFree(set, bin);
 		
 		return return_value;
 	}
@@ -216,7 +230,7 @@ cpHashSetReject(cpHashSet *set, cpHashSetRejectFunc func, void *data)
 				(*prev_ptr) = next;
 
 				set->entries--;
-				free(bin);
+				binFree(set, bin);
 			}
 			
 			bin = next;
@@ -55,6 +55,9 @@ typedef struct cpHashSet {
 	void *default_value;
 	
 	cpHashSetBin **table;
+	
+	// Pool to allocate the bins from. Defaults to NULL (use malloc).
+	struct cpPool *binPool;
 } cpHashSet;
 
 // Basic allocation/destruction functions.
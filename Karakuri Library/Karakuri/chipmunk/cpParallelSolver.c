@@ -0,0 +1,346 @@
+/* cpParallelSolver.c
+ * Graph-colored multi-threaded impulse solver, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "chipmunk.h"
+
+// Colors are tracked with one bit per color on each body.
+#define MAX_COLORS 32
+// Items that don't fit in MAX_COLORS colors are solved by one thread after the colors.
+#define OVERFLOW_COLOR MAX_COLORS
+#define MAX_THREADS 64
+// Below this many arbiters and constraints the threads cost more than they save.
+#define MIN_PARALLEL_ITEMS 128
+// Spins before a thread waiting at the barrier yields its CPU.
+#define SPINS_BEFORE_YIELD 1024
+
+typedef struct cpSolverWorker {
+	cpParallelSolver *solver;
+	pthread_t thread;
+	int index;
+	int sense;
+} cpSolverWorker;
+
+struct cpParallelSolver {
+	int threadCount;
+	int deterministic;
+
+	// Worker threads. (threadCount - 1 of them, the caller is thread 0)
+	cpSolverWorker *workers;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int generation;
+	int quit;
+
+	// Sense-reversing spin barrier.
+	volatile int barrierCount;
+	volatile int barrierSense;
+	int callerSense;
+
+	// Current job.
+	int iterations;
+	cpFloat eCoef;
+
+	// Arbiters and constraints sorted by color.
+	cpArbiter **arbiters;
+	cpConstraint **constraints;
+	int *colors;
+	int arbiterCapacity, constraintCapacity, colorCapacity;
+	int arbiterStart[MAX_COLORS + 2];
+	int constraintStart[MAX_COLORS + 2];
+	int colorCount;
+};
+
+#pragma mark Barrier
+
+static void
+barrierWait(cpParallelSolver *solver, int *sense)
+{
+	int localSense = !*sense;
+	*sense = localSense;
+
+	if(__sync_add_and_fetch(&solver->barrierCount, 1) == solver->threadCount){
+		solver->barrierCount = 0;
+		__sync_synchronize();
+		solver->barrierSense = localSense;
+	} else {
+		int spins = 0;
+		while(solver->barrierSense != localSense){
+			if(++spins == SPINS_BEFORE_YIELD){
+				spins = 0;
+				sched_yield();
+			}
+		}
+		__sync_synchronize();
+	}
+}
+
+#pragma mark Solving
+
+static void
+solveColor(cpParallelSolver *solver, int color, int index, int count, cpFloat eCoef)
+{
+	int start = solver->arbiterStart[color];
+	int num = solver->arbiterStart[color + 1] - start;
+	cpArbiter **arbiters = solver->arbiters + start;
+	for(int i=num*index/count, end=num*(index + 1)/count; i<end; i++)
+		cpArbiterApplyImpulse(arbiters[i], eCoef);
+
+	start = solver->constraintStart[color];
+	num = solver->constraintStart[color + 1] - start;
+	cpConstraint **constraints = solver->constraints + start;
+	for(int i=num*index/count, end=num*(index + 1)/count; i<end; i++)
+		constraints[i]->klass->applyImpulse(constraints[i]);
+}
+
+static inline int
+colorIsEmpty(cpParallelSolver *solver, int color)
+{
+	return (solver->arbiterStart[color] == solver->arbiterStart[color + 1] &&
+			solver->constraintStart[color] == solver->constraintStart[color + 1]);
+}
+
+// Every thread runs this with the same job, so they all skip the same empty colors.
+static void
+runIterations(cpParallelSolver *solver, int index, int *sense)
+{
+	int count = solver->threadCount;
+	cpFloat eCoef = solver->eCoef;
+
+	for(int i=0; i<solver->iterations; i++){
+		for(int color=0; color<solver->colorCount; color++){
+			solveColor(solver, color, index, count, eCoef);
+			if(count > 1) barrierWait(solver, sense);
+		}
+
+		if(!colorIsEmpty(solver, OVERFLOW_COLOR)){
+			if(index == 0) solveColor(solver, OVERFLOW_COLOR, 0, 1, eCoef);
+			if(count > 1) barrierWait(solver, sense);
+		}
+	}
+	
+	// Nobody leaves the job early, or a late worker could mistake the next job for this one.
+	if(count > 1) barrierWait(solver, sense);
+}
+
+static void *
+workerMain(void *data)
+{
+	cpSolverWorker *worker = (cpSolverWorker *)data;
+	cpParallelSolver *solver = worker->solver;
+	int generation = 0;
+
+	for(;;){
+		pthread_mutex_lock(&solver->mutex);
+		while(solver->generation == generation && !solver->quit)
+			pthread_cond_wait(&solver->cond, &solver->mutex);
+		generation = solver->generation;
+		int quit = solver->quit;
+		pthread_mutex_unlock(&solver->mutex);
+
+		if(quit) break;
+		runIterations(solver, worker->index, &worker->sense);
+	}
+
+	return NULL;
+}
+
+#pragma mark Memory Management
+
+cpParallelSolver *
+cpParallelSolverNew(int threadCount, int deterministic)
+{
+	if(threadCount <= 0){
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		threadCount = (cpus > 0 ? (int)cpus : 1);
+	}
+	if(threadCount > MAX_THREADS) threadCount = MAX_THREADS;
+
+	cpParallelSolver *solver = (cpParallelSolver *)calloc(1, sizeof(cpParallelSolver));
+	solver->threadCount = threadCount;
+	solver->deterministic = deterministic;
+
+	pthread_mutex_init(&solver->mutex, NULL);
+	pthread_cond_init(&solver->cond, NULL);
+
+	if(threadCount > 1){
+		solver->workers = (cpSolverWorker *)calloc(threadCount - 1, sizeof(cpSolverWorker));
+		for(int i=0; i<threadCount - 1; i++){
+			cpSolverWorker *worker = &solver->workers[i];
+			worker->solver = solver;
+			worker->index = i + 1;
+			pthread_create(&worker->thread, NULL, &workerMain, worker);
+		}
+	}
+
+	return solver;
+}
+
+void
+cpParallelSolverFree(cpParallelSolver *solver)
+{
+	if(!solver) return;
+
+	pthread_mutex_lock(&solver->mutex);
+	solver->quit = 1;
+	pthread_cond_broadcast(&solver->cond);
+	pthread_mutex_unlock(&solver->mutex);
+
+	for(int i=0; i<solver->threadCount - 1; i++)
+		pthread_join(solver->workers[i].thread, NULL);
+	free(solver->workers);
+
+	pthread_cond_destroy(&solver->cond);
+	pthread_mutex_destroy(&solver->mutex);
+
+	free(solver->arbiters);
+	free(solver->constraints);
+	free(solver->colors);
+	free(solver);
+}
+
+int
+cpParallelSolverGetThreadCount(cpParallelSolver *solver)
+{
+	return solver->threadCount;
+}
+
+int
+cpParallelSolverIsDeterministic(cpParallelSolver *solver)
+{
+	return solver->deterministic;
+}
+
+int
+cpParallelSolverGetColorCount(cpParallelSolver *solver)
+{
+	return solver->colorCount;
+}
+
+#pragma mark Coloring
+
+// Bodies that never change velocity can be shared by any number of items of the same color.
+// cpBodyApplyImpulse() and the constraint helpers in util.h never write to them, so only their velocity is read.
+static inline int
+bodyIsShared(cpBody *body)
+{
+	return (body->m_inv == 0.0f && body->i_inv == 0.0f);
+}
+
+static inline void
+clearBodyColors(cpBody *a, cpBody *b)
+{
+	a->solverColors = 0;
+	b->solverColors = 0;
+}
+
+// Pick the lowest color neither body uses yet.
+static int
+pickColor(cpBody *a, cpBody *b)
+{
+	int sharedA = bodyIsShared(a);
+	int sharedB = bodyIsShared(b);
+	unsigned int used = (sharedA ? 0 : a->solverColors) | (sharedB ? 0 : b->solverColors);
+
+	int color = 0;
+	while(color < MAX_COLORS && (used & (1u << color))) color++;
+	if(color == MAX_COLORS) return OVERFLOW_COLOR;
+
+	if(!sharedA) a->solverColors |= 1u << color;
+	if(!sharedB) b->solverColors |= 1u << color;
+	return color;
+}
+
+static void
+growScratch(void **arr, int *capacity, int count, size_t size)
+{
+	if(count <= *capacity) return;
+
+	int newCapacity = (*capacity ? *capacity : 64);
+	while(newCapacity < count) newCapacity *= 2;
+	*arr = realloc(*arr, newCapacity*size);
+	*capacity = newCapacity;
+}
+
+// Counting sort of the items by color. start[] receives the first index of each color.
+#define SORT_BY_COLOR(type, src, num, dst, start) { \
+	int counts[MAX_COLORS + 1] = {0}; \
+	for(int i=0; i<num; i++) counts[colors[i]]++; \
+	start[0] = 0; \
+	for(int c=0; c<=MAX_COLORS; c++) start[c + 1] = start[c] + counts[c]; \
+	int offsets[MAX_COLORS + 1]; \
+	for(int c=0; c<=MAX_COLORS; c++) offsets[c] = start[c]; \
+	for(int i=0; i<num; i++) dst[offsets[colors[i]]++] = (type)src[i]; \
+}
+
+int
+cpParallelSolverPrepare(cpParallelSolver *solver, cpArray *arbiters, cpArray *constraints)
+{
+	int numArbiters = arbiters->num;
+	int numConstraints = constraints->num;
+
+	if(!solver->deterministic){
+		if(solver->threadCount < 2 || numArbiters + numConstraints < MIN_PARALLEL_ITEMS) return 0;
+	}
+
+	growScratch((void **)&solver->arbiters, &solver->arbiterCapacity, numArbiters, sizeof(cpArbiter *));
+	growScratch((void **)&solver->constraints, &solver->constraintCapacity, numConstraints, sizeof(cpConstraint *));
+	growScratch((void **)&solver->colors, &solver->colorCapacity, (numArbiters > numConstraints ? numArbiters : numConstraints), sizeof(int));
+	int *colors = solver->colors;
+
+	for(int i=0; i<numArbiters; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		clearBodyColors(arb->a->body, arb->b->body);
+	}
+	for(int i=0; i<numConstraints; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		clearBodyColors(constraint->a, constraint->b);
+	}
+
+	int colorCount = 0;
+
+	for(int i=0; i<numArbiters; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		int color = pickColor(arb->a->body, arb->b->body);
+		if(color != OVERFLOW_COLOR && color >= colorCount) colorCount = color + 1;
+		colors[i] = color;
+	}
+	SORT_BY_COLOR(cpArbiter *, arbiters->arr, numArbiters, solver->arbiters, solver->arbiterStart);
+
+	// Constraints keep coloring on top of the colors used by the arbiters.
+	for(int i=0; i<numConstraints; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		int color = pickColor(constraint->a, constraint->b);
+		if(color != OVERFLOW_COLOR && color >= colorCount) colorCount = color + 1;
+		colors[i] = color;
+	}
+	SORT_BY_COLOR(cpConstraint *, constraints->arr, numConstraints, solver->constraints, solver->constraintStart);
+
+	solver->colorCount = colorCount;
+	return 1;
+}
+
+void
+cpParallelSolverApplyImpulses(cpParallelSolver *solver, int iterations, cpFloat eCoef)
+{
+	if(iterations <= 0) return;
+
+	solver->iterations = iterations;
+	solver->eCoef = eCoef;
+
+	if(solver->threadCount > 1){
+		pthread_mutex_lock(&solver->mutex);
+		solver->generation++;
+		pthread_cond_broadcast(&solver->cond);
+		pthread_mutex_unlock(&solver->mutex);
+	}
+
+	// The closing barrier of the job makes sure all the workers are done.
+	runIterations(solver, 0, &solver->callerSense);
+}
@@ -0,0 +1,41 @@
+/* cpParallelSolver.h
+ * Graph-colored multi-threaded impulse solver, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+// The arbiters and constraints of a step are split into colors so that no two
+// items of the same color share a body with finite mass. The items of one color
+// are then solved on several threads at once, and the colors are solved one
+// after another. Bodies with infinite mass and moment (static bodies) never get
+// a velocity change, so they don't count as shared.
+//
+// The colors are assigned greedily in the order of the arbiter and constraint
+// arrays, so the result only depends on that order: it is identical no matter
+// how many threads run the solver or how they are scheduled. It differs slightly
+// from the result of the plain serial solver, which visits all arbiters and then
+// all constraints.
+
+struct cpSpace;
+
+typedef struct cpParallelSolver cpParallelSolver;
+
+// Create a solver using threadCount threads, including the thread calling cpSpaceStep().
+// Pass 0 to use one thread per online CPU.
+// If deterministic is non-zero, the colored order is used even when the step is
+// solved on one thread, so a simulation gives the same result on every machine.
+// Otherwise the plain serial solver is used when only one CPU is available or
+// when there are too few arbiters and constraints to be worth the threads.
+cpParallelSolver *cpParallelSolverNew(int threadCount, int deterministic);
+void cpParallelSolverFree(cpParallelSolver *solver);
+
+int cpParallelSolverGetThreadCount(cpParallelSolver *solver);
+int cpParallelSolverIsDeterministic(cpParallelSolver *solver);
+
+// Used by cpSpaceStep().
+// Color the arbiters and constraints of this step. Returns 0 if the plain serial solver should be used instead.
+int cpParallelSolverPrepare(cpParallelSolver *solver, cpArray *arbiters, cpArray *constraints);
+// Run iterations of the solver on the prepared colors.
+void cpParallelSolverApplyImpulses(cpParallelSolver *solver, int iterations, cpFloat eCoef);
+
+// Number of colors used by the last prepared step. (The serial overflow batch is not counted)
+int cpParallelSolverGetColorCount(cpParallelSolver *solver);
@@ -58,14 +58,7 @@ cpVect cpPolyShapeGetVert(cpShape *shape, int index);
 static inline cpFloat
 cpPolyShapeValueOnAxis(const cpPolyShape *poly, const cpVect n, const cpFloat d)
 {
-	cpVect *verts = poly->tVerts;
-	cpFloat min = cpvdot(n, verts[0]);
-	
-	int i;
-	for(i=1; i<poly->numVerts; i++)
-		min = cpfmin(min, cpvdot(n, verts[i]));
-	
-	return min - d;
+	return cpvMinDot(poly->tVerts, poly->numVerts, n) - d;
 }
 
 // Returns true if the polygon contains the vertex.
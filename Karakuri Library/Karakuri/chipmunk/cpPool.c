@@ -0,0 +1,193 @@
+/* cpPool.c
+ * Slab pools for the short-lived objects of a cpSpace, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+ 
+#include <stdlib.h>
+
+#include "chipmunk.h"
+
+// Objects and slab headers are aligned so that vector types can be stored safely.
+#define CP_POOL_ALIGN 16
+#define CP_POOL_ROUND(size) (((size) + (CP_POOL_ALIGN - 1)) & ~(size_t)(CP_POOL_ALIGN - 1))
+
+// Aim for slabs of about this many bytes.
+#define CP_POOL_SLAB_SIZE 16384
+
+cpPool *
+cpPoolInit(cpPool *pool, size_t size, int count)
+{
+	pool->size = CP_POOL_ROUND(size);
+	if(count <= 0){
+		count = (int)(CP_POOL_SLAB_SIZE/pool->size);
+		if(count < 8) count = 8;
+	}
+	pool->count = count;
+	
+	pool->freeList = NULL;
+	pool->slabs = NULL;
+	
+	pool->allocCount = 0;
+	pool->slabCount = 0;
+	pool->reservedBytes = 0;
+	
+	return pool;
+}
+
+void
+cpPoolDestroy(cpPool *pool)
+{
+	// Free the slabs wholesale. Outstanding objects become invalid.
+	void *slab = pool->slabs;
+	while(slab){
+		void *next = *(void **)slab;
+		free(slab);
+		slab = next;
+	}
+	
+	pool->slabs = NULL;
+	pool->freeList = NULL;
+	pool->reservedBytes = 0;
+}
+
+static void
+cpPoolAddSlab(cpPool *pool)
+{
+	size_t header = CP_POOL_ROUND(sizeof(void *));
+	char *slab = (char *)malloc(header + pool->size*pool->count);
+	
+	*(void **)slab = pool->slabs;
+	pool->slabs = slab;
+	pool->slabCount++;
+	pool->reservedBytes += header + pool->size*pool->count;
+	
+	// Thread the new objects onto the free list in address order.
+	char *objects = slab + header;
+	for(int i=pool->count - 1; i>=0; i--){
+		void *obj = objects + pool->size*i;
+		*(void **)obj = pool->freeList;
+		pool->freeList = obj;
+	}
+}
+
+void *
+cpPoolAlloc(cpPool *pool)
+{
+	if(!pool->freeList) cpPoolAddSlab(pool);
+	
+	void *obj = pool->freeList;
+	pool->freeList = *(void **)obj;
+	pool->allocCount++;
+	
+	return obj;
+}
+
+void
+cpPoolFree(cpPool *pool, void *ptr)
+{
+	if(!ptr) return;
+	
+	*(void **)ptr = pool->freeList;
+	pool->freeList = ptr;
+}
+
+#pragma mark Space Pools
+
+cpSpacePools *
+cpSpacePoolsNew(void)
+{
+	cpSpacePools *pools = (cpSpacePools *)calloc(1, sizeof(cpSpacePools));
+	
+	cpPoolInit(&pools->arbiters, sizeof(cpArbiter), 0);
+	cpPoolInit(&pools->contacts, sizeof(cpContact)*CP_POOLED_CONTACT_COUNT, 0);
+	cpPoolInit(&pools->hashSetBins, sizeof(cpHashSetBin), 0);
+	cpPoolInit(&pools->spaceHashBins, sizeof(cpSpaceHashBin), 0);
+	cpPoolInit(&pools->handles, sizeof(cpHandle), 0);
+	cpPoolInit(&pools->treeNodes, sizeof(cpBBTreeNode), 0);
+	cpPoolInit(&pools->sweepHandles, sizeof(cpSweep1DHandle), 0);
+	
+	return pools;
+}
+
+void
+cpSpacePoolsFree(cpSpacePools *pools)
+{
+	if(!pools) return;
+	
+	cpPoolDestroy(&pools->arbiters);
+	cpPoolDestroy(&pools->contacts);
+	cpPoolDestroy(&pools->hashSetBins);
+	cpPoolDestroy(&pools->spaceHashBins);
+	cpPoolDestroy(&pools->handles);
+	cpPoolDestroy(&pools->treeNodes);
+	cpPoolDestroy(&pools->sweepHandles);
+	
+	free(pools);
+}
+
+unsigned int
+cpSpacePoolsGetAllocCount(cpSpacePools *pools)
+{
+	return (
+		pools->arbiters.allocCount + pools->contacts.allocCount +
+		pools->hashSetBins.allocCount + pools->spaceHashBins.allocCount +
+		pools->handles.allocCount + pools->treeNodes.allocCount +
+		pools->sweepHandles.allocCount + pools->mallocCount
+	);
+}
+
+unsigned int
+cpSpacePoolsGetHeapAllocCount(cpSpacePools *pools)
+{
+	return (
+		pools->arbiters.slabCount + pools->contacts.slabCount +
+		pools->hashSetBins.slabCount + pools->spaceHashBins.slabCount +
+		pools->handles.slabCount + pools->treeNodes.slabCount +
+		pools->sweepHandles.slabCount + pools->mallocCount
+	);
+}
+
+size_t
+cpSpacePoolsGetReservedBytes(cpSpacePools *pools)
+{
+	return (
+		pools->arbiters.reservedBytes + pools->contacts.reservedBytes +
+		pools->hashSetBins.reservedBytes + pools->spaceHashBins.reservedBytes +
+		pools->handles.reservedBytes + pools->treeNodes.reservedBytes +
+		pools->sweepHandles.reservedBytes
+	);
+}
+
+void
+cpSpacePoolsResetCounters(cpSpacePools *pools)
+{
+	cpPool *list[] = {
+		&pools->arbiters, &pools->contacts, &pools->hashSetBins, &pools->spaceHashBins,
+		&pools->handles, &pools->treeNodes, &pools->sweepHandles,
+	};
+	for(int i=0; i<7; i++){
+		list[i]->allocCount = 0;
+		list[i]->slabCount = 0;
+	}
+	
+	pools->mallocCount = 0;
+}
+
+cpContact *
+cpSpacePoolsAllocContacts(cpSpacePools *pools, int num)
+{
+	if(pools && num <= CP_POOLED_CONTACT_COUNT)
+		return (cpContact *)cpPoolAlloc(&pools->contacts);
+	
+	if(pools) pools->mallocCount++;
+	return (cpContact *)malloc(num*sizeof(cpContact));
+}
+
+void
+cpSpacePoolsFreeContacts(cpSpacePools *pools, cpContact *contacts, int num)
+{
+	if(pools && num <= CP_POOLED_CONTACT_COUNT)
+		cpPoolFree(&pools->contacts, contacts);
+	else
+		free(contacts);
+}
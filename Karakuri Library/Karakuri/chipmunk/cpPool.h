@@ -0,0 +1,66 @@
+/* cpPool.h
+ * Slab pools for the short-lived objects of a cpSpace, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+// cpPool is a fixed size object allocator. Objects are carved out of large
+// slabs and recycled through a free list, so the steady state of a space does
+// not touch malloc() at all. The slabs are only released by cpPoolDestroy().
+
+typedef struct cpPool {
+	// Size of one object, rounded up for alignment.
+	size_t size;
+	// Number of objects carved out of each slab.
+	int count;
+	
+	// Recycled objects. The first word of a free object points to the next one.
+	void *freeList;
+	// Linked list of slabs. The first word of a slab points to the next one.
+	void *slabs;
+	
+	// Number of objects handed out and slabs allocated since the last reset.
+	unsigned int allocCount;
+	unsigned int slabCount;
+	
+	// Bytes held by all the slabs, including their headers.
+	size_t reservedBytes;
+} cpPool;
+
+cpPool *cpPoolInit(cpPool *pool, size_t size, int count);
+void cpPoolDestroy(cpPool *pool);
+
+void *cpPoolAlloc(cpPool *pool);
+void cpPoolFree(cpPool *pool, void *ptr);
+
+
+// Number of contacts in a pooled contact block.
+// Arbiters with more contacts than this fall back to malloc().
+#define CP_POOLED_CONTACT_COUNT 4
+
+// All the pools used by a single cpSpace.
+typedef struct cpSpacePools {
+	cpPool arbiters;
+	cpPool contacts;
+	cpPool hashSetBins;
+	cpPool spaceHashBins;
+	cpPool handles;
+	cpPool treeNodes;
+	cpPool sweepHandles;
+	
+	// Number of allocations that bypassed the pools since the last reset.
+	unsigned int mallocCount;
+} cpSpacePools;
+
+cpSpacePools *cpSpacePoolsNew(void);
+void cpSpacePoolsFree(cpSpacePools *pools);
+
+// Object and heap allocation counters, cleared by cpSpacePoolsResetCounters().
+unsigned int cpSpacePoolsGetAllocCount(cpSpacePools *pools);
+unsigned int cpSpacePoolsGetHeapAllocCount(cpSpacePools *pools);
+// Bytes held by the slabs of all the pools. Not cleared by cpSpacePoolsResetCounters().
+size_t cpSpacePoolsGetReservedBytes(cpSpacePools *pools);
+void cpSpacePoolsResetCounters(cpSpacePools *pools);
+
+// Contact arrays for arbiters. pools may be NULL, in which case malloc() is used.
+struct cpContact *cpSpacePoolsAllocContacts(cpSpacePools *pools, int num);
+void cpSpacePoolsFreeContacts(cpSpacePools *pools, struct cpContact *contacts, int num);
@@ -0,0 +1,130 @@
+/* cpSIMD.h
+ * SSE2 and NEON versions of the polygon axis tests, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+// The polygon collision tests project every vertex of a polygon on the same
+// axis. In the single precision build (CP_USE_DOUBLES 0) four vertices fit in
+// one SSE2 or NEON register, so they are projected at once. A single cpVect
+// only has two lanes and is still added and multiplied with scalar code, which
+// the compiler already does as well as the intrinsics would.
+//
+// The SIMD versions do the same multiplications and additions in the same
+// order as the scalar code, so they give the same results. Define CP_NO_SIMD
+// to use the scalar code in a single precision build.
+
+#if !CP_USE_DOUBLES && !defined(CP_NO_SIMD)
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#include <emmintrin.h>
+		#define CP_USE_SSE 1
+	#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+		#include <arm_neon.h>
+		#define CP_USE_NEON 1
+	#endif
+#endif
+
+#if defined(CP_USE_SSE) || defined(CP_USE_NEON)
+	#define CP_USE_SIMD 1
+#else
+	#define CP_USE_SIMD 0
+#endif
+
+#if CP_USE_SIMD
+
+// Four vectors in structure of arrays form.
+typedef struct cpVect4 {
+#if CP_USE_SSE
+	__m128 x, y;
+#else
+	float32x4_t x, y;
+#endif
+} cpVect4;
+
+// Load four vectors. If fewer than four are left, the last one is repeated.
+static inline cpVect4
+cpVect4Load(const cpVect *verts, int num)
+{
+	cpVect padded[4];
+	if(num < 4){
+		for(int i=0; i<4; i++) padded[i] = verts[i < num ? i : num - 1];
+		verts = padded;
+	}
+
+	cpVect4 v;
+#if CP_USE_SSE
+	__m128 a = _mm_loadu_ps(&verts[0].x);
+	__m128 b = _mm_loadu_ps(&verts[2].x);
+	v.x = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+	v.y = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+#else
+	float32x4x2_t xy = vld2q_f32(&verts[0].x);
+	v.x = xy.val[0];
+	v.y = xy.val[1];
+#endif
+	return v;
+}
+
+// Bit i of the result is set if cpvdot(n, v[i]) - d > 0.
+static inline int
+cpVect4OutsideMask(const cpVect4 v, const cpVect n, const cpFloat d)
+{
+#if CP_USE_SSE
+	__m128 dot = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(n.x), v.x), _mm_mul_ps(_mm_set1_ps(n.y), v.y));
+	return _mm_movemask_ps(_mm_cmpgt_ps(_mm_sub_ps(dot, _mm_set1_ps(d)), _mm_setzero_ps()));
+#else
+	float32x4_t dot = vaddq_f32(vmulq_f32(vdupq_n_f32(n.x), v.x), vmulq_f32(vdupq_n_f32(n.y), v.y));
+	uint32x4_t outside = vcgtq_f32(vsubq_f32(dot, vdupq_n_f32(d)), vdupq_n_f32(0.0f));
+	static const uint32_t bits[4] = {1, 2, 4, 8};
+	uint32x4_t masked = vandq_u32(outside, vld1q_u32(bits));
+	uint32x2_t sum = vpadd_u32(vget_low_u32(masked), vget_high_u32(masked));
+	return (int)vget_lane_u32(vpadd_u32(sum, sum), 0);
+#endif
+}
+
+#endif
+
+// Smallest value of cpvdot(n, verts[i]).
+static inline cpFloat
+cpvMinDot(const cpVect *verts, int num, const cpVect n)
+{
+#if CP_USE_SIMD
+	int i = 0;
+	cpFloat min = INFINITY;
+
+	if(num >= 4){
+	#if CP_USE_SSE
+		__m128 nx = _mm_set1_ps(n.x);
+		__m128 ny = _mm_set1_ps(n.y);
+		__m128 min4 = _mm_set1_ps(INFINITY);
+		for(; i + 4 <= num; i += 4){
+			cpVect4 v = cpVect4Load(verts + i, 4);
+			min4 = _mm_min_ps(min4, _mm_add_ps(_mm_mul_ps(nx, v.x), _mm_mul_ps(ny, v.y)));
+		}
+		min4 = _mm_min_ps(min4, _mm_movehl_ps(min4, min4));
+		min = _mm_cvtss_f32(_mm_min_ss(min4, _mm_shuffle_ps(min4, min4, _MM_SHUFFLE(1, 1, 1, 1))));
+	#else
+		float32x4_t nx = vdupq_n_f32(n.x);
+		float32x4_t ny = vdupq_n_f32(n.y);
+		float32x4_t min4 = vdupq_n_f32(INFINITY);
+		for(; i + 4 <= num; i += 4){
+			cpVect4 v = cpVect4Load(verts + i, 4);
+			min4 = vminq_f32(min4, vaddq_f32(vmulq_f32(nx, v.x), vmulq_f32(ny, v.y)));
+		}
+		float32x2_t min2 = vpmin_f32(vget_low_f32(min4), vget_high_f32(min4));
+		min = vget_lane_f32(vpmin_f32(min2, min2), 0);
+	#endif
+	}
+
+	for(; i<num; i++)
+		min = cpfmin(min, cpvdot(n, verts[i]));
+
+	return min;
+#else
+	cpFloat min = cpvdot(n, verts[0]);
+
+	for(int i=1; i<num; i++)
+		min = cpfmin(min, cpvdot(n, verts[i]));
+
+	return min;
+#endif
+}
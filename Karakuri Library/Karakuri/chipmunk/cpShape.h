@@ -106,6 +106,8 @@ cpBB cpShapeCacheBB(cpShape *shape);
 
 // Test if a point lies within a shape.
 int cpShapePointQuery(cpShape *shape, cpVect p, cpLayers layers, cpGroup group);
+// Test if a line segment from a to b intersects a shape.
+int cpShapeSegmentQuery(cpShape *shape, cpVect a, cpVect b, cpLayers layers, cpGroup group, cpSegmentQueryInfo *info);
 void cpSegmentQueryInfoPrint(cpSegmentQueryInfo *info);
 
 #define CP_DeclareShapeGetter(struct, type, name) type struct##Get##name(cpShape *shape)
@@ -48,7 +48,14 @@ contactSetTrans(cpShape **shapes, cpSpace *space)
 	cpShape *a = shapes[0];
 	cpShape *b = shapes[1];
 	
-	return cpArbiterNew(a, b, space->stamp);
+	if(!space->pools) return cpArbiterNew(a, b, space->stamp);
+	
+	cpArbiter *arb = (cpArbiter *)cpPoolAlloc(&space->pools->arbiters);
+	memset(arb, 0, sizeof(cpArbiter));
+	cpArbiterInit(arb, a, b, space->stamp);
+	arb->pools = space->pools;
+	
+	return arb;
 }
 
 #pragma mark Collision Pair Function Helpers
@@ -119,15 +126,17 @@ cpSpaceInit(cpSpace *space)
 {
 	space->iterations = DEFAULT_ITERATIONS;
 	space->elasticIterations = DEFAULT_ELASTIC_ITERATIONS;
-//	space->sleepTicks = 300;
 	
 	space->gravity = cpvzero;
 	space->damping = 1.0f;
 	
+	space->sleepTimeThreshold = INFINITY;
+	space->idleSpeedThreshold = 0.0f;
+	
 	space->stamp = 0;
 
-	space->staticShapes = cpSpaceHashNew(DEFAULT_DIM_SIZE, DEFAULT_COUNT, (cpSpaceHashBBFunc)shapeBBFunc);
-	space->activeShapes = cpSpaceHashNew(DEFAULT_DIM_SIZE, DEFAULT_COUNT, (cpSpaceHashBBFunc)shapeBBFunc);
+	space->staticShapes = (cpSpatialIndex *)cpSpaceHashNew(DEFAULT_DIM_SIZE, DEFAULT_COUNT, (cpSpaceHashBBFunc)shapeBBFunc);
+	space->activeShapes = (cpSpatialIndex *)cpSpaceHashNew(DEFAULT_DIM_SIZE, DEFAULT_COUNT, (cpSpaceHashBBFunc)shapeBBFunc);
 	
 	space->bodies = cpArrayNew(0);
 	space->arbiters = cpArrayNew(0);
@@ -140,6 +149,24 @@ cpSpaceInit(cpSpace *space)
 	space->collFuncSet = cpHashSetNew(0, (cpHashSetEqlFunc)collFuncSetEql, (cpHashSetTransFunc)collFuncSetTrans);
 	space->collFuncSet->default_value = &space->defaultPairFunc;
 	
+	space->pools = NULL;
+	space->contactBuffer.arr = NULL;
+	space->contactBuffer.num = 0;
+	space->contactBuffer.max = 0;
+	space->contactBuffer.pools = NULL;
+	
+	space->sleepingRoots = cpArrayNew(0);
+	space->sleepingShapes = cpArrayNew(0);
+	space->pendingWakeRoots = cpArrayNew(0);
+	space->activeConstraints = cpArrayNew(0);
+	space->locked = 0;
+	space->sortArbiters = 0;
+	
+	space->solver = NULL;
+	
+	space->querySegments = NULL;
+	space->querySegmentsMax = 0;
+	
 	return space;
 }
 
@@ -152,8 +179,8 @@ cpSpaceNew(void)
 void
 cpSpaceDestroy(cpSpace *space)
 {
-	cpSpaceHashFree(space->staticShapes);
-	cpSpaceHashFree(space->activeShapes);
+	cpSpatialIndexFree(space->staticShapes);
+	cpSpatialIndexFree(space->activeShapes);
 	
 	cpArrayFree(space->bodies);
 	
@@ -168,6 +195,16 @@ cpSpaceDestroy(cpSpace *space)
 	if(space->collFuncSet)
 		cpHashSetEach(space->collFuncSet, &freeWrap, NULL);
 	cpHashSetFree(space->collFuncSet);
+	
+	free(space->contactBuffer.arr);
+	
+	cpArrayFree(space->sleepingRoots);
+	cpArrayFree(space->sleepingShapes);
+	cpArrayFree(space->pendingWakeRoots);
+	cpArrayFree(space->activeConstraints);
+	
+	cpParallelSolverFree(space->solver);
+	free(space->querySegments);
 }
 
 void
@@ -180,12 +217,286 @@ cpSpaceFree(cpSpace *space)
 void
 cpSpaceFreeChildren(cpSpace *space)
 {
-	cpSpaceHashEach(space->staticShapes, (cpSpaceHashIterator)&shapeFreeWrap, NULL);
-	cpSpaceHashEach(space->activeShapes, (cpSpaceHashIterator)&shapeFreeWrap, NULL);
+	// Sleeping bodies are not in the bodies array.
+	cpSpaceActivateAll(space);
+	
+	cpSpatialIndexEach(space->staticShapes, (cpSpaceHashIterator)&shapeFreeWrap, NULL);
+	cpSpatialIndexEach(space->activeShapes, (cpSpaceHashIterator)&shapeFreeWrap, NULL);
 	cpArrayEach(space->bodies,           (cpArrayIter)&bodyFreeWrap,          NULL);
 	cpArrayEach(space->constraints,      (cpArrayIter)&constraintFreeWrap,    NULL);
 }
 
+void
+cpSpaceUsePools(cpSpace *space, cpSpacePools *pools)
+{
+	space->pools = pools;
+	space->contactBuffer.pools = pools;
+	
+	space->contactSet->binPool = &pools->hashSetBins;
+	cpSpatialIndexSetPools(space->staticShapes, pools);
+	cpSpatialIndexSetPools(space->activeShapes, pools);
+}
+
+void
+cpSpaceUseSpatialIndex(cpSpace *space, cpSpatialIndex *staticIndex, cpSpatialIndex *activeIndex)
+{
+	assert(!cpSpatialIndexCount(space->staticShapes) && !cpSpatialIndexCount(space->activeShapes));
+	
+	cpSpatialIndexFree(space->staticShapes);
+	cpSpatialIndexFree(space->activeShapes);
+	
+	space->staticShapes = staticIndex;
+	space->activeShapes = activeIndex;
+	space->sortArbiters = 1;
+	
+	if(space->pools){
+		cpSpatialIndexSetPools(staticIndex, space->pools);
+		cpSpatialIndexSetPools(activeIndex, space->pools);
+	}
+}
+
+void
+cpSpaceSetSolverThreads(cpSpace *space, int threadCount, int deterministic)
+{
+	assert(!space->locked);
+	
+	cpParallelSolverFree(space->solver);
+	space->solver = NULL;
+	
+	if(threadCount != 1 || deterministic)
+		space->solver = cpParallelSolverNew(threadCount, deterministic);
+}
+
+#pragma mark Sleeping
+
+// Move the shapes of woken bodies from the static hash back to the active hash.
+static void
+wakeSleepingShapes(cpSpace *space)
+{
+	cpArray *shapes = space->sleepingShapes;
+	
+	for(int i=0; i<shapes->num;){
+		cpShape *shape = (cpShape *)shapes->arr[i];
+		if(shape->body->sleeping){
+			i++;
+			continue;
+		}
+		
+		cpSpatialIndexRemove(space->staticShapes, shape, shape->id);
+		cpSpatialIndexInsert(space->activeShapes, shape, shape->id, shape->bb);
+		cpArrayDeleteIndex(shapes, i);
+	}
+}
+
+// Return the bodies of a woken island to the bodies array.
+static void
+activateIslandBodies(cpSpace *space, cpBody *root)
+{
+	cpBody *body = root;
+	while(body){
+		cpBody *next = body->islandNext;
+		
+		body->sleeping = 0;
+		body->idleTime = 0.0f;
+		body->islandRoot = NULL;
+		body->islandNext = NULL;
+		cpArrayPush(space->bodies, body);
+		
+		body = next;
+	}
+}
+
+// Finish activating the islands that were woken while the space was locked.
+static void
+flushPendingWake(cpSpace *space)
+{
+	cpArray *roots = space->pendingWakeRoots;
+	if(!roots->num) return;
+	
+	for(int i=0; i<roots->num; i++)
+		activateIslandBodies(space, (cpBody *)roots->arr[i]);
+	roots->num = 0;
+	
+	wakeSleepingShapes(space);
+}
+
+void
+cpBodyActivate(cpBody *body)
+{
+	if(!body->sleeping) return;
+	
+	cpSpace *space = body->space;
+	cpBody *root = body->islandRoot;
+	cpArrayDeleteObj(space->sleepingRoots, root);
+	
+	// Clear the flags right away so the island isn't woken twice.
+	for(cpBody *member = root; member; member = member->islandNext)
+		member->sleeping = 0;
+	
+	// The hashes can't be modified while they are being iterated.
+	cpArrayPush(space->pendingWakeRoots, root);
+	if(!space->locked) flushPendingWake(space);
+}
+
+void
+cpSpaceActivateAll(cpSpace *space)
+{
+	cpArray *roots = space->sleepingRoots;
+	while(roots->num)
+		cpBodyActivate((cpBody *)roots->arr[roots->num - 1]);
+}
+
+int
+cpSpaceGetSleepingBodyCount(cpSpace *space)
+{
+	int count = 0;
+	
+	cpArray *roots = space->sleepingRoots;
+	for(int i=0; i<roots->num; i++){
+		for(cpBody *body = (cpBody *)roots->arr[i]; body; body = body->islandNext)
+			count++;
+	}
+	
+	return count;
+}
+
+// Wake the sleeping bodies whose shapes overlap a static shape that was added or removed.
+static void
+activateTouchingShape(cpSpace *space, cpShape *shape)
+{
+	cpArray *shapes = space->sleepingShapes;
+	if(!shapes->num) return;
+	
+	space->locked = 1;
+	for(int i=0; i<shapes->num; i++){
+		cpShape *other = (cpShape *)shapes->arr[i];
+		if(cpBBintersects(shape->bb, other->bb)) cpBodyActivate(other->body);
+	}
+	space->locked = 0;
+	
+	flushPendingWake(space);
+}
+
+static inline cpBody *
+islandFind(cpBody *body)
+{
+	cpBody *root = body;
+	while(root->islandRoot != root) root = root->islandRoot;
+	
+	// Path compression.
+	while(body != root){
+		cpBody *next = body->islandRoot;
+		body->islandRoot = root;
+		body = next;
+	}
+	
+	return root;
+}
+
+static inline void
+islandUnion(cpBody *a, cpBody *b)
+{
+	// Static and rogue bodies don't join islands, so a single floor doesn't merge everything.
+	if(!a->space || !b->space || a->sleeping || b->sleeping) return;
+	
+	cpBody *rootA = islandFind(a);
+	cpBody *rootB = islandFind(b);
+	if(rootA != rootB) rootB->islandRoot = rootA;
+}
+
+static void
+collectSleepingShape(cpShape *shape, cpArray *shapes)
+{
+	if(shape->body->sleeping) cpArrayPush(shapes, shape);
+}
+
+// Build the contact graph islands and put the ones that stayed idle long enough to sleep.
+static void
+updateSleeping(cpSpace *space, cpFloat dt)
+{
+	cpFloat threshold = space->sleepTimeThreshold;
+	if(threshold == INFINITY) return;
+	
+	cpArray *bodies = space->bodies;
+	cpArray *arbiters = space->arbiters;
+	cpArray *constraints = space->constraints;
+	
+	cpFloat dv = space->idleSpeedThreshold;
+	cpFloat dvsq = (dv ? dv*dv : cpvdot(space->gravity, space->gravity)*dt*dt);
+	
+	// Update the idle timers.
+	for(int i=0; i<bodies->num; i++){
+		cpBody *body = (cpBody *)bodies->arr[i];
+		
+		cpFloat ke = body->m*cpvdot(body->v, body->v) + body->i*body->w*body->w;
+		body->idleTime = (ke > body->m*dvsq ? 0.0f : body->idleTime + dt);
+		
+		body->islandIdleTime = body->idleTime;
+		body->islandRoot = body;
+		body->islandNext = NULL;
+	}
+	
+	// Join the bodies that touch or are connected by a constraint.
+	for(int i=0; i<arbiters->num; i++){
+		cpArbiter *arb = (cpArbiter *)arbiters->arr[i];
+		islandUnion(arb->a->body, arb->b->body);
+	}
+	
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		islandUnion(constraint->a, constraint->b);
+	}
+	
+	// An island is only as idle as its most active body.
+	for(int i=0; i<bodies->num; i++){
+		cpBody *body = (cpBody *)bodies->arr[i];
+		cpBody *root = islandFind(body);
+		if(body->idleTime < root->islandIdleTime) root->islandIdleTime = body->idleTime;
+	}
+	
+	int sleepCount = 0;
+	for(int i=0; i<bodies->num; i++){
+		cpBody *body = (cpBody *)bodies->arr[i];
+		cpBody *root = islandFind(body);
+		if(root->islandIdleTime < threshold) continue;
+		
+		if(body == root){
+			cpArrayPush(space->sleepingRoots, root);
+		} else {
+			body->islandNext = root->islandNext;
+			root->islandNext = body;
+		}
+		
+		body->sleeping = 1;
+		body->v = cpvzero;
+		body->w = 0.0f;
+		body->v_bias = cpvzero;
+		body->w_bias = 0.0f;
+		sleepCount++;
+	}
+	
+	if(!sleepCount) return;
+	
+	// Sleeping bodies are neither integrated nor solved.
+	int num = 0;
+	for(int i=0; i<bodies->num; i++){
+		cpBody *body = (cpBody *)bodies->arr[i];
+		if(!body->sleeping) bodies->arr[num++] = body;
+	}
+	bodies->num = num;
+	
+	// Park their shapes in the static hash so they are no longer rehashed every step.
+	cpArray *shapes = space->sleepingShapes;
+	int first = shapes->num;
+	cpSpatialIndexEach(space->activeShapes, (cpSpaceHashIterator)&collectSleepingShape, shapes);
+	
+	for(int i=first; i<shapes->num; i++){
+		cpShape *shape = (cpShape *)shapes->arr[i];
+		cpSpatialIndexRemove(space->activeShapes, shape, shape->id);
+		cpSpatialIndexInsert(space->staticShapes, shape, shape->id, shape->bb);
+	}
+}
+
 #pragma mark Collision Pair Function Management
 
 void
@@ -222,7 +533,8 @@ cpShape *
 cpSpaceAddShape(cpSpace *space, cpShape *shape)
 {
 	assert(shape->body);
-	cpSpaceHashInsert(space->activeShapes, shape, shape->id, shape->bb);
+	cpBodyActivate(shape->body);
+	cpSpatialIndexInsert(space->activeShapes, shape, shape->id, shape->bb);
 	
 	return shape;
 }
@@ -233,7 +545,8 @@ cpSpaceAddStaticShape(cpSpace *space, cpShape *shape)
 	assert(shape->body);
 
 	cpShapeCacheBB(shape);
-	cpSpaceHashInsert(space->staticShapes, shape, shape->id, shape->bb);
+	cpSpatialIndexInsert(space->staticShapes, shape, shape->id, shape->bb);
+	activateTouchingShape(space, shape);
 	
 	return shape;
 }
@@ -241,6 +554,8 @@ cpSpaceAddStaticShape(cpSpace *space, cpShape *shape)
 cpBody *
 cpSpaceAddBody(cpSpace *space, cpBody *body)
 {
+	body->space = space;
+	body->idleTime = 0.0f;
 	cpArrayPush(space->bodies, body);
 	
 	return body;
@@ -249,6 +564,8 @@ cpSpaceAddBody(cpSpace *space, cpBody *body)
 cpConstraint *
 cpSpaceAddConstraint(cpSpace *space, cpConstraint *constraint)
 {
+	cpBodyActivate(constraint->a);
+	cpBodyActivate(constraint->b);
 	cpArrayPush(space->constraints, constraint);
 	
 	return constraint;
@@ -279,26 +596,32 @@ shapeRemovalArbiterReject(cpSpace *space, cpShape *shape)
 void
 cpSpaceRemoveShape(cpSpace *space, cpShape *shape)
 {
-	cpSpaceHashRemove(space->activeShapes, shape, shape->id);
+	cpBodyActivate(shape->body);
+	cpSpatialIndexRemove(space->activeShapes, shape, shape->id);
 	shapeRemovalArbiterReject(space, shape);
 }
 
 void
 cpSpaceRemoveStaticShape(cpSpace *space, cpShape *shape)
 {
-	cpSpaceHashRemove(space->staticShapes, shape, shape->id);
+	cpSpatialIndexRemove(space->staticShapes, shape, shape->id);
 	shapeRemovalArbiterReject(space, shape);
+	activateTouchingShape(space, shape);
 }
 
 void
 cpSpaceRemoveBody(cpSpace *space, cpBody *body)
 {
+	cpBodyActivate(body);
 	cpArrayDeleteObj(space->bodies, body);
+	body->space = NULL;
 }
 
 void
 cpSpaceRemoveConstraint(cpSpace *space, cpConstraint *constraint)
 {
+	cpBodyActivate(constraint->a);
+	cpBodyActivate(constraint->b);
 	cpArrayDeleteObj(space->constraints, constraint);
 }
 
@@ -322,8 +645,8 @@ void
 cpSpacePointQuery(cpSpace *space, cpVect point, cpLayers layers, cpGroup group, cpSpacePointQueryFunc func, void *data)
 {
 	pointQueryContext context = {layers, group, func, data};
-	cpSpaceHashPointQuery(space->activeShapes, point, (cpSpaceHashQueryFunc)pointQueryHelper, &context);
-	cpSpaceHashPointQuery(space->staticShapes, point, (cpSpaceHashQueryFunc)pointQueryHelper, &context);
+	cpSpatialIndexPointQuery(space->activeShapes, point, (cpSpaceHashQueryFunc)pointQueryHelper, &context);
+	cpSpatialIndexPointQuery(space->staticShapes, point, (cpSpaceHashQueryFunc)pointQueryHelper, &context);
 }
 
 static void
@@ -341,6 +664,120 @@ cpSpacePointQueryFirst(cpSpace *space, cpVect point, cpLayers layers, cpGroup gr
 	return shape;
 }
 
+#pragma mark Segment Query Functions
+
+typedef struct segmentQueryContext {
+	cpSpatialIndexSegment *segments;
+	cpLayers layers;
+	cpGroup group;
+	cpSpaceSegmentQueryFunc func;
+	cpSegmentQueryInfo *out;
+	void *data;
+} segmentQueryContext;
+
+static cpFloat
+segmentQueryHelper(cpShape *shape, int index, segmentQueryContext *context)
+{
+	cpSpatialIndexSegment *segment = &context->segments[index];
+	cpSegmentQueryInfo info = {NULL, 1.0f, cpvzero};
+	
+	if(cpShapeSegmentQuery(shape, segment->a, segment->b, context->layers, context->group, &info))
+		context->func(shape, info.t, info.n, context->data);
+	
+	return segment->t_exit;
+}
+
+void
+cpSpaceSegmentQuery(cpSpace *space, cpVect a, cpVect b, cpLayers layers, cpGroup group, cpSpaceSegmentQueryFunc func, void *data)
+{
+	cpSpatialIndexSegment segment = {a, b, 1.0f};
+	segmentQueryContext context = {&segment, layers, group, func, NULL, data};
+	
+	cpSpatialIndexSegmentQuery(space->activeShapes, &segment, 1, (cpSpatialIndexSegmentQueryFunc)segmentQueryHelper, &context);
+	cpSpatialIndexSegmentQuery(space->staticShapes, &segment, 1, (cpSpatialIndexSegmentQueryFunc)segmentQueryHelper, &context);
+}
+
+// Keep the nearest hit and shorten the segment to it.
+static cpFloat
+segmentQueryFirstHelper(cpShape *shape, int index, segmentQueryContext *context)
+{
+	cpSpatialIndexSegment *segment = &context->segments[index];
+	cpSegmentQueryInfo info = {NULL, 1.0f, cpvzero};
+	
+	if(cpShapeSegmentQuery(shape, segment->a, segment->b, context->layers, context->group, &info) && info.t < segment->t_exit){
+		context->out[index] = info;
+		return info.t;
+	}
+	
+	return segment->t_exit;
+}
+
+void
+cpSpaceSegmentQueryFirstBatch(cpSpace *space, int count, const cpVect *a, const cpVect *b, cpLayers layers, cpGroup group, cpSegmentQueryInfo *out)
+{
+	if(count <= 0) return;
+	
+	if(space->querySegmentsMax < count){
+		space->querySegmentsMax = count;
+		space->querySegments = (cpSpatialIndexSegment *)realloc(space->querySegments, count*sizeof(cpSpatialIndexSegment));
+	}
+	
+	cpSpatialIndexSegment *segments = space->querySegments;
+	for(int i=0; i<count; i++){
+		segments[i].a = a[i];
+		segments[i].b = b[i];
+		segments[i].t_exit = 1.0f;
+		
+		out[i].shape = NULL;
+		out[i].t = 1.0f;
+		out[i].n = cpvzero;
+	}
+	
+	segmentQueryContext context = {segments, layers, group, NULL, out, NULL};
+	cpSpatialIndexSegmentQuery(space->activeShapes, segments, count, (cpSpatialIndexSegmentQueryFunc)segmentQueryFirstHelper, &context);
+	cpSpatialIndexSegmentQuery(space->staticShapes, segments, count, (cpSpatialIndexSegmentQueryFunc)segmentQueryFirstHelper, &context);
+}
+
+cpShape *
+cpSpaceSegmentQueryFirst(cpSpace *space, cpVect a, cpVect b, cpLayers layers, cpGroup group, cpSegmentQueryInfo *out)
+{
+	cpSegmentQueryInfo info;
+	cpSpaceSegmentQueryFirstBatch(space, 1, &a, &b, layers, group, &info);
+	
+	if(out) (*out) = info;
+	return info.shape;
+}
+
+#pragma mark BBox Query Functions
+
+typedef struct bbQueryContext {
+	cpBB bb;
+	cpLayers layers;
+	cpGroup group;
+	cpSpaceBBQueryFunc func;
+	void *data;
+} bbQueryContext;
+
+static void
+bbQueryHelper(bbQueryContext *context, cpShape *shape, void *unused)
+{
+	if(
+		!(context->group && shape->group && context->group == shape->group) &&
+		(context->layers&shape->layers) &&
+		cpBBintersects(context->bb, shape->bb)
+	){
+		context->func(shape, context->data);
+	}
+}
+
+void
+cpSpaceBBQuery(cpSpace *space, cpBB bb, cpLayers layers, cpGroup group, cpSpaceBBQueryFunc func, void *data)
+{
+	bbQueryContext context = {bb, layers, group, func, data};
+	cpSpatialIndexQuery(space->activeShapes, &context, bb, (cpSpatialIndexQueryFunc)bbQueryHelper, &context);
+	cpSpatialIndexQuery(space->staticShapes, &context, bb, (cpSpatialIndexQueryFunc)bbQueryHelper, &context);
+}
+
 void
 cpSpaceEachBody(cpSpace *space, cpSpaceBodyIterator func, void *data)
 {
@@ -348,6 +785,12 @@ cpSpaceEachBody(cpSpace *space, cpSpaceBodyIterator func, void *data)
 	
 	for(int i=0; i<bodies->num; i++)
 		func((cpBody *)bodies->arr[i], data);
+	
+	cpArray *roots = space->sleepingRoots;
+	for(int i=0; i<roots->num; i++){
+		for(cpBody *body = (cpBody *)roots->arr[i]; body; body = body->islandNext)
+			func(body, data);
+	}
 }
 
 #pragma mark Spatial Hash Management
@@ -362,21 +805,28 @@ updateBBCache(cpShape *shape, void *unused)
 void
 cpSpaceResizeStaticHash(cpSpace *space, cpFloat dim, int count)
 {
-	cpSpaceHashResize(space->staticShapes, dim, count);
-	cpSpaceHashRehash(space->staticShapes);
+	if(space->staticShapes->klass != cpSpaceHashGetClass()) return;
+	
+	cpSpaceHashResize((cpSpaceHash *)space->staticShapes, dim, count);
+	cpSpatialIndexReindex(space->staticShapes);
 }
 
 void
 cpSpaceResizeActiveHash(cpSpace *space, cpFloat dim, int count)
 {
-	cpSpaceHashResize(space->activeShapes, dim, count);
+	if(space->activeShapes->klass != cpSpaceHashGetClass()) return;
+	
+	cpSpaceHashResize((cpSpaceHash *)space->activeShapes, dim, count);
 }
 
 void 
 cpSpaceRehashStatic(cpSpace *space)
 {
-	cpSpaceHashEach(space->staticShapes, (cpSpaceHashIterator)&updateBBCache, NULL);
-	cpSpaceHashRehash(space->staticShapes);
+	// The static geometry moved, so nothing resting on it can stay asleep.
+	cpSpaceActivateAll(space);
+	
+	cpSpatialIndexEach(space->staticShapes, (cpSpaceHashIterator)&updateBBCache, NULL);
+	cpSpatialIndexReindex(space->staticShapes);
 }
 
 #pragma mark Collision Detection Functions
@@ -403,15 +853,16 @@ queryFunc(cpShape *a, cpShape *b, cpSpace *space)
 	if(queryReject(a,b)) return;
 	
 	// Shape 'a' should have the lower shape type. (required by cpCollideShapes() )
-	if(a->klass->type > b->klass->type){
+	// Shapes of the same type put the newer shape first, as the spatial hash finds them. The contacts and
+	// the stability of stacks depend on this, so it must not change with the order of the query.
+	if(a->klass->type > b->klass->type || (a->klass->type == b->klass->type && a->id < b->id)){
 		cpShape *temp = a;
 		a = b;
 		b = temp;
 	}
 	
 	// Narrow-phase collision detection.
-	cpContact *contacts = NULL;
-	int numContacts = cpCollideShapes(a, b, &contacts);
+	int numContacts = cpCollideShapes(a, b, &space->contactBuffer);
 	if(!numContacts) return; // Shapes are not colliding.
 	
 	// Get an arbiter from space->contactSet for the two shapes.
@@ -424,17 +875,21 @@ queryFunc(cpShape *a, cpShape *b, cpSpace *space)
 	// For collisions between two similar primitive types, the order could have been swapped.
 	arb->a = a; arb->b = b;
 	// Inject the new contact points into the arbiter.
-	cpArbiterInject(arb, contacts, numContacts);
+	cpArbiterInject(arb, space->contactBuffer.arr, numContacts);
 	
 	// Add the arbiter to the list of active arbiters.
 	cpArrayPush(space->arbiters, arb);
+	
+	// Sleeping shapes are only found through the static hash, touched by an awake body.
+	if(a->body->sleeping) cpBodyActivate(a->body);
+	if(b->body->sleeping) cpBodyActivate(b->body);
 }
 
 // Iterator for active/static hash collisions.
 static void
 active2staticIter(cpShape *shape, cpSpace *space)
 {
-	cpSpaceHashQuery(space->staticShapes, shape, shape->bb, (cpSpaceHashQueryFunc)&queryFunc, space);
+	cpSpatialIndexQuery(space->staticShapes, shape, shape->bb, (cpSpaceHashQueryFunc)&queryFunc, space);
 }
 
 // Hashset reject func to throw away old arbiters.
@@ -449,6 +904,32 @@ contactSetReject(cpArbiter *arb, cpSpace *space)
 	return 1;
 }
 
+static cpHashValue
+arbiterMinID(cpArbiter *arb)
+{
+	return (arb->a->id < arb->b->id ? arb->a->id : arb->b->id);
+}
+
+static cpHashValue
+arbiterMaxID(cpArbiter *arb)
+{
+	return (arb->a->id < arb->b->id ? arb->b->id : arb->a->id);
+}
+
+// Orders the arbiters by (min shape id, max shape id).
+static int
+compareArbiters(const void *p1, const void *p2)
+{
+	cpArbiter *arb1 = *(cpArbiter **)p1;
+	cpArbiter *arb2 = *(cpArbiter **)p2;
+	
+	cpHashValue id1 = arbiterMinID(arb1), id2 = arbiterMinID(arb2);
+	if(id1 != id2) return (id1 < id2 ? -1 : 1);
+	
+	id1 = arbiterMaxID(arb1), id2 = arbiterMaxID(arb2);
+	return (id1 < id2 ? -1 : (id1 > id2 ? 1 : 0));
+}
+
 static void
 filterArbiterByCallback(cpSpace *space)
 {
@@ -486,8 +967,89 @@ filterArbiterByCallback(cpSpace *space)
 	}
 }
 
+#pragma mark Arbiter Management Functions
+
+void
+cpSpaceEachArbiter(cpSpace *space, cpSpaceArbiterIterator func, void *data)
+{
+	cpHashSetEach(space->contactSet, (cpHashSetIterFunc)func, data);
+}
+
+// Stamp of the arbiters that have not been restored yet. Real stamps start at 0.
+#define UNRESTORED_STAMP -1
+
+static void
+markUnrestored(cpArbiter *arb, void *unused)
+{
+	arb->stamp = UNRESTORED_STAMP;
+}
+
+void
+cpSpaceBeginRestoreArbiters(cpSpace *space)
+{
+	cpHashSetEach(space->contactSet, (cpHashSetIterFunc)&markUnrestored, NULL);
+	space->arbiters->num = 0;
+}
+
+cpArbiter *
+cpSpaceRestoreArbiter(cpSpace *space, cpShape *a, cpShape *b, int stamp, int numContacts)
+{
+	// Reuse the arbiter if the shapes still have one, so most of a rollback allocates nothing.
+	// The contacts are not cleared. The next step only reads their hashes and impulses before replacing them.
+	cpShape *shape_pair[] = {a, b};
+	cpArbiter *arb = (cpArbiter *)cpHashSetInsert(space->contactSet, CP_HASH_PAIR(a, b), shape_pair, space);
+	
+	if(arb->numContacts != numContacts){
+		if(arb->contacts) cpSpacePoolsFreeContacts(arb->pools, arb->contacts, arb->numContacts);
+		arb->contacts = cpSpacePoolsAllocContacts(arb->pools, numContacts);
+		arb->numContacts = numContacts;
+	}
+	
+	arb->a = a;
+	arb->b = b;
+	arb->stamp = stamp;
+	
+	return arb;
+}
+
+static int
+rejectUnrestored(cpArbiter *arb, void *unused)
+{
+	if(arb->stamp == UNRESTORED_STAMP){
+		cpArbiterFree(arb);
+		return 0;
+	}
+	
+	return 1;
+}
+
+void
+cpSpaceEndRestoreArbiters(cpSpace *space)
+{
+	cpHashSetReject(space->contactSet, (cpHashSetRejectFunc)&rejectUnrestored, NULL);
+}
+
 #pragma mark All Important cpSpaceStep() Function
 
+static void
+applyImpulses(cpSpace *space, cpArray *arbiters, cpArray *constraints, int parallel, int iterations, cpFloat eCoef)
+{
+	if(parallel){
+		cpParallelSolverApplyImpulses(space->solver, iterations, eCoef);
+		return;
+	}
+	
+	for(int i=0; i<iterations; i++){
+		for(int j=0; j<arbiters->num; j++)
+			cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j], eCoef);
+			
+		for(int j=0; j<constraints->num; j++){
+			cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
+			constraint->klass->applyImpulse(constraint);
+		}
+	}
+}
+
 void
 cpSpaceStep(cpSpace *space, cpFloat dt)
 {
@@ -500,6 +1062,18 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 	// Empty the arbiter list.
 	cpHashSetReject(space->contactSet, (cpHashSetRejectFunc)&contactSetReject, space);
 	space->arbiters->num = 0;
+	
+	// A constraint between a sleeping and an awake body wakes the sleeping island.
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		cpBody *a = constraint->a;
+		cpBody *b = constraint->b;
+		
+		if(a->sleeping && !b->sleeping && b->space) cpBodyActivate(a);
+		if(b->sleeping && !a->sleeping && a->space) cpBodyActivate(b);
+	}
+	
+	space->locked = 1;
 
 	// Integrate positions.
 	for(int i=0; i<bodies->num; i++){
@@ -508,14 +1082,27 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 	}
 	
 	// Pre-cache BBoxes and shape data.
-	cpSpaceHashEach(space->activeShapes, (cpSpaceHashIterator)&updateBBCache, NULL);
+	cpSpatialIndexEach(space->activeShapes, (cpSpaceHashIterator)&updateBBCache, NULL);
 	
 	// Collide!
-	cpSpaceHashEach(space->activeShapes, (cpSpaceHashIterator)&active2staticIter, space);
-	cpSpaceHashQueryRehash(space->activeShapes, (cpSpaceHashQueryFunc)&queryFunc, space);
+	cpSpatialIndexEach(space->activeShapes, (cpSpaceHashIterator)&active2staticIter, space);
+	cpSpatialIndexReindexQuery(space->activeShapes, (cpSpaceHashQueryFunc)&queryFunc, space);
+	
+	// The solver order changes the result, so it must not follow the layout of a tree or a sweep.
+	if(space->sortArbiters)
+		qsort(space->arbiters->arr, space->arbiters->num, sizeof(void *), compareArbiters);
 	
 	// Filter arbiter list based on collision callbacks
 	filterArbiterByCallback(space);
+	
+	// Skip the constraints of sleeping islands.
+	cpArray *activeConstraints = space->activeConstraints;
+	activeConstraints->num = 0;
+	for(int i=0; i<constraints->num; i++){
+		cpConstraint *constraint = (cpConstraint *)constraints->arr[i];
+		if(!constraint->a->sleeping && !constraint->b->sleeping) cpArrayPush(activeConstraints, constraint);
+	}
+	constraints = activeConstraints;
 
 	// Prestep the arbiters.
 	cpArray *arbiters = space->arbiters;
@@ -528,15 +1115,10 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 		constraint->klass->preStep(constraint, dt, dt_inv);
 	}
 
-	for(int i=0; i<space->elasticIterations; i++){
-		for(int j=0; j<arbiters->num; j++)
-			cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j], 1.0f);
-			
-		for(int j=0; j<constraints->num; j++){
-			cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
-			constraint->klass->applyImpulse(constraint);
-		}
-	}
+	// Color the arbiters and constraints for the multi-threaded solver.
+	int parallel = (space->solver && cpParallelSolverPrepare(space->solver, arbiters, constraints));
+
+	applyImpulses(space, arbiters, constraints, parallel, space->elasticIterations, 1.0f);
 
 	// Integrate velocities.
 	cpFloat damping = cpfpow(1.0f/space->damping, -dt);
@@ -551,20 +1133,13 @@ cpSpaceStep(cpSpace *space, cpFloat dt)
 	// Run the impulse solver.
 	// run the old-style elastic solver if elastic iterations are disabled
 	cpFloat elasticCoef = (space->elasticIterations ? 0.0f : 1.0f);
-	for(int i=0; i<space->iterations; i++){
-		for(int j=0; j<arbiters->num; j++)
-			cpArbiterApplyImpulse((cpArbiter *)arbiters->arr[j], elasticCoef);
-			
-		for(int j=0; j<constraints->num; j++){
-			cpConstraint *constraint = (cpConstraint *)constraints->arr[j];
-			constraint->klass->applyImpulse(constraint);
-		}
-	}
+	applyImpulses(space, arbiters, constraints, parallel, space->iterations, elasticCoef);
 
-//	cpFloat dvsq = cpvdot(space->gravity, space->gravity);
-//	dvsq *= dt*dt * space->damping*space->damping;
-//	for(int i=0; i<bodies->num; i++)
-//		cpBodyMarkLowEnergy(bodies->arr[i], dvsq, space->sleepTicks);
+	space->locked = 0;
+	
+	// Islands woken by a contact this step join the integration from the next step.
+	flushPendingWake(space);
+	updateSleeping(space, dt);
 	
 	// Increment the stamp.
 	space->stamp++;
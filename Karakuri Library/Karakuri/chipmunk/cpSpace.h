@@ -49,14 +49,22 @@ typedef struct cpSpace{
 	// Default damping to supply when integrating rigid body motions.
 	cpFloat damping;
 	
+	// Time in seconds a group of bodies must stay idle before it falls asleep.
+	// Defaults to INFINITY, which disables sleeping.
+	cpFloat sleepTimeThreshold;
+	
+	// Speed under which a body is considered idle.
+	// If 0, the speed gained from gravity in one step is used.
+	cpFloat idleSpeedThreshold;
+	
 	// *** Internally Used Fields
 	
 	// Time stamp. Is incremented on every call to cpSpaceStep().
 	int stamp;
 
-	// The static and active shape spatial hashes.
-	cpSpaceHash *staticShapes;
-	cpSpaceHash *activeShapes;
+	// The static and active shape spatial indexes. (cpSpaceHash by default)
+	cpSpatialIndex *staticShapes;
+	cpSpatialIndex *activeShapes;
 	
 	// List of bodies in the system.
 	cpArray *bodies;
@@ -72,6 +80,32 @@ typedef struct cpSpace{
 	cpHashSet *collFuncSet;
 	// Default collision pair function.
 	cpCollPairFunc defaultPairFunc;
+	
+	// Pools for arbiters, contacts and hash bins. (NULL to use malloc)
+	cpSpacePools *pools;
+	// Scratch buffer for the narrow-phase collision functions.
+	cpContactBuffer contactBuffer;
+	
+	// Root bodies of the sleeping islands. Sleeping bodies are removed from the bodies array.
+	cpArray *sleepingRoots;
+	// Shapes of sleeping bodies. They are kept in the static hash while sleeping.
+	cpArray *sleepingShapes;
+	// Islands woken while the space was locked. Their shapes are moved back after the collision pass.
+	cpArray *pendingWakeRoots;
+	// Constraints with at least one awake body. Rebuilt every step.
+	cpArray *activeConstraints;
+	// Non-zero while cpSpaceStep() is iterating the spatial hashes.
+	int locked;
+	// Non-zero to sort the arbiters by shape id after the collision pass, so the solver order does not
+	// depend on the history of the spatial index. Set by cpSpaceUseSpatialIndex().
+	int sortArbiters;
+	
+	// Multi-threaded solver. (NULL to use the serial solver)
+	cpParallelSolver *solver;
+	
+	// Scratch segments for cpSpaceSegmentQueryFirstBatch().
+	cpSpatialIndexSegment *querySegments;
+	int querySegmentsMax;
 } cpSpace;
 
 // Basic allocation/destruction functions.
@@ -85,6 +119,20 @@ void cpSpaceFree(cpSpace *space);
 // Convenience function. Frees all referenced entities. (bodies, shapes and constraints)
 void cpSpaceFreeChildren(cpSpace *space);
 
+// Allocate the space's internal objects from the given pools.
+// Must be called before anything is added to the space. The caller owns the pools
+// and must free them after the space has been freed.
+void cpSpaceUsePools(cpSpace *space, cpSpacePools *pools);
+
+// Replace the spatial indexes of the static and active shapes. The space takes ownership of them.
+// Must be called before anything is added to the space, but after cpSpaceUsePools().
+// Turns on sortArbiters, because trees and sweeps report the pairs in the order of their current layout.
+void cpSpaceUseSpatialIndex(cpSpace *space, cpSpatialIndex *staticIndex, cpSpatialIndex *activeIndex);
+
+// Solve the contacts and constraints on threadCount threads. (See cpParallelSolver.h)
+// Pass 1 and deterministic = 0 to go back to the serial solver, 0 to use one thread per CPU.
+void cpSpaceSetSolverThreads(cpSpace *space, int threadCount, int deterministic);
+
 // Collision pair function management functions.
 void cpSpaceAddCollisionPairFunc(cpSpace *space, cpCollisionType a, cpCollisionType b,
                                  cpCollFunc func, void *data);
@@ -107,14 +155,47 @@ typedef void (*cpSpacePointQueryFunc)(cpShape *shape, void *data);
 void cpSpacePointQuery(cpSpace *space, cpVect point, cpLayers layers, cpGroup group, cpSpacePointQueryFunc func, void *data);
 cpShape *cpSpacePointQueryFirst(cpSpace *space, cpVect point, cpLayers layers, cpGroup group);
 
+// Segment query callback function
+typedef void (*cpSpaceSegmentQueryFunc)(cpShape *shape, cpFloat t, cpVect n, void *data);
+// Call func for every shape crossed by the segment from a to b, in no particular order.
+void cpSpaceSegmentQuery(cpSpace *space, cpVect a, cpVect b, cpLayers layers, cpGroup group, cpSpaceSegmentQueryFunc func, void *data);
+// Find the shape the segment from a to b crosses first. out may be NULL.
+cpShape *cpSpaceSegmentQueryFirst(cpSpace *space, cpVect a, cpVect b, cpLayers layers, cpGroup group, cpSegmentQueryInfo *out);
+// Find the first shape crossed by each of the segments from a[i] to b[i].
+// The whole batch goes through each spatial index once. out[i].shape is NULL for the segments that hit nothing.
+void cpSpaceSegmentQueryFirstBatch(cpSpace *space, int count, const cpVect *a, const cpVect *b, cpLayers layers, cpGroup group, cpSegmentQueryInfo *out);
+
+// BBox query callback function
+typedef void (*cpSpaceBBQueryFunc)(cpShape *shape, void *data);
+// Call func for every shape whose BBox overlaps bb.
+void cpSpaceBBQuery(cpSpace *space, cpBB bb, cpLayers layers, cpGroup group, cpSpaceBBQueryFunc func, void *data);
+
 // Iterator function for iterating the bodies in a space.
 typedef void (*cpSpaceBodyIterator)(cpBody *body, void *data);
 void cpSpaceEachBody(cpSpace *space, cpSpaceBodyIterator func, void *data);
 
 // Spatial hash management functions.
+// Resizing does nothing if the index is not a cpSpaceHash.
 void cpSpaceResizeStaticHash(cpSpace *space, cpFloat dim, int count);
 void cpSpaceResizeActiveHash(cpSpace *space, cpFloat dim, int count);
 void cpSpaceRehashStatic(cpSpace *space);
 
+// Wake all sleeping bodies in the space.
+void cpSpaceActivateAll(cpSpace *space);
+// Number of bodies that are currently sleeping.
+int cpSpaceGetSleepingBodyCount(cpSpace *space);
+
+// Arbiter management functions, used to save and restore the state of a space.
+typedef void (*cpSpaceArbiterIterator)(cpArbiter *arb, void *data);
+// Call func for every arbiter in the persistent contact set. (Including the arbiters of sleeping bodies)
+void cpSpaceEachArbiter(cpSpace *space, cpSpaceArbiterIterator func, void *data);
+// Replace the arbiters with saved ones: call cpSpaceBeginRestoreArbiters(), then cpSpaceRestoreArbiter()
+// for every saved arbiter, then cpSpaceEndRestoreArbiters() to throw away the arbiters that were not restored.
+void cpSpaceBeginRestoreArbiters(cpSpace *space);
+// Reuse or add the arbiter for the shapes a and b with room for numContacts contacts.
+// The caller must fill in the hash and the impulses of every contact. The rest is rebuilt by the next step.
+cpArbiter *cpSpaceRestoreArbiter(cpSpace *space, cpShape *a, cpShape *b, int stamp, int numContacts);
+void cpSpaceEndRestoreArbiters(cpSpace *space);
+
 // Update the space.
 void cpSpaceStep(cpSpace *space, cpFloat dt);
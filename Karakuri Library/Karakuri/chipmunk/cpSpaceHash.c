@@ -28,9 +28,9 @@
 #include "prime.h"
 
 static cpHandle*
-cpHandleAlloc(void)
+cpHandleAlloc(cpSpaceHash *hash)
 {
-	return (cpHandle *)malloc(sizeof(cpHandle));
+	return (hash->handlePool ? (cpHandle *)cpPoolAlloc(hash->handlePool) : (cpHandle *)malloc(sizeof(cpHandle)));
 }
 
 static cpHandle*
@@ -44,9 +44,9 @@ cpHandleInit(cpHandle *hand, void *obj)
 }
 
 static cpHandle*
-cpHandleNew(void *obj)
+cpHandleNew(cpSpaceHash *hash, void *obj)
 {
-	return cpHandleInit(cpHandleAlloc(), obj);
+	return cpHandleInit(cpHandleAlloc(hash), obj);
 }
 
 static inline void
@@ -56,17 +56,18 @@ cpHandleRetain(cpHandle *hand)
 }
 
 static inline void
-cpHandleFree(cpHandle *hand)
+cpHandleFree(cpSpaceHash *hash, cpHandle *hand)
 {
-	free(hand);
+	if(hash->handlePool) cpPoolFree(hash->handlePool, hand);
+	else free(hand);
 }
 
 static inline void
-cpHandleRelease(cpHandle *hand)
+cpHandleRelease(cpSpaceHash *hash, cpHandle *hand)
 {
 	hand->retain--;
 	if(hand->retain == 0)
-		cpHandleFree(hand);
+		cpHandleFree(hash, hand);
 }
 
 
@@ -96,9 +97,9 @@ handleSetEql(void *obj, void *elt)
 
 // Transformation function for the handleset.
 static void *
-handleSetTrans(void *obj, void *unused)
+handleSetTrans(void *obj, void *data)
 {
-	cpHandle *hand = cpHandleNew(obj);
+	cpHandle *hand = cpHandleNew((cpSpaceHash *)data, obj);
 	cpHandleRetain(hand);
 	
 	return hand;
@@ -107,15 +108,24 @@ handleSetTrans(void *obj, void *unused)
 cpSpaceHash*
 cpSpaceHashInit(cpSpaceHash *hash, cpFloat celldim, int numcells, cpSpaceHashBBFunc bbfunc)
 {
+	hash->index.klass = cpSpaceHashGetClass();
+	hash->index.bbfunc = bbfunc;
+	
 	cpSpaceHashAllocTable(hash, next_prime(numcells));
 	hash->celldim = celldim;
-	hash->bbfunc = bbfunc;
+	
+	hash->autoResize = 0;
+	hash->sizeSum = 0.0f;
+	hash->sizeCount = 0;
 	
 	hash->bins = NULL;
 	hash->handleSet = cpHashSetNew(0, &handleSetEql, &handleSetTrans);
 	
 	hash->stamp = 1;
 	
+	hash->binPool = NULL;
+	hash->handlePool = NULL;
+	
 	return hash;
 }
 
@@ -133,7 +143,7 @@ clearHashCell(cpSpaceHash *hash, int index)
 		cpSpaceHashBin *next = bin->next;
 		
 		// Release the lock on the handle.
-		cpHandleRelease(bin->handle);
+		cpHandleRelease(hash, bin->handle);
 		// Recycle the bin.
 		bin->next = hash->bins;
 		hash->bins = bin;
@@ -159,17 +169,18 @@ freeBins(cpSpaceHash *hash)
 	cpSpaceHashBin *bin = hash->bins;
 	while(bin){
 		cpSpaceHashBin *next = bin->next;
-		free(bin);
+		if(hash->binPool) cpPoolFree(hash->binPool, bin);
+		else free(bin);
 		bin = next;
 	}
 }
 
 // Hashset iterator function to free the handles.
 static void
-handleFreeWrap(void *elt, void *unused)
+handleFreeWrap(void *elt, void *data)
 {
 	cpHandle *hand = (cpHandle *)elt;
-	cpHandleFree(hand);
+	cpHandleFree((cpSpaceHash *)data, hand);
 }
 
 void
@@ -179,7 +190,7 @@ cpSpaceHashDestroy(cpSpaceHash *hash)
 	freeBins(hash);
 	
 	// Free the handles.
-	cpHashSetEach(hash->handleSet, &handleFreeWrap, NULL);
+	cpHashSetEach(hash->handleSet, &handleFreeWrap, hash);
 	cpHashSetFree(hash->handleSet);
 	
 	free(hash->table);
@@ -193,6 +204,14 @@ cpSpaceHashFree(cpSpaceHash *hash)
 	free(hash);
 }
 
+void
+cpSpaceHashSetPools(cpSpaceHash *hash, cpPool *binPool, cpPool *handlePool, cpPool *setBinPool)
+{
+	hash->binPool = binPool;
+	hash->handlePool = handlePool;
+	hash->handleSet->binPool = setBinPool;
+}
+
 void
 cpSpaceHashResize(cpSpaceHash *hash, cpFloat celldim, int numcells)
 {
@@ -203,6 +222,35 @@ cpSpaceHashResize(cpSpaceHash *hash, cpFloat celldim, int numcells)
 	cpSpaceHashAllocTable(hash, next_prime(numcells));
 }
 
+void
+cpSpaceHashSetAutoResize(cpSpaceHash *hash, int autoResize)
+{
+	hash->autoResize = autoResize;
+	hash->sizeSum = 0.0f;
+	hash->sizeCount = 0;
+}
+
+// The cell size only changes when it is off by more than this factor, so it doesn't flap.
+#define AUTO_RESIZE_SLACK 1.5f
+
+// Retune the table from the sizes measured by the last cpSpaceHashQueryRehash().
+static void
+autoResize(cpSpaceHash *hash)
+{
+	int count = hash->sizeCount;
+	if(!count) return;
+	
+	cpFloat dim = hash->sizeSum/count;
+	hash->sizeSum = 0.0f;
+	hash->sizeCount = 0;
+	
+	int resizeDim = (dim > 0.0f && (dim > hash->celldim*AUTO_RESIZE_SLACK || dim*AUTO_RESIZE_SLACK < hash->celldim));
+	int resizeCells = (hash->numcells < count);
+	
+	if(resizeDim || resizeCells)
+		cpSpaceHashResize(hash, (resizeDim ? dim : hash->celldim), (resizeCells ? count*2 : hash->numcells));
+}
+
 // Return true if the chain contains the handle.
 static inline int
 containsHandle(cpSpaceHashBin *bin, cpHandle *hand)
@@ -222,7 +270,10 @@ getEmptyBin(cpSpaceHash *hash)
 	cpSpaceHashBin *bin = hash->bins;
 	
 	// Make a new one if necessary.
-	if(bin == NULL) return (cpSpaceHashBin *)malloc(sizeof(cpSpaceHashBin));
+	if(bin == NULL){
+		if(hash->binPool) return (cpSpaceHashBin *)cpPoolAlloc(hash->binPool);
+		return (cpSpaceHashBin *)malloc(sizeof(cpSpaceHashBin));
+	}
 
 	hash->bins = bin->next;
 	return bin;
@@ -267,7 +318,7 @@ hashHandle(cpSpaceHash *hash, cpHandle *hand, cpBB bb)
 void
 cpSpaceHashInsert(cpSpaceHash *hash, void *obj, cpHashValue id, cpBB bb)
 {
-	cpHandle *hand = (cpHandle *)cpHashSetInsert(hash->handleSet, id, obj, NULL);
+	cpHandle *hand = (cpHandle *)cpHashSetInsert(hash->handleSet, id, obj, hash);
 	hashHandle(hash, hand, bb);
 }
 
@@ -275,7 +326,7 @@ void
 cpSpaceHashRehashObject(cpSpaceHash *hash, void *obj, cpHashValue id)
 {
 	cpHandle *hand = (cpHandle *)cpHashSetFind(hash->handleSet, id, obj);
-	hashHandle(hash, hand, hash->bbfunc(obj));
+	hashHandle(hash, hand, hash->index.bbfunc(obj));
 }
 
 // Hashset iterator function for rehashing the spatial hash. (hash hash hash hash?)
@@ -285,7 +336,7 @@ handleRehashHelper(void *elt, void *data)
 	cpHandle *hand = (cpHandle *)elt;
 	cpSpaceHash *hash = (cpSpaceHash *)data;
 	
-	hashHandle(hash, hand, hash->bbfunc(hand->obj));
+	hashHandle(hash, hand, hash->index.bbfunc(hand->obj));
 }
 
 void
@@ -304,7 +355,7 @@ cpSpaceHashRemove(cpSpaceHash *hash, void *obj, cpHashValue id)
 	
 	if(hand){
 		hand->obj = NULL;
-		cpHandleRelease(hand);
+		cpHandleRelease(hash, hand);
 	}
 }
 
@@ -418,7 +469,12 @@ handleQueryRehashHelper(void *elt, void *data)
 	int n = hash->numcells;
 
 	void *obj = hand->obj;
-	cpBB bb = hash->bbfunc(obj);
+	cpBB bb = hash->index.bbfunc(obj);
+	
+	if(hash->autoResize){
+		hash->sizeSum += cpfmax(bb.r - bb.l, bb.t - bb.b);
+		hash->sizeCount++;
+	}
 
 	int l = bb.l/dim;
 	int r = bb.r/dim;
@@ -453,53 +509,141 @@ handleQueryRehashHelper(void *elt, void *data)
 void
 cpSpaceHashQueryRehash(cpSpaceHash *hash, cpSpaceHashQueryFunc func, void *data)
 {
+	if(hash->autoResize) autoResize(hash);
 	clearHash(hash);
 	
 	queryRehashPair pair = {hash, func, data};
 	cpHashSetEach(hash->handleSet, &handleQueryRehashHelper, &pair);
 }
 
-// modified from http://playtechs.blogspot.com/2007/03/raytracing-on-grid.html
-void raytrace(cpSpaceHash *hash, void *obj, cpVect a, cpVect b, cpSpaceHashQueryFunc func, void *data)
+#pragma mark Spatial Index Class
+
+static void
+hashDestroy(cpSpatialIndex *index)
 {
-	a = cpvmult(a, 1.0f/hash->celldim);
-	b = cpvmult(b, 1.0f/hash->celldim);
-	cpFloat dt_dx = 1.0f/fabs(b.x - a.x), dt_dy = 1.0f/fabs(b.y - a.y);
-	
-	int cell_x = (int)cpffloor(a.x), cell_y = (int)cpffloor(a.y);
+	cpSpaceHashDestroy((cpSpaceHash *)index);
+}
 
-	cpFloat t = 0;
+static void
+hashSetPools(cpSpatialIndex *index, cpSpacePools *pools)
+{
+	cpSpaceHashSetPools((cpSpaceHash *)index, &pools->spaceHashBins, &pools->handles, &pools->hashSetBins);
+}
 
-	int x_inc, y_inc;
-	cpFloat next_v, next_h;
+static int
+hashCount(cpSpatialIndex *index)
+{
+	return ((cpSpaceHash *)index)->handleSet->entries;
+}
+
+static void
+hashEach(cpSpatialIndex *index, cpSpatialIndexIterator func, void *data)
+{
+	cpSpaceHashEach((cpSpaceHash *)index, func, data);
+}
+
+static void
+hashInsert(cpSpatialIndex *index, void *obj, cpHashValue id, cpBB bb)
+{
+	cpSpaceHashInsert((cpSpaceHash *)index, obj, id, bb);
+}
+
+static void
+hashRemove(cpSpatialIndex *index, void *obj, cpHashValue id)
+{
+	cpSpaceHashRemove((cpSpaceHash *)index, obj, id);
+}
+
+static void
+hashReindex(cpSpatialIndex *index)
+{
+	cpSpaceHashRehash((cpSpaceHash *)index);
+}
+
+static void
+hashReindexQuery(cpSpatialIndex *index, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpSpaceHashQueryRehash((cpSpaceHash *)index, func, data);
+}
+
+static void
+hashPointQuery(cpSpatialIndex *index, cpVect point, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpSpaceHashPointQuery((cpSpaceHash *)index, point, func, data);
+}
+
+static void
+hashQuery(cpSpatialIndex *index, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpSpaceHashQuery((cpSpaceHash *)index, obj, bb, func, data);
+}
 
-	if (b.x > a.x){
+// Calls the callback for the objects in a chain that weren't checked against the segment yet.
+static inline void
+segmentQueryHelper(cpSpaceHash *hash, cpSpaceHashBin *bin, cpSpatialIndexSegment *segment, int index, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	for(; bin; bin = bin->next){
+		cpHandle *hand = bin->handle;
+		void *other = hand->obj;
+		
+		if(hand->stamp == hash->stamp || !other) continue;
+		
+		segment->t_exit = cpfmin(segment->t_exit, func(other, index, data));
+		hand->stamp = hash->stamp;
+	}
+}
+
+// Objects are hashed into cells by truncating their coordinates, so a cell covers two cell widths around 0.
+static inline int
+truncatedCell(int cell)
+{
+	return (cell < 0 ? cell + 1 : cell);
+}
+
+// Walk the cells crossed by the segment in order and stop after the cell containing t_exit.
+// Modified from http://playtechs.blogspot.com/2007/03/raytracing-on-grid.html
+static void
+segmentQuery(cpSpaceHash *hash, cpSpatialIndexSegment *segment, int index, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	cpVect a = cpvmult(segment->a, 1.0f/hash->celldim);
+	cpVect b = cpvmult(segment->b, 1.0f/hash->celldim);
+	
+	int cell_x = (int)cpffloor(a.x), cell_y = (int)cpffloor(a.y);
+	
+	int x_inc, y_inc;
+	cpFloat temp_h, temp_v;
+	
+	if(b.x > a.x){
 		x_inc = 1;
-		next_h = (cpfceil(a.x) - a.x)*dt_dx;
+		temp_h = cpffloor(a.x + 1.0f) - a.x;
 	} else {
 		x_inc = -1;
-		next_h = (a.x - cpffloor(a.x))*dt_dx;
+		temp_h = a.x - cpffloor(a.x);
 	}
-
-	if (b.y > a.y){
+	
+	if(b.y > a.y){
 		y_inc = 1;
-		next_v = (cpfceil(a.y) - a.y)*dt_dy;
+		temp_v = cpffloor(a.y + 1.0f) - a.y;
 	} else {
 		y_inc = -1;
-		next_v = (a.y - cpffloor(a.y))*dt_dy;
+		temp_v = a.y - cpffloor(a.y);
 	}
 	
-	// fix NANs in horizontal directions
-	next_h = (next_h == next_h ? next_h : dt_dx);
-	next_v = (next_v == next_v ? next_v : dt_dy);
-
+	cpFloat dx = cpfabs(b.x - a.x), dy = cpfabs(b.y - a.y);
+	cpFloat dt_dx = (dx ? 1.0f/dx : INFINITY), dt_dy = (dy ? 1.0f/dy : INFINITY);
+	
+	// Avoid 0*INFINITY for axis aligned segments.
+	cpFloat next_h = (temp_h ? temp_h*dt_dx : dt_dx);
+	cpFloat next_v = (temp_v ? temp_v*dt_dy : dt_dy);
+	
 	int n = hash->numcells;
-	while(next_h < 1.0f || next_v < 1.0f){
-		printf("cell (%d,%d)\n", cell_x, cell_y);
-		int index = hash_func(cell_x, cell_y, n);
-		query(hash, hash->table[index], obj, func, data);
-
-		if (next_v < next_h){
+	cpFloat t = 0.0f;
+	
+	while(t < segment->t_exit){
+		int cell = hash_func(truncatedCell(cell_x), truncatedCell(cell_y), n);
+		segmentQueryHelper(hash, hash->table[cell], segment, index, func, data);
+		
+		if(next_v < next_h){
 			cell_y += y_inc;
 			t = next_v;
 			next_v += dt_dy;
@@ -509,4 +653,39 @@ void raytrace(cpSpaceHash *hash, void *obj, cpVect a, cpVect b, cpSpaceHashQuery
 			next_h += dt_dx;
 		}
 	}
+	
+	hash->stamp++;
+}
+
+void
+cpSpaceHashSegmentQuery(cpSpaceHash *hash, cpSpatialIndexSegment *segments, int count, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	for(int i=0; i<count; i++)
+		segmentQuery(hash, &segments[i], i, func, data);
+}
+
+static void
+hashSegmentQuery(cpSpatialIndex *index, cpSpatialIndexSegment *segments, int count, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	cpSpaceHashSegmentQuery((cpSpaceHash *)index, segments, count, func, data);
+}
+
+static const cpSpatialIndexClass klass = {
+	hashDestroy,
+	hashSetPools,
+	hashCount,
+	hashEach,
+	hashInsert,
+	hashRemove,
+	hashReindex,
+	hashReindexQuery,
+	hashPointQuery,
+	hashQuery,
+	hashSegmentQuery,
+};
+
+const cpSpatialIndexClass *
+cpSpaceHashGetClass(void)
+{
+	return &klass;
 }
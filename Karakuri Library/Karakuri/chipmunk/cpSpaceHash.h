@@ -19,7 +19,7 @@
  * SOFTWARE.
  */
 
-// The spatial hash is Chipmunk's default (and currently only) spatial index type.
+// The spatial hash is Chipmunk's default spatial index type.
 // Based on a chained hash table.
 
 // Used internally to track objects added to the hash
@@ -40,16 +40,22 @@ typedef struct cpSpaceHashBin{
 } cpSpaceHashBin;
 
 // BBox callback. Called whenever the hash needs a bounding box from an object.
-typedef cpBB (*cpSpaceHashBBFunc)(void *obj);
+typedef cpSpatialIndexBBFunc cpSpaceHashBBFunc;
 
 typedef struct cpSpaceHash{
+	// Common spatial index header. (Holds the BBox callback.)
+	cpSpatialIndex index;
+	
 	// Number of cells in the table.
 	int numcells;
 	// Dimentions of the cells.
 	cpFloat celldim;
 	
-	// BBox callback.
-	cpSpaceHashBBFunc bbfunc;
+	// If non-zero, the cell size follows the average size of the objects. See cpSpaceHashSetAutoResize().
+	int autoResize;
+	// Sum of the object sizes and number of objects measured by the last cpSpaceHashQueryRehash().
+	cpFloat sizeSum;
+	int sizeCount;
 
 	// Hashset of all the handles.
 	cpHashSet *handleSet;
@@ -60,6 +66,10 @@ typedef struct cpSpaceHash{
 
 	// Incremented on each query. See cpHandle.stamp.
 	int stamp;
+	
+	// Pools to allocate the bins and handles from. Default to NULL (use malloc).
+	struct cpPool *binPool;
+	struct cpPool *handlePool;
 } cpSpaceHash;
 
 //Basic allocation/destruction functions.
@@ -70,16 +80,26 @@ cpSpaceHash *cpSpaceHashNew(cpFloat celldim, int cells, cpSpaceHashBBFunc bbfunc
 void cpSpaceHashDestroy(cpSpaceHash *hash);
 void cpSpaceHashFree(cpSpaceHash *hash);
 
+// Allocate bins, handles and handle set bins from the given pools. (Call before inserting anything.)
+void cpSpaceHashSetPools(cpSpaceHash *hash, struct cpPool *binPool, struct cpPool *handlePool, struct cpPool *setBinPool);
+
 // Resize the hashtable. (Does not rehash! You must call cpSpaceHashRehash() if needed.)
 void cpSpaceHashResize(cpSpaceHash *hash, cpFloat celldim, int numcells);
 
+// Let cpSpaceHashQueryRehash() retune the cell size to the average size of the objects,
+// and grow the table when there are more objects than cells.
+void cpSpaceHashSetAutoResize(cpSpaceHash *hash, int autoResize);
+
+// Class used to drive a cpSpaceHash through the cpSpatialIndex functions.
+const cpSpatialIndexClass *cpSpaceHashGetClass(void);
+
 // Add an object to the hash.
 void cpSpaceHashInsert(cpSpaceHash *hash, void *obj, cpHashValue id, cpBB bb);
 // Remove an object from the hash.
 void cpSpaceHashRemove(cpSpaceHash *hash, void *obj, cpHashValue id);
 
 // Iterator function
-typedef void (*cpSpaceHashIterator)(void *obj, void *data);
+typedef cpSpatialIndexIterator cpSpaceHashIterator;
 // Iterate over the objects in the hash.
 void cpSpaceHashEach(cpSpaceHash *hash, cpSpaceHashIterator func, void *data);
 
@@ -89,11 +109,13 @@ void cpSpaceHashRehash(cpSpaceHash *hash);
 void cpSpaceHashRehashObject(cpSpaceHash *hash, void *obj, cpHashValue id);
 
 // Query callback.
-typedef void (*cpSpaceHashQueryFunc)(void *obj1, void *obj2, void *data);
+typedef cpSpatialIndexQueryFunc cpSpaceHashQueryFunc;
 // Point query the hash. A reference to the query point is passed as obj1 to the query callback.
 void cpSpaceHashPointQuery(cpSpaceHash *hash, cpVect point, cpSpaceHashQueryFunc func, void *data);
 // Query the hash for a given BBox.
 void cpSpaceHashQuery(cpSpaceHash *hash, void *obj, cpBB bb, cpSpaceHashQueryFunc func, void *data);
+// Walk the cells crossed by each segment. (See cpSpatialIndexSegmentQuery())
+void cpSpaceHashSegmentQuery(cpSpaceHash *hash, cpSpatialIndexSegment *segments, int count, cpSpatialIndexSegmentQueryFunc func, void *data);
 // Run a query for the object, then insert it. (Optimized case)
 void cpSpaceHashQueryInsert(cpSpaceHash *hash, void *obj, cpBB bb, cpSpaceHashQueryFunc func, void *data);
 // Rehashes while querying for each object. (Optimized case) 
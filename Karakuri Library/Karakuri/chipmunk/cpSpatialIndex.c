@@ -0,0 +1,17 @@
+/* cpSpatialIndex.c
+ * Common interface of the broadphase indexes of a cpSpace, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+#include <stdlib.h>
+
+#include "chipmunk.h"
+
+void
+cpSpatialIndexFree(cpSpatialIndex *index)
+{
+	if(!index) return;
+	
+	index->klass->destroy(index);
+	free(index);
+}
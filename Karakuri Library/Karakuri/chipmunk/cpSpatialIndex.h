@@ -0,0 +1,126 @@
+/* cpSpatialIndex.h
+ * Common interface of the broadphase indexes of a cpSpace, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+// A cpSpace keeps its static and active shapes in two spatial indexes.
+// Every index type starts with a cpSpatialIndex header, so a space can use
+// cpSpaceHash, cpBBTree or cpSweep1D interchangeably through these functions.
+// All index types report the same candidate pairs. The callbacks still have to
+// check whether the bounding boxes really overlap.
+
+struct cpSpacePools;
+
+// BBox callback. Called whenever the index needs a bounding box from an object.
+typedef cpBB (*cpSpatialIndexBBFunc)(void *obj);
+// Iterator function.
+typedef void (*cpSpatialIndexIterator)(void *obj, void *data);
+// Query callback.
+typedef void (*cpSpatialIndexQueryFunc)(void *obj1, void *obj2, void *data);
+
+// Segment for the segment queries. Only the part from a to lerp(a, b, t_exit) is searched.
+typedef struct cpSpatialIndexSegment {
+	cpVect a, b;
+	cpFloat t_exit;
+} cpSpatialIndexSegment;
+// Segment query callback. Called with the index of the segment in the batch.
+// Returns the new t_exit of the segment, so a search for the first hit can stop early.
+typedef cpFloat (*cpSpatialIndexSegmentQueryFunc)(void *obj, int segment, void *data);
+
+typedef struct cpSpatialIndexClass cpSpatialIndexClass;
+
+typedef struct cpSpatialIndex {
+	const cpSpatialIndexClass *klass;
+
+	// BBox callback.
+	cpSpatialIndexBBFunc bbfunc;
+} cpSpatialIndex;
+
+struct cpSpatialIndexClass {
+	void (*destroy)(cpSpatialIndex *index);
+
+	// Allocate the index's internal objects from the given pools. (Call before inserting anything.)
+	void (*setPools)(cpSpatialIndex *index, struct cpSpacePools *pools);
+
+	int (*count)(cpSpatialIndex *index);
+	void (*each)(cpSpatialIndex *index, cpSpatialIndexIterator func, void *data);
+
+	void (*insert)(cpSpatialIndex *index, void *obj, cpHashValue id, cpBB bb);
+	void (*remove)(cpSpatialIndex *index, void *obj, cpHashValue id);
+
+	// Update the bounding boxes of all the objects.
+	void (*reindex)(cpSpatialIndex *index);
+	// Update the bounding boxes and report every pair of objects that may overlap, once.
+	void (*reindexQuery)(cpSpatialIndex *index, cpSpatialIndexQueryFunc func, void *data);
+
+	// A reference to the query point is passed as obj1 to the query callback.
+	void (*pointQuery)(cpSpatialIndex *index, cpVect point, cpSpatialIndexQueryFunc func, void *data);
+	// obj is passed as obj1 to the query callback and is never reported as obj2.
+	void (*query)(cpSpatialIndex *index, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data);
+	// Report the objects whose BBox may be crossed by each segment before its t_exit, in one pass over the index.
+	// The t_exit of the segments is updated with the values returned by the callback.
+	void (*segmentQuery)(cpSpatialIndex *index, cpSpatialIndexSegment *segments, int count, cpSpatialIndexSegmentQueryFunc func, void *data);
+};
+
+// Destroy and free an index of any type.
+void cpSpatialIndexFree(cpSpatialIndex *index);
+
+static inline void
+cpSpatialIndexSetPools(cpSpatialIndex *index, struct cpSpacePools *pools)
+{
+	index->klass->setPools(index, pools);
+}
+
+static inline int
+cpSpatialIndexCount(cpSpatialIndex *index)
+{
+	return index->klass->count(index);
+}
+
+static inline void
+cpSpatialIndexEach(cpSpatialIndex *index, cpSpatialIndexIterator func, void *data)
+{
+	index->klass->each(index, func, data);
+}
+
+static inline void
+cpSpatialIndexInsert(cpSpatialIndex *index, void *obj, cpHashValue id, cpBB bb)
+{
+	index->klass->insert(index, obj, id, bb);
+}
+
+static inline void
+cpSpatialIndexRemove(cpSpatialIndex *index, void *obj, cpHashValue id)
+{
+	index->klass->remove(index, obj, id);
+}
+
+static inline void
+cpSpatialIndexReindex(cpSpatialIndex *index)
+{
+	index->klass->reindex(index);
+}
+
+static inline void
+cpSpatialIndexReindexQuery(cpSpatialIndex *index, cpSpatialIndexQueryFunc func, void *data)
+{
+	index->klass->reindexQuery(index, func, data);
+}
+
+static inline void
+cpSpatialIndexPointQuery(cpSpatialIndex *index, cpVect point, cpSpatialIndexQueryFunc func, void *data)
+{
+	index->klass->pointQuery(index, point, func, data);
+}
+
+static inline void
+cpSpatialIndexQuery(cpSpatialIndex *index, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data)
+{
+	index->klass->query(index, obj, bb, func, data);
+}
+
+static inline void
+cpSpatialIndexSegmentQuery(cpSpatialIndex *index, cpSpatialIndexSegment *segments, int count, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	index->klass->segmentQuery(index, segments, count, func, data);
+}
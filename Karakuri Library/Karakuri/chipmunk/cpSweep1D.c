@@ -0,0 +1,320 @@
+/* cpSweep1D.c
+ * Sort-and-sweep broadphase, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+#include <stdlib.h>
+
+#include "chipmunk.h"
+
+#pragma mark Handles
+
+static cpSweep1DHandle *
+handleAlloc(cpSweep1D *sweep)
+{
+	return (sweep->handlePool ? (cpSweep1DHandle *)cpPoolAlloc(sweep->handlePool) : (cpSweep1DHandle *)malloc(sizeof(cpSweep1DHandle)));
+}
+
+static void
+handleFree(cpSweep1D *sweep, cpSweep1DHandle *hand)
+{
+	if(sweep->handlePool) cpPoolFree(sweep->handlePool, hand);
+	else free(hand);
+}
+
+// Equality function for the handle set.
+static int
+handleSetEql(void *obj, cpSweep1DHandle *hand)
+{
+	return (obj == hand->obj);
+}
+
+// Transformation function for the handle set.
+static void *
+handleSetTrans(void *obj, cpSweep1D *sweep)
+{
+	cpSweep1DHandle *hand = handleAlloc(sweep);
+	hand->obj = obj;
+	hand->bb = cpBBNew(0.0f, 0.0f, 0.0f, 0.0f);
+	
+	return hand;
+}
+
+#pragma mark Memory Management Functions
+
+cpSweep1D *
+cpSweep1DAlloc(void)
+{
+	return (cpSweep1D *)calloc(1, sizeof(cpSweep1D));
+}
+
+cpSweep1D *
+cpSweep1DInit(cpSweep1D *sweep, cpSpatialIndexBBFunc bbfunc)
+{
+	sweep->index.klass = cpSweep1DGetClass();
+	sweep->index.bbfunc = bbfunc;
+	
+	sweep->handleSet = cpHashSetNew(0, (cpHashSetEqlFunc)handleSetEql, (cpHashSetTransFunc)handleSetTrans);
+	
+	sweep->max = 32;
+	sweep->num = 0;
+	sweep->table = (cpSweep1DHandle **)malloc(sweep->max*sizeof(cpSweep1DHandle *));
+	sweep->sorted = 1;
+	
+	sweep->handlePool = NULL;
+	
+	return sweep;
+}
+
+cpSweep1D *
+cpSweep1DNew(cpSpatialIndexBBFunc bbfunc)
+{
+	return cpSweep1DInit(cpSweep1DAlloc(), bbfunc);
+}
+
+void
+cpSweep1DDestroy(cpSweep1D *sweep)
+{
+	// The table holds every handle, removed ones included.
+	for(int i=0; i<sweep->num; i++)
+		handleFree(sweep, sweep->table[i]);
+	free(sweep->table);
+	
+	cpHashSetFree(sweep->handleSet);
+}
+
+void
+cpSweep1DFree(cpSweep1D *sweep)
+{
+	if(!sweep) return;
+	cpSweep1DDestroy(sweep);
+	free(sweep);
+}
+
+#pragma mark Sorting
+
+static int
+compareHandles(const void *a, const void *b)
+{
+	cpFloat la = (*(cpSweep1DHandle **)a)->bb.l;
+	cpFloat lb = (*(cpSweep1DHandle **)b)->bb.l;
+	return (la < lb ? -1 : (la > lb ? 1 : 0));
+}
+
+// Sort the table by the left edges.
+static void
+sortTable(cpSweep1D *sweep)
+{
+	cpSweep1DHandle **table = sweep->table;
+	int num = sweep->num;
+	
+	if(!sweep->sorted){
+		// Freshly inserted handles can be anywhere.
+		qsort(table, num, sizeof(cpSweep1DHandle *), compareHandles);
+	} else {
+		// Objects move only a little between steps, so this is nearly linear.
+		for(int i=1; i<num; i++){
+			cpSweep1DHandle *hand = table[i];
+			cpFloat l = hand->bb.l;
+			
+			int j = i - 1;
+			for(; j>=0 && table[j]->bb.l > l; j--)
+				table[j + 1] = table[j];
+			table[j + 1] = hand;
+		}
+	}
+	
+	sweep->sorted = 1;
+}
+
+// Drop the removed handles and refresh the BBoxes of the others.
+static void
+updateTable(cpSweep1D *sweep)
+{
+	cpSweep1DHandle **table = sweep->table;
+	cpSpatialIndexBBFunc bbfunc = sweep->index.bbfunc;
+	
+	int num = 0;
+	for(int i=0; i<sweep->num; i++){
+		cpSweep1DHandle *hand = table[i];
+		if(!hand->obj){
+			handleFree(sweep, hand);
+			continue;
+		}
+		
+		hand->bb = bbfunc(hand->obj);
+		table[num++] = hand;
+	}
+	
+	sweep->num = num;
+	
+	sortTable(sweep);
+}
+
+#pragma mark Spatial Index Class
+
+static void
+sweepDestroy(cpSpatialIndex *index)
+{
+	cpSweep1DDestroy((cpSweep1D *)index);
+}
+
+static void
+sweepSetPools(cpSpatialIndex *index, cpSpacePools *pools)
+{
+	cpSweep1D *sweep = (cpSweep1D *)index;
+	sweep->handlePool = &pools->sweepHandles;
+	sweep->handleSet->binPool = &pools->hashSetBins;
+}
+
+static int
+sweepCount(cpSpatialIndex *index)
+{
+	return ((cpSweep1D *)index)->handleSet->entries;
+}
+
+typedef struct eachContext {
+	cpSpatialIndexIterator func;
+	void *data;
+} eachContext;
+
+static void
+eachHelper(cpSweep1DHandle *hand, eachContext *context)
+{
+	context->func(hand->obj, context->data);
+}
+
+static void
+sweepEach(cpSpatialIndex *index, cpSpatialIndexIterator func, void *data)
+{
+	eachContext context = {func, data};
+	cpHashSetEach(((cpSweep1D *)index)->handleSet, (cpHashSetIterFunc)eachHelper, &context);
+}
+
+static void
+sweepInsert(cpSpatialIndex *index, void *obj, cpHashValue id, cpBB bb)
+{
+	cpSweep1D *sweep = (cpSweep1D *)index;
+	
+	int count = sweep->handleSet->entries;
+	cpSweep1DHandle *hand = (cpSweep1DHandle *)cpHashSetInsert(sweep->handleSet, id, obj, sweep);
+	if(sweep->handleSet->entries == count) return; // Already in the table.
+	
+	hand->bb = bb;
+	
+	if(sweep->num == sweep->max){
+		sweep->max *= 2;
+		sweep->table = (cpSweep1DHandle **)realloc(sweep->table, sweep->max*sizeof(cpSweep1DHandle *));
+	}
+	
+	sweep->table[sweep->num++] = hand;
+	sweep->sorted = 0;
+}
+
+static void
+sweepRemove(cpSpatialIndex *index, void *obj, cpHashValue id)
+{
+	cpSweep1D *sweep = (cpSweep1D *)index;
+	
+	// The handle stays in the table until the next reindex.
+	cpSweep1DHandle *hand = (cpSweep1DHandle *)cpHashSetRemove(sweep->handleSet, id, obj);
+	if(hand) hand->obj = NULL;
+}
+
+static void
+sweepReindex(cpSpatialIndex *index)
+{
+	updateTable((cpSweep1D *)index);
+}
+
+static void
+sweepReindexQuery(cpSpatialIndex *index, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpSweep1D *sweep = (cpSweep1D *)index;
+	updateTable(sweep);
+	
+	cpSweep1DHandle **table = sweep->table;
+	int num = sweep->num;
+	
+	for(int i=0; i<num; i++){
+		cpSweep1DHandle *a = table[i];
+		cpBB bb = a->bb;
+		
+		for(int j=i+1; j<num; j++){
+			cpSweep1DHandle *b = table[j];
+			if(b->bb.l > bb.r) break;
+			
+			if(b->bb.b <= bb.t && bb.b <= b->bb.t) func(a->obj, b->obj, data);
+		}
+	}
+}
+
+static void
+sweepQuery(cpSpatialIndex *index, void *obj, cpBB bb, cpSpatialIndexQueryFunc func, void *data)
+{
+	cpSweep1D *sweep = (cpSweep1D *)index;
+	if(!sweep->sorted) sortTable(sweep);
+	
+	cpSweep1DHandle **table = sweep->table;
+	int num = sweep->num;
+	
+	for(int i=0; i<num; i++){
+		cpSweep1DHandle *hand = table[i];
+		if(hand->bb.l > bb.r) break;
+		
+		if(hand->obj && hand->obj != obj && cpBBintersects(hand->bb, bb)) func(obj, hand->obj, data);
+	}
+}
+
+static void
+sweepPointQuery(cpSpatialIndex *index, cpVect point, cpSpatialIndexQueryFunc func, void *data)
+{
+	sweepQuery(index, &point, cpBBNew(point.x, point.y, point.x, point.y), func, data);
+}
+
+// One pass over the table for the whole batch.
+static void
+sweepSegmentQuery(cpSpatialIndex *index, cpSpatialIndexSegment *segments, int count, cpSpatialIndexSegmentQueryFunc func, void *data)
+{
+	cpSweep1D *sweep = (cpSweep1D *)index;
+	if(!sweep->sorted) sortTable(sweep);
+	
+	cpFloat right = -INFINITY;
+	for(int j=0; j<count; j++) right = cpfmax(right, cpfmax(segments[j].a.x, segments[j].b.x));
+	
+	cpSweep1DHandle **table = sweep->table;
+	int num = sweep->num;
+	
+	for(int i=0; i<num; i++){
+		cpSweep1DHandle *hand = table[i];
+		if(hand->bb.l > right) break;
+		if(!hand->obj) continue;
+		
+		for(int j=0; j<count; j++){
+			cpSpatialIndexSegment *segment = &segments[j];
+			if(cpBBSegmentQuery(hand->bb, segment->a, segment->b) < segment->t_exit){
+				segment->t_exit = cpfmin(segment->t_exit, func(hand->obj, j, data));
+			}
+		}
+	}
+}
+
+static const cpSpatialIndexClass klass = {
+	sweepDestroy,
+	sweepSetPools,
+	sweepCount,
+	sweepEach,
+	sweepInsert,
+	sweepRemove,
+	sweepReindex,
+	sweepReindexQuery,
+	sweepPointQuery,
+	sweepQuery,
+	sweepSegmentQuery,
+};
+
+const cpSpatialIndexClass *
+cpSweep1DGetClass(void)
+{
+	return &klass;
+}
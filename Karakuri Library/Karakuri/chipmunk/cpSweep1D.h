@@ -0,0 +1,44 @@
+/* cpSweep1D.h
+ * Sort-and-sweep broadphase, added for the Karakuri Framework.
+ * Distributed under the same MIT license as the rest of Chipmunk.
+ */
+
+// The sort-and-sweep index keeps its objects sorted along the x axis and finds
+// the overlapping pairs in a single sweep. The order barely changes from one step
+// to the next, so an insertion sort keeps it sorted in nearly linear time.
+// It is fast for self-collision of many moving objects, but BBox and point
+// queries scan the array, so it should not be used for the static shapes.
+
+typedef struct cpSweep1DHandle {
+	// Pointer to the object. NULL once the object has been removed.
+	void *obj;
+	// BBox of the object at the last reindex.
+	cpBB bb;
+} cpSweep1DHandle;
+
+typedef struct cpSweep1D {
+	// Common spatial index header. (Holds the BBox callback.)
+	cpSpatialIndex index;
+	
+	// Handles by object.
+	cpHashSet *handleSet;
+	
+	// Handles sorted by the left edge of their BBox.
+	cpSweep1DHandle **table;
+	int num, max;
+	// Zero if handles were added since the table was last sorted.
+	int sorted;
+	
+	// Pool to allocate the handles from. Defaults to NULL (use malloc).
+	struct cpPool *handlePool;
+} cpSweep1D;
+
+// Basic allocation/destruction functions.
+cpSweep1D *cpSweep1DAlloc(void);
+cpSweep1D *cpSweep1DInit(cpSweep1D *sweep, cpSpatialIndexBBFunc bbfunc);
+cpSweep1D *cpSweep1DNew(cpSpatialIndexBBFunc bbfunc);
+
+void cpSweep1DDestroy(cpSweep1D *sweep);
+void cpSweep1DFree(cpSweep1D *sweep);
+
+const cpSpatialIndexClass *cpSweep1DGetClass(void);
@@ -11,7 +11,7 @@
 #include <Karakuri/KarakuriLibrary.h>
 
 
-GLuint KRCreatePNGGLTextureFromImageData(NSData* imageData, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear);
-GLuint KRCreatePNGGLTextureFromImageAtPath(NSString* imagePath, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear);
+GLuint KRCreatePNGGLTextureFromImageData(NSData* imageData, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear);
+GLuint KRCreatePNGGLTextureFromImageAtPath(NSString* imagePath, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear);
 
 
@@ -1286,7 +1286,7 @@ static BOOL stbi_png_info_from_memory(stbi_uc const *buffer, int len, int *x, in
 #pragma mark -
 #pragma mark PNG Loader Interface
 
-GLuint KRCreatePNGGLTextureFromImageData(NSData* imageData, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear)
+GLuint KRCreatePNGGLTextureFromImageData(NSData* imageData, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear)
 {
     GLuint textureName = GL_INVALID_VALUE;
     int image_width, image_height, image_component_count;
@@ -1347,6 +1347,7 @@ GLuint KRCreatePNGGLTextureFromImageData(NSData* imageData, KRVector2D* imageSiz
                              GL_UNSIGNED_BYTE, 		// Data type of the pixels on memory
                              image_buffer           // Pixel data on memory
                              );
+                *bitsPerPixel = (image_component_count == 3)? 24: 32;
                 
                 if (scalesLinear) {
                     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -1371,12 +1372,12 @@ GLuint KRCreatePNGGLTextureFromImageData(NSData* imageData, KRVector2D* imageSiz
     return textureName;    
 }
 
-GLuint KRCreatePNGGLTextureFromImageAtPath(NSString* imagePath, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear)
+GLuint KRCreatePNGGLTextureFromImageAtPath(NSString* imagePath, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear)
 {
     GLuint textureName = GL_INVALID_VALUE;
     NSData* fileData = [[NSData alloc] initWithContentsOfFile:imagePath];
     if (fileData && [fileData length] > 0) {
-        textureName = KRCreatePNGGLTextureFromImageData(fileData, imageSize, textureSize, scalesLinear);
+        textureName = KRCreatePNGGLTextureFromImageData(fileData, imageSize, textureSize, bitsPerPixel, scalesLinear);
     }
     [fileData release];
     return textureName;
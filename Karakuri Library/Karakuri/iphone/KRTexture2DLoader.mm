@@ -36,7 +36,7 @@ typedef enum {
 } Texture2DPixelFormat;
 
 
-static GLuint _KRCreateGLTextureFromData(const void* data, Texture2DPixelFormat pixelFormat, NSUInteger width, NSUInteger height, CGSize contentSize, KRVector2D* imageSize_, KRVector2D* textureSize_, BOOL isFont)
+static GLuint _KRCreateGLTextureFromData(const void* data, Texture2DPixelFormat pixelFormat, NSUInteger width, NSUInteger height, CGSize contentSize, KRVector2D* imageSize_, KRVector2D* textureSize_, int* bitsPerPixel_, BOOL isFont)
 {
     GLuint  _name;
 	GLint   saveName;
@@ -54,50 +54,62 @@ static GLuint _KRCreateGLTextureFromData(const void* data, Texture2DPixelFormat
     switch (pixelFormat) {
         case kTexture2DPixelFormat_RGBA8888:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+            *bitsPerPixel_ = 32;
             break;
             
         case kTexture2DPixelFormat_RGBA4444:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_SHORT_4_4_4_4, data);
+            *bitsPerPixel_ = 16;
             break;
             
         case kTexture2DPixelFormat_RGBA5551:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_SHORT_5_5_5_1, data);
+            *bitsPerPixel_ = 16;
             break;
             
         case kTexture2DPixelFormat_RGB565:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, data);
+            *bitsPerPixel_ = 16;
             break;
             
         case kTexture2DPixelFormat_RGB888:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
+            *bitsPerPixel_ = 24;
             break;
             
         case kTexture2DPixelFormat_L8:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, height, 0, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+            *bitsPerPixel_ = 8;
             break;
             
         case kTexture2DPixelFormat_A8:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, width, height, 0, GL_ALPHA, GL_UNSIGNED_BYTE, data);
+            *bitsPerPixel_ = 8;
             break;
             
         case kTexture2DPixelFormat_LA88:
             glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE_ALPHA, width, height, 0, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE, data);
+            *bitsPerPixel_ = 16;
             break;
             
         case kTexture2DPixelFormat_RGB_PVRTC2:
             glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB_PVRTC_2BPPV1_IMG, width, height, 0, (width * height) / 4, data);
+            *bitsPerPixel_ = 2;
             break;
             
         case kTexture2DPixelFormat_RGB_PVRTC4:
             glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGB_PVRTC_4BPPV1_IMG, width, height, 0, (width * height) / 2, data);
+            *bitsPerPixel_ = 4;
             break;
             
         case kTexture2DPixelFormat_RGBA_PVRTC2:
             glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG, width, height, 0, (width * height) / 4, data);
+            *bitsPerPixel_ = 2;
             break;
             
         case kTexture2DPixelFormat_RGBA_PVRTC4:
             glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG, width, height, 0, (width * height) / 2, data);
+            *bitsPerPixel_ = 4;
             break;
             
         default:
@@ -121,7 +133,7 @@ static GLuint _KRCreateGLTextureFromData(const void* data, Texture2DPixelFormat
     return _name;
 }
 
-static GLuint _KRCreateGLTextureFromCGImage(CGImageRef imageRef, UIImageOrientation orientation, BOOL sizeToFit, Texture2DPixelFormat pixelFormat, KRVector2D* imageSize_, KRVector2D* textureSize_, NSString* imageName)
+static GLuint _KRCreateGLTextureFromCGImage(CGImageRef imageRef, UIImageOrientation orientation, BOOL sizeToFit, Texture2DPixelFormat pixelFormat, KRVector2D* imageSize_, KRVector2D* textureSize_, int* bitsPerPixel_, NSString* imageName)
 {
     NSUInteger				width;
     NSUInteger              height;
@@ -377,7 +389,7 @@ static GLuint _KRCreateGLTextureFromCGImage(CGImageRef imageRef, UIImageOrientat
 		data = tempData;
 	}
     
-    GLuint ret = _KRCreateGLTextureFromData(data, pixelFormat, width, height, imageSize, imageSize_, textureSize_, NO);
+    GLuint ret = _KRCreateGLTextureFromData(data, pixelFormat, width, height, imageSize, imageSize_, textureSize_, bitsPerPixel_, NO);
 	
 	CGContextRelease(context);
 	free(data);
@@ -385,14 +397,14 @@ static GLuint _KRCreateGLTextureFromCGImage(CGImageRef imageRef, UIImageOrientat
 	return ret;
 }
 
-GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear)
+GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear)
 {
     static BOOL hasFailedInternalPNGLoading = NO;
     
     NSString* imagePath = [[NSBundle mainBundle] pathForResource:imageName ofType:nil];
 
     if (!hasFailedInternalPNGLoading && [[imageName pathExtension] compare:@"png" options:NSCaseInsensitiveSearch] == NSOrderedSame) {
-        GLuint textureName = KRCreatePNGGLTextureFromImageAtPath(imagePath, imageSize, textureSize, scalesLinear);
+        GLuint textureName = KRCreatePNGGLTextureFromImageAtPath(imagePath, imageSize, textureSize, bitsPerPixel, scalesLinear);
         if (textureName != GL_INVALID_VALUE) {
             return textureName;
         }
@@ -401,25 +413,25 @@ GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* image
     
     UIImage* image = [[UIImage alloc] initWithContentsOfFile:imagePath];
     
-    GLuint ret = _KRCreateGLTextureFromCGImage([image CGImage], [image imageOrientation], NO, kTexture2DPixelFormat_Automatic, imageSize, textureSize, imageName);
+    GLuint ret = _KRCreateGLTextureFromCGImage([image CGImage], [image imageOrientation], NO, kTexture2DPixelFormat_Automatic, imageSize, textureSize, bitsPerPixel, imageName);
     
     [image release];
     
     return ret;
 }
 
-GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear)
+GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear)
 {
     UIImage* image = [[UIImage alloc] initWithData:data];
 
-    GLuint ret = _KRCreateGLTextureFromCGImage([image CGImage], [image imageOrientation], NO, kTexture2DPixelFormat_Automatic, imageSize, textureSize, @"*on-memory");
+    GLuint ret = _KRCreateGLTextureFromCGImage([image CGImage], [image imageOrientation], NO, kTexture2DPixelFormat_Automatic, imageSize, textureSize, bitsPerPixel, @"*on-memory");
     
     [image release];
     
     return ret;
 }
 
-GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor& color, GLenum* textureTarget, KRVector2D* imageSize, KRVector2D* textureSize)
+GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor& color, GLenum* textureTarget, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel)
 {
     CGColorSpaceRef			colorSpace;
 	void*					data;
@@ -473,7 +485,7 @@ GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor&
         p[i] |= 0x00ffffff;
     }    
 
-	GLuint ret = _KRCreateGLTextureFromData(data, kTexture2DPixelFormat_RGBA8888, revisedSize.width, revisedSize.height, size, imageSize, textureSize, YES);
+	GLuint ret = _KRCreateGLTextureFromData(data, kTexture2DPixelFormat_RGBA8888, revisedSize.width, revisedSize.height, size, imageSize, textureSize, bitsPerPixel, YES);
 	
     imageSize->x = size.width;
     imageSize->y = size.height;
@@ -15,7 +15,7 @@
 #define KRTextureMaxSize    1024
 
 
-GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear)
+GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear)
 {
     // Build up bitmap data
     CGImageSourceRef imageSourceRef = CGImageSourceCreateWithData((CFDataRef)data, NULL);
@@ -27,6 +27,7 @@ GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVec
     imageSize->y = CGImageGetHeight(imageRef);
     textureSize->x = 1.0;
     textureSize->y = 1.0;
+    *bitsPerPixel = 32;
     
     // Adjust image size for texture
     KRVector2D revisedSize = *imageSize;
@@ -132,7 +133,7 @@ GLuint KRCreateGLTextureFromImageData(NSData* data, KRVector2D* imageSize, KRVec
     return textureName;    
 }
 
-GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* imageSize, KRVector2D* textureSize, BOOL scalesLinear)
+GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel, BOOL scalesLinear)
 {
     static BOOL hasFailedInternalPNGLoading = NO;
 
@@ -145,7 +146,7 @@ GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* image
     }
     
     if (!hasFailedInternalPNGLoading && [[imageName pathExtension] compare:@"png" options:NSCaseInsensitiveSearch] == NSOrderedSame) {
-        GLuint textureName = KRCreatePNGGLTextureFromImageAtPath(imagePath, imageSize, textureSize, scalesLinear);
+        GLuint textureName = KRCreatePNGGLTextureFromImageAtPath(imagePath, imageSize, textureSize, bitsPerPixel, scalesLinear);
         if (textureName != GL_INVALID_VALUE) {
             return textureName;
         }
@@ -163,6 +164,7 @@ GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* image
     imageSize->y = CGImageGetHeight(imageRef);
     textureSize->x = 1.0;
     textureSize->y = 1.0;
+    *bitsPerPixel = 32;
     
     // Adjust image size for texture
     KRVector2D revisedSize = *imageSize;
@@ -269,7 +271,7 @@ GLuint KRCreateGLTextureFromImageWithName(NSString* imageName, KRVector2D* image
     return textureName;
 }
 
-GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor& color, GLenum* textureTarget, KRVector2D* imageSize, KRVector2D* textureSize)
+GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor& color, GLenum* textureTarget, KRVector2D* imageSize, KRVector2D* textureSize, int* bitsPerPixel)
 {
     NSDictionary* attrDict = [[NSDictionary alloc] initWithObjectsAndKeys:
                               (NSFont*)fontObj, NSFontAttributeName,
@@ -372,6 +374,7 @@ GLuint KRCreateGLTextureFromString(NSString* str, void* fontObj, const KRColor&
     imageSize->y = size.height;
     textureSize->x = (float)imageSize->x / revisedSize.width;
     textureSize->y = (float)imageSize->y / revisedSize.height;
+    *bitsPerPixel = 32;
     
     [attrDict release];
 